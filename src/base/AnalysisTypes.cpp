@@ -20,6 +20,7 @@
 
 #include "AnalysisTypes.h"
 
+#include "ChordAnalysisIndex.h"
 #include "NotationTypes.h"
 #include "Pitch.h"
 #include "Event.h"
@@ -33,7 +34,12 @@
 #include "misc/Debug.h"
 #include "misc/Strings.h"
 
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
 #include <algorithm>
+#include <functional>
 #include <iostream>
 
 #include <assert.h>
@@ -48,27 +54,33 @@ namespace Rosegarden
 // Miscellany (doesn't analyze anything)
 ///////////////////////////////////////////////////////////////////////////
 
-Key
-AnalysisHelper::getKeyForEvent(const Event *e, Segment &s)
+namespace
 {
-    Segment::iterator i =
-        e ? s.findNearestTime(e->getAbsoluteTime()) //cc
-          : s.begin();
-
-    if (i==s.end()) return Key();
+    /// The last key at or before i.
+    Key keyBefore(Segment &s, Segment::iterator i)
+    {
+        if (i==s.end()) return Key();
 
-    // This is an ugly loop. Is there a better way to iterate backwards
-    // through an STL container?
+        // This is an ugly loop. Is there a better way to iterate backwards
+        // through an STL container?
 
-    while (true) {
-        if ((*i)->isa(Key::EventType)) {
-            return Key(**i);
+        while (true) {
+            if ((*i)->isa(Key::EventType)) {
+                return Key(**i);
+            }
+            if (i != s.begin()) --i;
+            else break;
         }
-        if (i != s.begin()) --i;
-        else break;
+
+        return Key();
     }
+}
 
-    return Key();
+Key
+AnalysisHelper::getKeyForEvent(const Event *e, Segment &s)
+{
+    return keyBefore(s, e ? s.findNearestTime(e->getAbsoluteTime()) //cc
+                          : s.begin());
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -135,6 +147,38 @@ AnalysisHelper::labelChords(CompositionTimeSliceAdapter &c, Segment &s,
 }
 
 
+void
+AnalysisHelper::labelChords(const ChordAnalysisIndex &index,
+                            timeT from, timeT to, Segment &s,
+                            const Quantizer *quantizer)
+{
+    ChordAnalysisIndex::EntryVector entries;
+    index.getEntries(from, to, quantizer, entries);
+
+    Key key = entries.empty() ? getKeyForEvent(nullptr, s) :
+        keyBefore(s, s.findNearestTime(entries.front().time));
+
+    for (const ChordAnalysisIndex::Entry &entry : entries) {
+
+        if (entry.keyEvent) {
+            key = Key(*entry.keyEvent);
+            Text text(key.getName(), Text::KeyName);
+            s.insert(text.getAsEvent(entry.time));
+            continue;
+        }
+
+        if (entry.slice.mask == 0) continue;
+
+        ChordLabel ch(key, entry.slice.mask, entry.slice.bass);
+
+        if (ch.isValid()) {
+            Text text(ch.getName(key), Text::ChordName);
+            s.insert(text.getAsEvent(entry.time));
+        }
+    }
+}
+
+
 // ChordLabel
 /////////////////////////////////////////////////
 
@@ -269,6 +313,56 @@ ChordLabel::checkMap()
 // Harmony guessing
 ///////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    typedef std::function<void(size_t begin, size_t end)> WindowFunction;
+
+    class WindowJob : public QRunnable
+    {
+    public:
+        WindowJob(const WindowFunction &function, size_t begin, size_t end) :
+            m_function(function),
+            m_begin(begin),
+            m_end(end)
+        {
+        }
+
+        void run() override  { m_function(m_begin, m_end); }
+
+    private:
+        const WindowFunction &m_function;
+        size_t m_begin;
+        size_t m_end;
+    };
+
+    /// Call function for consecutive windows of [0, count) on a thread pool.
+    /**
+     * Returns once every window is done.  The function must only read
+     * shared state, apart from the results for its own window.
+     */
+    void forEachWindow(size_t count, const WindowFunction &function)
+    {
+        // Large enough for a window to be worth a thread, small enough
+        // for the windows to even out over the pool.
+        const size_t windowSize = 256;
+
+        if (count <= windowSize) {
+            function(0, count);
+            return;
+        }
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+
+        for (size_t begin = 0; begin < count; begin += windowSize) {
+            pool.start(new WindowJob(function, begin,
+                                     std::min(count, begin + windowSize)));
+        }
+
+        pool.waitForDone();
+    }
+}
+
 void
 AnalysisHelper::guessHarmonies(CompositionTimeSliceAdapter &c, Segment &s)
 {
@@ -301,6 +395,7 @@ AnalysisHelper::makeHarmonyGuessList(CompositionTimeSliceAdapter &c,
     checkHarmonyTable();
 
     PitchProfile p; // defaults to all zeroes
+    std::vector<PitchProfile> profiles;
     TimeSignature timeSig;
     timeT timeSigTime = 0;
     timeT nextSigTime = (*c.begin())->getAbsoluteTime();
@@ -378,55 +473,66 @@ AnalysisHelper::makeHarmonyGuessList(CompositionTimeSliceAdapter &c,
 
         // (If the pitch profile hasn't changed much, continue)
 
-        PitchProfile np = p.normalized();
+        // Only the profile depends on what came before.  The scoring
+        // below is done once all of the profiles are known.
 
-        HarmonyGuess possibleChords;
+        l.push_back(std::pair<timeT, HarmonyGuess>(time, HarmonyGuess()));
+        profiles.push_back(p.normalized());
+    }
 
+    // 3. Save a short list of the nearest chords for each profile in the
+    // HarmonyGuessList passed in from guessHarmonies().  The windows of
+    // slices are independent, so they are scored on the thread pool.
+
+    forEachWindow(l.size(),
+                  [this, &l, &profiles](size_t begin, size_t end)
+    {
+        HarmonyGuess possibleChords;
         possibleChords.reserve(m_harmonyTable.size());
 
-        for (HarmonyTable::iterator j = m_harmonyTable.begin();
-             j != m_harmonyTable.end();
-             ++j)
+        for (size_t sliceNo = begin; sliceNo < end; ++sliceNo)
         {
-            double score = np.productScorer(j->first);
-            possibleChords.push_back(ChordPossibility(score, j->second));
-        }
+            const PitchProfile &np = profiles[sliceNo];
 
-        // 3. Save a short list of the nearest chords in the
-        // HarmonyGuessList passed in from guessHarmonies()
+            possibleChords.clear();
 
-        l.push_back(std::pair<timeT, HarmonyGuess>(time, HarmonyGuess()));
+            for (HarmonyTable::const_iterator j = m_harmonyTable.begin();
+                 j != m_harmonyTable.end();
+                 ++j)
+            {
+                double score = np.productScorer(j->first);
+                possibleChords.push_back(ChordPossibility(score, j->second));
+            }
 
-        HarmonyGuess& smallerGuess = l.back().second;
+            HarmonyGuess& smallerGuess = l[sliceNo].second;
 
-        // Have to learn to love this:
+            // Have to learn to love this:
 
-        smallerGuess.resize(10);
+            smallerGuess.resize(10);
 
-        partial_sort_copy(possibleChords.begin(),
-                          possibleChords.end(),
-                          smallerGuess.begin(),
-                          smallerGuess.end(),
-                          cp_less());
+            partial_sort_copy(possibleChords.begin(),
+                              possibleChords.end(),
+                              smallerGuess.begin(),
+                              smallerGuess.end(),
+                              cp_less());
 
 #ifdef GIVE_HARMONYGUESS_DETAILS
-        RG_DEBUG << "Time: " << time;
+            RG_DEBUG << "Time: " << l[sliceNo].first;
 
-        RG_DEBUG << "Profile: ";
-        for (int k = 0; k < 12; ++k)
-               RG_DEBUG << np[k] << " ";
+            RG_DEBUG << "Profile: ";
+            for (int k = 0; k < 12; ++k)
+                   RG_DEBUG << np[k] << " ";
 
-        RG_DEBUG << "Best guesses: ";
-        for (HarmonyGuess::iterator debugi = smallerGuess.begin();
-             debugi != smallerGuess.end();
-             ++debugi)
-        {
-            RG_DEBUG << debugi->first << ": " << debugi->second.getName(Key());
-        }
+            RG_DEBUG << "Best guesses: ";
+            for (HarmonyGuess::iterator debugi = smallerGuess.begin();
+                 debugi != smallerGuess.end();
+                 ++debugi)
+            {
+                RG_DEBUG << debugi->first << ": " << debugi->second.getName(Key());
+            }
 #endif
-
-    }
-
+        }
+    });
 }
 
 // Comparison function object -- can't declare this in the headers because
@@ -449,7 +555,7 @@ AnalysisHelper::refineHarmonyGuessList(CompositionTimeSliceAdapter &/* c */,
                                        Segment &segment)
 {
     // (Fetch the piece's starting key from the key guesser)
-    Key key;
+    const Key key;
 
     checkProgressionMap();
 
@@ -459,92 +565,111 @@ AnalysisHelper::refineHarmonyGuessList(CompositionTimeSliceAdapter &/* c */,
         return;
     }
 
-    // Look at the list of harmony guesses two guesses at a time.
+    // Look at the list of harmony guesses two guesses at a time.  Each
+    // pair is scored independently of the others, so the pairs are
+    // scored in windows on the thread pool and the results used below.
 
-    HarmonyGuessList::iterator i = harmonyGuessList.begin();
-    // j stays ahead of i
-    HarmonyGuessList::iterator j = i + 1;
-
-    ChordLabel bestGuessForFirstChord, bestGuessForSecondChord;
-    while (j != harmonyGuessList.end())
+    struct BestPair
     {
+        double score;
+        ChordLabel first;
+        ChordLabel second;
+    };
+    std::vector<BestPair> bestPairs(harmonyGuessList.size() - 1);
 
-        double highestScore = 0;
-
-        // For each possible pair of chords (i.e., two for loops here)
-        for (HarmonyGuess::iterator harmonyIter1 = i->second.begin();
-             harmonyIter1 != i->second.end();
-             ++harmonyIter1)
+    forEachWindow(bestPairs.size(),
+                  [&](size_t begin, size_t end)
+    {
+        for (size_t pairNo = begin; pairNo < end; ++pairNo)
         {
-            for (HarmonyGuess::iterator harmonyIter2 = j->second.begin();
-                 harmonyIter2 != j->second.end();
-                 ++harmonyIter2)
+            // j stays ahead of i
+            HarmonyGuessList::const_iterator i =
+                harmonyGuessList.begin() + pairNo;
+            HarmonyGuessList::const_iterator j = i + 1;
+
+            BestPair &best = bestPairs[pairNo];
+            best.score = 0;
+
+            // For each possible pair of chords (i.e., two for loops here)
+            for (HarmonyGuess::const_iterator harmonyIter1 = i->second.begin();
+                 harmonyIter1 != i->second.end();
+                 ++harmonyIter1)
             {
-                // Print the guess being processed:
-
-                //RG_DEBUG << k->second.getName(Key()) << "->" << l->second.getName(Key());
-
-                // For a first approximation, let's say the probability that
-                // a chord guess is correct is proportional to its score. Then
-                // the probability that a pair is correct is the product of
-                // its scores.
-
-                double currentScore;
-                currentScore = harmonyIter1->first * harmonyIter2->first;
-
-                //RG_DEBUG << currentScore;
-
-                // Is this a familiar progression? Bonus if so.
-
-                bool isFamiliar = false;
+                for (HarmonyGuess::const_iterator harmonyIter2 = j->second.begin();
+                     harmonyIter2 != j->second.end();
+                     ++harmonyIter2)
+                {
+                    // For a first approximation, let's say the probability
+                    // that a chord guess is correct is proportional to its
+                    // score. Then the probability that a pair is correct is
+                    // the product of its scores.
+
+                    double currentScore;
+                    currentScore = harmonyIter1->first * harmonyIter2->first;
+
+                    // Is this a familiar progression? Bonus if so.
+
+                    bool isFamiliar = false;
+
+                    ProgressionMap::const_iterator pmi =
+                        m_progressionMap.lower_bound(
+                            ChordProgression(harmonyIter1->second,
+                                             harmonyIter2->second)
+                        );
+
+                    // no initialization
+                    for ( ;
+                         pmi != m_progressionMap.end()
+                         && pmi->first == harmonyIter1->second
+                         && pmi->second == harmonyIter2->second;
+                         ++pmi)
+                    {
+                        // key doesn't have operator== defined
+                        if (key.getName() == pmi->homeKey.getName())
+                        {
+                            isFamiliar = true;
+                            break;
+                        }
+                    }
 
-                // #### my ways of breaking up long function calls are haphazard
-                //      also, does this code belong here?
+                    if (isFamiliar) currentScore *= 5; // #### arbitrary
 
-                ProgressionMap::iterator pmi =
-                    m_progressionMap.lower_bound(
-                        ChordProgression(harmonyIter1->second, harmonyIter2->second)
-                    );
+                    // (Are voice-leading rules followed? Penalty if not)
 
-                // no initialization
-                for ( ;
-                     pmi != m_progressionMap.end()
-                     && pmi->first == harmonyIter1->second
-                     && pmi->second == harmonyIter2->second;
-                     ++pmi)
-                {
-                    // key doesn't have operator== defined
-                    if (key.getName() == pmi->homeKey.getName())
+                    // Is this better than any pair examined so far? If so,
+                    // keep it as the best chord progression
+                    if (currentScore > best.score)
                     {
-                        //RG_DEBUG << k->second.getName(Key()) << "->" << l->second.getName(Key()) << " is familiar";
-                        isFamiliar = true;
-                        break;
+                        best.first  = harmonyIter1->second;
+                        best.second = harmonyIter2->second;
+                        best.score = currentScore;
                     }
                 }
+            }
+        }
+    });
 
-                if (isFamiliar) currentScore *= 5; // #### arbitrary
-
-                // (Are voice-leading rules followed? Penalty if not)
+    // A pair with nothing scoring above zero keeps the best guesses from
+    // the pair before it.
+    ChordLabel bestGuessForFirstChord, bestGuessForSecondChord;
 
-                // Is this better than any pair examined so far? If so, set
-                // some variables that should end up holding the best chord
-                // progression
-                if (currentScore > highestScore)
-                {
-                    bestGuessForFirstChord  = harmonyIter1->second;
-                    bestGuessForSecondChord = harmonyIter2->second;
-                    highestScore = currentScore;
-                }
+    for (size_t pairNo = 0; pairNo < bestPairs.size(); ++pairNo)
+    {
+        const BestPair &best = bestPairs[pairNo];
+        const timeT time = harmonyGuessList[pairNo + 1].first;
 
-            }
+        if (best.score > 0)
+        {
+            bestGuessForFirstChord  = best.first;
+            bestGuessForSecondChord = best.second;
         }
 
         // Since we're not returning any results right now, print them
-        RG_DEBUG << "Time: " << j->first;
+        RG_DEBUG << "Time: " << time;
         RG_DEBUG << "Best chords: "
           << bestGuessForFirstChord.getName(Key()) << ", "
           << bestGuessForSecondChord.getName(Key());
-        RG_DEBUG << "Best score: " << highestScore;
+        RG_DEBUG << "Best score: " << best.score;
 
         // Using the best pair of chords:
 
@@ -569,18 +694,14 @@ AnalysisHelper::refineHarmonyGuessList(CompositionTimeSliceAdapter &/* c */,
         // Temporary hack to get _something_ interesting out:
         Event *e;
         e = Text(bestGuessForFirstChord.getName(Key()), Text::ChordName).
-            getAsEvent(j->first);
+            getAsEvent(time);
         segment.insert(new Event(*e, e->getAbsoluteTime(),
                                  e->getDuration(), e->getSubOrdering()-1));
         delete e;
 
         e = Text(bestGuessForSecondChord.getName(Key()), Text::ChordName).
-            getAsEvent(j->first);
+            getAsEvent(time);
         segment.insert(e);
-
-        // For now, just advance:
-        i = j;
-        ++j;
     }
 }
 
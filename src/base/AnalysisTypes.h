@@ -31,6 +31,7 @@ namespace Rosegarden
 
 class Segment;
 class Event;
+class ChordAnalysisIndex;
 class CompositionTimeSliceAdapter;
 class Quantizer;
 class Composition;
@@ -131,6 +132,15 @@ public:
     void labelChords(CompositionTimeSliceAdapter &c, Segment &s,
                      const Quantizer *quantizer);
 
+    /**
+     * Like the above, but for the notes filed in a ChordAnalysisIndex
+     * between from and to.  If from and to are equal, the whole index
+     * is labelled.
+     */
+    void labelChords(const ChordAnalysisIndex &index,
+                     timeT from, timeT to, Segment &s,
+                     const Quantizer *quantizer);
+
     /**
      * Returns a time signature that is probably reasonable for the
      * given timeslice.
@@ -161,6 +171,10 @@ public:
      * Like labelChords, but the algorithm is more complicated. This tries
      * to guess the chords that should go under a beat even when all of the
      * chord members aren't played at once.
+     *
+     * The scoring of the guesses is shared out over a thread pool in
+     * windows of consecutive time slices.  The labels are inserted into
+     * the segment on the calling thread.
      */
     void guessHarmonies(CompositionTimeSliceAdapter &c, Segment &s);
 
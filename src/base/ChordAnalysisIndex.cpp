@@ -0,0 +1,202 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_NO_DEBUG_PRINT
+
+#include "ChordAnalysisIndex.h"
+
+#include "BaseProperties.h"
+#include "Event.h"
+#include "NotationTypes.h"
+#include "Quantizer.h"
+
+#include "misc/Debug.h"
+
+#include <algorithm>
+
+
+namespace Rosegarden
+{
+
+
+ChordAnalysisIndex::ChordAnalysisIndex()
+{
+}
+
+ChordAnalysisIndex::~ChordAnalysisIndex()
+{
+    for (const Segment *segment : m_segments) {
+        const_cast<Segment *>(segment)->removeObserver(this);
+    }
+}
+
+void
+ChordAnalysisIndex::addSegment(Segment *segment)
+{
+    if (!m_segments.insert(segment).second) return;
+
+    for (Segment::iterator i = segment->begin(); i != segment->end(); ++i) {
+        eventAdded(segment, *i);
+    }
+
+    segment->addObserver(this);
+}
+
+void
+ChordAnalysisIndex::removeSegment(Segment *segment)
+{
+    // It may have been deleted already.  See segmentDeleted().
+    if (m_segments.erase(segment) == 0) return;
+
+    segment->removeObserver(this);
+    dropSegment(segment);
+}
+
+void
+ChordAnalysisIndex::dropSegment(const Segment *segment)
+{
+    for (BucketMap::iterator i = m_buckets.begin(); i != m_buckets.end(); ) {
+
+        Bucket &bucket = i->second;
+        const auto inSegment =
+            [segment](const Indexed &indexed)
+            { return indexed.segment == segment; };
+
+        bucket.notes.erase(std::remove_if(bucket.notes.begin(),
+                                          bucket.notes.end(), inSegment),
+                           bucket.notes.end());
+        bucket.keys.erase(std::remove_if(bucket.keys.begin(),
+                                         bucket.keys.end(), inSegment),
+                          bucket.keys.end());
+
+        if (bucket.notes.empty() && bucket.keys.empty())
+            i = m_buckets.erase(i);
+        else
+            ++i;
+    }
+}
+
+void
+ChordAnalysisIndex::eventAdded(const Segment *segment, Event *e)
+{
+    if (e->isa(Note::EventType)) {
+        m_buckets[e->getAbsoluteTime()].notes.push_back({ segment, e });
+    } else if (e->isa(Key::EventType)) {
+        m_buckets[e->getAbsoluteTime()].keys.push_back({ segment, e });
+    }
+}
+
+void
+ChordAnalysisIndex::eraseFrom(std::vector<Indexed> &v, const Event *e)
+{
+    for (std::vector<Indexed>::iterator i = v.begin(); i != v.end(); ++i) {
+        if (i->event == e) {
+            v.erase(i);
+            return;
+        }
+    }
+}
+
+void
+ChordAnalysisIndex::eventRemoved(const Segment *, Event *e)
+{
+    // An event's time cannot change while it is in a segment, so it is
+    // still in the bucket it was filed in.
+    BucketMap::iterator i = m_buckets.find(e->getAbsoluteTime());
+    if (i == m_buckets.end()) return;
+
+    if (e->isa(Note::EventType)) {
+        eraseFrom(i->second.notes, e);
+    } else if (e->isa(Key::EventType)) {
+        eraseFrom(i->second.keys, e);
+    }
+
+    if (i->second.notes.empty() && i->second.keys.empty())
+        m_buckets.erase(i);
+}
+
+void
+ChordAnalysisIndex::segmentDeleted(const Segment *segment)
+{
+    RG_DEBUG << "segmentDeleted()" << segment;
+
+    // Can't call removeObserver() on a const segment, and it is going
+    // away anyway.
+    m_segments.erase(segment);
+    dropSegment(segment);
+}
+
+void
+ChordAnalysisIndex::getEntries(timeT from, timeT to,
+                               const Quantizer *quantizer,
+                               EntryVector &entries) const
+{
+    entries.clear();
+
+    BucketMap::const_iterator begin = m_buckets.begin();
+    BucketMap::const_iterator end = m_buckets.end();
+    if (from != to) {
+        begin = m_buckets.lower_bound(from);
+        end = m_buckets.lower_bound(to);
+    }
+
+    // Key is the quantized time and subordering.
+    typedef std::map<std::pair<timeT, int>, Slice> SliceMap;
+    SliceMap slices;
+
+    for (BucketMap::const_iterator i = begin; i != end; ++i) {
+
+        const timeT time = i->first;
+
+        for (const Indexed &key : i->second.keys) {
+            entries.push_back({ time, key.event, Slice() });
+        }
+
+        for (const Indexed &note : i->second.notes) {
+
+            long pitch = 0;
+            if (!note.event->get<Int>(BaseProperties::PITCH, pitch)) continue;
+
+            const timeT quantizedTime =
+                quantizer ? quantizer->getQuantizedAbsoluteTime(note.event)
+                          : time;
+
+            std::pair<SliceMap::iterator, bool> inserted = slices.insert(
+                    SliceMap::value_type(
+                            std::make_pair(quantizedTime,
+                                           note.event->getSubOrdering()),
+                            { time, 0, int(pitch), 0 }));
+
+            Slice &slice = inserted.first->second;
+            slice.time = std::min(slice.time, time);
+            slice.mask |= 1 << (pitch % 12);
+            slice.bass = std::min(slice.bass, int(pitch));
+            ++slice.noteCount;
+        }
+    }
+
+    for (const SliceMap::value_type &slice : slices) {
+        entries.push_back({ slice.second.time, nullptr, slice.second });
+    }
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry &a, const Entry &b) {
+                         if (a.time != b.time) return a.time < b.time;
+                         return a.keyEvent && !b.keyEvent;
+                     });
+}
+
+
+}
@@ -0,0 +1,121 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_CHORD_ANALYSIS_INDEX_H
+#define RG_CHORD_ANALYSIS_INDEX_H
+
+#include "base/Segment.h"
+#include "base/TimeT.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Rosegarden
+{
+
+
+class Event;
+class Quantizer;
+
+
+/// The notes and key changes of a set of Segments, by time.
+/**
+ * An alternative to CompositionTimeSliceAdapter for analysis that is
+ * repeated as the user edits, like the chord name ruler.  Rather than
+ * merging the Segments' iterators on every pass, the notes and key
+ * signatures of the observed Segments are filed by absolute time as they
+ * are added and removed, so a query only looks at the times it asks for.
+ *
+ * Events are kept by pointer and read when a query is made, so changes
+ * made in place (e.g. a transposition) are seen without a notification.
+ * The grouping into chords is done per query since the quantized times
+ * can change without notification too.
+ */
+class ChordAnalysisIndex : public SegmentObserver
+{
+public:
+    ChordAnalysisIndex();
+    ~ChordAnalysisIndex() override;
+
+    /// Start observing the segment and index its notes and keys.
+    void addSegment(Segment *segment);
+    /// Stop observing the segment and drop its notes and keys.
+    void removeSegment(Segment *segment);
+    bool hasSegment(const Segment *segment) const
+        { return m_segments.find(segment) != m_segments.end(); }
+
+    /// The notes that sound together, in the chord sense of GenericChord.
+    struct Slice
+    {
+        /// Absolute time of the earliest note.  Where a label goes.
+        timeT time;
+        /// Bit n is set if pitch class n is present.
+        int mask;
+        /// Lowest pitch.
+        int bass;
+        int noteCount;
+    };
+
+    /// A slice, or a key change if keyEvent is set.
+    struct Entry
+    {
+        timeT time;
+        const Event *keyEvent;
+        Slice slice;
+    };
+    typedef std::vector<Entry> EntryVector;
+
+    /// The key changes and slices in [from, to), in time order.
+    /**
+     * If from and to are equal, everything is returned.  Notes are put in
+     * the same slice if their quantized start times and suborderings
+     * match.  A key change comes before any slice starting at its time.
+     */
+    void getEntries(timeT from, timeT to, const Quantizer *quantizer,
+                    EntryVector &entries) const;
+
+    // SegmentObserver overrides.
+    void eventAdded(const Segment *, Event *) override;
+    void eventRemoved(const Segment *, Event *) override;
+    void segmentDeleted(const Segment *) override;
+
+private:
+    struct Indexed
+    {
+        const Segment *segment;
+        const Event *event;
+    };
+
+    /// Everything indexed at one absolute time.
+    struct Bucket
+    {
+        std::vector<Indexed> notes;
+        std::vector<Indexed> keys;
+    };
+
+    typedef std::map<timeT, Bucket> BucketMap;
+    BucketMap m_buckets;
+
+    std::set<const Segment *> m_segments;
+
+    static void eraseFrom(std::vector<Indexed> &v, const Event *e);
+    void dropSegment(const Segment *segment);
+};
+
+
+}
+
+#endif
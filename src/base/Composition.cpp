@@ -50,7 +50,7 @@ namespace Rosegarden
 const PropertyName Composition::NoAbsoluteTimeProperty("NoAbsoluteTime");
 const PropertyName Composition::BarNumberProperty("BarNumber");
 
-const std::string Composition::TempoEventType("tempo");
+const EventTypeName Composition::TempoEventType("tempo");
 const PropertyName Composition::TempoProperty("Tempo");
 const PropertyName Composition::TargetTempoProperty("TargetTempo");
 const PropertyName Composition::TempoTimestampProperty("TimestampSec");
@@ -18,6 +18,7 @@
 
 #include "RealTime.h"
 #include "base/Segment.h"
+#include "EventTypeName.h"
 #include "Track.h"
 #include "Configuration.h"
 #include "XmlExportable.h"
@@ -937,7 +938,7 @@ public:
 
 protected:
 
-    static const std::string TempoEventType;
+    static const EventTypeName TempoEventType;
     static const PropertyName TempoProperty;
     static const PropertyName TargetTempoProperty;
 
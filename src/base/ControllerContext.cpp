@@ -36,13 +36,155 @@
 namespace Rosegarden
 {
 
+    /*** ControllerIndex ***/
+ControllerIndex::
+ControllerIndex(Segment *segment) :
+    m_segment(segment)
+{
+    rebuild();
+    m_segment->addObserver(this);
+}
+
+ControllerIndex::
+~ControllerIndex()
+{
+    if (m_segment)
+        { m_segment->removeObserver(this); }
+}
+
+ControllerIndex::EventsByTime *
+ControllerIndex::
+indexFor(const Event *e, bool create)
+{
+    if (e->isa(PitchBend::EventType))
+        { return &m_pitchBends; }
+
+    if (!e->isa(Controller::EventType) || !e->has(Controller::NUMBER))
+        { return nullptr; }
+
+    const int controllerId = e->get <Int>(Controller::NUMBER);
+    if (create)
+        { return &m_controllers[controllerId]; }
+
+    std::map<int, EventsByTime>::iterator found =
+        m_controllers.find(controllerId);
+    return found == m_controllers.end() ? nullptr : &found->second;
+}
+
+void
+ControllerIndex::
+rebuild()
+{
+    m_controllers.clear();
+    m_pitchBends.clear();
+    if (!m_segment)
+        { return; }
+
+    for (Segment::iterator i = m_segment->begin();
+         i != m_segment->end(); ++i) {
+        EventsByTime *index = indexFor(*i, true);
+        if (index) {
+            index->insert(index->end(),
+                          EventsByTime::value_type((*i)->getAbsoluteTime(),
+                                                   *i));
+        }
+    }
+}
+
+void
+ControllerIndex::
+eventAdded(const Segment *, Event *e)
+{
+    EventsByTime *index = indexFor(e, true);
+    if (index)
+        { index->insert(EventsByTime::value_type(e->getAbsoluteTime(), e)); }
+}
+
+void
+ControllerIndex::
+eventRemoved(const Segment *, Event *e)
+{
+    EventsByTime *index = indexFor(e, false);
+    if (!index)
+        { return; }
+
+    // An event's time cannot change while it is in a segment, so it is
+    // where it was filed.
+    std::pair<EventsByTime::iterator, EventsByTime::iterator> range =
+        index->equal_range(e->getAbsoluteTime());
+    for (EventsByTime::iterator i = range.first; i != range.second; ++i) {
+        if (i->second == e) {
+            index->erase(i);
+            return;
+        }
+    }
+}
+
+void
+ControllerIndex::
+allEventsChanged(const Segment *)
+{
+    // Sent when all the events have been moved in time, so they can't
+    // be found by their time any more.
+    rebuild();
+}
+
+void
+ControllerIndex::
+segmentDeleted(const Segment *)
+{
+    m_segment = nullptr;
+    rebuild();
+}
+
+const Event *
+ControllerIndex::
+findLatest(const std::string& eventType, int controllerId,
+           timeT noEarlierThan, timeT noLaterThan) const
+{
+    const EventsByTime *index = &m_pitchBends;
+    if (eventType == Controller::EventType) {
+        std::map<int, EventsByTime>::const_iterator found =
+            m_controllers.find(controllerId);
+        if (found == m_controllers.end())
+            { return nullptr; }
+        index = &found->second;
+    } else if (eventType != PitchBend::EventType) {
+        return nullptr;
+    }
+
+    // The last time earlier than noLaterThan.
+    EventsByTime::const_iterator latest = index->lower_bound(noLaterThan);
+    if (latest == index->begin())
+        { return nullptr; }
+    --latest;
+
+    const timeT t = latest->first;
+    if (t <= noEarlierThan)
+        { return nullptr; }
+
+    // Of the events at that time, the segment's backwards search would
+    // meet the one with the highest subordering first.  Equal ones are
+    // in the order they were inserted, as in the segment.
+    const Event *result = nullptr;
+    for (EventsByTime::const_iterator i = index->lower_bound(t);
+         i != index->end() && i->first == t; ++i) {
+        if (!result ||
+            i->second->getSubOrdering() >= result->getSubOrdering())
+            { result = i->second; }
+    }
+    return result;
+}
+
     /*** ControllerSearch ***/
 ControllerSearch::
 ControllerSearch(const std::string& eventType,
-                 int controllerId) :
+                 int controllerId,
+                 const ControllerContextMap *indexes) :
     m_eventType(eventType),
     m_controllerId(controllerId),
-    m_instrument(0)
+    m_instrument(0),
+    m_indexes(indexes)
 {}
 
 // Return the last value of controller before noLaterThan in segment s.
@@ -55,6 +197,20 @@ searchSegment(const Segment *s, timeT noEarlierThan, timeT noLaterThan) const
     if (!s)
         { return Maybe(false, ControllerSearchValue(0,0)); }
 
+    const ControllerIndex *index =
+        m_indexes ? m_indexes->getIndex(s) : nullptr;
+    if (index) {
+        const Event *e = index->findLatest(m_eventType, m_controllerId,
+                                           noEarlierThan, noLaterThan);
+        if (!e)
+            { return Maybe(false, ControllerSearchValue(0,0)); }
+
+        long value = 0;
+        ControllerEventAdapter(const_cast<Event *>(e)).getValue(value);
+        return Maybe(true, ControllerSearchValue(value,
+                                                 e->getAbsoluteTime()));
+    }
+
     // Get the latest relevant event before or at noEarlierThan.
     Segment::reverse_iterator latest(s->findTimeConst(noLaterThan));
 
@@ -200,7 +356,7 @@ getControllerValue(const Instrument *instrument,
 
     // Some non-static values exist for this controller but the last
     // value isn't it, so search.
-    const ControllerSearch params(eventType, controllerId);
+    const ControllerSearch params(eventType, controllerId, this);
     Maybe foundInEvents = params.doubleSearch(a, b, searchTime);
 
     // Found it so we're done.
@@ -265,7 +421,7 @@ makeControlValueAbsolute(const Instrument *instrument, const Segment *a,
     const int controllerId =
         e->has(Controller::NUMBER) ?
         e->get <Int>(Controller::NUMBER) : 0;
-    const ControllerSearch params(eventType, controllerId);
+    const ControllerSearch params(eventType, controllerId, this);
     ControllerSearch::Maybe result =
         params.doubleSearch(a, b, at);
     int baseline;
@@ -332,5 +488,32 @@ clear()
     m_PitchBendLatestValue = Maybe(false,ControllerSearchValue());
 }
 
+void
+ControllerContextMap::
+addIndex(Segment *segment)
+{
+    std::unique_ptr<ControllerIndex> &index = m_indexes[segment];
+    if (!index || index->getSegment() != segment)
+        { index.reset(new ControllerIndex(segment)); }
+}
+
+const ControllerIndex *
+ControllerContextMap::
+getIndex(const Segment *segment) const
+{
+    std::map<const Segment *,
+             std::unique_ptr<ControllerIndex> >::const_iterator found =
+        m_indexes.find(segment);
+    if (found == m_indexes.end())
+        { return nullptr; }
+
+    // Don't trust an index whose segment has gone, even if another
+    // segment has turned up at the same address.
+    if (found->second->getSegment() != segment)
+        { return nullptr; }
+
+    return found->second.get();
+}
+
 
 } // End namespace Rosegarden
@@ -18,9 +18,11 @@
 #ifndef RG_CONTROLLERCONTEXT_H
 #define RG_CONTROLLERCONTEXT_H
 
+#include "base/Segment.h"
 #include "base/TimeT.h"
 
 #include <map>
+#include <memory>
 #include <string>
 
 
@@ -32,7 +34,6 @@ class ControllerContextMap;
 class ControlParameter;
 class Event;
 class Instrument;
-class Segment;
 
 
 // @class ControllerSearchValue A (possibly intermediate) value in a
@@ -59,6 +60,51 @@ class ControllerSearchValue
     timeT             m_when;
 };
 
+// @class ControllerIndex The controller and pitchbend events of a
+// segment, by controller and time.
+//
+// Chasing a controller would otherwise mean scanning backwards through
+// the segment from the search time, checking the type of every event on
+// the way.  Here each controller gets its own time-ordered index, so a
+// search is a lookup plus a scan of any events at the same time.  The
+// index follows the segment's edits as an observer.  Events are kept by
+// pointer and their values read when searched for.
+class ControllerIndex : public SegmentObserver
+{
+ public:
+    explicit ControllerIndex(Segment *segment);
+    ~ControllerIndex() override;
+
+    // The segment indexed, or nullptr if it has been deleted.
+    const Segment *getSegment() const { return m_segment; }
+
+    // Return the latest event of the controller that is later than
+    // noEarlierThan and earlier than noLaterThan, as
+    // ControllerSearch::searchSegment() would find it, or nullptr.
+    const Event *findLatest(const std::string& eventType,
+                            int controllerId,
+                            timeT noEarlierThan,
+                            timeT noLaterThan) const;
+
+    // SegmentObserver overrides.
+    void eventAdded(const Segment *, Event *) override;
+    void eventRemoved(const Segment *, Event *) override;
+    void allEventsChanged(const Segment *) override;
+    void segmentDeleted(const Segment *) override;
+
+ private:
+    typedef std::multimap<timeT, Event *> EventsByTime;
+
+    // The index e belongs in, or nullptr if e is not a controller or
+    // pitchbend.  create says whether a missing index may be added.
+    EventsByTime *indexFor(const Event *e, bool create);
+    void rebuild();
+
+    Segment                    *m_segment;
+    std::map<int, EventsByTime> m_controllers;
+    EventsByTime                m_pitchBends;
+};
+
 // @class ControllerSearch The unvarying parameters governing a
 // search for a controller for a given instrument.
 // @author Tom Breton (Tehom)
@@ -67,8 +113,11 @@ class ControllerSearch
  public:
     typedef ControllerSearchValue::Maybe Maybe;
 
+    // If indexes is given, the segments it has indexed are searched
+    // through their ControllerIndex rather than scanned.
     ControllerSearch(const std::string& eventType,
-                     int controllerId);
+                     int controllerId,
+                     const ControllerContextMap *indexes = nullptr);
 
     // Search Segments A and B for the latest controller value.  B may
     // be nullptr but A must exist.
@@ -86,6 +135,7 @@ class ControllerSearch
     const std::string  m_eventType;
     const int          m_controllerId;
     const Instrument  *m_instrument;
+    const ControllerContextMap *m_indexes;
 };
 
 // @class ControllerContextMap A cache of controller values, one per
@@ -118,6 +168,13 @@ struct ControllerContextMap
     void storeLatestValue(Event *e);
     void clear();
 
+    // Index segment's controllers for the searches made here.  The
+    // index is kept up to date as segment changes and is not affected
+    // by clear().
+    void addIndex(Segment *segment);
+    // The index of segment, or nullptr if it has none.
+    const ControllerIndex *getIndex(const Segment *segment) const;
+
  private:
     static int makeAbsolute(const ControlParameter * controlParameter,
                      int value);
@@ -131,6 +188,8 @@ struct ControllerContextMap
 
     Cache             m_latestValues;
     Maybe             m_PitchBendLatestValue;
+
+    std::map<const Segment *, std::unique_ptr<ControllerIndex> > m_indexes;
  };
 
 class ControllerContextParams
@@ -85,6 +85,9 @@ public:
 
     /// All Instruments on a Device.
     virtual InstrumentVector getAllInstruments() const = 0;
+    /// getAllInstruments() without the copy.
+    const InstrumentVector &getAllInstrumentsRef() const
+        { return m_instruments; }
     /// All Instruments that a user is allowed to select.
     /**
      * For SoftSynthDevice and AudioDevice, this is the same as
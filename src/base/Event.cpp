@@ -38,7 +38,7 @@ const PropertyName Event::NotationTime("!notationtime");
 const PropertyName Event::NotationDuration("!notationduration");
 
 
-Event::EventData::EventData(const std::string &type, timeT absoluteTime,
+Event::EventData::EventData(const std::string *type, timeT absoluteTime,
                             timeT duration, short subOrdering) :
     m_refCount(1),
     m_type(type),
@@ -50,7 +50,7 @@ Event::EventData::EventData(const std::string &type, timeT absoluteTime,
     // empty
 }
 
-Event::EventData::EventData(const std::string &type, timeT absoluteTime,
+Event::EventData::EventData(const std::string *type, timeT absoluteTime,
                             timeT duration, short subOrdering,
                             const PropertyMap *properties) :
     m_refCount(1),
@@ -392,7 +392,8 @@ Event::unsafeChangeTime(timeT offset)
 size_t
 Event::getStorageSize() const
 {
-    size_t s = sizeof(Event) + sizeof(EventData) + m_data->m_type.size();
+    // The type string is shared by all Events of that type.
+    size_t s = sizeof(Event) + sizeof(EventData);
     if (m_data->m_properties) {
         for (PropertyMap::const_iterator i = m_data->m_properties->begin();
              i != m_data->m_properties->end(); ++i) {
@@ -410,6 +411,15 @@ Event::getStorageSize() const
     return s;
 }
 
+size_t
+Event::getUnsharedStorageSize() const
+{
+    if (m_data->m_refCount > 1)
+        return sizeof(Event);
+
+    return getStorageSize();
+}
+
 bool
 Event::isCopyOf(const Event &e) const
 {
@@ -422,7 +432,7 @@ Event::isCopyOf(const Event &e) const
     return false;
 }
 
-int Event::getSubOrdering(const std::string& eventType)
+int Event::getSubOrdering(const EventTypeName &eventType)
 {
     // Missing:
     // - TimeSignature (private, -150)
@@ -480,7 +490,7 @@ operator<(const Event &a, const Event &b)
 
 QDebug operator<<(QDebug dbg, const Event &event)
 {
-    dbg << "Event type :" << event.m_data->m_type << "\n";
+    dbg << "Event type :" << *event.m_data->m_type << "\n";
     dbg << "  Absolute Time :" << event.m_data->m_absoluteTime << "\n";
     dbg << "  Duration :" << event.m_data->m_duration << "\n";
     dbg << "  Sub-ordering :" << event.m_data->m_subOrdering << "\n";
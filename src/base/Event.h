@@ -17,6 +17,7 @@
 #ifndef RG_EVENT_H
 #define RG_EVENT_H
 
+#include "EventTypeName.h"
 #include "PropertyMap.h"
 #include "Exception.h"
 #include "TimeT.h"
@@ -110,37 +111,65 @@ public:
 
     // *** Constructors
 
-    Event(const std::string &type,
+    Event(const EventTypeName &type,
           timeT absoluteTime,
           timeT duration = 0) :
-        m_data(new EventData(type,
+        m_data(new EventData(&type.getName(),
                              absoluteTime,
                              duration,
                              getSubOrdering(type))),
         m_nonPersistentProperties(nullptr)
     { }
 
-    Event(const std::string &type,
+    Event(const EventTypeName &type,
           timeT absoluteTime,
           timeT duration,
           short subOrdering) :
-        m_data(new EventData(type, absoluteTime, duration, subOrdering)),
+        m_data(new EventData(&type.getName(),
+                             absoluteTime, duration, subOrdering)),
         m_nonPersistentProperties(nullptr)
     { }
 
-    Event(const std::string &type,
+    Event(const EventTypeName &type,
           timeT absoluteTime,
           timeT duration,
           short subOrdering,
           timeT notationAbsoluteTime,
           timeT notationDuration) :
-        m_data(new EventData(type, absoluteTime, duration, subOrdering)),
+        m_data(new EventData(&type.getName(),
+                             absoluteTime, duration, subOrdering)),
         m_nonPersistentProperties(nullptr)
     {
         setNotationAbsoluteTime(notationAbsoluteTime);
         setNotationDuration(notationDuration);
     }
 
+    // For types that come from a file or the user.  These intern the
+    // type, which costs a lookup, so prefer the EventType constants.
+
+    Event(const std::string &type,
+          timeT absoluteTime,
+          timeT duration = 0) :
+        Event(EventTypeName(type), absoluteTime, duration)
+    { }
+
+    Event(const std::string &type,
+          timeT absoluteTime,
+          timeT duration,
+          short subOrdering) :
+        Event(EventTypeName(type), absoluteTime, duration, subOrdering)
+    { }
+
+    Event(const std::string &type,
+          timeT absoluteTime,
+          timeT duration,
+          short subOrdering,
+          timeT notationAbsoluteTime,
+          timeT notationDuration) :
+        Event(EventTypeName(type), absoluteTime, duration, subOrdering,
+              notationAbsoluteTime, notationDuration)
+    { }
+
     // these ctors can't use default args: default has to be obtained from e
 
     Event(const Event &e,
@@ -262,17 +291,29 @@ public:
     /**
      * See NotationTypes.h and MidiTypes.h for more examples.
      */
-    std::string getType() const
+    /**
+     * The returned string is interned and outlives the Event, and
+     * comparing it against the EventType constants is cheap.
+     */
+    const std::string &getType() const
     {
         if (!m_data) {
             // cppcheck-suppress ConfigurationNotChecked
             RG_DEBUG << "Event::getType(): FATAL: m_data == nullptr.  Crash likely.";
-            return "";
+            return EventTypeName::Empty();
         }
-        return m_data->m_type;
+        return *m_data->m_type;
     }
     /// Check Event type.
-    bool isa(const std::string &type) const  { return (m_data->m_type == type); }
+    /**
+     * A pointer compare.  Use this with the EventType constants (e.g.
+     * Note::EventType) in loops.
+     */
+    bool isa(const EventTypeName &type) const
+            { return (m_data->m_type == &type.getName()); }
+    /// Check Event type against an arbitrary string.
+    bool isa(const std::string &type) const
+            { return (m_data->m_type == &type  ||  *m_data->m_type == type); }
 
     timeT getAbsoluteTime() const  { return m_data->m_absoluteTime; }
 
@@ -461,6 +502,14 @@ public:
     /// Approximate.  For debugging and inspection purposes.
     size_t getStorageSize() const;
 
+    /// Approximate storage owned by this Event alone.
+    /**
+     * Like getStorageSize(), but the EventData is only counted if no
+     * other Event shares it.  Used for undo history accounting, where
+     * most saved Events share their data with the live Segment.
+     */
+    size_t getUnsharedStorageSize() const;
+
     // UNUSED
     static void dumpStats(std::ostream &);
 
@@ -469,7 +518,7 @@ protected:
     // Interface for subclasses such as XmlStorableEvent.
 
     Event() :
-        m_data(new EventData("", 0, 0, 0)),
+        m_data(new EventData(&EventTypeName::Empty().getName(), 0, 0, 0)),
         m_nonPersistentProperties(nullptr)
     { }
 
@@ -479,7 +528,8 @@ protected:
      * Segment.  Use this only to modify an Event before it is added to a
      * Segment.
      */
-    void setType(const std::string &t)  { unshare(); m_data->m_type = t; }
+    void setType(const std::string &t)
+            { unshare(); m_data->m_type = EventTypeName::intern(t); }
 
     /**
      * This field is immutable when the Event is in a Segment.  Changing it
@@ -496,9 +546,9 @@ private:
     /// Data that are shared between shallow-copied instances
     struct EventData
     {
-        EventData(const std::string &type,
+        EventData(const std::string *type,
                   timeT absoluteTime, timeT duration, short subOrdering);
-        EventData(const std::string &type,
+        EventData(const std::string *type,
                   timeT absoluteTime, timeT duration, short subOrdering,
                   const PropertyMap *properties);
         /// Make a unique copy.  Used for Copy On Write.
@@ -506,7 +556,9 @@ private:
         ~EventData();
         unsigned int m_refCount;
 
-        std::string m_type;
+        /// Interned by EventTypeName, so two types are equal iff the
+        /// pointers are.
+        const std::string *m_type;
         timeT m_absoluteTime;
         timeT m_duration;
         short m_subOrdering;
@@ -533,6 +585,11 @@ private:
                 return false;
             if (m_subOrdering != rhs.m_subOrdering)
                 return false;
+            // Either may have no property map at all.
+            const bool empty = !m_properties || m_properties->empty();
+            const bool rhsEmpty = !rhs.m_properties || rhs.m_properties->empty();
+            if (empty || rhsEmpty)
+                return empty == rhsEmpty;
             if (*m_properties != *rhs.m_properties)
                 return false;
             return true;
@@ -627,7 +684,7 @@ private:
         return (*propertyMap)->insert(pair).first;
     }
 
-    static int getSubOrdering(const std::string& eventType);
+    static int getSubOrdering(const EventTypeName &eventType);
 
 #ifndef NDEBUG
     static int m_getCount;
@@ -0,0 +1,60 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "EventTypeName.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <set>
+
+
+namespace Rosegarden
+{
+
+
+namespace
+{
+    // Node-based, so the strings never move once inserted.
+    typedef std::set<std::string> NameSet;
+
+    // Create on first use to avoid static init order fiasco.  The
+    // EventType constants are interned during static init.
+    // Note: These are deliberate memory leaks since we cannot be sure
+    //       who might access them as we are going down.
+    NameSet &a_names()
+    {
+        static NameSet *names = new NameSet;
+        return *names;
+    }
+
+    QMutex &a_namesMutex()
+    {
+        static QMutex *mutex = new QMutex;
+        return *mutex;
+    }
+}
+
+
+const std::string *
+EventTypeName::intern(const std::string &name)
+{
+    QMutexLocker locker(&a_namesMutex());
+
+    return &*a_names().insert(name).first;
+}
+
+
+}
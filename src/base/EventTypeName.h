@@ -0,0 +1,127 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_EVENT_TYPE_NAME_H
+#define RG_EVENT_TYPE_NAME_H
+
+#include <string>
+#include <ostream>
+
+#include <rosegardenprivate_export.h>
+
+namespace Rosegarden
+{
+
+
+/// Interned Event type name (e.g. "note", Note::EventType).
+/**
+
+  Like PropertyName, this maps an Event type string to a runtime-only
+  atom so that Event::isa() is a single pointer compare instead of a
+  string compare.  The atom is the address of a shared copy of the
+  string which is never freed, so Event::getType() can return it by
+  reference without allocating.
+
+  The strings themselves are what get written to the .rg file and
+  shown to the user, so nothing outside of a running Rosegarden ever
+  sees the atoms.  As with PropertyName, do not persist them.
+
+  EventTypeName converts implicitly to const std::string & so the
+  EventType constants (Note::EventType, Controller::EventType, ...)
+  can still be used anywhere a std::string is expected.
+
+  Unlike PropertyName, interning is thread-safe so that Events can be
+  created on worker threads.
+
+*/
+
+class ROSEGARDENPRIVATE_EXPORT EventTypeName
+{
+public:
+    EventTypeName() : m_name(&Empty().getName())  { }
+    explicit EventTypeName(const char *name) : m_name(intern(name))  { }
+    explicit EventTypeName(const std::string &name) : m_name(intern(name))  { }
+
+    bool operator==(const EventTypeName &t) const
+            { return m_name == t.m_name; }
+    bool operator!=(const EventTypeName &t) const
+            { return m_name != t.m_name; }
+
+    const std::string &getName() const  { return *m_name; }
+    operator const std::string &() const  { return *m_name; }
+    const char *c_str() const  { return m_name->c_str(); }
+
+    /// Returns the empty string EventTypeName ("").
+    static const EventTypeName &Empty()
+    {
+        // Create on first use to avoid static init order fiasco.
+        static const EventTypeName empty("");
+        return empty;
+    }
+
+    /// Return the shared copy of name, creating it if necessary.
+    /**
+     * Two strings compare equal if and only if they intern to the
+     * same pointer.
+     */
+    static const std::string *intern(const std::string &name);
+
+private:
+    const std::string *m_name;
+};
+
+// Comparisons against plain strings.  Event::getType() returns the
+// interned string itself, so the address check usually settles it.
+
+inline bool operator==(const std::string &s, const EventTypeName &t)
+{
+    return &s == &t.getName()  ||  s == t.getName();
+}
+
+inline bool operator==(const EventTypeName &t, const std::string &s)
+{
+    return s == t;
+}
+
+inline bool operator!=(const std::string &s, const EventTypeName &t)
+{
+    return !(s == t);
+}
+
+inline bool operator!=(const EventTypeName &t, const std::string &s)
+{
+    return !(s == t);
+}
+
+inline std::ostream &operator<<(std::ostream &out, const EventTypeName &t)
+{
+    out << t.getName();
+    return out;
+}
+
+inline std::string operator+(const std::string &s, const EventTypeName &t)
+{
+    return s + t.getName();
+}
+
+inline std::string operator+(const char *s, const EventTypeName &t)
+{
+    return s + t.getName();
+}
+
+
+}
+
+#endif
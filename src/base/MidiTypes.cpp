@@ -26,7 +26,7 @@ namespace Rosegarden
 // PitchBend
 //////////////////////////////////////////////////////////////////////
 
-const std::string PitchBend::EventType = "pitchbend";
+const EventTypeName PitchBend::EventType("pitchbend");
 
 const PropertyName PitchBend::MSB("msb");
 const PropertyName PitchBend::LSB("lsb");
@@ -45,7 +45,7 @@ Event *PitchBend::makeEvent(timeT absoluteTime, MidiByte msb, MidiByte lsb)
 // Controller
 //////////////////////////////////////////////////////////////////////
 
-const char *Controller::EventType{"controller"};
+const EventTypeName Controller::EventType("controller");
 
 const PropertyName Controller::NUMBER{"number"};
 const PropertyName Controller::VALUE{"value"};
@@ -127,7 +127,7 @@ const QString &Controller::getName(const MidiByte number)
 // RPN
 //////////////////////////////////////////////////////////////////////
 
-const char *RPN::EventType{"rpn"};
+const EventTypeName RPN::EventType("rpn");
 
 const PropertyName RPN::NUMBER{"number"};
 const PropertyName RPN::VALUE{"value"};
@@ -151,7 +151,7 @@ RPN::makeEvent(timeT absoluteTime, int number, int value)
 // NRPN
 //////////////////////////////////////////////////////////////////////
 
-const char *NRPN::EventType{"nrpn"};
+const EventTypeName NRPN::EventType("nrpn");
 
 const PropertyName NRPN::NUMBER{"number"};
 const PropertyName NRPN::VALUE{"value"};
@@ -175,7 +175,7 @@ NRPN::makeEvent(timeT absoluteTime, int number, int value)
 // Key Pressure
 //////////////////////////////////////////////////////////////////////
 
-const std::string KeyPressure::EventType = "keypressure";
+const EventTypeName KeyPressure::EventType("keypressure");
 
 const PropertyName KeyPressure::PITCH("pitch");
 const PropertyName KeyPressure::PRESSURE("pressure");
@@ -195,7 +195,7 @@ KeyPressure::makeEvent(timeT absoluteTime, MidiByte pitch, MidiByte pressure)
 // Channel Pressure
 //////////////////////////////////////////////////////////////////////
 
-const std::string ChannelPressure::EventType = "channelpressure";
+const EventTypeName ChannelPressure::EventType("channelpressure");
 
 const PropertyName ChannelPressure::PRESSURE("pressure");
 
@@ -213,7 +213,7 @@ ChannelPressure::makeEvent(timeT absoluteTime, MidiByte pressure)
 // ProgramChange
 //////////////////////////////////////////////////////////////////////
 
-const std::string ProgramChange::EventType = "programchange";
+const EventTypeName ProgramChange::EventType("programchange");
 
 const PropertyName ProgramChange::PROGRAM("program");
 
@@ -252,7 +252,7 @@ namespace
 
 }
 
-const std::string SystemExclusive::EventType = "systemexclusive";
+const EventTypeName SystemExclusive::EventType("systemexclusive");
 
 const PropertyName SystemExclusive::DATABLOCK("datablock");
 
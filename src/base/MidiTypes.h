@@ -18,6 +18,7 @@
 
 #include "Exception.h"
 #include "MidiProgram.h"  // For MidiByte
+#include "EventTypeName.h"
 #include "PropertyName.h"
 #include "TimeT.h"
 
@@ -40,7 +41,7 @@ class Event;
 
 namespace PitchBend
 {
-    extern const std::string EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName MSB;
@@ -54,7 +55,7 @@ namespace PitchBend
 
 namespace Controller
 {
-    extern const char *EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName NUMBER;
@@ -70,7 +71,7 @@ namespace Controller
 // Registered Parameter Numbers
 namespace RPN
 {
-    extern const char *EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName NUMBER;
@@ -84,7 +85,7 @@ namespace RPN
 // Non-Registered Parameter Numbers
 namespace NRPN
 {
-    extern const char *EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName NUMBER;
@@ -98,7 +99,7 @@ namespace NRPN
 
 namespace KeyPressure
 {
-    extern const std::string EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName PITCH;
@@ -112,7 +113,7 @@ namespace KeyPressure
 
 namespace ChannelPressure
 {
-    extern const std::string EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName PRESSURE;
@@ -125,7 +126,7 @@ namespace ChannelPressure
 
 namespace ProgramChange
 {
-    extern const std::string EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     extern const PropertyName PROGRAM;
@@ -138,7 +139,7 @@ namespace ProgramChange
 
 namespace SystemExclusive
 {
-    extern const std::string EventType;
+    extern const EventTypeName EventType;
     constexpr int EventSubOrdering = -5;
 
     struct BadEncoding : public Exception {
@@ -26,10 +26,16 @@
 //#include "base/Profiler.h"
 #include "misc/Debug.h"
 
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
 #include <iostream>
 #include <cmath>
 #include <cstdio> // for sprintf
 #include <ctime>
+#include <deque>
+#include <unordered_map>
 
 // Don't forget to comment out RG_NO_DEBUG_PRINT above as well.
 //#define DEBUG_NOTATION_QUANTIZER 1
@@ -50,6 +56,7 @@ public:
         m_maxTuplet(3),
         m_articulate(true),
         m_contrapuntal(false),
+        m_threadCount(0),
         m_q(q),
         m_provisionalBase("notationquantizer-provisionalBase"),
         m_provisionalAbsTime("notationquantizer-provisionalAbsTime"),
@@ -64,6 +71,7 @@ public:
         m_maxTuplet(i.m_maxTuplet),
         m_articulate(i.m_articulate),
         m_contrapuntal(false),
+        m_threadCount(i.m_threadCount),
         m_q(i.m_q),
         m_provisionalBase(i.m_provisionalBase),
         m_provisionalAbsTime(i.m_provisionalAbsTime),
@@ -72,17 +80,99 @@ public:
         m_provisionalScore(i.m_provisionalScore)
     { }
 
+    /// Working values for one Event during one quantizeRange().
+    /**
+     * These used to be kept in "notationquantizer-provisional..."
+     * properties on the Events themselves, which meant a property map
+     * insert (and possibly an EventData copy) per value per Event, and
+     * the same again to remove them at the end.
+     *
+     * Events outside the range (chord notes past the end, or notes in
+     * a bar scanned for tuplets) still get the properties, as they
+     * always have.  See seedProvisional() and storeProvisional().
+     */
+    struct Scratch
+    {
+        Event *event{nullptr};
+
+        timeT absTime{0};
+        timeT duration{0};
+        timeT base{0};
+        long score{0};
+        int noteType{0};
+
+        bool haveAbsTime{false};
+        bool haveDuration{false};
+        bool haveBase{false};
+        bool haveScore{false};
+        bool haveNoteType{false};
+
+        /// The values came from properties left by an earlier run.
+        bool lingering{false};
+        /// The Event is in the range being quantized.
+        bool inRange{false};
+    };
+
+    /// The Scratch for each Event touched by one quantizeRange().
+    /**
+     * A deque so that references stay valid as entries are added.
+     */
+    class ScratchTable
+    {
+    public:
+        /// The Event's Scratch, or nullptr if it has none.
+        const Scratch *find(const Event *e) const
+        {
+            auto iter = m_index.find(e);
+            if (iter == m_index.end())
+                return nullptr;
+            return &m_scratch[iter->second];
+        }
+
+        /// The Event's Scratch, creating it if necessary.
+        Scratch &get(Event *e)
+        {
+            auto result = m_index.insert(
+                    std::make_pair(e, m_scratch.size()));
+            if (result.second) {
+                m_scratch.emplace_back();
+                m_scratch.back().event = e;
+            }
+            return m_scratch[result.first->second];
+        }
+
+        /// Forget the Event, which is about to be deleted.
+        void erase(const Event *e)  { m_index.erase(e); }
+
+        /// Call function(Scratch &) for each Event still in the table.
+        template <typename Function>
+        void forEach(Function function)
+        {
+            for (const auto &entry : m_index) {
+                function(m_scratch[entry.second]);
+            }
+        }
+
+    private:
+        std::deque<Scratch> m_scratch;
+        std::unordered_map<const Event *, size_t> m_index;
+    };
+
     class ProvisionalQuantizer : public Quantizer {
         // This class exists only to pick out the provisional abstime
         // and duration values from half-quantized events, so that we
         // can treat them using the normal Chord class
     public:
-        explicit ProvisionalQuantizer(const Impl *i) : Quantizer("blah", "blahblah"), m_impl(i) { }
+        ProvisionalQuantizer(const Impl *i, const ScratchTable &scratch) :
+            Quantizer("blah", "blahblah"),
+            m_impl(i),
+            m_scratch(scratch)
+        { }
         timeT getQuantizedDuration(const Event *e) const override {
-            return m_impl->getProvisional(e, DurationValue);
+            return m_impl->getProvisional(m_scratch, e, DurationValue);
         }
         timeT getQuantizedAbsoluteTime(const Event *e) const override {
-            timeT t = m_impl->getProvisional(e, AbsoluteTimeValue);
+            timeT t = m_impl->getProvisional(m_scratch, e, AbsoluteTimeValue);
 #ifdef DEBUG_NOTATION_QUANTIZER
             RG_DEBUG << "ProvisionalQuantizer::getQuantizedAbsoluteTime(): returning " << t;
 #endif
@@ -91,42 +181,117 @@ public:
 
     private:
         const Impl *m_impl;
+        const ScratchTable &m_scratch;
+    };
+
+    /// Scores for snapping a time to the nearest multiples of base.
+    /**
+     * Lower is better.  leftScore does not yet include the penalty for
+     * the neighbouring notes.  See neighbourPenalty().
+     */
+    struct BaseScore
+    {
+        timeT base;
+        /// The time snapped left (down) to a multiple of base.
+        timeT leftTime;
+        long leftScore;
+        long rightScore;
+    };
+
+    /// Everything needed to pick an Event's absolute time.
+    /**
+     * See quantizeAbsoluteTimes().
+     */
+    struct AbsoluteTimeJob
+    {
+        Scratch *scratch;
+
+        timeT t;
+        timeT sigTime;
+        timeT d;
+        int noteType;
+        timeT barDuration;
+        int maxDepth;
+        std::vector<int> divisions;
+
+        /// Previous starting note (N) or nullptr.
+        const Event *n;
+        /// Previous starting note that ends before this one starts (N').
+        const Event *nprime;
+
+        /// One per depth.  Filled in by scoreJob().
+        std::vector<BaseScore> scores;
     };
+    typedef std::vector<AbsoluteTimeJob> AbsoluteTimeJobs;
+    class ScoreTask;
 
     void quantizeRange(Segment *,
                        Segment::iterator,
                        Segment::iterator) const;
 
-    void quantizeAbsoluteTime(Segment *, Segment::iterator) const;
-    long scoreAbsoluteTimeForBase(Segment *, const Segment::iterator &,
+    /// Provisionally quantize the absolute times of the non-rests.
+    /**
+     * Erases the rests in [from, to).
+     */
+    void quantizeAbsoluteTimes(Segment *,
+                               Segment::iterator &from,
+                               Segment::iterator to,
+                               ScratchTable &,
+                               timeT &wholeStart,
+                               timeT &wholeEnd) const;
+    /// The part of the absolute time scoring that is independent of
+    /// other Events.  Thread-safe.
+    void scoreJob(AbsoluteTimeJob &) const;
+    /// Pick the best of the job's scores and set the provisional time.
+    void resolveJob(const AbsoluteTimeJob &, const ScratchTable &) const;
+
+    BaseScore scoreBase(int depth, timeT base, timeT sigTime,
+                        timeT t, timeT d, int noteType) const;
+    double neighbourPenalty(const ScratchTable &,
+                            const Event *n, const Event *nprime,
+                            timeT leftTime) const;
+    long pickScore(const BaseScore &, double penalty2,
+                   bool &wantRight) const;
+    long scoreAbsoluteTimeForBase(const ScratchTable &,
                                   int depth, timeT base, timeT sigTime,
                                   timeT t, timeT d, int noteType,
-                                  const Segment::iterator &,
-                                  const Segment::iterator &,
+                                  const Event *n,
+                                  const Event *nprime,
                                   bool &wantRight) const;
-    void quantizeDurationProvisional(Segment *, Segment::iterator) const;
-    void quantizeDuration(Segment *, Chord &) const;
+
+    void quantizeDurationProvisional(Segment *, Segment::iterator,
+                                     ScratchTable &) const;
+    void quantizeDuration(Segment *, Chord &, ScratchTable &) const;
 
     void scanTupletsInBar(Segment *,
                           timeT barStart, timeT barDuration,
                           timeT wholeStart, timeT wholeEnd,
-                          const std::vector<int> &divisions) const;
+                          const std::vector<int> &divisions,
+                          ScratchTable &) const;
     void scanTupletsAt(Segment *, Segment::iterator, int depth,
                        timeT base, timeT barStart,
-                       timeT tupletStart, timeT tupletBase) const;
+                       timeT tupletStart, timeT tupletBase,
+                       ScratchTable &) const;
     bool isValidTupletAt(Segment *, const Segment::iterator &,
                          int depth, timeT base, timeT sigTime,
-                         timeT tupletBase) const;
+                         timeT tupletBase, const ScratchTable &) const;
 
-    void setProvisional(Event *e, ValueType v, timeT t) const;
-    timeT getProvisional(const Event *, ValueType v) const;
-    void unsetProvisionalProperties(Event *) const;
+    void setProvisional(ScratchTable &, Event *e, ValueType v, timeT t) const;
+    timeT getProvisional(const ScratchTable &,
+                         const Event *, ValueType v) const;
+
+    /// Pick up any provisional properties an earlier run left on e.
+    void seedProvisional(ScratchTable &, Event *e) const;
+    /// Leave the provisional values on the Events outside the range,
+    /// and remove them from the Events inside it.
+    void storeProvisional(ScratchTable &) const;
 
     timeT m_unit;
     int m_simplicityFactor;
     int m_maxTuplet;
     bool m_articulate;
     bool m_contrapuntal;
+    int m_threadCount;
 
 private:
     NotationQuantizer *const m_q;
@@ -138,6 +303,31 @@ private:
     PropertyName m_provisionalScore;
 };
 
+/// Runs scoreJob() on a run of jobs on a worker thread.
+class NotationQuantizer::Impl::ScoreTask : public QRunnable
+{
+public:
+    ScoreTask(const Impl *impl,
+              AbsoluteTimeJobs::iterator begin,
+              AbsoluteTimeJobs::iterator end) :
+        m_impl(impl),
+        m_begin(begin),
+        m_end(end)
+    { }
+
+    void run() override
+    {
+        for (AbsoluteTimeJobs::iterator job = m_begin; job != m_end; ++job) {
+            m_impl->scoreJob(*job);
+        }
+    }
+
+private:
+    const Impl *m_impl;
+    AbsoluteTimeJobs::iterator m_begin;
+    AbsoluteTimeJobs::iterator m_end;
+};
+
 NotationQuantizer::NotationQuantizer() :
     Quantizer(NotationPrefix),
     m_impl(new Impl(this))
@@ -234,61 +424,266 @@ NotationQuantizer::getArticulate() const
 */
 
 void
-NotationQuantizer::Impl::setProvisional(Event *e, ValueType v, timeT t) const
+NotationQuantizer::setThreadCount(int threadCount)
+{
+    m_impl->m_threadCount = threadCount;
+}
+
+void
+NotationQuantizer::Impl::setProvisional(ScratchTable &scratch,
+                                        Event *e, ValueType v, timeT t) const
 {
+    Scratch &entry = scratch.get(e);
     if (v == AbsoluteTimeValue) {
-        e->setMaybe<Int>(m_provisionalAbsTime, t);
+        entry.absTime = t;
+        entry.haveAbsTime = true;
     } else {
-        e->setMaybe<Int>(m_provisionalDuration, t);
+        entry.duration = t;
+        entry.haveDuration = true;
     }
 }
 
 timeT
-NotationQuantizer::Impl::getProvisional(const Event *e, ValueType v) const
+NotationQuantizer::Impl::getProvisional(const ScratchTable &scratch,
+                                        const Event *e, ValueType v) const
 {
-    timeT t;
+    const Scratch *entry = scratch.find(e);
     if (v == AbsoluteTimeValue) {
-        t = e->getAbsoluteTime();
-        e->get<Int>(m_provisionalAbsTime, t);
+        if (entry  &&  entry->haveAbsTime)
+            return entry->absTime;
+        return e->getAbsoluteTime();
     } else {
-        t = e->getDuration();
-        e->get<Int>(m_provisionalDuration, t);
+        if (entry  &&  entry->haveDuration)
+            return entry->duration;
+        return e->getDuration();
+    }
+}
+
+void
+NotationQuantizer::Impl::seedProvisional(ScratchTable &scratch,
+                                         Event *e) const
+{
+    long value = 0;
+
+    if (e->get<Int>(m_provisionalAbsTime, value)) {
+        Scratch &entry = scratch.get(e);
+        entry.absTime = value;
+        entry.haveAbsTime = true;
+        entry.lingering = true;
+    }
+    if (e->get<Int>(m_provisionalDuration, value)) {
+        Scratch &entry = scratch.get(e);
+        entry.duration = value;
+        entry.haveDuration = true;
+        entry.lingering = true;
+    }
+    if (e->get<Int>(m_provisionalBase, value)) {
+        Scratch &entry = scratch.get(e);
+        entry.base = value;
+        entry.haveBase = true;
+        entry.lingering = true;
+    }
+    if (e->get<Int>(m_provisionalScore, value)) {
+        Scratch &entry = scratch.get(e);
+        entry.score = value;
+        entry.haveScore = true;
+        entry.lingering = true;
+    }
+    if (e->get<Int>(m_provisionalNoteType, value)) {
+        Scratch &entry = scratch.get(e);
+        entry.noteType = int(value);
+        entry.haveNoteType = true;
+        entry.lingering = true;
     }
-    return t;
 }
 
 void
-NotationQuantizer::Impl::unsetProvisionalProperties(Event *e) const
+NotationQuantizer::Impl::storeProvisional(ScratchTable &scratch) const
+{
+    scratch.forEach([this](const Scratch &entry) {
+        Event *e = entry.event;
+
+        if (entry.inRange) {
+            if (entry.lingering) {
+                e->unset(m_provisionalBase);
+                e->unset(m_provisionalAbsTime);
+                e->unset(m_provisionalDuration);
+                e->unset(m_provisionalNoteType);
+                e->unset(m_provisionalScore);
+            }
+            return;
+        }
+
+        if (entry.haveAbsTime)
+            e->setMaybe<Int>(m_provisionalAbsTime, entry.absTime);
+        if (entry.haveDuration)
+            e->setMaybe<Int>(m_provisionalDuration, entry.duration);
+        if (entry.haveBase)
+            e->setMaybe<Int>(m_provisionalBase, entry.base);
+        if (entry.haveScore)
+            e->setMaybe<Int>(m_provisionalScore, entry.score);
+        if (entry.haveNoteType)
+            e->setMaybe<Int>(m_provisionalNoteType, entry.noteType);
+    });
+}
+
+namespace
 {
-    e->unset(m_provisionalBase);
-    e->unset(m_provisionalAbsTime);
-    e->unset(m_provisionalDuration);
-    e->unset(m_provisionalNoteType);
-    e->unset(m_provisionalScore);
+    /// Below this many events, the scoring is not worth farming out.
+    constexpr size_t parallelThreshold = 2048;
+    /// Roughly how many events each worker task scores.
+    constexpr size_t eventsPerTask = 512;
 }
 
 void
-NotationQuantizer::Impl::quantizeAbsoluteTime(Segment *s, Segment::iterator i) const
+NotationQuantizer::Impl::quantizeAbsoluteTimes(Segment *s,
+                                               Segment::iterator &from,
+                                               Segment::iterator to,
+                                               ScratchTable &scratch,
+                                               timeT &wholeStart,
+                                               timeT &wholeEnd) const
 {
-    //Profiler profiler("NotationQuantizer::Impl::quantizeAbsoluteTime");
+    //Profiler profiler("NotationQuantizer::Impl::quantizeAbsoluteTimes");
+
+    // This is done in three phases.  Each Event's choice of time
+    // depends on the times already chosen for the notes before it (see
+    // neighbourPenalty()), but the bulk of the work, scoring each
+    // candidate snap base, does not.  So we gather everything up
+    // front, score the bases (on worker threads if there is enough to
+    // do), then make the choices in Segment order.  The result is
+    // identical to doing each Event in turn.
 
     const Composition *comp = s->getComposition();
 
-    TimeSignature timeSig;
-    timeT t = m_q->getFromSource(*i, AbsoluteTimeValue);
-    timeT sigTime = comp->getTimeSignatureAt(t, timeSig);
+    static timeT shortTime = Note(Note::Shortest).getDuration();
 
-    timeT d = getProvisional(*i, DurationValue);
-    int noteType = Note::getNearestNote(d).getNoteType();
-    (*i)->setMaybe<Int>(m_provisionalNoteType, noteType);
+    // *** Phase 1: Gather.
 
-    int maxDepth = 8 - noteType;
-    if (maxDepth < 4) maxDepth = 4;
-    std::vector<int> divisions;
-    timeSig.getDivisions(maxDepth, divisions);
-    if (timeSig == TimeSignature()) // special case for 4/4
-        divisions[0] = 2;
+    AbsoluteTimeJobs jobs;
+    // Bar of each job.  Used to split the scoring up for the workers.
+    std::vector<std::pair<timeT, timeT>> bars;
+
+    Segment::iterator i = from;
+
+    for (Segment::iterator nexti = i; i != to; i = nexti) {
+
+        ++nexti;
+
+        if ((*i)->isa(Note::EventRestType)) {
+            if (i == from) ++from;
+            scratch.erase(*i);
+            s->erase(i);
+            continue;
+        }
+
+        jobs.emplace_back();
+        AbsoluteTimeJob &job = jobs.back();
+        job.scratch = &scratch.get(*i);
+
+        TimeSignature timeSig;
+        job.t = m_q->getFromSource(*i, AbsoluteTimeValue);
+        job.sigTime = comp->getTimeSignatureAt(job.t, timeSig);
+
+        job.d = getProvisional(scratch, *i, DurationValue);
+        job.noteType = Note::getNearestNote(job.d).getNoteType();
+        job.scratch->noteType = job.noteType;
+        job.scratch->haveNoteType = true;
+
+        job.maxDepth = 8 - job.noteType;
+        if (job.maxDepth < 4) job.maxDepth = 4;
+        timeSig.getDivisions(job.maxDepth, job.divisions);
+        if (timeSig == TimeSignature()) // special case for 4/4
+            job.divisions[0] = 2;
+
+        job.barDuration = timeSig.getBarDuration();
+
+        bars.push_back(std::make_pair(
+                job.sigTime, (job.t - job.sigTime) / job.barDuration));
+
+        // The previous starting note (N) and the previous starting note
+        // that ends (roughly) before this one starts (N').  See
+        // neighbourPenalty().
+
+        job.n = nullptr;
+        job.nprime = nullptr;
+
+        Segment::iterator j(i);
+        for (;;) {
+            if (j == s->begin()) break;
+            --j;
+            if ((*j)->isa(Note::EventType)) {
+                if (!job.n) job.n = *j;
+                if ((*j)->getAbsoluteTime() + (*j)->getDuration() + shortTime/2
+                    <= (*i)->getAbsoluteTime()) {
+                    job.nprime = *j;
+                    break;
+                }
+            }
+        }
+
+#ifdef DEBUG_NOTATION_QUANTIZER
+        if (job.n && job.n != job.nprime) {
+            RG_DEBUG << "found n (distinct from nprime) at " << job.n->getAbsoluteTime();
+        }
+        if (job.nprime) {
+            RG_DEBUG << "found nprime at " << job.nprime->getAbsoluteTime()
+                     << ", duration " << job.nprime->getDuration();
+        }
+#endif
+    }
+
+    // *** Phase 2: Score.
+
+    const int threadCount = m_threadCount > 0 ?
+            m_threadCount : QThread::idealThreadCount();
+
+    if (jobs.size() < parallelThreshold  ||  threadCount <= 1) {
+        for (AbsoluteTimeJob &job : jobs) {
+            scoreJob(job);
+        }
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threadCount);
+
+        // Whole bars per task, so that neighbouring notes are scored
+        // together.
+        size_t begin = 0;
+        while (begin < jobs.size()) {
+            size_t end = std::min(begin + eventsPerTask, jobs.size());
+            while (end < jobs.size()  &&  bars[end] == bars[end - 1])
+                ++end;
+            pool.start(new ScoreTask(this,
+                                     jobs.begin() + begin,
+                                     jobs.begin() + end));
+            begin = end;
+        }
+
+        pool.waitForDone();
+    }
+
+    // *** Phase 3: Choose.
+
+    wholeStart = 0;
+    wholeEnd = 0;
+
+    for (const AbsoluteTimeJob &job : jobs) {
 
+        resolveJob(job, scratch);
+
+        timeT t0 = job.scratch->absTime;
+        timeT t1 = job.scratch->duration + t0;
+        if (wholeStart == wholeEnd) {
+            wholeStart = t0;
+            wholeEnd = t1;
+        } else if (t1 > wholeEnd) {
+            wholeEnd = t1;
+        }
+    }
+}
+
+void
+NotationQuantizer::Impl::scoreJob(AbsoluteTimeJob &job) const
+{
     // At each depth of beat subdivision, we find the closest match
     // and assign it a score according to distance and depth.  The
     // calculation for the score should accord "better" scores to
@@ -298,116 +693,90 @@ NotationQuantizer::Impl::quantizeAbsoluteTime(Segment *s, Segment::iterator i) c
     // 2 more than the value of our depth counter, which counts
     // from 0 at a point where the effective depth is already 1.
 
-    timeT base = timeSig.getBarDuration();
+    timeT base = job.barDuration;
 
-    timeT bestBase = -2;
-    long bestScore = 0;
-    bool bestRight = false;
-
-#ifdef DEBUG_NOTATION_QUANTIZER
-    RG_DEBUG << "quantizeAbsoluteTime(): t is " << t << ", d is " << d;
-#endif
-
-    // scoreAbsoluteTimeForBase wants to know the previous starting
-    // note (N) and the previous starting note that ends (roughly)
-    // before this one starts (N').  Much more efficient to calculate
-    // them once now before the loop.
-
-    static timeT shortTime = Note(Note::Shortest).getDuration();
+    job.scores.clear();
+    job.scores.reserve(job.maxDepth);
 
-    Segment::iterator j(i);
-    Segment::iterator n(s->end()), nprime(s->end());
-    for (;;) {
-        if (j == s->begin()) break;
-        --j;
-        if ((*j)->isa(Note::EventType)) {
-            if (n == s->end()) n = j;
-            if ((*j)->getAbsoluteTime() + (*j)->getDuration() + shortTime/2
-                <= (*i)->getAbsoluteTime()) {
-                nprime = j;
-                break;
-            }
-        }
+    for (int depth = 0; depth < job.maxDepth; ++depth) {
+        base /= job.divisions[depth];
+        if (base < m_unit) break;
+        job.scores.push_back(scoreBase(depth, base, job.sigTime,
+                                       job.t, job.d, job.noteType));
     }
+}
+
+void
+NotationQuantizer::Impl::resolveJob(const AbsoluteTimeJob &job,
+                                    const ScratchTable &scratch) const
+{
+    timeT t = job.t;
 
 #ifdef DEBUG_NOTATION_QUANTIZER
-    if (n != s->end() && n != nprime) {
-        RG_DEBUG << "found n (distinct from nprime) at " << (*n)->getAbsoluteTime();
-    }
-    if (nprime != s->end()) {
-        RG_DEBUG << "found nprime at " << (*nprime)->getAbsoluteTime()
-                 << ", duration " << (*nprime)->getDuration();
-    }
+    RG_DEBUG << "resolveJob(): t is " << t << ", d is " << job.d;
 #endif
 
-    for (int depth = 0; depth < maxDepth; ++depth) {
+    timeT bestBase = -2;
+    long bestScore = 0;
+    bool bestRight = false;
+
+    for (size_t depth = 0; depth < job.scores.size(); ++depth) {
+
+        const BaseScore &baseScore = job.scores[depth];
 
-        base /= divisions[depth];
-        if (base < m_unit) break;
         bool right = false;
-        long score = scoreAbsoluteTimeForBase(s, i, depth, base, sigTime,
-                                              t, d, noteType, n, nprime, right);
+        long score = pickScore(
+                baseScore,
+                neighbourPenalty(scratch, job.n, job.nprime,
+                                 baseScore.leftTime),
+                right);
 
         if (depth == 0 || score < bestScore) {
 #ifdef DEBUG_NOTATION_QUANTIZER
             RG_DEBUG << " [*]";
 #endif
-            bestBase = base;
+            bestBase = baseScore.base;
             bestScore = score;
             bestRight = right;
         }
-
-#ifdef DEBUG_NOTATION_QUANTIZER
-        //cout << endl;
-#endif
     }
 
     if (bestBase == -2) {
 #ifdef DEBUG_NOTATION_QUANTIZER
-        RG_DEBUG << "quantizeAbsoluteTime(): weirdness: no snap found";
+        RG_DEBUG << "resolveJob(): weirdness: no snap found";
 #endif
     } else {
         // we need to snap relative to the time sig, not relative
         // to the start of the whole composition
-        t -= sigTime;
+        t -= job.sigTime;
 
         t = (t / bestBase) * bestBase;
         if (bestRight) t += bestBase;
 
-/*
-        timeT low = (t / bestBase) * bestBase;
-        timeT high = low + bestBase;
-        t = ((high - t > t - low) ? low : high);
-*/
-
-        t += sigTime;
+        t += job.sigTime;
 
 #ifdef DEBUG_NOTATION_QUANTIZER
         RG_DEBUG << "snap base is " << bestBase << ", snapped to " << t;
 #endif
     }
 
-    setProvisional(*i, AbsoluteTimeValue, t);
-    (*i)->setMaybe<Int>(m_provisionalBase, bestBase);
-    (*i)->setMaybe<Int>(m_provisionalScore, bestScore);
+    Scratch &entry = *job.scratch;
+    entry.absTime = t;
+    entry.haveAbsTime = true;
+    entry.base = bestBase;
+    entry.haveBase = true;
+    entry.score = bestScore;
+    entry.haveScore = true;
 }
 
-long
-NotationQuantizer::Impl::scoreAbsoluteTimeForBase(
-        Segment *s,
-        const Segment::iterator & /* i */,
-        int depth,
-        timeT base,
-        timeT sigTime,
-        timeT t,
-        timeT d,
-        int noteType,
-        const Segment::iterator &n,
-        const Segment::iterator &nprime,
-        bool &wantRight) const
+NotationQuantizer::Impl::BaseScore
+NotationQuantizer::Impl::scoreBase(int depth,
+                                   timeT base,
+                                   timeT sigTime,
+                                   timeT t,
+                                   timeT d,
+                                   int noteType) const
 {
-    //Profiler profiler("NotationQuantizer::Impl::scoreAbsoluteTimeForBase");
-
     // Lower score is better.
 
     static timeT shortTime = Note(Note::Shortest).getDuration();
@@ -422,78 +791,105 @@ NotationQuantizer::Impl::scoreAbsoluteTimeForBase(
     // notes are more likely to be on big boundaries.  Actually, perhaps
     // introduce a generally-useful "salience" score a la Dixon et al
 
-    long leftScore = 0;
+    BaseScore result;
+    result.base = base;
+
+    long distance = (t - sigTime) % base;
+    result.leftTime = t - distance;
+    result.leftScore = long((distance + shortTime / 2) * effectiveDepth);
 
-    for (int ri = 0; ri < 2; ++ri) {
+    distance = base - distance;
+    long score = long((distance + shortTime / 2) * effectiveDepth);
 
-        bool right = (ri == 1);
+    // seriously penalise moving a note beyond its own end time
+    if (d > 0 && distance >= d * 0.9) {
+        score = long(score * (double(distance) / d + 0.5));
+    }
 
-        long distance = (t - sigTime) % base;
-        if (right) distance = base - distance;
-        long score = long((distance + shortTime / 2) * effectiveDepth);
+    result.rightScore = score;
 
-        double penalty1 = 1.0;
+#ifdef DEBUG_NOTATION_QUANTIZER
+    RG_DEBUG << "  depth/eff/base/left/right: " << depth << "/" << effectiveDepth << "/" << base << "/" << result.leftScore << "/" << result.rightScore;
+#endif
 
-        // seriously penalise moving a note beyond its own end time
-        if (d > 0 && right && distance >= d * 0.9) {
-            penalty1 = double(distance) / d + 0.5;
-        }
+    return result;
+}
 
-        double penalty2 = 1.0;
+double
+NotationQuantizer::Impl::neighbourPenalty(const ScratchTable &scratch,
+                                          const Event *n,
+                                          const Event *nprime,
+                                          timeT leftTime) const
+{
+    double penalty = 1.0;
 
-        // Examine the previous starting note (N), and the previous
-        // starting note that ends before this one starts (N').
+    // Examine the previous starting note (N), and the previous
+    // starting note that ends before this one starts (N').
 
-        // We should penalise moving this note to before the performed end
-        // of N' and seriously penalise moving it to the same quantized
-        // start time as N' -- but we should encourage moving it to the
-        // same time as the provisional end of N', or to the same start
-        // time as N if N != N'.
+    // We should penalise moving this note to before the performed end
+    // of N' and seriously penalise moving it to the same quantized
+    // start time as N' -- but we should encourage moving it to the
+    // same time as the provisional end of N', or to the same start
+    // time as N if N != N'.
 
-        if (!right) {
-            if (n != s->end()) {
-                if (n != nprime) {
-                    timeT nt = getProvisional(*n, AbsoluteTimeValue);
-                    if (t - distance == nt) penalty2 = penalty2 * 2 / 3;
-                }
-                if (nprime != s->end()) {
-                    timeT npt = getProvisional(*nprime, AbsoluteTimeValue);
-                    timeT npd = getProvisional(*nprime, DurationValue);
-                    if (t - distance <= npt) penalty2 *= 4;
-                    else if (t - distance < npt + npd) penalty2 *= 2;
-                    else if (t - distance == npt + npd) penalty2 = penalty2 * 2 / 3;
-                }
-            }
+    if (n) {
+        if (n != nprime) {
+            timeT nt = getProvisional(scratch, n, AbsoluteTimeValue);
+            if (leftTime == nt) penalty = penalty * 2 / 3;
         }
+        if (nprime) {
+            timeT npt = getProvisional(scratch, nprime, AbsoluteTimeValue);
+            timeT npd = getProvisional(scratch, nprime, DurationValue);
+            if (leftTime <= npt) penalty *= 4;
+            else if (leftTime < npt + npd) penalty *= 2;
+            else if (leftTime == npt + npd) penalty = penalty * 2 / 3;
+        }
+    }
 
-#ifdef DEBUG_NOTATION_QUANTIZER
-        RG_DEBUG << "  depth/eff/dist/t/score/pen1/pen2/res: " << depth << "/" << effectiveDepth << "/" << distance << "/" << (right ? t + distance : t - distance) << "/" << score << "/" << penalty1 << "/" << penalty2 << "/" << (score * penalty1 * penalty2);
-        if (right) RG_DEBUG << " -> ";
-        else RG_DEBUG << " <- ";
-        //if (ri == 0) cout << endl;
-#endif
+    return penalty;
+}
 
-        score = long(score * penalty1);
-        score = long(score * penalty2);
+long
+NotationQuantizer::Impl::pickScore(const BaseScore &baseScore,
+                                   double penalty2,
+                                   bool &wantRight) const
+{
+    long leftScore = long(baseScore.leftScore * penalty2);
 
-        if (ri == 0) {
-            leftScore = score;
-        } else {
-            if (score < leftScore) {
-                wantRight = true;
-                return score;
-            } else {
-                wantRight = false;
-                return leftScore;
-            }
-        }
+    if (baseScore.rightScore < leftScore) {
+        wantRight = true;
+        return baseScore.rightScore;
+    } else {
+        wantRight = false;
+        return leftScore;
     }
+}
+
+long
+NotationQuantizer::Impl::scoreAbsoluteTimeForBase(
+        const ScratchTable &scratch,
+        int depth,
+        timeT base,
+        timeT sigTime,
+        timeT t,
+        timeT d,
+        int noteType,
+        const Event *n,
+        const Event *nprime,
+        bool &wantRight) const
+{
+    //Profiler profiler("NotationQuantizer::Impl::scoreAbsoluteTimeForBase");
 
-    return leftScore;
+    BaseScore baseScore = scoreBase(depth, base, sigTime, t, d, noteType);
+    return pickScore(baseScore,
+                     neighbourPenalty(scratch, n, nprime, baseScore.leftTime),
+                     wantRight);
 }
 
 void
-NotationQuantizer::Impl::quantizeDurationProvisional(Segment *, Segment::iterator i)
+NotationQuantizer::Impl::quantizeDurationProvisional(Segment *,
+                                                     Segment::iterator i,
+                                                     ScratchTable &scratch)
     const
 {
     //Profiler profiler("NotationQuantizer::Impl::quantizeDurationProvisional");
@@ -503,7 +899,7 @@ NotationQuantizer::Impl::quantizeDurationProvisional(Segment *, Segment::iterato
 
     timeT d = m_q->getFromSource(*i, DurationValue);
     if (d == 0) {
-        setProvisional(*i, DurationValue, d);
+        setProvisional(scratch, *i, DurationValue, d);
         return;
     }
 
@@ -541,7 +937,7 @@ NotationQuantizer::Impl::quantizeDurationProvisional(Segment *, Segment::iterato
         }
     }
 
-    setProvisional(*i, DurationValue, time);
+    setProvisional(scratch, *i, DurationValue, time);
 
     if ((*i)->has(BEAMED_GROUP_TUPLET_BASE)) {
         // We're going to recalculate these, and use our own results
@@ -555,7 +951,8 @@ NotationQuantizer::Impl::quantizeDurationProvisional(Segment *, Segment::iterato
 }
 
 void
-NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
+NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c,
+                                          ScratchTable &scratch) const
 {
     static int totalFracCount = 0;
     static float totalFrac = 0;
@@ -572,7 +969,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
 //    timeT t = m_q->getFromSource(*c.getInitialElement(), AbsoluteTimeValue);
 //    timeT sigTime = comp->getTimeSignatureAt(t, timeSig);
 
-    timeT d = getProvisional(*c.getInitialElement(), DurationValue);
+    timeT d = getProvisional(scratch, *c.getInitialElement(), DurationValue);
     int noteType = Note::getNearestNote(d).getNoteType();
     int maxDepth = 8 - noteType;
     if (maxDepth < 4) maxDepth = 4;
@@ -582,7 +979,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
     Segment::iterator nextNote = c.getNextNote();
     timeT nextNoteTime =
         (s->isBeforeEndMarker(nextNote) ?
-         getProvisional(*nextNote, AbsoluteTimeValue) :
+         getProvisional(scratch, *nextNote, AbsoluteTimeValue) :
          s->getEndMarkerTime());
 
     timeT nonContrapuntalDuration = 0;
@@ -590,7 +987,8 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
     for (Chord::iterator ci = c.begin(); ci != c.end(); ++ci) {
 
         if (!(**ci)->isa(Note::EventType)) continue;
-        if ((**ci)->has(m_provisionalDuration) &&
+        const Scratch *entry = scratch.find(**ci);
+        if (entry && entry->haveDuration &&
             (**ci)->has(BEAMED_GROUP_TUPLET_BASE)) {
             // dealt with already in tuplet code, we'd only mess it up here
 #ifdef DEBUG_NOTATION_QUANTIZER
@@ -607,7 +1005,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
 #ifdef DEBUG_NOTATION_QUANTIZER
                 RG_DEBUG << "setting duration trivially to " << nonContrapuntalDuration;
 #endif
-                setProvisional(**ci, DurationValue, nonContrapuntalDuration);
+                setProvisional(scratch, **ci, DurationValue, nonContrapuntalDuration);
                 continue;
             } else {
                 // establish whose duration to use, then set it at the
@@ -620,7 +1018,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
             ud = m_q->getFromSource(**ci, DurationValue);
         }
 
-        timeT qt = getProvisional(**ci, AbsoluteTimeValue);
+        timeT qt = getProvisional(scratch, **ci, AbsoluteTimeValue);
 
 #ifdef DEBUG_NOTATION_QUANTIZER
         RG_DEBUG << "note at time " << (**ci)->getAbsoluteTime() << " (provisional time " << qt << ")";
@@ -640,7 +1038,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
                  << bases.first << " and " << bases.second;
 #endif
 
-        timeT qd = getProvisional(**ci, DurationValue);
+        timeT qd = getProvisional(scratch, **ci, DurationValue);
 
         timeT spaceAvailable = nextNoteTime - qt;
 
@@ -668,7 +1066,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
             if (bases.first == 0) return;
 
             timeT absTimeBase = bases.first;
-            (**ci)->get<Int>(m_provisionalBase, absTimeBase);
+            if (entry && entry->haveBase) absTimeBase = entry->base;
 
             spaceAvailable = std::min(spaceAvailable,
                                       comp->getBarEndForTime(qt) - qt);
@@ -724,7 +1122,7 @@ NotationQuantizer::Impl::quantizeDuration(Segment *s, Chord &c) const
             }
         }
 
-        setProvisional(**ci, DurationValue, qd);
+        setProvisional(scratch, **ci, DurationValue, qd);
         if (!m_contrapuntal) nonContrapuntalDuration = qd;
     }
 
@@ -741,7 +1139,8 @@ NotationQuantizer::Impl::scanTupletsInBar(
         timeT barDuration,
         timeT wholeStart,
         timeT wholeEnd,
-        const std::vector<int> &divisions) const
+        const std::vector<int> &divisions,
+        ScratchTable &scratch) const
 {
     //Profiler profiler("NotationQuantizer::Impl::scanTupletsInBar");
 
@@ -784,10 +1183,14 @@ NotationQuantizer::Impl::scanTupletsInBar(
             Segment::iterator j = s->findTime(tupletStart - tupletBase / 3);
             timeT jTime = tupletEnd;
 
-            while (s->isBeforeEndMarker(j) &&
-                   (!(*j)->isa(Note::EventType) ||
-                    !(*j)->get<Int>(m_provisionalAbsTime, jTime) ||
-                    jTime < tupletStart)) {
+            while (s->isBeforeEndMarker(j)) {
+                if ((*j)->isa(Note::EventType)) {
+                    const Scratch *entry = scratch.find(*j);
+                    if (entry && entry->haveAbsTime) {
+                        jTime = entry->absTime;
+                        if (jTime >= tupletStart) break;
+                    }
+                }
                 if ((*j)->getAbsoluteTime() > tupletEnd + tupletBase / 3) {
                     break;
                 }
@@ -803,7 +1206,7 @@ NotationQuantizer::Impl::scanTupletsInBar(
             }
 
             scanTupletsAt(s, j, depth+1, base, barStart,
-                          tupletStart, tupletBase);
+                          tupletStart, tupletBase, scratch);
 
             tupletStart = tupletEnd;
         }
@@ -819,7 +1222,8 @@ NotationQuantizer::Impl::scanTupletsAt(
         timeT base,
         timeT barStart,
         timeT tupletStart,
-        timeT tupletBase) const
+        timeT tupletBase,
+        ScratchTable &scratch) const
 {
     //Profiler profiler("NotationQuantizer::Impl::scanTupletsAt");
 
@@ -830,10 +1234,16 @@ NotationQuantizer::Impl::scanTupletsAt(
     std::vector<Event *> candidates;
     int count = 0;
 
-    while (s->isBeforeEndMarker(j) &&
-           ((*j)->isa(Note::EventRestType) ||
-            ((*j)->get<Int>(m_provisionalAbsTime, jTime) &&
-             jTime < tupletEnd))) {
+    while (s->isBeforeEndMarker(j)) {
+
+        const Scratch *entry = nullptr;
+
+        if (!(*j)->isa(Note::EventRestType)) {
+            entry = scratch.find(*j);
+            if (!entry || !entry->haveAbsTime) break;
+            jTime = entry->absTime;
+            if (jTime >= tupletEnd) break;
+        }
 
         if (!(*j)->isa(Note::EventType)) { ++j; continue; }
 
@@ -850,15 +1260,15 @@ NotationQuantizer::Impl::scanTupletsAt(
             return;
         }
 
-        timeT originalBase;
-
-        if (!(*j)->get<Int>(m_provisionalBase, originalBase)) {
+        if (!entry->haveBase) {
 #ifdef DEBUG_NOTATION_QUANTIZER
             RG_DEBUG << "some notes not provisionally quantized, no good";
 #endif
             return;
         }
 
+        timeT originalBase = entry->base;
+
         if (originalBase == base) {
 #ifdef DEBUG_NOTATION_QUANTIZER
             RG_DEBUG << "accepting note at original base";
@@ -876,7 +1286,8 @@ NotationQuantizer::Impl::scanTupletsAt(
             // anything from that).  Reject the entire group if it fails
             // any of the likelihood tests for tuplets.
 
-            if (!isValidTupletAt(s, j, depth, base, barStart, tupletBase)) {
+            if (!isValidTupletAt(s, j, depth, base, barStart, tupletBase,
+                                 scratch)) {
 #ifdef DEBUG_NOTATION_QUANTIZER
                 RG_DEBUG << "no good";
 #endif
@@ -938,8 +1349,8 @@ NotationQuantizer::Impl::scanTupletsAt(
 
         t += tupletStart;
 
-        setProvisional(*ei, AbsoluteTimeValue, t);
-        setProvisional(*ei, DurationValue, tupletBase);
+        setProvisional(scratch, *ei, AbsoluteTimeValue, t);
+        setProvisional(scratch, *ei, DurationValue, tupletBase);
     }
 
     // fill in with tupleted rests
@@ -971,7 +1382,8 @@ NotationQuantizer::Impl::isValidTupletAt(
         int depth,
         timeT /* base */,
         timeT sigTime,
-        timeT tupletBase) const
+        timeT tupletBase,
+        const ScratchTable &scratch) const
 {
     //Profiler profiler("NotationQuantizer::Impl::isValidTupletAt");
 
@@ -998,17 +1410,19 @@ NotationQuantizer::Impl::isValidTupletAt(
         return false;
     }
 
-    long score = 0;
-    if (!(*i)->get<Int>(m_provisionalScore, score)) return false;
+    const Scratch *entry = scratch.find(*i);
+    if (!entry || !entry->haveScore) return false;
+    long score = entry->score;
 
     timeT t = m_q->getFromSource(*i, AbsoluteTimeValue);
-    timeT d = getProvisional(*i, DurationValue);
-    int noteType = (*i)->get<Int>(m_provisionalNoteType);
+    timeT d = getProvisional(scratch, *i, DurationValue);
+    int noteType = entry->noteType;
 
     //!!! not as complete as the calculation we do in the original scoring
     bool dummy;
     long tupletScore = scoreAbsoluteTimeForBase
-        (s, i, depth, tupletBase, sigTime, t, d, noteType, s->end(), s->end(), dummy);
+        (scratch, depth, tupletBase, sigTime, t, d, noteType,
+         nullptr, nullptr, dummy);
 #ifdef DEBUG_NOTATION_QUANTIZER
     RG_DEBUG << "\nNotationQuantizer::isValidTupletAt: score " << score
          << " vs tupletScore " << tupletScore;
@@ -1055,10 +1469,18 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
     // which things are chords.  We need to assign absolute times to
     // all events, but we only need do durations for notes.
 
-    PropertyName provisionalBase("notationquantizer-provisionalBase");
-
     // We don't use setToTarget until we have our final values ready,
-    // as it erases and replaces the events.  Just set the properties.
+    // as it erases and replaces the events.  Until then the working
+    // values are kept in the scratch table.
+
+    ScratchTable scratch;
+
+    // Provisional values left by earlier runs on Events outside their
+    // ranges are seen by this one, as if they were still set.
+
+    for (Segment::iterator i = s->begin(); i != s->end(); ++i) {
+        seedProvisional(scratch, *i);
+    }
 
     // Set a provisional duration to each note first
 
@@ -1067,39 +1489,19 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
         ++events;
         if ((*i)->isa(Note::EventRestType)) continue;
         if ((*i)->isa(Note::EventType)) ++notes;
-        quantizeDurationProvisional(s, i);
+        quantizeDurationProvisional(s, i, scratch);
+        scratch.get(*i).inRange = true;
     }
     ++passes;
 
     // now do the absolute-time calculation
 
     timeT wholeStart = 0, wholeEnd = 0;
-
-    Segment::iterator i = from;
-
-    for (Segment::iterator nexti = i; i != to; i = nexti) {
-
-        ++nexti;
-
-        if ((*i)->isa(Note::EventRestType)) {
-            if (i == from) ++from;
-            s->erase(i);
-            continue;
-        }
-
-        quantizeAbsoluteTime(s, i);
-
-        timeT t0 = (*i)->get<Int>(m_provisionalAbsTime);
-        timeT t1 = (*i)->get<Int>(m_provisionalDuration) + t0;
-        if (wholeStart == wholeEnd) {
-            wholeStart = t0;
-            wholeEnd = t1;
-        } else if (t1 > wholeEnd) {
-            wholeEnd = t1;
-        }
-    }
+    quantizeAbsoluteTimes(s, from, to, scratch, wholeStart, wholeEnd);
     ++passes;
 
+    Segment::iterator i;
+
     // now we've grouped into chords, look for tuplets next
 
     const Composition *comp = s->getComposition();
@@ -1117,12 +1519,12 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
             if (isNew) timeSig.getDivisions(7, divisions);
             scanTupletsInBar(s, comp->getBarStart(barNo),
                              timeSig.getBarDuration(),
-                             wholeStart, wholeEnd, divisions);
+                             wholeStart, wholeEnd, divisions, scratch);
         }
         ++passes;
     }
 
-    ProvisionalQuantizer provisionalQuantizer(this);
+    ProvisionalQuantizer provisionalQuantizer(this, scratch);
 
     for (i = from; i != to; ++i) {
 
@@ -1135,7 +1537,7 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
         //Chord c(*s, i, m_q);
         Chord c(*s, i, &provisionalQuantizer);
 
-        quantizeDuration(s, c);
+        quantizeDuration(s, c, scratch);
 
         bool ended = false;
         for (Segment::iterator ci = c.getInitialElement();
@@ -1157,7 +1559,7 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
 
             if (!(*i)->isa(Note::EventType)) continue;
 
-            timeT qd = getProvisional(*i, DurationValue);
+            timeT qd = getProvisional(scratch, *i, DurationValue);
             timeT ud = m_q->getFromSource(*i, DurationValue);
 
             if (ud < (qd * 3 / 4) &&
@@ -1170,6 +1572,10 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
         ++passes;
     }
 
+    // setToTarget() replaces the Events in the range, so this has to
+    // be done first.
+    storeProvisional(scratch);
+
     i = from;
 
     for (Segment::iterator nexti = i; i != to; i = nexti) {
@@ -1178,10 +1584,8 @@ NotationQuantizer::Impl::quantizeRange(Segment *s,
 
         if ((*i)->isa(Note::EventRestType)) continue;
 
-        timeT t = getProvisional(*i, AbsoluteTimeValue);
-        timeT d = getProvisional(*i, DurationValue);
-
-        unsetProvisionalProperties(*i);
+        timeT t = getProvisional(scratch, *i, AbsoluteTimeValue);
+        timeT d = getProvisional(scratch, *i, DurationValue);
 
         if ((*i)->getAbsoluteTime() == t &&
             (*i)->getDuration() == d) ++setBad;
@@ -67,6 +67,13 @@ public:
     void setArticulate(bool);
     // unused bool getArticulate() const;
 
+    /**
+     * Set the number of threads used to score note positions in large
+     * ranges.  Default is 0, one per core.  1 does all of the work on
+     * the calling thread.  Doesn't affect the result.
+     */
+    void setThreadCount(int);
+
 protected:
     void quantizeRange(Segment *,
                                Segment::iterator,
@@ -20,6 +20,7 @@
 
 #include "TimeT.h"
 #include "Exception.h"
+#include "EventTypeName.h"
 #include "PropertyName.h"
 
 #include <list>
@@ -277,7 +278,7 @@ namespace Marks
 class ROSEGARDENPRIVATE_EXPORT Clef
 {
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const int EventSubOrdering;
     static const PropertyName ClefPropertyName;
     static const PropertyName OctaveOffsetPropertyName;
@@ -400,7 +401,7 @@ private:
 class ROSEGARDENPRIVATE_EXPORT Key
 {
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const int EventSubOrdering;
     static const PropertyName KeyPropertyName;
     static const Key DefaultKey;
@@ -632,7 +633,7 @@ private:
 class Indication
 {
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const int EventSubOrdering;
     static const PropertyName IndicationTypePropertyName;
     typedef Exception BadIndicationName;
@@ -700,7 +701,7 @@ private:
 class Text
 {
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const int EventSubOrdering;
     static const PropertyName TextPropertyName;
     static const PropertyName TextTypePropertyName;
@@ -789,8 +790,8 @@ private:
 class ROSEGARDENPRIVATE_EXPORT Note
 {
 public:
-    static const std::string EventType;
-    static const std::string EventRestType;
+    static const EventTypeName EventType;
+    static const EventTypeName EventRestType;
     static const int EventRestSubOrdering;
 
     typedef int Type; // not an enum, too much arithmetic at stake
@@ -956,7 +957,7 @@ private:
 class ROSEGARDENPRIVATE_EXPORT Symbol
 {
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const int EventSubOrdering;
     static const PropertyName SymbolTypePropertyName;
 
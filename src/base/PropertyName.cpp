@@ -21,6 +21,8 @@
 
 #include "misc/Debug.h"
 
+#include <QMutex>
+#include <QMutexLocker>
 #include <QtGlobal>  // For Q_ASSERT()
 
 #include <iostream>
@@ -49,10 +51,21 @@ namespace
 
     int a_nextId = 0;
 
+    // PropertyNames are created on worker threads too, e.g. by the
+    // export jobs.  Guards both maps and a_nextId.
+    // Note: This is a deliberate memory leak, as above.
+    QMutex &a_mapsMutex()
+    {
+        static QMutex *mutex = new QMutex;
+        return *mutex;
+    }
+
     // Get the existing ID for a name, or if not found, create
     // a new ID and add to the map.
     int a_getId(const std::string &name)
     {
+        QMutexLocker locker(&a_mapsMutex());
+
         if (!a_nameToIDMap) {
             // Create on first use to avoid static init order fiasco.
             a_nameToIDMap = new NameToIDMap;
@@ -100,6 +113,8 @@ PropertyName &PropertyName::operator=(const std::string &name)
 
 std::string PropertyName::getName() const
 {
+    QMutexLocker locker(&a_mapsMutex());
+
     IDToNameMap::iterator i(a_idToNameMap->find(m_id));
     // Not found?  Return the empty string.
     if (i == a_idToNameMap->end())
@@ -25,25 +25,6 @@
 
 namespace Rosegarden {
 
-RealTime::RealTime(int s, int n) :
-    sec(s),
-    nsec(n)
-{
-    // Normalize so that -nanoSecondsPerSecond < nsec < nanoSecondsPerSecond.
-    sec += nsec / nanoSecondsPerSecond;
-    nsec %= nanoSecondsPerSecond;
-
-    // Check signs and make sure they match.
-    if (sec < 0  &&  nsec > 0) {
-        ++sec;
-        nsec -= nanoSecondsPerSecond;
-    }
-    if (sec > 0  &&  nsec < 0) {
-        --sec;
-        nsec += nanoSecondsPerSecond;
-    }
-}
-
 RealTime
 RealTime::fromSeconds(double sec)
 {
@@ -169,47 +150,13 @@ RealTime::operator*(double m) const
     return fromSeconds(t);
 }
 
-RealTime
-RealTime::operator/(int d) const
-{
-    int secdiv = sec / d;
-    int secrem = sec % d;
-
-    double nsecdiv =
-            (double(nsec) + nanoSecondsPerSecond * double(secrem)) / d;
-    
-    return RealTime(secdiv, int(nsecdiv + 0.5));
-}
-
 double 
 RealTime::operator/(const RealTime &r) const
 {
-    double lTotal = double(sec) * nanoSecondsPerSecond + double(nsec);
-    double rTotal = double(r.sec) * nanoSecondsPerSecond + double(r.nsec);
-    
-    if (rTotal == 0) return 0.0;
-    else return lTotal/rTotal;
-}
-
-long
-RealTime::realTime2Frame(const RealTime &time, unsigned int sampleRate)
-{
-    if (time < zero())
-        return -realTime2Frame(-time, sampleRate);
-    double s = time.sec + double(time.nsec + 1) / 1000000000.0;
-    return long(s * sampleRate);
-}
+    const int64_t rTotal = r.toNanoseconds();
 
-RealTime
-RealTime::frame2RealTime(long frame, unsigned int sampleRate)
-{
-    if (frame < 0) return -frame2RealTime(-frame, sampleRate);
-
-    RealTime rt;
-    rt.sec = frame / sampleRate;
-    frame -= rt.sec * sampleRate;
-    rt.nsec = (int)(((double(frame) * 1000000.0) / sampleRate) * 1000.0);
-    return rt;
+    if (rTotal == 0) return 0.0;
+    else return double(toNanoseconds()) / double(rTotal);
 }
 
 ROSEGARDENPRIVATE_EXPORT QDebug operator<<(QDebug dbg, const Rosegarden::RealTime &t)
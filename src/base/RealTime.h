@@ -20,6 +20,8 @@
 
 #include <QTextStream>
 
+#include <stdint.h>
+
 #include <rosegardenprivate_export.h>
 
 struct timeval;
@@ -34,16 +36,23 @@ constexpr int nanoSecondsPerSecond = 1000000000;
  * A RealTime consists of two ints that must be at least 32 bits each.
  * A signed 32-bit int can store values exceeding +/- 2 billion.  This
  * means we can safely use our lower int for nanoseconds, as there are
- * 1 billion nanoseconds in a second and we need to handle double that
- * because of the implementations of addition etc that we use.
+ * 1 billion nanoseconds in a second.
+ *
+ * Arithmetic, comparison and frame conversion are done on a single
+ * 64-bit nanosecond count (see toNanoseconds()) and are constexpr and
+ * inline, since the sequencer and audio threads do a lot of them.
+ * sec and nsec always have the same sign.
  *
  * The maximum valid RealTime on a 32-bit system is somewhere around
  * 68 years: 999999999 nanoseconds longer than the classic Unix epoch.
  */
 struct ROSEGARDENPRIVATE_EXPORT RealTime
 {
-    RealTime()  { }
-    RealTime(int s, int n);
+    constexpr RealTime()  { }
+    constexpr RealTime(int s, int n) :
+        sec(int(combine(s, n) / nanoSecondsPerSecond)),
+        nsec(int(combine(s, n) % nanoSecondsPerSecond))
+    { }
 
     int sec{0};
     int nsec{0};
@@ -65,12 +74,45 @@ struct ROSEGARDENPRIVATE_EXPORT RealTime
         { return sec + static_cast<double>(nsec) / nanoSecondsPerSecond; }
 
     static RealTime fromMilliseconds(int msec);
+
+    constexpr int64_t toNanoseconds() const  { return combine(sec, nsec); }
+    static constexpr RealTime fromNanoseconds(int64_t ns)
+    {
+        return RealTime(int(ns / nanoSecondsPerSecond),
+                        int(ns % nanoSecondsPerSecond));
+    }
+
     // ??? Profiler is the only user.  Maybe move it there?
     static RealTime fromTimeval(const struct timeval &);
 
-    // Convenience functions for handling sample frames
-    static long realTime2Frame(const RealTime &time, unsigned int sampleRate);
-    static RealTime frame2RealTime(long frame, unsigned int sampleRate);
+    // Convenience functions for handling sample frames.  These are
+    // exact, and frame2RealTime() followed by realTime2Frame() always
+    // gives back the original frame.
+
+    static constexpr long realTime2Frame(const RealTime &time,
+                                         unsigned int sampleRate)
+    {
+        if (time.toNanoseconds() < 0)
+            return -realTime2Frame(-time, sampleRate);
+
+        // The extra nanosecond makes up for frame2RealTime() rounding
+        // down.
+        return long(int64_t(time.sec) * sampleRate +
+                    (int64_t(time.nsec) + 1) * sampleRate /
+                            nanoSecondsPerSecond);
+    }
+
+    static constexpr RealTime frame2RealTime(long frame,
+                                             unsigned int sampleRate)
+    {
+        if (frame < 0)
+            return -frame2RealTime(-frame, sampleRate);
+
+        const int64_t seconds = int64_t(frame) / sampleRate;
+        const int64_t remainder = int64_t(frame) - seconds * sampleRate;
+        return RealTime(int(seconds),
+                        int(remainder * nanoSecondsPerSecond / sampleRate));
+    }
 
     /// Return "HH:MM:SS.mmm" string to the nearest millisecond.
     std::string toText(bool fixedDp = false) const;
@@ -85,58 +127,79 @@ struct ROSEGARDENPRIVATE_EXPORT RealTime
 
     // Math
 
-    RealTime operator+(const RealTime &r) const
-            { return RealTime(sec + r.sec, nsec + r.nsec); }
-    RealTime operator-(const RealTime &r) const
-            { return RealTime(sec - r.sec, nsec - r.nsec); }
-    RealTime operator-() const
-            { return RealTime(-sec, -nsec); }
-    RealTime operator*(double m) const;
-    RealTime operator/(int d) const;
-
-    /// Find the fractional difference between times
-    double operator/(const RealTime &r) const;
-
-    // Comparison
-
-    bool operator<(const RealTime &r) const
+    constexpr RealTime operator+(const RealTime &r) const
+            { return fromSum(sec + r.sec, nsec + r.nsec); }
+    constexpr RealTime operator-(const RealTime &r) const
+            { return fromSum(sec - r.sec, nsec - r.nsec); }
+    constexpr RealTime operator-() const
     {
-        if (sec == r.sec)
-            return (nsec < r.nsec);
-        else
-            return (sec < r.sec);
+        RealTime rt;
+        rt.sec = -sec;
+        rt.nsec = -nsec;
+        return rt;
     }
-
-    bool operator>(const RealTime &r) const
+    RealTime operator*(double m) const;
+    /// Divide, rounding to the nearest nanosecond.
+    constexpr RealTime operator/(int d) const
     {
-        if (sec == r.sec)
-            return (nsec > r.nsec);
-        else
-            return (sec > r.sec);
+        const int64_t n = toNanoseconds();
+        int64_t q = n / d;
+        const int64_t r = n % d;
+        if (2 * (r < 0 ? -r : r) >= (d < 0 ? -int64_t(d) : int64_t(d)))
+            q += ((n < 0) != (d < 0)) ? -1 : 1;
+        return fromNanoseconds(q);
     }
 
-    bool operator==(const RealTime &r) const
-            { return (sec == r.sec  &&  nsec == r.nsec); }
-
-    bool operator!=(const RealTime &r) const
-            { return !(r == *this); }
+    /// Find the fractional difference between times
+    double operator/(const RealTime &r) const;
 
-    bool operator>=(const RealTime &r) const
-    {
-        if (sec == r.sec)
-            return (nsec >= r.nsec);
-        else
-            return (sec >= r.sec);
-    }
+    // Comparison
 
-    bool operator<=(const RealTime &r) const
+    constexpr bool operator<(const RealTime &r) const
+            { return toNanoseconds() < r.toNanoseconds(); }
+    constexpr bool operator>(const RealTime &r) const
+            { return toNanoseconds() > r.toNanoseconds(); }
+    constexpr bool operator==(const RealTime &r) const
+            { return toNanoseconds() == r.toNanoseconds(); }
+    constexpr bool operator!=(const RealTime &r) const
+            { return toNanoseconds() != r.toNanoseconds(); }
+    constexpr bool operator>=(const RealTime &r) const
+            { return toNanoseconds() >= r.toNanoseconds(); }
+    constexpr bool operator<=(const RealTime &r) const
+            { return toNanoseconds() <= r.toNanoseconds(); }
+
+private:
+    static constexpr int64_t combine(int s, int n)
+            { return int64_t(s) * nanoSecondsPerSecond + n; }
+
+    /// Normalize the sum or difference of two normalized RealTimes.
+    /**
+     * Cheaper than the constructor since n is known to be within two
+     * seconds, so there is no division.
+     */
+    static constexpr RealTime fromSum(int s, int n)
     {
-        if (sec == r.sec)
-            return (nsec <= r.nsec);
-        else
-            return (sec <= r.sec);
+        if (n >= nanoSecondsPerSecond) {
+            ++s;
+            n -= nanoSecondsPerSecond;
+        } else if (n <= -nanoSecondsPerSecond) {
+            --s;
+            n += nanoSecondsPerSecond;
+        }
+
+        if (s < 0  &&  n > 0) {
+            ++s;
+            n -= nanoSecondsPerSecond;
+        } else if (s > 0  &&  n < 0) {
+            --s;
+            n += nanoSecondsPerSecond;
+        }
+
+        RealTime rt;
+        rt.sec = s;
+        rt.nsec = n;
+        return rt;
     }
-
 };
 
 // I/O
@@ -227,11 +227,16 @@ SegmentLinker::linkedSegmentChanged(Segment *s, const timeT from,
         timeT segTo = segStartTime + refTo;
         Segment::iterator itrFrom = linkedSegToUpdate->findTime(segFrom);
         Segment::iterator itrTo = linkedSegToUpdate->findTime(segTo);
-        lyricsChanged = eraseNonIgnored(linkedSegToUpdate,
-                                        itrFrom, itrTo, lyricsChanged);
 
-        //now go through s from 'from' to 'to', inserting the equivalent
-        //event in linkedSegToUpdate
+        int semitones =
+                linkedSegToUpdate->getLinkTransposeParams().m_semitones -
+                                s->getLinkTransposeParams().m_semitones;
+        int steps = linkedSegToUpdate->getLinkTransposeParams().m_steps -
+                                    s->getLinkTransposeParams().m_steps;
+
+        //work out the equivalent in linkedSegToUpdate of the events in s
+        //from 'from' to 'to'
+        EventTimeMap mapped;
         for (Segment::const_iterator eventIter = s->findTime(from);
              eventIter != s->findTime(to);
              ++eventIter) {
@@ -243,15 +248,33 @@ SegmentLinker::linkedSegmentChanged(Segment *s, const timeT from,
             timeT eventNotationT = (e->getNotationAbsoluteTime() - sourceSegStartTime)
                                    + segStartTime;
 
-            int semitones =
-                    linkedSegToUpdate->getLinkTransposeParams().m_semitones -
-                                    s->getLinkTransposeParams().m_semitones;
-            int steps = linkedSegToUpdate->getLinkTransposeParams().m_steps -
-                                        s->getLinkTransposeParams().m_steps;
+            Event *refSegEvent =
+                    mapEvent(e, eventT, eventNotationT, semitones, steps);
+            if (refSegEvent) {
+                mapped.insert(EventTimeMap::value_type(eventT, refSegEvent));
+            }
+        }
+
+        // Only replace the events that differ, so that the observers of
+        // the linked segment (e.g. the notation view) only hear about
+        // what has actually changed rather than the whole range.  If the
+        // whole segment is being replaced, do it the simple way: an
+        // emptied segment takes its start and end times from what is
+        // inserted next.
+        const bool wholeSegment = (itrFrom == linkedSegToUpdate->begin() &&
+                                   itrTo == linkedSegToUpdate->end());
 
-            lyricsChanged = insertMappedEvent(linkedSegToUpdate, e, eventT,
-                                              eventNotationT, semitones, steps,
-                                              lyricsChanged);
+        lyricsChanged = eraseNonIgnored(linkedSegToUpdate,
+                                        itrFrom, itrTo, lyricsChanged,
+                                        wholeSegment ? nullptr : &mapped);
+
+        //insert what is left over
+        for (EventTimeMap::iterator mappedIter = mapped.begin();
+             mappedIter != mapped.end();
+             ++mappedIter) {
+            Event *refSegEvent = mappedIter->second;
+            if (!lyricsChanged) lyricsChanged = isLyric(refSegEvent);
+            linkedSegToUpdate->insert(refSegEvent);
         }
 
         // Fix verses count if lyrics have been modified
@@ -264,18 +287,21 @@ SegmentLinker::linkedSegmentChanged(Segment *s, const timeT from,
     }
 }
 
-bool
-SegmentLinker::insertMappedEvent(Segment *seg,
-                                 const Event *e, timeT t, timeT nt,
-                                 int semitones, int steps,
-                                 bool lyricsAlreadyInserted)
+Event *
+SegmentLinker::mapEvent(const Event *e, timeT t, timeT nt,
+                        int semitones, int steps)
 {
-    bool lyricInserted = lyricsAlreadyInserted;
-
     bool ignore;
     if (e->get<Bool>(BaseProperties::LINKED_SEGMENT_IGNORE_UPDATE, ignore)
         && ignore) {
-        return lyricInserted;
+        return nullptr;
+    }
+
+    //correct for temporal (and pitch shift??) here eventually...
+    if (semitones!=0 && e->isa(Rosegarden::Key::EventType)) {
+        Rosegarden::Key trKey = (Rosegarden::Key (*e)).transpose(semitones,
+                                                                     steps);
+        return trKey.getAsEvent(t);
     }
 
     Event *refSegEvent = new Event(*e,
@@ -285,41 +311,42 @@ SegmentLinker::insertMappedEvent(Segment *seg,
                                    nt,
                                    e->getNotationDuration());
 
-    bool needsInsertion = true;
-
-    //correct for temporal (and pitch shift??) here eventually...
-    if (semitones!=0) {
-        if (e->isa(Note::EventType)) {
-            long oldPitch = 0;
-            if (e->get<Int>(BaseProperties::PITCH, oldPitch)) {
-                long newPitch = oldPitch + semitones;
-                refSegEvent->set<Int>(BaseProperties::PITCH, newPitch);
-            }
-        } else if (e->isa(Rosegarden::Key::EventType)) {
-            Rosegarden::Key trKey = (Rosegarden::Key (*e)).transpose(semitones,
-                                                                         steps);
-            delete refSegEvent;
-            refSegEvent = nullptr;
-            SegmentNotationHelper helper(*seg);
-            helper.insertKey(t,trKey);
-            needsInsertion = false;
+    if (semitones!=0 && e->isa(Note::EventType)) {
+        long oldPitch = 0;
+        if (e->get<Int>(BaseProperties::PITCH, oldPitch)) {
+            long newPitch = oldPitch + semitones;
+            refSegEvent->set<Int>(BaseProperties::PITCH, newPitch);
         }
     }
 
-    if (needsInsertion) {
+    return refSegEvent;
+}
 
-        if (! lyricInserted) {
-            // Is the inserted event a lyric?
-            if (e->isa(Text::EventType)) {
-                std::string textType;
-                lyricInserted =
-                    e->get<String>(Text::TextTypePropertyName, textType)
-                    && (textType == Text::Lyric);
-                }
-        }
+bool
+SegmentLinker::isLyric(const Event *e)
+{
+    if (!e->isa(Text::EventType)) return false;
 
-        seg->insert(refSegEvent);
-    }
+    std::string textType;
+    return e->get<String>(Text::TextTypePropertyName, textType)
+        && (textType == Text::Lyric);
+}
+
+bool
+SegmentLinker::insertMappedEvent(Segment *seg,
+                                 const Event *e, timeT t, timeT nt,
+                                 int semitones, int steps,
+                                 bool lyricsAlreadyInserted)
+{
+    bool lyricInserted = lyricsAlreadyInserted;
+
+    Event *refSegEvent = mapEvent(e, t, nt, semitones, steps);
+    if (!refSegEvent) return lyricInserted;
+
+    // Is the inserted event a lyric?
+    if (! lyricInserted) lyricInserted = isLyric(e);
+
+    seg->insert(refSegEvent);
 
     return lyricInserted;
 }
@@ -327,7 +354,8 @@ SegmentLinker::insertMappedEvent(Segment *seg,
 bool
 SegmentLinker::eraseNonIgnored(Segment *s, Segment::const_iterator itrFrom,
                                            Segment::const_iterator itrTo,
-                                           bool lyricsAlreadyErased)
+                                           bool lyricsAlreadyErased,
+                                           EventTimeMap *keep)
 {
     bool lyricErased = lyricsAlreadyErased;
 
@@ -337,23 +365,35 @@ SegmentLinker::eraseNonIgnored(Segment *s, Segment::const_iterator itrFrom,
         bool ignore = false;
         (*eraseItr)->get<Bool>(BaseProperties::LINKED_SEGMENT_IGNORE_UPDATE,
                                 ignore);
-        if (!ignore) {
-
-            if (! lyricErased) {
-                // Is the erased event a lyric?
-                Event *e = *eraseItr;
-                if (e->isa(Text::EventType)) {
-                    std::string textType;
-                    lyricErased =
-                        e->get<String>(Text::TextTypePropertyName, textType)
-                        && (textType == Text::Lyric);
+        if (ignore) {
+            ++eraseItr;
+            continue;
+        }
+
+        //leave it be if it would only be replaced by an equal event
+        if (keep) {
+            bool kept = false;
+            std::pair<EventTimeMap::iterator, EventTimeMap::iterator> range =
+                keep->equal_range((*eraseItr)->getAbsoluteTime());
+            for (EventTimeMap::iterator keepItr = range.first;
+                 keepItr != range.second; ++keepItr) {
+                if (*keepItr->second == **eraseItr) {
+                    delete keepItr->second;
+                    keep->erase(keepItr);
+                    kept = true;
+                    break;
                 }
             }
-
-            s->erase(eraseItr++);
-        } else {
-            ++eraseItr;
+            if (kept) {
+                ++eraseItr;
+                continue;
+            }
         }
+
+        // Is the erased event a lyric?
+        if (! lyricErased) lyricErased = isLyric(*eraseItr);
+
+        s->erase(eraseItr++);
     }
     return lyricErased;
 }
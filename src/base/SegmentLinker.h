@@ -20,6 +20,8 @@
 #include "Segment.h"
 #include <QObject>
 
+#include <map>
+
 namespace Rosegarden
 {
 
@@ -82,13 +84,21 @@ private:
 
     void linkedSegmentChanged(Segment* s, const timeT from, const timeT to);
 
+    /// Events to go into a linked segment, by absolute time.
+    typedef std::multimap<timeT, Event *> EventTimeMap;
+
     /**
      * Return true if lyricsAlreadyErased is true or if some
      * lyrics have been erased
+     *
+     * If keep is given, an event that is equal to one of the events in
+     * keep is left where it is, and the equal event is removed from keep
+     * and deleted.
      */
     bool eraseNonIgnored(Segment *s, Segment::const_iterator itrFrom,
                                      Segment::const_iterator itrTo,
-                                     bool lyricsAlreadyErased);
+                                     bool lyricsAlreadyErased,
+                                     EventTimeMap *keep = nullptr);
 
     /**
      * Return true if lyricsAlreadyInserted is true or if a lyric
@@ -98,6 +108,15 @@ private:
                            int semitones, int steps,
                            bool lyricsAlreadyInserted);
 
+    /**
+     * The copy of e to go into a linked segment at time t, or nullptr if
+     * e is ignored for link purposes.
+     */
+    static Event *mapEvent(const Event *e, timeT t, timeT nt,
+                           int semitones, int steps);
+
+    static bool isLyric(const Event *e);
+
     LinkedSegmentParamsList::iterator findParamsItrForSegment(Segment *s);
     static void handleImpliedCMajor(Segment *s);
 
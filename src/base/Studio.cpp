@@ -127,6 +127,8 @@ Studio::addDevice(const std::string &name,
     }
 
     m_devices.push_back(d);
+    indexDevice(d);
+
     // inform the observers
     for(ObserverList::const_iterator i = m_observers.begin();
         i != m_observers.end(); ++i) {
@@ -143,6 +145,7 @@ Studio::removeDevice(DeviceId id)
         if ((*it)->getId() == id) {
             Device* d = *it;
             m_devices.erase(it);
+            reindexDevices();
             // inform the observers
             for(ObserverList::const_iterator i = m_observers.begin();
                 i != m_observers.end(); ++i) {
@@ -154,6 +157,31 @@ Studio::removeDevice(DeviceId id)
     }
 }
 
+void
+Studio::indexDevice(Device *device)
+{
+    // insert() rather than operator[] so that, as with a search of
+    // m_devices, the first one with a given ID wins.
+
+    m_devicesById.insert(DeviceMap::value_type(device->getId(), device));
+
+    for (Instrument *instrument : device->getAllInstrumentsRef()) {
+        m_instrumentsById.insert(
+                InstrumentMap::value_type(instrument->getId(), instrument));
+    }
+}
+
+void
+Studio::reindexDevices()
+{
+    m_devicesById.clear();
+    m_instrumentsById.clear();
+
+    for (Device *device : m_devices) {
+        indexDevice(device);
+    }
+}
+
 void
 Studio::resyncDeviceConnections()
 {
@@ -195,7 +223,7 @@ Studio::getSpareDeviceId(InstrumentId &baseInstrumentId)
     for (it = m_devices.begin(); it != m_devices.end(); ++it) {
         ids.insert((*it)->getId());
         if ((*it)->getType() == Device::Midi) {
-            InstrumentVector il = (*it)->getAllInstruments();
+            const InstrumentVector &il = (*it)->getAllInstrumentsRef();
             for (size_t i = 0; i < il.size(); ++i) {
                 if (il[i]->getId() > highestMidiInstrumentId) {
                     highestMidiInstrumentId = il[i]->getId();
@@ -217,18 +245,19 @@ Studio::getSpareDeviceId(InstrumentId &baseInstrumentId)
 }
 
 InstrumentVector
-Studio::getAllInstruments()
+Studio::getAllInstruments() const
 {
     InstrumentVector list;
+    list.reserve(m_instrumentsById.size());
 
-    DeviceVector::iterator it;
+    DeviceVector::const_iterator it;
 
     // Append lists
     //
     for (it = m_devices.begin(); it != m_devices.end(); ++it)
     {
         // get sub list
-        InstrumentVector subList = (*it)->getAllInstruments();
+        const InstrumentVector &subList = (*it)->getAllInstrumentsRef();
 
         // concetenate
         list.insert(list.end(), subList.begin(), subList.end());
@@ -268,23 +297,11 @@ Studio::getPresentationInstruments() const
 Instrument *
 Studio::getInstrumentById(InstrumentId id) const
 {
-    // For each Device
-    for (std::vector<Device *>::const_iterator deviceIter = m_devices.begin();
-         deviceIter != m_devices.end();
-         ++deviceIter)
-    {
-        InstrumentVector list = (*deviceIter)->getAllInstruments();
-
-        for (InstrumentVector::const_iterator instrumentIter = list.begin();
-             instrumentIter != list.end();
-             ++instrumentIter) {
-            if ((*instrumentIter)->getId() == id)
-                return (*instrumentIter);
-        }
-    }
-
-    return nullptr;
+    InstrumentMap::const_iterator instrumentIter = m_instrumentsById.find(id);
+    if (instrumentIter == m_instrumentsById.end())
+        return nullptr;
 
+    return instrumentIter->second;
 }
 
 // From a user selection (from a "Presentation" list) return
@@ -346,6 +363,10 @@ Studio::getInstrumentFor(const Track *track) const
 Buss *
 Studio::getBussById(BussId id) const
 {
+    // The IDs normally match the positions.  See setBussCount().
+    if (id < m_busses.size()  &&  m_busses[id]->getId() == id)
+        return m_busses[id];
+
     for (BussVector::const_iterator i = m_busses.begin(); i != m_busses.end(); ++i) {
         if ((*i)->getId() == id) return *i;
     }
@@ -769,27 +790,13 @@ Studio::getDevice(DeviceId id) const
 {
     //RG_DEBUG << "Studio[" << this << "]::getDevice(" << id << ")... ";
 
-    std::vector<Device*>::const_iterator it;
-
-    for (it = m_devices.begin(); it != m_devices.end(); ++it) {
-
-        // possibly fix a following seg.fault :
-        if( ! (*it) ){
-            RG_WARNING << "getDevice(): WARNING: (*it) is nullptr";
-            continue;
-        }
-
-        //RG_DEBUG << (*it)->getId();
-
-        if ((*it)->getId() == id) {
-            //RG_DEBUG << "Found";
-            return (*it);
-        }
+    DeviceMap::const_iterator deviceIter = m_devicesById.find(id);
+    if (deviceIter == m_devicesById.end()) {
+        //RG_DEBUG << "NOT found";
+        return nullptr;
     }
 
-    //RG_DEBUG << "NOT found";
-
-    return nullptr;
+    return deviceIter->second;
 }
 
 Device *
@@ -821,32 +828,21 @@ Studio::getSoftSynthDevice() const
 std::string
 Studio::getSegmentName(InstrumentId id)
 {
-    std::vector<Device*>::iterator it;
-    Rosegarden::InstrumentVector::iterator iit;
-    Rosegarden::InstrumentVector instList;
+    const Instrument *instrument = getInstrumentById(id);
+    if (!instrument)
+        return std::string("");
 
-    for (it = m_devices.begin(); it != m_devices.end(); ++it)
+    const MidiDevice *midiDevice =
+            dynamic_cast<const MidiDevice *>(instrument->getDevice());
+    if (midiDevice)
     {
-        const MidiDevice* midiDevice = dynamic_cast<MidiDevice*>(*it);
-
-        if (midiDevice)
+        if (instrument->sendsProgramChange())
         {
-            instList = (*it)->getAllInstruments();
-
-            for (iit = instList.begin(); iit != instList.end(); ++iit)
-            {
-                if ((*iit)->getId() == id)
-                {
-                    if ((*iit)->sendsProgramChange())
-                    {
-                        return (*iit)->getProgramName();
-                    }
-                    else
-                    {
-                        return midiDevice->getName() + " " + (*iit)->getName();
-                    }
-                }
-            }
+            return instrument->getProgramName();
+        }
+        else
+        {
+            return midiDevice->getName() + " " + instrument->getName();
         }
     }
 
@@ -960,7 +956,7 @@ Studio::getRecordInInvalid(int newCount) const
 
     InvalidInstrumentVector invalidInstruments;
     // get actual count
-    RecordInVector recs = getRecordIns();
+    const RecordInVector &recs = getRecordInsRef();
     int oldCount = recs.size();
 
     // no problem increasing count
@@ -998,7 +994,7 @@ Studio::getSubmasterInvalid(int newCount) const
 
     InvalidInstrumentVector invalidInstruments;
     // get actual count
-    BussVector buss = getBusses();
+    const BussVector &buss = getBussesRef();
     int oldCount = buss.size();
 
     // no problem increasing count
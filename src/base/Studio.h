@@ -23,6 +23,7 @@
 
 #include <QCoreApplication>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -78,10 +79,14 @@ public:
 
     // Return the combined instrument list from all devices
     //
-    InstrumentVector getAllInstruments();
+    InstrumentVector getAllInstruments() const;
     InstrumentVector getPresentationInstruments() const;
 
-    // Return an Instrument
+    /// Return an Instrument.  nullptr if there isn't one with this ID.
+    /**
+     * This is a lookup in m_instrumentsById, so it is cheap enough to
+     * call as often as needed.
+     */
     Instrument* getInstrumentById(InstrumentId id) const;
     Instrument* getInstrumentFromList(int index);
 
@@ -139,6 +144,7 @@ public:
 
     // Busses
     BussVector getBusses() const  { return m_busses; }
+    const BussVector &getBussesRef() const  { return m_busses; }
     size_t getNumberOfBusses() const  { return m_busses.size(); }
     Buss *getBussById(BussId id) const;
     void addBuss(Buss *buss);
@@ -150,6 +156,7 @@ public:
 
     // Record Ins
     RecordInVector getRecordIns() const  { return m_recordIns; }
+    const RecordInVector &getRecordInsRef() const  { return m_recordIns; }
     size_t getNumberOfRecordIns() const  { return m_recordIns.size(); }
     RecordIn *getRecordIn(int number) const;
     void addRecordIn(RecordIn *ri) { m_recordIns.push_back(ri); }
@@ -195,6 +202,10 @@ public:
     const MidiMetronome* getMetronomeFromDevice(DeviceId id) const;
 
     /// Return the device list
+    /**
+     * Use addDevice() and removeDevice() to change the list.  Otherwise
+     * m_devicesById and m_instrumentsById will be out of date.
+     */
     DeviceVector *getDevices()  { return &m_devices; }
     const DeviceVector *getDevices() const  { return &m_devices; }
     DeviceVector &getDevicesRef()  { return m_devices; }
@@ -275,6 +286,23 @@ private:
     Studio &operator=(const Studio &) = delete;
 
     DeviceVector        m_devices;
+
+    /// Index of m_devices for getDevice().
+    typedef std::map<DeviceId, Device *> DeviceMap;
+    DeviceMap m_devicesById;
+    /// Index of the Instruments on m_devices for getInstrumentById().
+    /**
+     * A Device's Instruments are created along with it and their IDs
+     * never change, so this only needs updating when a Device is added
+     * or removed.
+     */
+    typedef std::map<InstrumentId, Instrument *> InstrumentMap;
+    InstrumentMap m_instrumentsById;
+    /// Add device and its Instruments to the indexes.
+    void indexDevice(Device *device);
+    /// Rebuild the indexes from m_devices.
+    void reindexDevices();
+
     /// Returns nullptr if there are no MIDI out devices.
     Device *getFirstMIDIOutDevice() const;
 
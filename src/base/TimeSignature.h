@@ -19,6 +19,7 @@
 #include <rosegardenprivate_export.h>
 
 #include "NotationTypes.h"
+#include "EventTypeName.h"
 #include "PropertyName.h"
 #include "TimeT.h"
 
@@ -159,7 +160,7 @@ public:
     /// Returned event is on heap; caller takes responsibility for ownership
     Event *getAsEvent(timeT absoluteTime) const;
 
-    static const std::string EventType;
+    static const EventTypeName EventType;
 
     static const PropertyName NumeratorPropertyName;
     static const PropertyName DenominatorPropertyName;
@@ -18,6 +18,7 @@
 #ifndef RG_SEGMENTID_H
 #define RG_SEGMENTID_H
 
+#include "base/EventTypeName.h"
 #include "base/PropertyName.h"
 #include "base/TimeT.h"
 
@@ -36,7 +37,7 @@ class Event;
 class SegmentID
 {
  public:
-  static const std::string EventType;
+  static const EventTypeName EventType;
   static const int EventSubOrdering;
   static const PropertyName IDPropertyName;
   static const PropertyName SubtypePropertyName;
@@ -27,6 +27,8 @@
 
 #include <QString>
 
+#include <map>
+
 // Getting a NULL reference.  Need to track down.  See Q_ASSERT_X()
 // calls below.
 #pragma GCC diagnostic ignored "-Waddress"
@@ -230,6 +232,9 @@ BasicCommand::execute()
     // calculate the start and end of the modified region
     calculateModifiedStartEnd();
 
+    // Only keep what undo needs.
+    trimToModifiedRange(m_originalEvents);
+
     timeT updateStartTime = m_modifiedEventsStart;
     if (m_segment->getStartTime() < updateStartTime)
         updateStartTime = m_segment->getStartTime();
@@ -333,6 +338,13 @@ BasicCommand::copyTo(QSharedPointer<Segment> dest)
     Segment::const_iterator from = m_segment->begin();
     Segment::const_iterator to = m_segment->end();
 
+    // Once we know which range the command modifies, there is no
+    // need to copy anything else.
+    if (haveModifiedStartEnd()) {
+        from = m_segment->findTime(m_modifiedEventsStart);
+        to = m_segment->findTime(m_modifiedEventsEnd);
+    }
+
     dest->clear();
 
     // For each Event in m_segment...
@@ -346,6 +358,18 @@ BasicCommand::copyTo(QSharedPointer<Segment> dest)
     }
 }
 
+void
+BasicCommand::trimToModifiedRange(QSharedPointer<Segment> events)
+{
+    if (!haveModifiedStartEnd())
+        return;
+
+    events->erase(events->begin(),
+                  events->findTime(m_modifiedEventsStart));
+    events->erase(events->findTime(m_modifiedEventsEnd),
+                  events->end());
+}
+
 void BasicCommand::copyFrom(QSharedPointer<Segment> source, bool wholeSegment)
 {
     requireSegment();
@@ -362,18 +386,83 @@ void BasicCommand::copyFrom(QSharedPointer<Segment> source, bool wholeSegment)
         to = source->findTime(source->getEndTime());
     }
 
-    m_segment->erase(m_segment->findTime(m_modifiedEventsStart),
-                     m_segment->findTime(m_modifiedEventsEnd));
+    typedef std::multimap<timeT, const Event *> EventTimeMap;
+    EventTimeMap restore;
     for (Segment::const_iterator i = from; i != to; ++i) {
 
         RG_DEBUG << "copyFrom(): Found event of type" << (*i)->getType() << "and duration" << (*i)->getDuration() << "at time" << (*i)->getAbsoluteTime();
 
-        m_segment->insert(new Event(**i));
+        restore.insert(EventTimeMap::value_type((*i)->getAbsoluteTime(), *i));
+    }
+
+    Segment::iterator eraseFrom = m_segment->findTime(m_modifiedEventsStart);
+    Segment::iterator eraseTo = m_segment->findTime(m_modifiedEventsEnd);
+
+    if (eraseFrom == m_segment->begin() && eraseTo == m_segment->end()) {
+        // Everything goes.  Do it the simple way so that the emptied
+        // Segment takes its start and end times from what is inserted.
+        m_segment->erase(eraseFrom, eraseTo);
+    } else {
+        // The events the command didn't touch are still copies of the
+        // ones in source.  Leave those where they are, so that only the
+        // events that actually differ are erased and inserted and the
+        // observers (and any linked segments) only hear about those.
+        for (Segment::iterator i = eraseFrom; i != eraseTo; ) {
+            Segment::iterator j = i;
+            ++j;
+
+            bool kept = false;
+            std::pair<EventTimeMap::iterator, EventTimeMap::iterator> range =
+                restore.equal_range((*i)->getAbsoluteTime());
+            for (EventTimeMap::iterator k = range.first;
+                 k != range.second; ++k) {
+                if ((*i)->isCopyOf(*k->second)) {
+                    restore.erase(k);
+                    kept = true;
+                    break;
+                }
+            }
+
+            if (!kept)
+                m_segment->erase(i);
+
+            i = j;
+        }
+    }
+
+    for (EventTimeMap::const_iterator i = restore.begin();
+         i != restore.end(); ++i) {
+        m_segment->insert(new Event(*i->second));
     }
 
     source->clear();
 }
 
+namespace
+{
+    size_t savedEventsMemory(const Segment *events)
+    {
+        if (!events)
+            return 0;
+
+        size_t usage = sizeof(Segment);
+
+        for (const Event *event : *events) {
+            // Each Event is also held by a multiset node.
+            usage += event->getUnsharedStorageSize() + 4 * sizeof(void *);
+        }
+
+        return usage;
+    }
+}
+
+size_t
+BasicCommand::getMemoryUsage() const
+{
+    return savedEventsMemory(m_originalEvents.data()) +
+           savedEventsMemory(m_redoEvents.data());
+}
+
 void
 BasicCommand::requireSegment()
 {
@@ -41,8 +41,12 @@ class CommandArgumentQuerier; // forward declaration useful for some subclasses
  * Derivers provide their own version of modifySegment() which does the
  * actual work of the command.  This class takes care of undo/redo.
  *
- * This class stores the entirety of the original version of the Segment
- * in m_originalEvents.
+ * On the first execute(), this class takes a copy of the entire original
+ * Segment in m_originalEvents so that the modified range can be found.
+ * Once that range is known, everything outside it is dropped, so that a
+ * command on the history only holds the delta it needs for undo.  The
+ * saved Events share their EventData with the live Segment (see
+ * Event's Copy On Write) until one side or the other is modified.
  *
  * On undo (unexecute()), this class only copies back the events in the
  * range of time that was modified.  This is done primarily because the
@@ -80,6 +84,9 @@ public:
     /// events selected after command; 0 if no change / no meaningful selection
     virtual EventSelection *getSubsequentSelection() { return nullptr; }
 
+    /// Memory held in m_originalEvents and m_redoEvents.
+    size_t getMemoryUsage() const override;
+
 protected:
     /**
      * You should pass "bruteForceRedoRequired = true" if your
@@ -141,8 +148,14 @@ private:
     Segment *m_segment;
     /// if the segment is not set yet - get it from the segment marking
     void requireSegment();
-    /// Copy all Events within m_segment's time range from m_segment to dest.
+    /// Copy Events from m_segment to dest.
+    /**
+     * Copies the whole of m_segment until the modified range has been
+     * calculated, and only the modified range after that.
+     */
     void copyTo(QSharedPointer<Segment> dest);
+    /// Remove Events outside the modified time range from events.
+    void trimToModifiedRange(QSharedPointer<Segment> events);
     /// Copy Events in the modification time range from source to m_segment.
     /**
      * Events in m_segment are removed in the time range before the copy.
@@ -182,11 +195,14 @@ private:
      * Sets m_modifiedEventsStart and m_modifiedEventsEnd.
      */
     void calculateModifiedStartEnd();
+    /// Whether calculateModifiedStartEnd() has done its work.
+    bool haveModifiedStartEnd() const
+        { return m_modifiedEventsStart != -1  ||  m_modifiedEventsEnd != -1; }
 
-    /// All Events from m_segment prior to executing the command.
+    /// Events from m_segment prior to executing the command.
     /**
-     * This is a complete backup of m_segment.
-     *
+     * This is a complete backup of m_segment until the first execute()
+     * has finished.  After that it only holds the modified range.
      */
     QSharedPointer<Segment> m_originalEvents;
 
@@ -82,6 +82,16 @@ MacroCommand::getName() const
     return m_name;
 }
 
+size_t
+MacroCommand::getMemoryUsage() const
+{
+    size_t usage = 0;
+    for (const Command *command : m_commands) {
+        usage += command->getMemoryUsage();
+    }
+    return usage;
+}
+
 void
 MacroCommand::setName(const QString& name)
 {
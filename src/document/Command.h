@@ -42,6 +42,14 @@ public:
     virtual void unexecute() = 0;
     virtual QString getName() const = 0;
 
+    /// Approximate memory held by this command for undo/redo, in bytes.
+    /**
+     * Used by CommandHistory to enforce its memory budget and to report
+     * what each history entry costs.  Commands that keep no significant
+     * state can leave this as is.
+     */
+    virtual size_t getMemoryUsage() const  { return 0; }
+
     bool getUpdateLinks() const { return m_updateLinks; }
     void setUpdateLinks(bool update) { m_updateLinks = update; }
 
@@ -78,6 +86,8 @@ public:
     QString getName() const override;
     virtual void setName(const QString& name);
 
+    size_t getMemoryUsage() const override;
+
     virtual const std::vector<Command *>& getCommands() { return m_commands; }
 
 protected:
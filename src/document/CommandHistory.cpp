@@ -22,6 +22,7 @@
 #include "Command.h"
 #include "gui/general/ActionData.h"
 #include "misc/Debug.h"
+#include "misc/Preferences.h"
 
 #include <QRegularExpression>
 #include <QMenu>
@@ -119,11 +120,15 @@ CommandHistory::addCommand(Command *command, timeT startPointerPosition)
     commInfo.command = command;
     commInfo.pointerPositionBefore = m_pointerPosition;
     commInfo.pointerPositionAfter = m_pointerPosition;
+    commInfo.memoryUsage = 0;
     m_undoStack.push(commInfo);
-    clipCommands();
 
     // Execute the command
     command->execute();
+    m_undoStack.top().memoryUsage = command->getMemoryUsage();
+
+    // Clip after execution so the new command's memory is counted.
+    clipCommands();
 
     emit updateLinkedSegments(command);
     emit commandExecuted();
@@ -144,6 +149,7 @@ CommandHistory::undo()
 
     CommandInfo commInfo = m_undoStack.top();
     commInfo.command->unexecute();
+    commInfo.memoryUsage = commInfo.command->getMemoryUsage();
     emit updateLinkedSegments(commInfo.command);
     emit commandExecuted();
     emit commandUnexecuted(commInfo.command);
@@ -166,6 +172,7 @@ CommandHistory::redo()
 
     CommandInfo commInfo = m_redoStack.top();
     commInfo.command->execute();
+    commInfo.memoryUsage = commInfo.command->getMemoryUsage();
     emit updateLinkedSegments(commInfo.command);
     emit commandExecuted();
     //emit commandExecuted2(commInfo.command);
@@ -174,7 +181,9 @@ CommandHistory::redo()
 
     m_undoStack.push(commInfo);
     m_redoStack.pop();
-    // no need to clip
+    // No need to clip the number of commands, but a redo can grow
+    // the memory held by the undo stack.
+    clipCommands();
 
     updateActions();
 
@@ -227,6 +236,103 @@ CommandHistory::clipCommands()
 
     clipStack(m_undoStack, m_undoLimit);
     clipStack(m_redoStack, m_redoLimit);
+
+    const int limitMB = Preferences::getUndoMemoryLimitMB();
+    if (limitMB <= 0)
+        return;
+
+    // The budget covers both stacks.  The oldest undo entries go first,
+    // then the far end of the redo history if that alone is too big.
+    const size_t limit = size_t(limitMB) * 1024 * 1024;
+
+    const size_t redoMemory = stackMemory(m_redoStack);
+    const int dropped = clipStackToMemory(
+            m_undoStack, redoMemory < limit ? limit - redoMemory : 0);
+    if (dropped > 0) {
+        RG_DEBUG << "clipCommands(): Dropped" << dropped <<
+                    "undo entries to stay within" << limitMB << "MB";
+        for (const QString &line : getMemoryReport()) {
+            RG_DEBUG << "clipCommands():  " << line;
+        }
+        m_savedAt -= dropped;
+    }
+
+    const size_t undoMemory = stackMemory(m_undoStack);
+    clipStackToMemory(m_redoStack,
+                      undoMemory < limit ? limit - undoMemory : 0);
+}
+
+int
+CommandHistory::clipStackToMemory(CommandStack &stack, size_t limit)
+{
+    if (stackMemory(stack) <= limit)
+        return 0;
+
+    CommandStack tempStack;
+    size_t total = 0;
+
+    // Keep the most recent entries that fit.  Always keep at least one.
+    while (!stack.empty()) {
+        const size_t usage = stack.top().memoryUsage;
+        if (!tempStack.empty()  &&  total + usage > limit)
+            break;
+        total += usage;
+        tempStack.push(stack.top());
+        stack.pop();
+    }
+
+    const int dropped = int(stack.size());
+
+    clearStack(stack);
+
+    while (!tempStack.empty()) {
+        stack.push(tempStack.top());
+        tempStack.pop();
+    }
+
+    return dropped;
+}
+
+size_t
+CommandHistory::stackMemory(CommandStack stack)
+{
+    size_t total = 0;
+
+    while (!stack.empty()) {
+        total += stack.top().memoryUsage;
+        stack.pop();
+    }
+
+    return total;
+}
+
+size_t
+CommandHistory::getMemoryUsage() const
+{
+    return stackMemory(m_undoStack) + stackMemory(m_redoStack);
+}
+
+QStringList
+CommandHistory::getMemoryReport() const
+{
+    QStringList report;
+
+    // for undo then redo
+    for (int undoFlag = 1; undoFlag >= 0; --undoFlag) {
+        CommandStack stack(undoFlag ? m_undoStack : m_redoStack);
+        while (!stack.empty()) {
+            const CommandInfo &commInfo = stack.top();
+            QString commandName = commInfo.command->getName();
+            commandName.replace(QRegularExpression("&"), "");
+            report.append(QString("%1 %2: %3 KB").
+                    arg(undoFlag ? "Undo" : "Redo").
+                    arg(commandName).
+                    arg((commInfo.memoryUsage + 1023) / 1024));
+            stack.pop();
+        }
+    }
+
+    return report;
 }
 
 void
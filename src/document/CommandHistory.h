@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 #include <stack>
 #include <set>
@@ -103,6 +104,15 @@ public:
     /// Set the maximum number of items in the menus.
     // unused void setMenuLimit(int limit);
 
+    /// Approximate memory held by the undo and redo history, in bytes.
+    size_t getMemoryUsage() const;
+
+    /// One line per history entry with the memory it holds.
+    /**
+     * Most recent entries first.  For diagnostics.
+     */
+    QStringList getMemoryReport() const;
+
     /// Enable/Disable undo (during playback).
     void enableUndo(bool enable);
 
@@ -210,11 +220,21 @@ protected:
         Command *command;
         timeT pointerPositionBefore;  // for undo
         timeT pointerPositionAfter;   // for redo
+        /// Command::getMemoryUsage() as of the last execute/unexecute.
+        size_t memoryUsage;
     };
     typedef std::stack<CommandInfo> CommandStack;
     CommandStack m_undoStack;
     CommandStack m_redoStack;
     void clipStack(CommandStack &stack, int limit);
+    /// Drop the oldest entries until stack fits in limit bytes.
+    /**
+     * The most recent entry is always kept.  Returns the number of
+     * entries dropped.
+     */
+    int clipStackToMemory(CommandStack &stack, size_t limit);
+    /// Sum of CommandInfo::memoryUsage over a copy of stack.
+    static size_t stackMemory(CommandStack stack);
     void clearStack(CommandStack &stack);
     void clipCommands();
 
@@ -807,7 +807,7 @@ void RosegardenDocument::initialiseStudio()
     // All the softsynths, audio instruments, and busses.
     std::vector<PluginContainer *> pluginContainers;
 
-    BussVector busses = m_studio.getBusses();
+    const BussVector &busses = m_studio.getBussesRef();
 
     // For each buss (first one is master)
     for (size_t i = 0; i < busses.size(); ++i) {
@@ -834,7 +834,7 @@ void RosegardenDocument::initialiseStudio()
         pluginContainers.push_back(busses[i]);
     }
 
-    RecordInVector recordIns = m_studio.getRecordIns();
+    const RecordInVector &recordIns = m_studio.getRecordInsRef();
 
     // For each record in
     for (size_t i = 0; i < recordIns.size(); ++i) {
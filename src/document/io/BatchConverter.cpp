@@ -0,0 +1,251 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_MODULE_STRING "[BatchConverter]"
+#define RG_NO_DEBUG_PRINT
+
+#include "BatchConverter.h"
+
+#include "base/Selection.h"
+#include "document/RosegardenDocument.h"
+#include "document/io/LilyPondExporter.h"
+#include "document/io/MusicXmlExporter.h"
+#include "misc/Debug.h"
+#include "sound/MidiFile.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace Rosegarden
+{
+
+
+bool
+BatchConverter::canWrite(const QString &extension)
+{
+    const QString ext = extension.toLower();
+
+    return ext == "mid"  ||  ext == "midi"  ||
+           ext == "ly"  ||
+           ext == "xml"  ||  ext == "musicxml";
+}
+
+bool
+BatchConverter::convert(const QString &inFile, const QString &outFile,
+                        QString &error)
+{
+    const QString extension = QFileInfo(outFile).suffix().toLower();
+    if (!canWrite(extension)) {
+        error = tr("Unknown output format: %1").arg(outFile);
+        return false;
+    }
+
+    RosegardenDocument doc(
+            nullptr,  // parent
+            {},  // audioPluginManager
+            true,  // skipAutoload
+            true,  // clearCommandHistory
+            false);  // m_useSequencer
+
+    // cppcheck-suppress danglingLifetime
+    RosegardenDocument::currentDocument = &doc;
+
+    bool ok = doc.openDocument(
+            inFile,
+            false,  // permanent
+            true,  // squelchProgressDialog
+            false);  // enableLock
+
+    if (!ok) {
+        RosegardenDocument::currentDocument = nullptr;
+        error = tr("Error opening rg file: %1").arg(inFile);
+        return false;
+    }
+
+    if (extension == "mid"  ||  extension == "midi") {
+        MidiFile midiFile;
+        ok = midiFile.convertToMidi(&doc, outFile);
+        if (!ok)
+            error = tr("Error writing MIDI file: %1").arg(outFile);
+
+    } else if (extension == "ly") {
+        LilyPondExporter lilyPondExporter(
+                &doc,
+                SegmentSelection(),
+                std::string(QFile::encodeName(outFile)));
+        ok = lilyPondExporter.write();
+        if (!ok) {
+            error = lilyPondExporter.getMessage();
+            if (error.isEmpty())
+                error = tr("Error writing LilyPond file: %1").arg(outFile);
+        }
+
+    } else {
+        MusicXmlExporter musicXmlExporter(
+                nullptr,  // parent
+                &doc,
+                std::string(outFile.toLocal8Bit()));
+        ok = musicXmlExporter.write();
+        if (!ok)
+            error = tr("Error writing MusicXML file: %1").arg(outFile);
+    }
+
+    RosegardenDocument::currentDocument = nullptr;
+
+    return ok;
+}
+
+namespace
+{
+
+    /// A conversion running in a child process.
+    struct Job
+    {
+        QString inFile;
+        QString outFile;
+        QProcess process;
+        QElapsedTimer timer;
+    };
+
+    /// The last line the child wrote to stderr, which is its error.
+    QString lastLine(const QByteArray &output)
+    {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+        const QStringList lines =
+            QString::fromLocal8Bit(output).split('\n', Qt::SkipEmptyParts);
+#else
+        const QStringList lines =
+            QString::fromLocal8Bit(output).split('\n', QString::SkipEmptyParts);
+#endif
+        if (lines.isEmpty())
+            return QString();
+        return lines.last().trimmed();
+    }
+
+}
+
+int
+BatchConverter::convertAll(const QString &program,
+                           const QStringList &inFiles,
+                           const QString &outDir,
+                           const QString &extension,
+                           int jobs)
+{
+    if (jobs < 1)
+        jobs = 1;
+
+    QElapsedTimer total;
+    total.start();
+
+    QStringList outFiles;
+    for (const QString &inFile : inFiles) {
+        outFiles << QDir(outDir).filePath(
+                QFileInfo(inFile).completeBaseName() + "." + extension);
+    }
+
+    // Two files with the same name in different directories would be
+    // converted to the same file, possibly at the same time.  Convert
+    // nothing rather than leave the user with one of them.
+    std::map<QString, QString> sources;
+    bool clash = false;
+    for (int i = 0; i < inFiles.size(); ++i) {
+        const QString outFile = QFileInfo(outFiles[i]).absoluteFilePath();
+        const auto inserted =
+                sources.insert(std::make_pair(outFile, inFiles[i]));
+        if (inserted.second)
+            continue;
+
+        std::cout << "FAILED  " << qPrintable(inFiles[i]) << ": " << qPrintable(tr("Same output file as %1").arg(inserted.first->second)) << std::endl;
+        clash = true;
+    }
+
+    if (clash) {
+        std::cout << "Converted 0 of " << inFiles.size() << " files" << std::endl;
+        return inFiles.size();
+    }
+
+    int next = 0;
+    int failed = 0;
+    std::vector<std::unique_ptr<Job> > running;
+
+    while (next < inFiles.size()  ||  !running.empty()) {
+
+        // Keep every slot busy.
+        while (next < inFiles.size()  &&  int(running.size()) < jobs) {
+            std::unique_ptr<Job> job(new Job);
+            job->inFile = inFiles[next];
+            job->outFile = outFiles[next];
+            ++next;
+
+            // Only the errors are of interest.
+            job->process.setStandardOutputFile(QProcess::nullDevice());
+
+            job->timer.start();
+            job->process.start(program, QStringList() <<
+                    "--convert" << job->inFile << job->outFile);
+
+            running.push_back(std::move(job));
+        }
+
+        // Report and drop the ones that have finished.
+        for (size_t i = 0; i < running.size(); ) {
+            Job &job = *running[i];
+
+            if (job.process.state() != QProcess::NotRunning  &&
+                !job.process.waitForFinished(10)) {
+                ++i;
+                continue;
+            }
+
+            const double seconds = job.timer.elapsed() / 1000.0;
+
+            if (job.process.exitStatus() == QProcess::NormalExit  &&
+                job.process.exitCode() == 0  &&
+                job.process.error() == QProcess::UnknownError) {
+                std::cout << "ok      " << qPrintable(QString::number(seconds, 'f', 3)) << "s  " << qPrintable(job.inFile) << " -> " << qPrintable(job.outFile) << std::endl;
+            } else {
+                QString error = lastLine(job.process.readAllStandardError());
+                if (job.process.exitStatus() == QProcess::CrashExit)
+                    error = tr("Crashed");
+                else if (job.process.error() == QProcess::FailedToStart)
+                    error = tr("Could not run %1").arg(program);
+
+                std::cout << "FAILED  " << qPrintable(QString::number(seconds, 'f', 3)) << "s  " << qPrintable(job.inFile) << ": " << qPrintable(error) << std::endl;
+
+                ++failed;
+            }
+
+            running.erase(running.begin() + i);
+        }
+    }
+
+    std::cout << "Converted " << inFiles.size() - failed << " of " << inFiles.size() << " files in " << qPrintable(QString::number(total.elapsed() / 1000.0, 'f', 3)) << "s" << std::endl;
+
+    return failed;
+}
+
+
+}
@@ -0,0 +1,81 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_BATCHCONVERTER_H
+#define RG_BATCHCONVERTER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+
+
+namespace Rosegarden
+{
+
+
+/// Converts Rosegarden files to other formats without a main window.
+/**
+ * convert() loads one document and runs the exporter that matches the
+ * output file's extension:
+ *
+ *   - .mid or .midi: MidiFile
+ *   - .ly: LilyPondExporter
+ *   - .xml or .musicxml: MusicXmlExporter
+ *
+ * The exporters read their options from the user's settings, as they do
+ * when exporting from the GUI.
+ *
+ * convertAll() converts many files at once.  Loading a document sets
+ * RosegardenDocument::currentDocument and the other global state that
+ * the GUI relies on, so each file is converted by a separate process
+ * running "program --convert source dest".  It prints a line with the
+ * time taken or the error for each file, and a summary at the end.
+ *
+ * See "rosegarden-convert --help".
+ */
+class BatchConverter
+{
+    Q_DECLARE_TR_FUNCTIONS(Rosegarden::BatchConverter)
+
+public:
+    /// Whether convert() can write files with this extension.
+    static bool canWrite(const QString &extension);
+
+    /// Convert inFile to outFile.
+    /**
+     * Returns false and sets error if it fails.
+     */
+    static bool convert(const QString &inFile, const QString &outFile,
+                        QString &error);
+
+    /// Convert each of inFiles to a file in outDir with extension.
+    /**
+     * Runs up to jobs copies of program at a time.  Returns the number
+     * of files that failed.  If any two of inFiles would be converted to
+     * the same file, nothing is converted and they all count as failed.
+     */
+    static int convertAll(const QString &program,
+                          const QStringList &inFiles,
+                          const QString &outDir,
+                          const QString &extension,
+                          int jobs);
+};
+
+
+}
+
+#endif
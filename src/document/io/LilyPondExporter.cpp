@@ -68,10 +68,16 @@
 #include <QRegularExpression>
 #include <QString>
 #include <QApplication>
+#include <QEventLoop>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
-#include <sstream>
 #include <algorithm>
+#include <fstream>
 #include <limits>
+#include <map>
+#include <sstream>
 
 namespace Rosegarden
 {
@@ -100,9 +106,8 @@ LilyPondExporter::LilyPondExporter(RosegardenDocument *doc,
                                    NotationView *parent) :
     m_doc(doc),
     m_fileName(fileName),
-    m_lastClefFound(Clef::Treble),
     m_selection(selection),
-    SKIP_PROPERTY("LilyPondExportSkipThisEvent")
+    m_deferBars(true)
 {
     m_composition = &m_doc->getComposition();
     m_studio = &m_doc->getStudio();
@@ -164,11 +169,12 @@ static bool canStartOrEndBeam(Event *event)
     return true;
 }
 
-Event *LilyPondExporter::nextNoteInGroup(const Segment *s,
+Event *LilyPondExporter::nextNoteInGroup(const SegmentBars &bars,
                                          Segment::iterator it,
                                          const std::string &groupType,
                                          int barEnd) const
 {
+    const Segment *s = bars.segment;
     Event *event = *it;
     long currentGroupId = -1;
     event->get<Int>(BEAMED_GROUP_ID, currentGroupId);
@@ -192,7 +198,7 @@ Event *LilyPondExporter::nextNoteInGroup(const Segment *s,
         if (!graceNotesGroup && isGrace)
             continue;
 
-        if (event->has(SKIP_PROPERTY))
+        if (bars.skipEvents.count(event))
             continue;
 
         const bool isNote = event->isa(Note::EventType);
@@ -287,7 +293,7 @@ LilyPondExporter::isSegmentToPrint(Segment *seg)
 void
 LilyPondExporter::handleStartingPreEvents(eventstartlist &preEventsToStart,
                                           const Segment *seg,
-                                          const Segment::iterator &j,                                          std::ofstream &str)
+                                          const Segment::iterator &j,                                          std::ostream &str)
 {
     eventstartlist::iterator m = preEventsToStart.begin();
 
@@ -384,7 +390,7 @@ void
 LilyPondExporter::handleStartingPostEvents(eventstartlist &postEventsToStart,
                                            const Segment *seg,
                                            const Segment::iterator &j,
-                                           std::ofstream &str)
+                                           std::ostream &str)
 {
     eventstartlist::iterator m = postEventsToStart.begin();
 
@@ -521,7 +527,7 @@ LilyPondExporter::handleStartingPostEvents(eventstartlist &postEventsToStart,
 void
 LilyPondExporter::handleEndingPreEvents(eventendlist &preEventsInProgress,
                                         const Segment::iterator &j,
-                                        std::ofstream &str)
+                                        std::ostream &str)
 {
     eventendlist::iterator k = preEventsInProgress.begin();
 
@@ -573,7 +579,7 @@ void
 LilyPondExporter::handleEndingPostEvents(eventendlist &postEventsInProgress,
                                          const Segment *seg,
                                          const Segment::iterator &j,
-                                         std::ofstream &str)
+                                         std::ostream &str)
 {
     eventendlist::iterator k = postEventsInProgress.begin();
 
@@ -848,13 +854,34 @@ LilyPondExporter::write()
             return false;
     }
 
-    std::ofstream str(qstrtostr(tmpName).c_str(), std::ios::out);
-    if (!str) {
+    std::ofstream file(qstrtostr(tmpName).c_str(), std::ios::out);
+    if (!file) {
         RG_WARNING << "LilyPondExporter::write() - can't write file " << tmpName;
         m_warningMessage = tr("Export failed.  The file could not be opened for writing.");
         return false;
     }
 
+    // The score is put together in memory so that the bars of the
+    // segments can be written out of order.  See writeScore().
+    std::ostringstream str;
+    m_deferBars = !m_writeBarsInOrder;
+    bool ok = writeScore(str);
+
+    file << str.str();
+    file.close();
+
+    // Release the segment bars.
+    m_segmentBars.clear();
+    m_pendingBars.clear();
+    m_predictedResults.clear();
+    m_scorePieces.clear();
+
+    return ok;
+}
+
+bool
+LilyPondExporter::writeScore(std::ostringstream &str)
+{
     str << "% This LilyPond file was generated by Rosegarden " << protectIllegalChars(VERSION) << std::endl;
 
     str << m_language->getImportStatement();
@@ -1643,12 +1670,6 @@ LilyPondExporter::write()
 
                 } /// if (!lsc.isAlt())
 
-                // Temporary storage for non-atomic events (!BOOM)
-                // ex. LilyPond expects signals when a decrescendo starts
-                // as well as when it ends
-                eventendlist preEventsInProgress;
-                eventendlist postEventsInProgress;
-
                 // If the segment doesn't start at 0, add a "skip" to the start
                 // No worries about overlapping segments, because Voices can overlap
                 // voiceCounter is a hack because LilyPond does not by default make
@@ -1723,199 +1744,30 @@ LilyPondExporter::write()
                     }
                 }
 
-
-
-                std::string lilyText = "";      // text events
-                std::string prevStyle = "";     // track note styles
-
-                Rosegarden::Key key = lsc.getPreviousKey();
-
-                // State variables
-                bool haveRepeating = false;  // Simple volta without alt. endings
-                bool haveAlternates = false; // Alternate ending may follow (?)
-                bool haveVoltaWithAltEndings = false; // Volta with alt. endings
-                bool haveAlt = false;        // Current seg. is an alt. ending
-
-                bool nextBarIsAlt1 = false;
-                bool nextBarIsAlt2 = false;
-                bool prevBarWasAlt2 = false;
-
-                int MultiMeasureRestCount = 0;
-
-                bool nextBarIsDouble = false;
-                bool nextBarIsEnd = false;
-                bool nextBarIsDot = false;
-
-                for (int barNo = m_composition->getBarNumber(seg->getStartTime());
-                    barNo <= m_composition->getBarNumber(seg->getEndMarkerTime());
-                    ++barNo) {
-                    qApp->processEvents();
-
-                    timeT barStart = m_composition->getBarStart(barNo);
-                    timeT barEnd = m_composition->getBarEnd(barNo);
-                    timeT currentSegmentStartTime = seg->getStartTime();
-                    timeT currentSegmentEndTime = seg->getEndMarkerTime();
-                    // Check for a partial measure in the beginning of the composition
-                    if (barStart < compositionStartTime) {
-                        barStart = compositionStartTime;
-                    }
-                    // Check for a partial measure in the end of the composition
-                    if (barEnd > compositionEndTime) {
-                        barEnd = compositionEndTime;
-                    }
-                    // Check for a partial measure beginning in the middle of a
-                    // theoretical bar
-                    if (barStart < currentSegmentStartTime) {
-                        barStart = currentSegmentStartTime;
-                    }
-                    // Check for a partial measure ending in the middle of a
-                    // theoretical bar
-                    if (barEnd > currentSegmentEndTime) {
-                        barEnd = currentSegmentEndTime;
-                    }
-
-                    // Check for a time signature in the first bar of the segment
-                    bool timeSigInFirstBar = false;
-                    TimeSignature firstTimeSig =
-                        m_composition->getTimeSignatureInBar(firstBar,
-                                                             timeSigInFirstBar);
-                    // and write it here (to avoid multiple time signatures when
-                    // a repeating segment is unfolded)
-                    if (timeSigInFirstBar && (barNo == firstBar)) {
-                        writeTimeSignature(firstTimeSig, col, str);
-                    }
-
-                    // open \repeat section if this is the first bar in the
-                    // repeat
-                    if ( (lsc.isRepeatingSegment()
-                           || (lsc.isSimpleRepeatedLinks()
-                                  && (m_useVolta)
-                              )
-                         ) && !haveRepeating) {
-
-                        haveRepeating = true;
-
-                        int numRepeats = lsc.getNumberOfVolta();
-                        if ((m_useVolta) && lsc.isSynchronous()) {
-                            str << std::endl << indent(col++)
-                                << "\\repeat volta " << numRepeats << " {";
-                        } else {
-                            // (m_useVolta == false)
-                            str << std::endl << indent(col++)
-                                << "\\repeat unfold "
-                                << numRepeats << " {";
-                        }
-                    } else if (lsc.isRepeatWithAlt() &&
-                            !haveVoltaWithAltEndings &&
-                            !haveAlt) {
-                        if (!lsc.isAlt()) {
-                            str << std::endl << indent(col++);
-                            if (lsc.isAutomaticVoltaUsable()) {
-                                str << "\\repeat volta "
-                                    << lsc.getNumberOfVolta() << " ";
-                            }
-                            // Opening of main repeating segment
-                            str << "{   % Repeating stegment start here";
-                            str << std::endl << indent(col)
-                                << "% Segment: " << seg->getLabel();
-                            haveVoltaWithAltEndings = true;
-                            if (!lsc.isAutomaticVoltaUsable()) {
-                                if (lsc.wasRepeatingWithoutAlt()) {
-                                    // When automatic volta is not usable, the
-                                    // "start-repeat" bar hides the "end-repeat"
-                                    // bar issued by the previous automatic
-                                    // volta. In such a case, a "double-repeat"
-                                    // bar has to be written. As #'(double-repeat)
-                                    // is currently not defined in
-                                    // LilyPond, the ":..:" string is used.
-                                    str << std::endl << indent(col)
-                                        << "\\bar \":..:\"";
-                                } else {
-                                    str << std::endl << indent(col)
-                                        << "\\set Score.repeatCommands = #'(start-repeat)";
-                                }
-                            }
-                        } else {
-                            str << std::endl << indent(col)
-                                << "{   % Alternative start here";
-                            str << std::endl << indent(col++)
-                                << "    % Segment: " << seg->getLabel();
-                            if (!lsc.isAutomaticVoltaUsable()) {
-                                str << std::endl << indent(col)
-                                    << "\\set Score.repeatCommands = ";
-                                if (lsc.isFirstAlt()) {
-                                    str << "#'((volta \""
-                                        << lsc.getAltText() << "\"))";
-                                } else {
-                                    str << "#'((volta #f) (volta \""
-                                        << lsc.getAltText() << "\") end-repeat)";
-                                }
-                            }
-
-                            if (m_altBar && lsc.isFirstAlt()) {
-                                // Since LilyPond 2.23, drawing explicitely
-                                // this bar in any other alternative than the
-                                // first one hides the repetion bar.
-                                str << std::endl << indent(col)
-                                    << "\\bar \"|\" ";
-                            }
-                            haveAlt = true;
-                        }
-                    }
-
-                    // open the \alternative section if this bar is alternative
-                    // ending 1 ending (because there was an "Alt1" flag in the
-                    // previous bar to the left of where we are right now)
-                    //
-                    // Alt1 remains in effect until we run into Alt2, which
-                    // runs to the end of the segment
-                    if (nextBarIsAlt1 && haveRepeating) {
-                        str << std::endl << indent(--col) << "} \% repeat close (before alternatives) ";
-                        str << std::endl << indent(col++) << "\\alternative {";
-                        str << std::endl << indent(col++) << "{  \% open alternative 1 ";
-                        nextBarIsAlt1 = false;
-                        haveAlternates = true;
-                    } else if (nextBarIsAlt2 && haveRepeating) {
-                        if (!prevBarWasAlt2) {
-                            col--;
-                            // add an extra str to the following to shut up
-                            // compiler warning from --ing and ++ing it in the
-                            // same statement
-                            str << std::endl << indent(--col) << "} \% close alternative 1 ";
-                            str << std::endl << indent(col++) << "{  \% open alternative 2";
-                            col++;
-                        }
-                        prevBarWasAlt2 = true;
-                    }
-
-                    // should a time signature be writed in the current bar ?
-                    bool noTimeSig = false;
-                    if (timeSigInFirstBar) {
-                        noTimeSig = barNo == firstBar;
-                    }
-
-                    // write out a bar's worth of events
-                    writeBar(seg, barNo, barStart, barEnd, col, key,
-                            lilyText,
-                            prevStyle, preEventsInProgress, postEventsInProgress, str,
-                            MultiMeasureRestCount,
-                            nextBarIsAlt1, nextBarIsAlt2, nextBarIsDouble,
-                            nextBarIsEnd, nextBarIsDot,
-                            noTimeSig);
-                }
-
-                // close \repeat
-                if (haveRepeating) {
-
-                    // close \alternative section if present
-                    if (haveAlternates) {
-                        str << std::endl << indent(--col) << "} \% close alternative 2 ";
-                    }
-
-                    // close \repeat section in either case
-                    str << std::endl << indent(--col) << "} \% close "
-                        << (haveAlternates ? "alternatives" : "repeat");
-                }
+                std::unique_ptr<SegmentBars> bars(new SegmentBars);
+                bars->segment = seg;
+                bars->col = col;
+                bars->key = lsc.getPreviousKey();
+                bars->compositionStartTime = compositionStartTime;
+                bars->compositionEndTime = compositionEndTime;
+                bars->repeatingSegment = lsc.isRepeatingSegment();
+                bars->simpleRepeatedLinks = lsc.isSimpleRepeatedLinks();
+                bars->synchronous = lsc.isSynchronous();
+                bars->numberOfVolta = lsc.getNumberOfVolta();
+                bars->repeatWithAlt = lsc.isRepeatWithAlt();
+                bars->alt = lsc.isAlt();
+                bars->automaticVoltaUsable = lsc.isAutomaticVoltaUsable();
+                bars->wasRepeatingWithoutAlt = lsc.wasRepeatingWithoutAlt();
+                bars->firstAlt = lsc.isFirstAlt();
+                bars->altText = lsc.getAltText();
+
+                const SegmentBarsResult barsResult =
+                        addSegmentBars(std::move(bars), str);
+                col = barsResult.endCol;
+                const bool haveRepeating = barsResult.haveRepeating;
+                const bool haveVoltaWithAltEndings =
+                        barsResult.haveVoltaWithAltEndings;
+                const bool haveAlt = barsResult.haveAlt;
 
                 // Open alternate parts if repeat with volta from linked segments
                 if (haveVoltaWithAltEndings) {
@@ -2181,21 +2033,520 @@ LilyPondExporter::write()
     str << "% " << indent(col++) << "\\midi {" << std::endl;
     str << "% " << indent(--col) << "} " << std::endl;
 
-    // close \score section and close out the file
+    // close \score section
     str << "} % score" << std::endl;
-    str.close();
+
+    if (!m_pendingBars.empty()) {
+        if (!writePendingBars(str)) {
+            // Something was not as predicted.  Start again and write
+            // everything in order.
+            RG_DEBUG << "writeScore(): writing the score again without deferred bars";
+            str.str("");
+            str.clear();
+            m_segmentBars.clear();
+            m_pendingBars.clear();
+            m_predictedResults.clear();
+            m_scorePieces.clear();
+            m_deferBars = false;
+            return writeScore(str);
+        }
+    }
+
+    // Report the first warning from the bars, in score order.
+    for (const std::unique_ptr<SegmentBars> &bars : m_segmentBars) {
+        if (!bars->result.warning.isEmpty()) {
+            m_warningMessage = bars->result.warning;
+            break;
+        }
+    }
+
     return true;
 }
 
+/// Writes the bars of a segment on a worker thread.
+class LilyPondExporter::SegmentBarsJob : public QRunnable
+{
+public:
+    SegmentBarsJob(LilyPondExporter *exporter, SegmentBars *bars) :
+        m_exporter(exporter),
+        m_bars(bars)
+    { }
+
+    void run() override
+    {
+        m_exporter->writeSegmentBars(*m_bars);
+    }
+
+private:
+    LilyPondExporter *m_exporter;
+    SegmentBars *m_bars;
+};
+
+/// Segment bars from previous exports.
+/**
+ * Printing from the notation editor exports the whole score every time.
+ * Most of the segments are usually unchanged since the last time, so
+ * their bars are kept here and reused.
+ *
+ * An entry is reused if the segment has not been modified since (see
+ * Segment::getRefreshStatus()) and everything else that goes into the
+ * bars (the context string, see getSegmentBarsContext()) is the same.
+ */
+class LilyPondExporter::SegmentBarsCache : public SegmentObserver
+{
+public:
+    ~SegmentBarsCache() override
+    {
+        for (const auto &pair : m_entries) {
+            const_cast<Segment *>(pair.first)->removeObserver(this);
+        }
+    }
+
+    /// Cached result, or nullptr.
+    /**
+     * Clears the segment's refresh status, so that any modification from
+     * here on makes the result that is about to be written stale.
+     */
+    const SegmentBarsResult *find(Segment *segment,
+                                  const std::string &context)
+    {
+        auto iter = m_entries.find(segment);
+        if (iter == m_entries.end()) {
+            Entry &entry = m_entries[segment];
+            entry.refreshStatusId = segment->getNewRefreshStatusId();
+            segment->addObserver(this);
+            return nullptr;
+        }
+
+        Entry &entry = iter->second;
+        RefreshStatus &refreshStatus =
+                segment->getRefreshStatus(entry.refreshStatusId);
+
+        const bool valid = entry.valid  &&
+                           !refreshStatus.needsRefresh()  &&
+                           entry.context == context;
+        refreshStatus.setNeedsRefresh(false);
+
+        if (!valid) {
+            entry.valid = false;
+            return nullptr;
+        }
+
+        return &entry.result;
+    }
+
+    /// Store the result of a find() that returned nullptr.
+    void store(Segment *segment,
+               const std::string &context,
+               const SegmentBarsResult &result)
+    {
+        auto iter = m_entries.find(segment);
+        if (iter == m_entries.end())
+            return;
+
+        Entry &entry = iter->second;
+        // Modified while the bars were being written?
+        if (segment->getRefreshStatus(entry.refreshStatusId).needsRefresh())
+            return;
+
+        entry.valid = true;
+        entry.context = context;
+        entry.result = result;
+    }
+
+    // SegmentObserver override.
+    void segmentDeleted(const Segment *segment) override
+    {
+        m_entries.erase(segment);
+    }
+
+private:
+    struct Entry
+    {
+        unsigned refreshStatusId{0};
+        bool valid{false};
+        std::string context;
+        SegmentBarsResult result;
+    };
+    std::map<const Segment *, Entry> m_entries;
+};
+
+LilyPondExporter::SegmentBarsCache &
+LilyPondExporter::getSegmentBarsCache()
+{
+    static SegmentBarsCache cache;
+    return cache;
+}
+
+std::string
+LilyPondExporter::getSegmentBarsContext(const SegmentBars &bars) const
+{
+    std::ostringstream context;
+
+    const Segment *seg = bars.segment;
+    context << seg->getStartTime() << ' ' << seg->getEndMarkerTime() << ' '
+            << seg->getTranspose() << ' ' << seg->getLabel() << '\n';
+
+    context << bars.col << ' ' << bars.key.getName() << ' '
+            << bars.compositionStartTime << ' ' << bars.compositionEndTime << ' '
+            << bars.repeatingSegment << bars.simpleRepeatedLinks
+            << bars.synchronous << ' ' << bars.numberOfVolta << ' '
+            << bars.repeatWithAlt << bars.alt << bars.automaticVoltaUsable
+            << bars.wasRepeatingWithoutAlt << bars.firstAlt << ' '
+            << bars.altText << '\n';
+
+    context << m_exportBeams << m_chordNamesMode << m_useVolta << m_altBar
+            << m_cancelAccidentals << m_fingeringsInStaff
+            << m_exportStaffGroup << ' ' << m_exportNoteLanguage << ' '
+            << m_languageLevel << ' ' << m_exportLyrics << ' '
+            << m_exportTempoMarks << ' ' << m_exportMarkerMode << '\n';
+
+    // The bar lines.
+    context << m_composition->getStartMarker();
+    for (int i = 0; i < m_composition->getTimeSignatureCount(); ++i) {
+        const std::pair<timeT, TimeSignature> change =
+                m_composition->getTimeSignatureChange(i);
+        context << ' ' << change.first << ':'
+                << change.second.getNumerator() << '/'
+                << change.second.getDenominator()
+                << change.second.isCommon() << change.second.isHidden()
+                << change.second.hasHiddenBars();
+    }
+
+    return context.str();
+}
+
+LilyPondExporter::SegmentBarsResult
+LilyPondExporter::addSegmentBars(std::unique_ptr<SegmentBars> bars,
+                                 std::ostringstream &str)
+{
+    SegmentBars *segmentBars = bars.get();
+    m_segmentBars.push_back(std::move(bars));
+
+    SegmentBarsCache &cache = getSegmentBarsCache();
+    const std::string context = getSegmentBarsContext(*segmentBars);
+
+    const SegmentBarsResult *cached = m_writeBarsInOrder ?
+            nullptr : cache.find(segmentBars->segment, context);
+    if (cached) {
+        segmentBars->result = *cached;
+        str << segmentBars->result.text;
+        return segmentBars->result;
+    }
+
+    prepareChords(*segmentBars);
+
+    if (!m_deferBars) {
+        writeSegmentBars(*segmentBars);
+        if (!m_writeBarsInOrder)
+            cache.store(segmentBars->segment, context, segmentBars->result);
+        str << segmentBars->result.text;
+        return segmentBars->result;
+    }
+
+    // Predict what writeSegmentBars() will do with the indentation and
+    // the repeats.  This only depends on the repeat structure, unless
+    // the segment's alternative ending directives are malformed.  See
+    // writePendingBars().
+
+    SegmentBarsResult predicted;
+    predicted.haveRepeating =
+            segmentBars->repeatingSegment  ||
+            (segmentBars->simpleRepeatedLinks  &&  m_useVolta);
+    if (!predicted.haveRepeating  &&  segmentBars->repeatWithAlt) {
+        if (!segmentBars->alt)
+            predicted.haveVoltaWithAltEndings = true;
+        else
+            predicted.haveAlt = true;
+    }
+    predicted.endCol = segmentBars->col;
+    if (predicted.haveVoltaWithAltEndings  ||  predicted.haveAlt)
+        ++predicted.endCol;
+
+    // The bars go between what we have so far and what comes next.
+    m_scorePieces.push_back(str.str());
+    str.str("");
+    m_pendingBars.push_back(segmentBars);
+    m_predictedResults.push_back(predicted);
+
+    return predicted;
+}
+
+bool
+LilyPondExporter::writePendingBars(std::ostringstream &str)
+{
+    // Get the lazily computed parts of the composition, the segments and
+    // the default key out of the way before the workers read them.
+    m_composition->getBarNumber(m_composition->getStartMarker());
+    Rosegarden::Key::DefaultKey.getAccidentalHeights(Clef());
+    for (SegmentBars *bars : m_pendingBars) {
+        bars->segment->getClefAtTime(bars->segment->getStartTime());
+    }
+
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+
+        for (SegmentBars *bars : m_pendingBars) {
+            pool.start(new SegmentBarsJob(this, bars));
+        }
+
+        // Keep the display up to date, but don't let the user change
+        // anything while the workers are reading the segments.
+        while (!pool.waitForDone(20)) {
+            qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+    }
+
+    // Check the predictions.
+    for (size_t i = 0; i < m_pendingBars.size(); ++i) {
+        const SegmentBarsResult &result = m_pendingBars[i]->result;
+        const SegmentBarsResult &predicted = m_predictedResults[i];
+        if (result.endCol != predicted.endCol  ||
+            result.haveRepeating != predicted.haveRepeating  ||
+            result.haveVoltaWithAltEndings !=
+                    predicted.haveVoltaWithAltEndings  ||
+            result.haveAlt != predicted.haveAlt)
+            return false;
+    }
+
+    // Splice.
+    std::string score;
+    for (size_t i = 0; i < m_pendingBars.size(); ++i) {
+        score += m_scorePieces[i];
+        score += m_pendingBars[i]->result.text;
+    }
+    score += str.str();
+    str.str(score);
+    // Append from here on.
+    str.seekp(0, std::ios_base::end);
+
+    SegmentBarsCache &cache = getSegmentBarsCache();
+    for (SegmentBars *bars : m_pendingBars) {
+        cache.store(bars->segment, getSegmentBarsContext(*bars),
+                    bars->result);
+    }
+
+    return true;
+}
+
+void
+LilyPondExporter::prepareChords(SegmentBars &bars) const
+{
+    Segment *s = bars.segment;
+    const Quantizer *quantizer = m_composition->getNotationQuantizer();
+
+    for (Segment::iterator i = s->begin(); s->isBeforeEndMarker(i); ++i) {
+        if ((*i)->isa(Note::EventType))
+            bars.chords[*i].reset(new Chord(*s, i, quantizer));
+    }
+}
+
+void
+LilyPondExporter::writeSegmentBars(SegmentBars &bars)
+{
+    Segment *seg = bars.segment;
+    int col = bars.col;
+
+    int segStartTime = seg->getStartTime();
+    int firstBar = m_composition->getBarNumber(segStartTime);
+
+    std::ostringstream str;
+
+    // State variables
+    bool haveRepeating = false;  // Simple volta without alt. endings
+    bool haveAlternates = false; // Alternate ending may follow (?)
+    bool haveVoltaWithAltEndings = false; // Volta with alt. endings
+    bool haveAlt = false;        // Current seg. is an alt. ending
+
+    bool &nextBarIsAlt1 = bars.nextBarIsAlt1;
+    bool &nextBarIsAlt2 = bars.nextBarIsAlt2;
+    bool prevBarWasAlt2 = false;
+
+    for (int barNo = m_composition->getBarNumber(seg->getStartTime());
+        barNo <= m_composition->getBarNumber(seg->getEndMarkerTime());
+        ++barNo) {
+
+        timeT barStart = m_composition->getBarStart(barNo);
+        timeT barEnd = m_composition->getBarEnd(barNo);
+        timeT currentSegmentStartTime = seg->getStartTime();
+        timeT currentSegmentEndTime = seg->getEndMarkerTime();
+        // Check for a partial measure in the beginning of the composition
+        if (barStart < bars.compositionStartTime) {
+            barStart = bars.compositionStartTime;
+        }
+        // Check for a partial measure in the end of the composition
+        if (barEnd > bars.compositionEndTime) {
+            barEnd = bars.compositionEndTime;
+        }
+        // Check for a partial measure beginning in the middle of a
+        // theoretical bar
+        if (barStart < currentSegmentStartTime) {
+            barStart = currentSegmentStartTime;
+        }
+        // Check for a partial measure ending in the middle of a
+        // theoretical bar
+        if (barEnd > currentSegmentEndTime) {
+            barEnd = currentSegmentEndTime;
+        }
+
+        // Check for a time signature in the first bar of the segment
+        bool timeSigInFirstBar = false;
+        TimeSignature firstTimeSig =
+            m_composition->getTimeSignatureInBar(firstBar,
+                                                 timeSigInFirstBar);
+        // and write it here (to avoid multiple time signatures when
+        // a repeating segment is unfolded)
+        if (timeSigInFirstBar && (barNo == firstBar)) {
+            writeTimeSignature(firstTimeSig, col, str);
+        }
+
+        // open \repeat section if this is the first bar in the
+        // repeat
+        if ( (bars.repeatingSegment
+               || (bars.simpleRepeatedLinks
+                      && (m_useVolta)
+                  )
+             ) && !haveRepeating) {
+
+            haveRepeating = true;
+
+            int numRepeats = bars.numberOfVolta;
+            if ((m_useVolta) && bars.synchronous) {
+                str << std::endl << indent(col++)
+                    << "\\repeat volta " << numRepeats << " {";
+            } else {
+                // (m_useVolta == false)
+                str << std::endl << indent(col++)
+                    << "\\repeat unfold "
+                    << numRepeats << " {";
+            }
+        } else if (bars.repeatWithAlt &&
+                !haveVoltaWithAltEndings &&
+                !haveAlt) {
+            if (!bars.alt) {
+                str << std::endl << indent(col++);
+                if (bars.automaticVoltaUsable) {
+                    str << "\\repeat volta "
+                        << bars.numberOfVolta << " ";
+                }
+                // Opening of main repeating segment
+                str << "{   % Repeating stegment start here";
+                str << std::endl << indent(col)
+                    << "% Segment: " << seg->getLabel();
+                haveVoltaWithAltEndings = true;
+                if (!bars.automaticVoltaUsable) {
+                    if (bars.wasRepeatingWithoutAlt) {
+                        // When automatic volta is not usable, the
+                        // "start-repeat" bar hides the "end-repeat"
+                        // bar issued by the previous automatic
+                        // volta. In such a case, a "double-repeat"
+                        // bar has to be written. As #'(double-repeat)
+                        // is currently not defined in
+                        // LilyPond, the ":..:" string is used.
+                        str << std::endl << indent(col)
+                            << "\\bar \":..:\"";
+                    } else {
+                        str << std::endl << indent(col)
+                            << "\\set Score.repeatCommands = #'(start-repeat)";
+                    }
+                }
+            } else {
+                str << std::endl << indent(col)
+                    << "{   % Alternative start here";
+                str << std::endl << indent(col++)
+                    << "    % Segment: " << seg->getLabel();
+                if (!bars.automaticVoltaUsable) {
+                    str << std::endl << indent(col)
+                        << "\\set Score.repeatCommands = ";
+                    if (bars.firstAlt) {
+                        str << "#'((volta \""
+                            << bars.altText << "\"))";
+                    } else {
+                        str << "#'((volta #f) (volta \""
+                            << bars.altText << "\") end-repeat)";
+                    }
+                }
+
+                if (m_altBar && bars.firstAlt) {
+                    // Since LilyPond 2.23, drawing explicitely
+                    // this bar in any other alternative than the
+                    // first one hides the repetion bar.
+                    str << std::endl << indent(col)
+                        << "\\bar \"|\" ";
+                }
+                haveAlt = true;
+            }
+        }
+
+        // open the \alternative section if this bar is alternative
+        // ending 1 ending (because there was an "Alt1" flag in the
+        // previous bar to the left of where we are right now)
+        //
+        // Alt1 remains in effect until we run into Alt2, which
+        // runs to the end of the segment
+        if (nextBarIsAlt1 && haveRepeating) {
+            str << std::endl << indent(--col) << "} \% repeat close (before alternatives) ";
+            str << std::endl << indent(col++) << "\\alternative {";
+            str << std::endl << indent(col++) << "{  \% open alternative 1 ";
+            nextBarIsAlt1 = false;
+            haveAlternates = true;
+        } else if (nextBarIsAlt2 && haveRepeating) {
+            if (!prevBarWasAlt2) {
+                col--;
+                // add an extra str to the following to shut up
+                // compiler warning from --ing and ++ing it in the
+                // same statement
+                str << std::endl << indent(--col) << "} \% close alternative 1 ";
+                str << std::endl << indent(col++) << "{  \% open alternative 2";
+                col++;
+            }
+            prevBarWasAlt2 = true;
+        }
+
+        // should a time signature be writed in the current bar ?
+        bool noTimeSig = false;
+        if (timeSigInFirstBar) {
+            noTimeSig = barNo == firstBar;
+        }
+
+        // write out a bar's worth of events
+        writeBar(bars, barNo, barStart, barEnd, col, str, noTimeSig);
+    }
+
+    // close \repeat
+    if (haveRepeating) {
+
+        // close \alternative section if present
+        if (haveAlternates) {
+            str << std::endl << indent(--col) << "} \% close alternative 2 ";
+        }
+
+        // close \repeat section in either case
+        str << std::endl << indent(--col) << "} \% close "
+            << (haveAlternates ? "alternatives" : "repeat");
+    }
+
+    bars.result.text = str.str();
+    bars.result.endCol = col;
+    bars.result.haveRepeating = haveRepeating;
+    bars.result.haveVoltaWithAltEndings = haveVoltaWithAltEndings;
+    bars.result.haveAlt = haveAlt;
+
+    // Done with the chords.
+    bars.chords.clear();
+}
+
 timeT
-LilyPondExporter::calculateDuration(Segment *s,
+LilyPondExporter::calculateDuration(SegmentBars &bars,
                                     const Segment::iterator &i,
                                     int barNo,
                                     timeT barEnd,
                                     timeT &soundingDuration,
                                     const std::pair<int, int> &tupletRatio,
-                                    bool &overlong)
+                                    bool &overlong) const
 {
+    Segment *s = bars.segment;
     timeT duration = (*i)->getNotationDuration();
     timeT absTime = (*i)->getNotationAbsoluteTime();
 
@@ -2221,8 +2572,8 @@ LilyPondExporter::calculateDuration(Segment *s,
             if (duration > 0 &&
                 duration < Note(Note::Shortest).getDuration() &&
                 !(*i)->has(BEAMED_GROUP_TUPLET_BASE)) {
-                if (m_warningMessage.isEmpty()) {
-                    m_warningMessage =
+                if (bars.result.warning.isEmpty()) {
+                    bars.result.warning =
                         tr("Bar %1 contains an event too short to "
                            "represent in standard notation.\n"
                            "This is probably due to a corrupt event in "
@@ -2255,7 +2606,7 @@ LilyPondExporter::calculateDuration(Segment *s,
 
     if ((*i)->isa(Note::EventType)) {
 
-        Chord chord(*s, i, m_composition->getNotationQuantizer());
+        const Chord &chord = *bars.chords.at(*i);
         Segment::iterator nextElt2 = chord.getFinalElement();
         ++nextElt2;
 
@@ -2266,7 +2617,7 @@ LilyPondExporter::calculateDuration(Segment *s,
             // rendering counterpoint in RG
             if ((*nextElt2)->isa(Note::EventRestType) &&
                 (*nextElt2)->getNotationAbsoluteTime() == absTime) {
-                (*nextElt2)->set<Bool>(SKIP_PROPERTY, true);
+                bars.skipEvents.insert(*nextElt2);
                 ++nextElt2;
             }
         }
@@ -2334,7 +2685,7 @@ static std::string lilyClefType(const std::string &clefType)
     return std::string();
 }
 
-void LilyPondExporter::handleGuitarChord(Segment::iterator i, std::ofstream &str)
+void LilyPondExporter::handleGuitarChord(Segment::iterator i, std::ostream &str)
 {
     try {
         Guitar::Chord chord = Guitar::Chord(**i);
@@ -2387,19 +2738,24 @@ void LilyPondExporter::handleGuitarChord(Segment::iterator i, std::ofstream &str
 }
 
 void
-LilyPondExporter::writeBar(Segment *s,
+LilyPondExporter::writeBar(SegmentBars &bars,
                            int barNo, timeT barStart, timeT barEnd, int col,
-                           Rosegarden::Key &key,
-                           std::string &lilyText,
-                           std::string &prevStyle,
-                           eventendlist &preEventsInProgress,
-                           eventendlist &postEventsInProgress,
-                           std::ofstream &str,
-                           int &MultiMeasureRestCount,
-                           bool &nextBarIsAlt1, bool &nextBarIsAlt2,
-                           bool &nextBarIsDouble, bool &nextBarIsEnd,
-                           bool &nextBarIsDot,  bool noTimeSignature)
+                           std::ostream &str,
+                           bool noTimeSignature)
 {
+    Segment *s = bars.segment;
+    Rosegarden::Key &key = bars.key;
+    std::string &lilyText = bars.lilyText;
+    std::string &prevStyle = bars.prevStyle;
+    eventendlist &preEventsInProgress = bars.preEventsInProgress;
+    eventendlist &postEventsInProgress = bars.postEventsInProgress;
+    int &MultiMeasureRestCount = bars.multiMeasureRestCount;
+    bool &nextBarIsAlt1 = bars.nextBarIsAlt1;
+    bool &nextBarIsAlt2 = bars.nextBarIsAlt2;
+    bool &nextBarIsDouble = bars.nextBarIsDouble;
+    bool &nextBarIsEnd = bars.nextBarIsEnd;
+    bool &nextBarIsDot = bars.nextBarIsDot;
+
     int lastStem = 0; // 0 => unset, -1 => down, 1 => up
 
     Segment::iterator i =
@@ -2429,7 +2785,7 @@ LilyPondExporter::writeBar(Segment *s,
     timeT writtenDuration = 0;
     std::pair<int,int> barDurationRatio(timeSignature.getNumerator(),timeSignature.getDenominator());
     std::pair<int,int> durationRatioSum(0,1);
-    static std::pair<int,int> durationRatio(0,1);
+    std::pair<int,int> &durationRatio = bars.durationRatio;
 
     if (absTime > barStart) {
         Note note(Note::getNearestNote(absTime - barStart, MAX_DOTS));
@@ -2491,9 +2847,9 @@ LilyPondExporter::writeBar(Segment *s,
 
                     if (newGroupId != -1) {
                         if (tuplet) {
-                            nextNoteInTuplet = nextNoteInGroup(s, i, groupType, barEnd);
+                            nextNoteInTuplet = nextNoteInGroup(bars, i, groupType, barEnd);
                         }
-                        nextBeamedNoteInGroup = nextNoteInGroup(s, i, GROUP_TYPE_BEAMED, barEnd);
+                        nextBeamedNoteInGroup = nextNoteInGroup(bars, i, GROUP_TYPE_BEAMED, barEnd);
                     }
                 }
 
@@ -2563,14 +2919,13 @@ LilyPondExporter::writeBar(Segment *s,
 
         timeT soundingDuration = -1;
         timeT duration = calculateDuration
-            (s, i, barNo, barEnd, soundingDuration, tupletRatio, overlong);
+            (bars, i, barNo, barEnd, soundingDuration, tupletRatio, overlong);
 
         if (soundingDuration == -1) {
             soundingDuration = duration * tupletRatio.first / tupletRatio.second;
         }
 
-        if (event->has(SKIP_PROPERTY)) {
-            event->unset(SKIP_PROPERTY);
+        if (bars.skipEvents.erase(event)) {
             ++i;
             continue;
         }
@@ -2592,7 +2947,7 @@ LilyPondExporter::writeBar(Segment *s,
 
         } else if (isNote) {
 
-            Chord chord(*s, i, m_composition->getNotationQuantizer());
+            const Chord &chord = *bars.chords.at(*i);
             Event *e = *chord.getInitialNote();
             bool tiedForward = false;
             bool tiedUp = false;
@@ -2874,10 +3229,7 @@ LilyPondExporter::writeBar(Segment *s,
                 Clef clef(*event);
                 const std::string clefType = clef.getClefType();
                 str << lilyClefType(clefType);
-
-                // save clef for later use by rests that need repositioned
-                m_lastClefFound = clef;
-                RG_DEBUG << "clef:" << clefType << "lastClefFound:" << m_lastClefFound.getClefType();
+                RG_DEBUG << "clef:" << clefType;
 
                 // Transpose the clef one or two octaves up or down, if specified.
                 int octaveOffset = clef.getOctaveOffset();
@@ -3034,7 +3386,7 @@ LilyPondExporter::writeBar(Segment *s,
 
 void
 LilyPondExporter::writeTimeSignature(const TimeSignature& timeSignature,
-                                     int col, std::ofstream &str)
+                                     int col, std::ostream &str)
 {
     if (timeSignature.isHidden()) {
         str << indent (col)
@@ -3091,7 +3443,7 @@ LilyPondExporter::writeSkip(const TimeSignature &timeSig,
                             timeT offset,
                             timeT duration,
                             bool useRests,
-                            std::ofstream &str)
+                            std::ostream &str)
 {
     DurationList dlist;
     timeSig.getDurationListForInterval(dlist, duration, offset);
@@ -3264,7 +3616,7 @@ LilyPondExporter::handleText(const Event *textEvent,
 void
 LilyPondExporter::writePitch(const Event *note,
                              const Rosegarden::Key &key,
-                             std::ofstream &str)
+                             std::ostream &str)
 {
     // Note pitch (need name as well as octave)
     // It is also possible to have "relative" pitches,
@@ -3306,7 +3658,7 @@ LilyPondExporter::writePitch(const Event *note,
 
 void
 LilyPondExporter::writeStyle(const Event *note, std::string &prevStyle,
-                             int col, std::ofstream &str, bool isInChord)
+                             int col, std::ostream &str, bool isInChord)
 {
     // some hard-coded styles in order to provide rudimentary style export support
     // note that this is technically bad practice, as style names are not supposed
@@ -3350,7 +3702,7 @@ LilyPondExporter::writeStyle(const Event *note, std::string &prevStyle,
 
 std::pair<int,int>
 LilyPondExporter::writeDuration(timeT duration,
-                                std::ofstream &str)
+                                std::ostream &str)
 {
     Note note(Note::getNearestNote(duration, MAX_DOTS));
     std::pair<int,int> durationRatio(0,1);
@@ -3399,7 +3751,7 @@ LilyPondExporter::writeDuration(timeT duration,
 }
 
 void
-LilyPondExporter::writeSlashes(const Event *note, std::ofstream &str)
+LilyPondExporter::writeSlashes(const Event *note, std::ostream &str)
 {
     // if a grace note has tremolo slashes, they have already been used to turn
     // the note into a slashed grace note, and need not be exported here
@@ -3423,7 +3775,7 @@ LilyPondExporter::writeSlashes(const Event *note, std::ofstream &str)
 void
 LilyPondExporter::writeVersesWithVolta(LilyPondSegmentsContext & lsc,
                                        int verseLine, int cycle,
-                                       int indentCol, std::ofstream &str)
+                                       int indentCol, std::ostream &str)
 {
     ////////////////////////////////////////////////////////////////////
     // The comment at the end of LilyPondExporter.h explains what the //
@@ -3479,7 +3831,7 @@ void
 LilyPondExporter::writeVersesUnfolded(LilyPondSegmentsContext & lsc,
                                       std::map<Segment *, int> & verseIndexes,
                                       int verseLine, int cycle,
-                                      int indentCol, std::ofstream &str)
+                                      int indentCol, std::ostream &str)
 {
     // Initialisation, when first line and first cycle
     if (verseLine == 0 && cycle == 0) {
@@ -3522,7 +3874,7 @@ LilyPondExporter::writeVersesUnfolded(LilyPondSegmentsContext & lsc,
 
 void
 LilyPondExporter::writeVerse(Segment *seg, int verseIndex,
-                             int indentCol, std::ofstream &str)
+                             int indentCol, std::ostream &str)
 {
 
     str << std::endl;
@@ -30,22 +30,28 @@
 #define RG_LILYPONDEXPORTER_H
 
 #include "base/Event.h"
+#include "base/NotationTypes.h"
 #include "base/PropertyName.h"
 #include "base/Segment.h"
 #include "base/Selection.h"
+#include "base/Sets.h"
 #include "document/io/LilyPondLanguage.h"
 
-#include <fstream>
+#include <memory>
+#include <ostream>
 #include <set>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <QCoreApplication>
 #include <QPointer>
+#include <QString>
 
 class QObject;
 class QProgressDialog;
-class QString;
 
 
 namespace Rosegarden
@@ -136,56 +142,177 @@ public:
     void setProgressDialog(QPointer<QProgressDialog> progressDialog)
             { m_progressDialog = progressDialog; }
 
+    /// Write the bars of every segment in order, bypassing the cache.
+    /**
+     * The output is the same either way.  For testing.
+     */
+    void setWriteBarsInOrder(bool inOrder)  { m_writeBarsInOrder = inOrder; }
+
 private:
     NotationView *m_notationView;
     RosegardenDocument *m_doc;
     Composition *m_composition;
     Studio *m_studio;
     std::string m_fileName;
-    Clef m_lastClefFound;
     LilyPondLanguage *m_language;
     SegmentSelection m_selection;
 
     void readConfigVariables();
 
-    Event *nextNoteInGroup(const Segment *s, Segment::iterator it, const std::string &groupType, int barEnd) const;
+    /// Write everything but the file handling for write().
+    bool writeScore(std::ostringstream &str);
+
+    /// What writeSegmentBars() produces for a segment.
+    struct SegmentBarsResult
+    {
+        std::string text;
+        /// Indentation after the bars.
+        int endCol{0};
+        bool haveRepeating{false};
+        bool haveVoltaWithAltEndings{false};
+        bool haveAlt{false};
+        /// First warning raised while writing the bars.
+        QString warning;
+    };
+
+    /// The bars of one segment.
+    /**
+     * The bars are the bulk of the export, and everything needed to
+     * write them is captured here from the LilyPondSegmentsContext, so
+     * that the segments can be written on worker threads and the
+     * results spliced into the score in order.  See writeScore().
+     */
+    struct SegmentBars
+    {
+        // *** Input
+
+        Segment *segment{nullptr};
+        int col{0};
+        Rosegarden::Key key;
+        timeT compositionStartTime{0};
+        timeT compositionEndTime{0};
+
+        // Copied from the LilyPondSegmentsContext.
+        bool repeatingSegment{false};
+        bool simpleRepeatedLinks{false};
+        bool synchronous{false};
+        int numberOfVolta{0};
+        bool repeatWithAlt{false};
+        bool alt{false};
+        bool automaticVoltaUsable{false};
+        bool wasRepeatingWithoutAlt{false};
+        bool firstAlt{false};
+        std::string altText;
+
+        // *** Output
+
+        SegmentBarsResult result;
+
+        // *** State carried from one bar to the next by writeBar()
+
+        std::string lilyText;   // text events
+        std::string prevStyle;  // track note styles
+        // Temporary storage for non-atomic events (!BOOM)
+        // ex. LilyPond expects signals when a decrescendo starts
+        // as well as when it ends
+        eventendlist preEventsInProgress;
+        eventendlist postEventsInProgress;
+        int multiMeasureRestCount{0};
+        bool nextBarIsAlt1{false};
+        bool nextBarIsAlt2{false};
+        bool nextBarIsDouble{false};
+        bool nextBarIsEnd{false};
+        bool nextBarIsDot{false};
+        std::pair<int, int> durationRatio{0, 1};
+        /// Rests that the quantizer put alongside a note.  Not exported.
+        std::set<const Event *> skipEvents;
+        /// The chord at each note.  See prepareChords().
+        std::unordered_map<const Event *, std::unique_ptr<Chord>> chords;
+    };
+    class SegmentBarsJob;
+    class SegmentBarsCache;
+    static SegmentBarsCache &getSegmentBarsCache();
+
+    /// Find the chord at each note of the segment.
+    /**
+     * Finding a chord can copy the beamed group properties from one of
+     * its notes to another, and linked segments share their events, so
+     * this is done on the calling thread before the bars are written.
+     */
+    void prepareChords(SegmentBars &bars) const;
+
+    /// Write the bars of a segment into bars.result.
+    /**
+     * Called on worker threads.  Reads the segment, the composition, the
+     * options and the chords from prepareChords(), and writes nothing
+     * but bars.
+     */
+    void writeSegmentBars(SegmentBars &bars);
+
+    /// Whether segment bars not in the cache are deferred.
+    /**
+     * When set, writeScore() carries on past each segment using the
+     * indentation and flags that its bars are expected to produce, and
+     * writes the bars afterwards on worker threads.  If any segment
+     * turns out differently, the score is written again with this
+     * cleared.
+     */
+    bool m_deferBars;
+    bool m_writeBarsInOrder{false};
+    /// The bars of every segment in the score, in order.
+    std::vector<std::unique_ptr<SegmentBars>> m_segmentBars;
+    /// Deferred bars.  Each goes after the corresponding score piece.
+    std::vector<SegmentBars *> m_pendingBars;
+    std::vector<SegmentBarsResult> m_predictedResults;
+    std::vector<std::string> m_scorePieces;
+
+    /// Everything other than the segment's events that goes into its bars.
+    std::string getSegmentBarsContext(const SegmentBars &bars) const;
+
+    /// Take the bars of a segment and write them now, or defer them.
+    /**
+     * Returns the result, or the predicted result if deferred.
+     */
+    SegmentBarsResult addSegmentBars(std::unique_ptr<SegmentBars> bars,
+                                     std::ostringstream &str);
+    /// Write the deferred bars and splice them into str.
+    /**
+     * Returns false if any of them did not come out as predicted.
+     */
+    bool writePendingBars(std::ostringstream &str);
+
+    Event *nextNoteInGroup(const SegmentBars &bars, Segment::iterator it, const std::string &groupType, int barEnd) const;
 
     // Return true if the given segment has to be print
     // (readConfigVAriables() should have been called before)
     bool isSegmentToPrint(Segment *seg);
 
-    void writeBar(Segment *, int barNo, timeT barStart, timeT barEnd, int col,
-                  Rosegarden::Key &key, std::string &lilyText,
-                  std::string &prevStyle,
-                  eventendlist &preEventsInProgress, eventendlist &postEventsInProgress,
-                  std::ofstream &str, int &MultiMeasureRestCount,
-                  bool &nextBarIsAlt1, bool &nextBarIsAlt2,
-                  bool &nextBarIsDouble, bool &nextBarIsEnd,
-                  bool &nextBarIsDot, bool noTimeSignature);
+    void writeBar(SegmentBars &bars, int barNo, timeT barStart, timeT barEnd,
+                  int col, std::ostream &str, bool noTimeSignature);
 
-    timeT calculateDuration(Segment *s,
+    timeT calculateDuration(SegmentBars &bars,
                                         const Segment::iterator &i,
                                         int barNo,
                                         timeT barEnd,
                                         timeT &soundingDuration,
                                         const std::pair<int, int> &tupletRatio,
-                                        bool &overlong);
+                                        bool &overlong) const;
 
     static void handleStartingPreEvents(eventstartlist &preEventsToStart,
                                         const Segment *seg,
                                         const Segment::iterator &j,
-                                        std::ofstream &str);
+                                        std::ostream &str);
     static void handleEndingPreEvents(eventendlist &preEventsInProgress,
                                       const Segment::iterator &j,
-                                      std::ofstream &str);
+                                      std::ostream &str);
     void handleStartingPostEvents(eventstartlist &postEventsToStart,
                                   const Segment *seg,
                                   const Segment::iterator &j,
-                                  std::ofstream &str);
+                                  std::ostream &str);
     static void handleEndingPostEvents(eventendlist &postEventsInProgress,
                                        const Segment *seg,
                                        const Segment::iterator &j,
-                                       std::ofstream &str);
+                                       std::ostream &str);
 
     // convert note pitch into LilyPond format note name string
     std::string convertPitchToLilyNoteName(int pitch,
@@ -210,13 +337,13 @@ private:
     // write a time signature
     static void writeTimeSignature(const TimeSignature& timeSignature,
                                    int col,
-                                   std::ofstream &str);
+                                   std::ostream &str);
 
     std::pair<int,int> writeSkip(const TimeSignature &timeSig,
                                  timeT offset,
 	                             timeT duration,
                                  bool useRests,
-                                 std::ofstream &);
+                                 std::ostream &);
 
     /*
      * Handle LilyPond directive.  Returns true if the event was a directive,
@@ -228,11 +355,11 @@ private:
                                 bool &nextBarIsDouble, bool &nextBarIsEnd, bool &nextBarIsDot);
 
     void handleText(const Event *, std::string &lilyText) const;
-    static void handleGuitarChord(Segment::iterator i, std::ofstream &str);
-    void writePitch(const Event *note, const Rosegarden::Key &key, std::ofstream &);
-    void writeStyle(const Event *note, std::string &prevStyle, int col, std::ofstream &, bool isInChord);
-    std::pair<int,int> writeDuration(timeT duration, std::ofstream &);
-    void writeSlashes(const Event *note, std::ofstream &);
+    static void handleGuitarChord(Segment::iterator i, std::ostream &str);
+    void writePitch(const Event *note, const Rosegarden::Key &key, std::ostream &);
+    void writeStyle(const Event *note, std::string &prevStyle, int col, std::ostream &, bool isInChord);
+    std::pair<int,int> writeDuration(timeT duration, std::ostream &);
+    void writeSlashes(const Event *note, std::ostream &);
 
     /*
      * Return the verse with index currentVerse from the givenSegment ready to
@@ -245,7 +372,7 @@ private:
      * segment with the indentation indentCol or an appropriate LilyPond
      * skip sequence if the verse doesn't exist.
      */
-    void writeVerse(Segment *seg, int verseIndex, int indentCol, std::ofstream &str);
+    void writeVerse(Segment *seg, int verseIndex, int indentCol, std::ostream &str);
 
     /*
      * Write in str all the lyrics verses using volta and alternativete endings
@@ -254,7 +381,7 @@ private:
      */
     void writeVersesWithVolta(LilyPondSegmentsContext & lsc,
                               int verseLine, int cycle,
-                              int indentCol, std::ofstream &str);
+                              int indentCol, std::ostream &str);
     /*
      * Write in str all the lyrics verses of an unfolded score (i.e. without
      * volta) for a given line and cycle with the indentation indentCol.
@@ -263,7 +390,7 @@ private:
     void writeVersesUnfolded(LilyPondSegmentsContext & lsc,
                              std::map<Segment *, int> & verseIndexes,
                              int verseLine, int cycle,
-                             int indentCol, std::ofstream &str);
+                             int indentCol, std::ostream &str);
 
     /* Used to embed a lyric syllable with a bar number */
     struct Syllable {
@@ -292,7 +419,6 @@ private:
 
 private:
     static const int MAX_DOTS = 4;
-    const PropertyName SKIP_PROPERTY;
 
     unsigned int m_paperSize;
     // ??? These need to be public someplace LilyPondOptionsDialog can get
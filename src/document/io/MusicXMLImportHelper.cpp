@@ -46,7 +46,13 @@ MusicXMLImportHelper::MusicXMLImportHelper(RosegardenDocument *doc) :
 
 MusicXMLImportHelper::~MusicXMLImportHelper()
 {
-    //
+    // Only non-empty if the parse failed.
+    for (Segment *segment : m_newSegments) {
+        for (const QueuedEvent &queued : m_queues[segment].events) {
+            delete queued.event;
+        }
+        delete segment;
+    }
 }
 
 bool
@@ -128,15 +134,16 @@ MusicXMLImportHelper::setVoice(const QString &voice)
         if (m_segments.find(m_staff+"/"+tmpVoice) == m_segments.end()) {
             createSegment = true;
         } else {
-            if ((tmpVoice != m_mainVoice[m_staff]) && (m_segments[m_staff+"/"+tmpVoice]->getEndTime() < m_curTime)) {
+            if ((tmpVoice != m_mainVoice[m_staff]) && (m_queues[m_segments[m_staff+"/"+tmpVoice]].endTime < m_curTime)) {
                 createSegment = true;
             }
         }
         if (createSegment) {
             Segment *segment = new Segment(Segment::Internal, m_curTime);
             segment->setLabel(m_label.toStdString());
-            m_document->getComposition().addSegment(segment);
             segment->setTrack(m_tracks[m_staff]->getId());
+            m_newSegments.push_back(segment);
+            m_queues[segment].endTime = m_curTime;
             m_segments[m_staff+"/"+tmpVoice] = segment;
         }
         m_voice = tmpVoice;
@@ -173,7 +180,7 @@ MusicXMLImportHelper::insertKey(const Key &key, int number)
                 RG_WARNING << "No segment for staff " << (*i).first << " and voice " << m_mainVoice[m_staff];
                 continue;
             }
-            segment->insert(key.getAsEvent(m_curTime));
+            queue(segment, key.getAsEvent(m_curTime));
         }
     }
     return true;
@@ -193,10 +200,11 @@ MusicXMLImportHelper::insertClef(const Clef &clef, int number)
         QString staff;
         staff.setNum(number);
         setStaff(staff);
-        m_segments[m_staff+"/"+m_voice]->insert(clef.getAsEvent(m_curTime));
+        queue(m_segments[m_staff+"/"+m_voice], clef.getAsEvent(m_curTime));
     } else {
         for (TrackMap::iterator i = m_tracks.begin(); i != m_tracks.end(); ++i) {
-            m_segments[(*i).first+"/"+m_mainVoice[m_staff]]->insert(clef.getAsEvent(m_curTime));
+            queue(m_segments[(*i).first+"/"+m_mainVoice[m_staff]],
+                  clef.getAsEvent(m_curTime));
         }
     }
     return true;
@@ -204,12 +212,41 @@ MusicXMLImportHelper::insertClef(const Clef &clef, int number)
 
 bool
 MusicXMLImportHelper::insert(Event *event)
+{
+    queue(m_segments[m_staff+"/"+m_voice], event);
+    if ( event->isa(Rosegarden::Note::EventType) || event->isa(Rosegarden::Note::EventRestType)) {
+        m_curTime = event->getAbsoluteTime() + event->getDuration();
+    }
+    return true;
+}
+
+void
+MusicXMLImportHelper::queue(Segment *segment, Event *event)
+{
+    if (!segment) {
+        RG_WARNING << "queue(): No segment for staff" << m_staff << "and voice" << m_voice;
+        delete event;
+        return;
+    }
+
+    SegmentQueue &segmentQueue = m_queues[segment];
+    segmentQueue.events.push_back(QueuedEvent{event, m_curTime});
+
+    // Keep track of the end time as Segment::insert() would.  setVoice()
+    // needs it.
+    const timeT endTime = event->getAbsoluteTime() + event->getGreaterDuration();
+    if (endTime > segmentQueue.endTime  ||  segmentQueue.empty)
+        segmentQueue.endTime = endTime;
+    segmentQueue.empty = false;
+}
+
+void
+MusicXMLImportHelper::insertNow(Segment *segment, Event *event, timeT curTime)
 {
     if (event->has(BaseProperties::IS_GRACE_NOTE)  &&
         event->get<Bool>(BaseProperties::IS_GRACE_NOTE)) {
-        Segment *segment = m_segments[m_staff+"/"+m_voice];
         Segment::iterator start, end;
-        segment->getTimeSlice(m_curTime, start, end);
+        segment->getTimeSlice(curTime, start, end);
         std::vector<Event *> toErase;
         for (Segment::iterator e = start; e != end; ++e) {
             if ( ! (*e)->isa(Rosegarden::Note::EventType) &&
@@ -227,11 +264,31 @@ MusicXMLImportHelper::insert(Event *event)
             segment->erase(segment->findSingle((*e)));
     }
 
-    m_segments[m_staff+"/"+m_voice]->insert(event);
-    if ( event->isa(Rosegarden::Note::EventType) || event->isa(Rosegarden::Note::EventRestType)) {
-        m_curTime = event->getAbsoluteTime() + event->getDuration();
+    segment->insert(event);
+}
+
+void
+MusicXMLImportHelper::buildSegments()
+{
+    for (Segment *segment : m_newSegments) {
+        SegmentQueue &segmentQueue = m_queues[segment];
+        for (const QueuedEvent &queued : segmentQueue.events) {
+            insertNow(segment, queued.event, queued.curTime);
+        }
+        segmentQueue.events.clear();
     }
-    return true;
+}
+
+void
+MusicXMLImportHelper::addSegments()
+{
+    Composition &composition = m_document->getComposition();
+
+    for (Segment *segment : m_newSegments) {
+        composition.addSegment(segment);
+    }
+    m_newSegments.clear();
+    m_queues.clear();
 }
 
 bool
@@ -276,7 +333,7 @@ MusicXMLImportHelper::endIndication(const std::string& name, int number, timeT e
           << ", " << extent << ") -> " << found;
     if (found) {
         Indication indication((*i).m_name, m_curTime - (*i).m_time + extent);
-        m_segments[m_staff+"/"+m_voice]->insert(indication.getAsEvent((*i).m_time));
+        queue(m_segments[m_staff+"/"+m_voice], indication.getAsEvent((*i).m_time));
         m_indications.erase(i);
     }
     return true;
@@ -42,6 +42,15 @@ class TimeSignature;
 class Clef;
 
 
+/// Builds the tracks and segments of one MusicXML part.
+/**
+ * While the file is being parsed the events are only queued for the
+ * segment they belong to.  The segments are not added to the composition
+ * until the parse is complete: MusicXMLXMLHandler::endDocument() calls
+ * buildSegments() for every part on a worker thread and then
+ * addSegments() for every part on the calling thread.  Since each part
+ * has its own segments and events, the parts can be built concurrently.
+ */
 class MusicXMLImportHelper {
 public:
 
@@ -74,8 +83,40 @@ public:
     void setInstrument(InstrumentId instrument);
     void setBracketType(int bracket);
 
+    /// Insert the queued events into the segments.
+    /**
+     * Doesn't touch the document, so it may be called on a worker thread.
+     */
+    void buildSegments();
+    /// Add the segments to the composition, in the order they were created.
+    void addSegments();
+
 private:
 
+    /// An event waiting to be inserted into its segment.
+    struct QueuedEvent {
+        Event *event;
+        /// m_curTime when the event was queued.  Needed for grace notes.
+        timeT curTime;
+    };
+
+    /// The events for a segment, and the segment's end time as it will
+    /// be once they have been inserted.
+    struct SegmentQueue {
+        std::vector<QueuedEvent> events;
+        timeT endTime{0};
+        bool empty{true};
+    };
+
+    /// Queue event for insertion into segment.
+    void queue(Segment *segment, Event *event);
+    /// Insert event into segment as insert() would have done at curTime.
+    static void insertNow(Segment *segment, Event *event, timeT curTime);
+
+    /// The segments created for this part.  Owned until addSegments().
+    std::vector<Segment *> m_newSegments;
+    std::map<Segment *, SegmentQueue> m_queues;
+
     class IndicationStart {
     public:
         explicit IndicationStart(const QString &staff="",
@@ -35,7 +35,11 @@
 #include "base/Track.h"
 #include "base/TimeSignature.h"
 
+#include <QEventLoop>
+#include <QRunnable>
 #include <QString>
+#include <QThread>
+#include <QThreadPool>
 #include <QtGlobal>
 
 
@@ -81,7 +85,8 @@ MusicXMLXMLHandler::MusicXMLXMLHandler(RosegardenDocument *doc) :
         m_line(0),
         m_clefoctavechange(0),
         m_midiChannel(0),
-        m_midiProgram(0)
+        m_midiProgram(0),
+        m_elementCount(0)
 {}
 
 MusicXMLXMLHandler::~MusicXMLXMLHandler()
@@ -122,7 +127,10 @@ MusicXMLXMLHandler::startElement(const QString& /*namespaceURI*/,
                                  const QString& qName,
                                  const QXmlStreamAttributes& atts)
 {
-    qApp->processEvents();
+    // Large scores have millions of elements.  Don't spend the import
+    // pumping the event loop.
+    if (++m_elementCount % 1000 == 0)
+        qApp->processEvents();
 
     // If m_ignored is not an empty string it contains the name of an element
     // which will be ignored, including all it children.
@@ -299,10 +307,46 @@ MusicXMLXMLHandler::characters(const QString& chars)
     return true;
 }
 
+namespace
+{
+    class BuildSegmentsJob : public QRunnable
+    {
+    public:
+        explicit BuildSegmentsJob(MusicXMLImportHelper *part) :
+            m_part(part)
+        { }
+
+        void run() override  { m_part->buildSegments(); }
+
+    private:
+        MusicXMLImportHelper *m_part;
+    };
+}
+
 bool
 MusicXMLXMLHandler::endDocument()
 {
     RG_DEBUG << "MusicXMLXMLHandler::endDocument";
+
+    // The parts are independent, so fill in their segments concurrently.
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+
+        for (PartMap::iterator p = m_parts.begin(); p != m_parts.end(); ++p)
+            pool.start(new BuildSegmentsJob((*p).second));
+
+        while (!pool.waitForDone(20)) {
+            qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+    }
+
+    // Adding the segments notifies the composition's observers, so
+    // that has to happen here.  Do it in part order so the result
+    // doesn't depend on the workers.
+    for (PartMap::iterator p = m_parts.begin(); p != m_parts.end(); ++p)
+        (*p).second->addSegments();
+
     return true;
 }
 
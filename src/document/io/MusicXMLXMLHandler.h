@@ -243,6 +243,9 @@ protected:
     int             m_midiChannel; //! NOTE Still in use???
     int             m_midiProgram;
 
+    // Elements read so far, to limit the calls to processEvents().
+    unsigned        m_elementCount;
+
 };
 
 
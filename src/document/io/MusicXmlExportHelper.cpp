@@ -42,6 +42,13 @@ namespace Rosegarden
 
 using namespace BaseProperties;
 
+namespace
+{
+    // Interned at static init rather than in the PartJobs.
+    const PropertyName MxmlPitch("MxmlPitch");
+    const PropertyName MxmlNoteHead("MxmlNoteHead");
+}
+
 MusicXmlExportHelper::MusicXmlExportHelper(const std::string &name,
                                      const TrackVector &tracklist,
                                      bool percussion,
@@ -372,8 +379,8 @@ MusicXmlExportHelper::emptyQuantizeQueue(PercussionMap &pm,
         int pp = (*v)->get<Int>(BaseProperties::PITCH);
         timeT t = (*v)->getNotationAbsoluteTime();
         Event *tmp = new Event(*(*v), t, duration);
-        tmp->set<Int>(PropertyName("MxmlPitch"), pm.getPitch(pp));
-        tmp->set<String>(PropertyName("MxmlNoteHead"), pm.getNoteHead(pp));
+        tmp->set<Int>(MxmlPitch, pm.getPitch(pp));
+        tmp->set<String>(MxmlNoteHead, pm.getNoteHead(pp));
         tmp->set<Bool>(NotationProperties::BEAM_ABOVE, stem);
         segment->insert(tmp);
         empty = false;
@@ -1082,8 +1089,8 @@ MusicXmlExportHelper::addNote(const Segment &segment, const Event &event)
         }
         if (m_percussionTrack) {
             Pitch pitch(event);
-            if (event.has(PropertyName("MxmlPitch"))) {
-                pitch = Pitch(event.get<Int>(PropertyName("MxmlPitch")));
+            if (event.has(MxmlPitch)) {
+                pitch = Pitch(event.get<Int>(MxmlPitch));
             }
             tmpNote << "        <unpitched>\n";
             tmpNote << "          <display-step>" << pitch.getNoteName(Key())
@@ -1091,7 +1098,7 @@ MusicXmlExportHelper::addNote(const Segment &segment, const Event &event)
             tmpNote << "          <display-octave>" << pitch.getOctaveAccidental(-1)
                                                     << "</display-octave>\n";
             tmpNote << "        </unpitched>\n";
-            tmpNotehead << "        <notehead>" << event.get<String>(PropertyName("MxmlNoteHead"))
+            tmpNotehead << "        <notehead>" << event.get<String>(MxmlNoteHead)
                                                 << "</notehead>\n";
 
             if (duration > 0) {
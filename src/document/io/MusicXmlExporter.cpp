@@ -33,9 +33,14 @@
 
 #include "rosegarden-version.h"
 
+#include <QEventLoop>
 #include <QProgressDialog>
+#include <QRunnable>
 #include <QSettings>
+#include <QThread>
+#include <QThreadPool>
 
+#include <atomic>
 #include <sstream>
 #include <iostream>
 
@@ -61,7 +66,7 @@ MusicXmlExporter::MusicXmlExporter(RosegardenMainWindow *parent,
         m_fileName(fileName)
 {
     m_composition = &m_doc->getComposition();
-    m_view = parent->getView();
+    m_view = parent ? parent->getView() : nullptr;
     readConfigVariables();
 }
 
@@ -492,6 +497,68 @@ MusicXmlExporter::writeScorePart(timeT compositionEndTime, std::ostream &str)
     return parts;
 }
 
+class MusicXmlExporter::PartJob : public QRunnable
+{
+public:
+    PartJob(MusicXmlExportHelper *part, int firstBar, int endBar,
+            MeasureVector *measures, std::atomic<int> *partsDone) :
+        m_part(part),
+        m_firstBar(firstBar),
+        m_endBar(endBar),
+        m_measures(measures),
+        m_partsDone(partsDone)
+    { }
+
+    void run() override
+    {
+        m_measures->reserve(m_endBar - m_firstBar);
+        for (int bar = m_firstBar; bar < m_endBar; ++bar) {
+            std::ostringstream str;
+            m_part->writeEvents(bar, str);
+            m_measures->push_back(str.str());
+        }
+        ++*m_partsDone;
+    }
+
+private:
+    MusicXmlExportHelper *m_part;
+    int m_firstBar;
+    int m_endBar;
+    MeasureVector *m_measures;
+    std::atomic<int> *m_partsDone;
+};
+
+std::vector<MusicXmlExporter::MeasureVector>
+MusicXmlExporter::writeParts(const PartsVector &parts, int firstBar, int endBar)
+{
+    std::vector<MeasureVector> measures(parts.size());
+    std::atomic<int> partsDone(0);
+
+    // The workers only read the composition.  Make sure the bar
+    // positions it calculates lazily are up to date before they start.
+    m_composition->getBarStart(endBar);
+
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+
+        for (size_t i = 0; i < parts.size(); ++i) {
+            pool.start(new PartJob(parts[i], firstBar, endBar,
+                                   &measures[i], &partsDone));
+        }
+
+        // Keep the display up to date, but don't let the user change
+        // anything while the workers are reading the segments.
+        while (!pool.waitForDone(20)) {
+            if (m_progressDialog && !parts.empty())
+                m_progressDialog->setValue(partsDone * 100 / parts.size());
+            qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+    }
+
+    return measures;
+}
+
 bool
 MusicXmlExporter::write()
 {
@@ -549,29 +616,28 @@ MusicXmlExporter::write()
                     QCoreApplication::translate(
                             "MusicXmlExporter", "Exporting MusicXML file..."));
 
-        size_t partIndex = 0;
+        const int firstBar = pickup ? -1 : 0;
+        int endBar = firstBar;
+        while (m_composition->getBarStart(endBar) < compositionEndTime)
+            ++endBar;
 
-        for (PartsVector::iterator c = parts.begin(); c != parts.end(); ++c) {
-            if (m_progressDialog) {
-                m_progressDialog->setValue(partIndex * 100 / parts.size());
-                ++partIndex;
-            }
+        const std::vector<MeasureVector> measures =
+                writeParts(parts, firstBar, endBar);
 
-            str << "  <part id=\"" << (*c)->getPartName() << "\">" << std::endl;
-            int bar = pickup ? -1 : 0;
-            // For each bar
-            while (m_composition->getBarStart(bar) < compositionEndTime) {
-                qApp->processEvents();
+        for (size_t partIndex = 0; partIndex < parts.size(); ++partIndex) {
+            const MeasureVector &partMeasures = measures[partIndex];
 
+            str << "  <part id=\"" << parts[partIndex]->getPartName() << "\">" << std::endl;
+            // For each bar
+            for (int bar = firstBar; bar < endBar; ++bar) {
                 str << "    <measure number=\"" << bar+1 << "\"";
                 if (bar < 0) str << " implicit=\"yes\"";
                 str << ">" << std::endl;
-                (*c)->writeEvents(bar, str);
+                str << partMeasures[bar - firstBar];
                 str << "    </measure>" << std::endl;
-                bar++;
-            } // while (m_composition->getBarEnd(bar) < ...
+            }
             str << "  </part>" << std::endl;
-        } // for (int trackPos = 0....
+        } // for (size_t partIndex = 0....
         str << "</score-partwise>" << std::endl;
         for (PartsVector::iterator c = parts.begin(); c != parts.end(); ++c)
             delete *c;
@@ -594,29 +660,23 @@ MusicXmlExporter::write()
                     QCoreApplication::translate(
                             "MusicXmlExporter", "Exporting MusicXML file..."));
 
-        int bar = 0;
-        // For each bar
-        while (m_composition->getBarStart(bar) < compositionEndTime) {
-            if (m_progressDialog) {
-                // ??? Probably a costly call.  Might want to consolidate with
-                //     the call above.
-                timeT barStart = m_composition->getBarStart(bar);
-                int progress = static_cast<int>(
-                        barStart * 100 /
-                        (compositionEndTime - compositionStartTime));
-                m_progressDialog->setValue(progress);
-            }
+        const int firstBar = 0;
+        int endBar = firstBar;
+        while (m_composition->getBarStart(endBar) < compositionEndTime)
+            ++endBar;
 
-            str << "  <measure number=\"" << bar+1 << "\">" << std::endl;
-            for (PartsVector::iterator c = parts.begin(); c != parts.end(); ++c) {
-                qApp->processEvents();
+        const std::vector<MeasureVector> measures =
+                writeParts(parts, firstBar, endBar);
 
-                str << "    <part id=\"" << (*c)->getPartName() << "\">" << std::endl;
-                (*c)->writeEvents(bar, str);
+        // For each bar
+        for (int bar = firstBar; bar < endBar; ++bar) {
+            str << "  <measure number=\"" << bar+1 << "\">" << std::endl;
+            for (size_t partIndex = 0; partIndex < parts.size(); ++partIndex) {
+                str << "    <part id=\"" << parts[partIndex]->getPartName() << "\">" << std::endl;
+                str << measures[partIndex][bar - firstBar];
                 str << "    </part>" << std::endl;
-            } // for (int trackPos = 0....
+            } // for (size_t partIndex = 0....
             str << "  </measure>" << std::endl;
-            bar++;
         }
         str << "</score-timewise>" << std::endl;
         for (PartsVector::iterator c = parts.begin(); c != parts.end(); ++c)
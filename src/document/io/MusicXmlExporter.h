@@ -31,6 +31,9 @@
 
 #include <QPointer>
 
+#include <string>
+#include <vector>
+
 class QProgressDialog;
 
 namespace Rosegarden
@@ -95,11 +98,14 @@ class Instrument;
  *                      .
  *                      .
  *
- *       To write the measures, write() will iterate over all parts and bars
- *       for a part-wise file (or over all bars and parts for a time-wise file)
- *       and calls the MusicXmlExportHelper member writeEvents().
- *       The member iterates over all voices of the part and handles all events
- *       of the segments.
+ *       To write the measures, writeParts() hands each part to a worker
+ *       thread which calls the MusicXmlExportHelper member writeEvents()
+ *       for every bar and keeps the text of each measure.  The member
+ *       iterates over all voices of the part and handles all events of the
+ *       segments.  Since every part has its own MusicXmlExportHelper the
+ *       parts don't share any state.  write() then stitches the measures
+ *       together part by part (or bar by bar for a time-wise file), so the
+ *       output doesn't depend on the order in which the workers finish.
  *
  *       Some known problems:
  *       1)     When exporting multi staff part, problems arise when segments
@@ -139,7 +145,8 @@ public:
     /**
      * Constructs a MusicXmlExporter object
      *
-     * @param parent the parent object.
+     * @param parent the parent object.  May be nullptr, in which case
+     *        EXPORT_SELECTED_SEGMENTS exports nothing.
      * @param doc the Rosegarden document.
      * @param filename name of the outfile MusicXML file.
      */
@@ -210,8 +217,21 @@ protected:
                             bool &exporting, bool &inMultiStaffGroup);
     PartsVector writeScorePart(timeT compositionEndTime, std::ostream &str);
 
+    /// The text of each measure of a part, indexed by bar - firstBar.
+    typedef std::vector<std::string> MeasureVector;
+
+    /// Write the measures firstBar up to endBar of all parts.
+    /**
+     * Each part is written by a worker thread.  The result has a
+     * MeasureVector for each part, in the same order as parts.
+     */
+    std::vector<MeasureVector> writeParts(const PartsVector &parts,
+                                          int firstBar, int endBar);
+
 private:
     QPointer<QProgressDialog> m_progressDialog;
+
+    class PartJob;
 };
 
 }
@@ -76,6 +76,7 @@
 #include "commands/segment/RemoveTimeSignatureCommand.h"
 #include "commands/segment/SegmentAutoSplitCommand.h"
 #include "commands/segment/SegmentChangeTransposeCommand.h"
+#include "commands/segment/SegmentInsertCommand.h"
 #include "commands/segment/SegmentJoinCommand.h"
 #include "commands/segment/SegmentLabelCommand.h"
 #include "commands/segment/SegmentReconfigureCommand.h"
@@ -179,6 +180,7 @@
 #include "sequencer/SequencerThread.h"
 #include "sound/AudioFile.h"
 #include "sound/AudioFileManager.h"
+#include "sound/AudioFileTranscriber.h"
 #ifdef HAVE_LILV
 #include "sound/LV2World.h"
 #include "sound/LV2Utils.h"
@@ -190,6 +192,7 @@
 #include "sound/MappedEvent.h"
 #include "sound/MappedStudio.h"
 #include "sound/MidiFile.h"
+#include "sound/PitchDetector.h"
 #include "sound/PluginIdentifier.h"
 #include "sound/SequencerDataBlock.h"
 #include "sound/SoundDriver.h"
@@ -408,6 +411,8 @@ RosegardenMainWindow::RosegardenMainWindow(
     RosegardenDocument *doc = newDocument(true, autoSaveFileName);  // permanent
 
     m_seqManager = new SequenceManager();
+    // Map for playback only what is about to be played.
+    m_seqManager->enableMappingWindow();
 
     m_parameterArea = new RosegardenParameterArea(this);
     m_parameterArea->setObjectName("RosegardenParameterArea");
@@ -897,6 +902,8 @@ RosegardenMainWindow::setupActions()
     createAction("repeat_quantize", &RosegardenMainWindow::slotRepeatQuantizeSelection);
     createAction("rescale", &RosegardenMainWindow::slotRescaleSelection);
     createAction("auto_split", &RosegardenMainWindow::slotAutoSplitSelection);
+    createAction("transcribe_audio",
+                 &RosegardenMainWindow::slotTranscribeSelection);
     createAction("split_by_pitch", &RosegardenMainWindow::slotSplitSelectionByPitch);
     createAction("split_by_recording", &RosegardenMainWindow::slotSplitSelectionByRecordedSrc);
     createAction("split_at_time", &RosegardenMainWindow::slotSplitSelectionAtTime);
@@ -2928,6 +2935,115 @@ RosegardenMainWindow::slotAutoSplitSelection()
     m_view->slotAddCommandToHistory(command);
 }
 
+void
+RosegardenMainWindow::slotTranscribeSelection()
+{
+    if (!m_view->haveSelection())
+        return;
+
+    RosegardenDocument *doc = RosegardenDocument::currentDocument;
+    Composition &composition = doc->getComposition();
+    const Studio &studio = doc->getStudio();
+
+    const SegmentSelection selection = m_view->getSelection();
+
+    // Each transcription goes on the first MIDI track below the audio.
+    std::vector<std::pair<Segment *, TrackId> > targets;
+    bool missingTrack = false;
+
+    for (Segment *segment : selection) {
+        if (segment->getType() != Segment::Audio)
+            continue;
+
+        const Track *audioTrack = composition.getTrackById(segment->getTrack());
+        if (!audioTrack)
+            continue;
+
+        const Track *midiTrack = nullptr;
+        for (int position = audioTrack->getPosition() + 1;
+             position < int(composition.getNbTracks()); ++position) {
+            const Track *track = composition.getTrackByPosition(position);
+            if (!track)
+                continue;
+            const Instrument *instrument =
+                    studio.getInstrumentById(track->getInstrument());
+            if (instrument  &&  instrument->getType() == Instrument::Midi) {
+                midiTrack = track;
+                break;
+            }
+        }
+
+        if (midiTrack)
+            targets.push_back(std::make_pair(segment, midiTrack->getId()));
+        else
+            missingTrack = true;
+    }
+
+    if (missingTrack) {
+        QMessageBox::warning(
+                this, tr("Rosegarden"),
+                tr("Audio is transcribed onto the first MIDI track below it.  Please add a MIDI track below each audio track to be transcribed."));
+    }
+
+    if (targets.empty())
+        return;
+
+    testAudioPath(tr("transcribing an audio file"));
+
+    // Use the pitch tracker's analysis settings.
+    QSettings settings;
+    settings.beginGroup(PitchTrackerConfigGroup);
+    const int frameSize = settings.value(
+            "framesize", PitchDetector::defaultFrameSize).toInt();
+    const int stepSize = settings.value(
+            "stepsize", PitchDetector::defaultStepSize).toInt();
+    int method = settings.value("method", 0).toInt();
+    settings.endGroup();
+
+    if (method < 0  ||  method >= PitchDetector::getMethods()->size())
+        method = 0;
+
+    QProgressDialog progressDialog(
+            tr("Transcribing audio..."),  // labelText
+            tr("Cancel"),  // cancelButtonText
+            0, 100,  // min, max
+            this);  // parent
+    progressDialog.setWindowTitle(tr("Rosegarden"));
+    progressDialog.setWindowModality(Qt::WindowModal);
+    // One segment after another may each set progress to 100.
+    progressDialog.setAutoClose(false);
+    // See Bug #1546.
+    progressDialog.show();
+
+    AudioFileTranscriber transcriber(&doc->getAudioFileManager());
+    transcriber.setMethod(PitchDetector::getMethods()->at(method));
+    transcriber.setFrameSize(frameSize, stepSize);
+    transcriber.setProgressDialog(&progressDialog);
+
+    MacroCommand *command = new MacroCommand(tr("Transcribe Audio to MIDI"));
+
+    for (const std::pair<Segment *, TrackId> &target : targets) {
+        Segment *transcribed =
+                transcriber.transcribe(target.first, composition);
+
+        if (progressDialog.wasCanceled()) {
+            delete transcribed;
+            delete command;
+            return;
+        }
+
+        if (transcribed) {
+            command->addCommand(new SegmentInsertCommand(
+                    &composition, transcribed, target.second));
+        }
+    }
+
+    if (command->hasCommands())
+        m_view->slotAddCommandToHistory(command);
+    else
+        delete command;
+}
+
 void
 RosegardenMainWindow::slotJogLeft()
 {
@@ -4775,6 +4891,17 @@ void RosegardenMainWindow::processRecordedEvents()
         RosegardenDocument::currentDocument->insertRecordedMidi(mC);
     }
 
+    // Warn once per recording if the sequencer had to drop events.
+    const unsigned overflowCount =
+            SequencerDataBlock::getInstance()->getRecordOverflowCount();
+    if (overflowCount > 0  &&  m_recordOverflowCount == 0) {
+        slotDisplayWarning(
+                WarningWidget::Midi,
+                tr("<h3>Recorded MIDI events lost</h3>"),
+                tr("<p>Rosegarden could not keep up with the incoming MIDI events, and some of them were not recorded.</p>"));
+    }
+    m_recordOverflowCount = overflowCount;
+
     RosegardenDocument::currentDocument->updateRecordingMIDISegment();
     RosegardenDocument::currentDocument->updateRecordingAudioSegments();
 }
@@ -6422,6 +6549,8 @@ RosegardenMainWindow::updateActions()
     findAction("rescale")->setEnabled(m_notPlaying  &&  m_haveSelection);
     findAction("auto_split")->setEnabled(
             (enableEditingDuringPlayback || m_notPlaying)  &&  m_haveSelection);
+    findAction("transcribe_audio")->setEnabled(
+            m_notPlaying  &&  m_haveSelection);
     findAction("split_by_pitch")->setEnabled(
             (enableEditingDuringPlayback || m_notPlaying)  &&  m_haveSelection);
     findAction("split_by_recording")->setEnabled(
@@ -686,6 +686,11 @@ public slots:
      */
     void slotAutoSplitSelection();
 
+    /**
+     * Transcribe the selected audio segments into MIDI segments
+     */
+    void slotTranscribeSelection();
+
     /**
      * Jog a selection left or right by an amount
      */
@@ -1562,6 +1567,8 @@ private:
     QTimer *m_cpuMeterTimer;
 
     void processRecordedEvents();
+    /// SequencerDataBlock::getRecordOverflowCount() as last seen.
+    unsigned m_recordOverflowCount{0};
 
     void muteAllTracks(bool mute = true);
 
@@ -0,0 +1,139 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+// rosegarden-convert: converts Rosegarden files without the GUI.
+//
+//   rosegarden-convert --convert source.rg dest.mid
+//   rosegarden-convert [-j jobs] -f mid -o outdir source.rg...
+//
+// The first form converts one file.  The second converts many files,
+// jobs at a time, each in its own process.  See BatchConverter.
+
+#include "document/io/BatchConverter.h"
+
+#include "rosegarden-version.h"
+
+#include "sound/audiostream/WavFileReadStream.h"
+#include "sound/audiostream/WavFileWriteStream.h"
+#include "sound/audiostream/OggVorbisReadStream.h"
+#include "sound/audiostream/SimpleWavFileWriteStream.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QStringList>
+#include <QThread>
+
+#include <iostream>
+
+using namespace Rosegarden;
+
+static void usage()
+{
+    std::cerr << "rosegarden-convert: Converts Rosegarden files without the GUI\n";
+    std::cerr << "Usage: rosegarden-convert --convert source.rg dest.{mid,ly,xml}\n";
+    std::cerr << "       rosegarden-convert [-j jobs] -f {mid,ly,xml} -o outdir source.rg...\n";
+    std::cerr << "       rosegarden-convert --version\n";
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    // There is nothing to show, so don't insist on a display.
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    // See main.cpp.
+#ifdef HAVE_LIBSNDFILE
+    WavFileReadStream::initStaticObjects();
+    WavFileWriteStream::initStaticObjects();
+#endif
+
+#ifdef HAVE_OGGZ
+#ifdef HAVE_FISHSOUND
+    OggVorbisReadStream::initStaticObjects();
+#endif
+#endif
+
+#ifndef HAVE_LIBSNDFILE
+    SimpleWavFileWriteStream::initStaticObjects();
+#endif
+
+    // The documents and the exporters need widgets and fonts.
+    QApplication app(argc, argv);
+
+    // Use the same settings as the GUI, for the export options.
+    app.setOrganizationName("rosegardenmusic");
+    app.setOrganizationDomain("rosegardenmusic.com");
+    app.setApplicationName("Rosegarden");
+
+    const QStringList args = app.arguments();
+
+    if (args.size() == 2  &&  args[1] == "--version") {
+        std::cout << "Rosegarden version: " << VERSION << " (\"" << CODENAME << "\")" << std::endl;
+        return 0;
+    }
+
+    // Convert one file.
+    if (args.size() >= 2  &&  args[1] == "--convert") {
+        if (args.size() != 4)
+            usage();
+
+        QString error;
+        if (!BatchConverter::convert(args[2], args[3], error)) {
+            std::cerr << qPrintable(error) << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Convert many.
+    int jobs = QThread::idealThreadCount();
+    QString extension;
+    QString outDir;
+    QStringList inFiles;
+
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "-j"  &&  i + 1 < args.size()) {
+            bool ok = false;
+            jobs = args[++i].toInt(&ok);
+            if (!ok  ||  jobs < 1)
+                usage();
+        } else if (args[i] == "-f"  &&  i + 1 < args.size()) {
+            extension = args[++i];
+        } else if (args[i] == "-o"  &&  i + 1 < args.size()) {
+            outDir = args[++i];
+        } else if (args[i].startsWith("-")) {
+            usage();
+        } else {
+            inFiles << args[i];
+        }
+    }
+
+    if (inFiles.isEmpty()  ||  outDir.isEmpty()  ||
+        !BatchConverter::canWrite(extension))
+        usage();
+
+    if (!QDir().mkpath(outDir)) {
+        std::cerr << "Can't create output directory: " << qPrintable(outDir) << std::endl;
+        return 1;
+    }
+
+    const int failed = BatchConverter::convertAll(
+            QCoreApplication::applicationFilePath(),
+            inFiles, outDir, extension, jobs);
+
+    return failed ? 1 : 0;
+}
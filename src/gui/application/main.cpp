@@ -19,6 +19,7 @@
 #include "misc/Debug.h"
 #include "gui/application/RosegardenMainWindow.h"
 #include "document/RosegardenDocument.h"
+#include "document/io/BatchConverter.h"
 #include "gui/widgets/StartupLogo.h"
 #include "gui/general/ResourceFinder.h"
 #include "gui/general/IconLoader.h"
@@ -27,7 +28,6 @@
 #include "base/RealTime.h"
 #include "misc/Preferences.h"
 
-#include "sound/MidiFile.h"
 #include "sound/audiostream/WavFileReadStream.h"
 #include "sound/audiostream/WavFileWriteStream.h"
 #include "sound/audiostream/OggVorbisReadStream.h"
@@ -338,44 +338,24 @@ static void usage()
 {
     std::cerr << "Rosegarden: A sequencer and musical notation editor\n";
     std::cerr << "Usage: rosegarden [--nosplash] [--nosound] [file.rg]\n";
-    std::cerr << "       rosegarden --convert source.rg dest.mid\n";
+    std::cerr << "       rosegarden --convert source.rg dest.{mid,ly,xml}\n";
     std::cerr << "       rosegarden --version\n";
     exit(2);
 }
 
 static void convert(const QStringList &args)
 {
+    if (args.size() < 4)
+        usage();
+
     QString inFile  = args[2];
     QString outFile = args[3];
 
     std::cout << "Converting from \"" << inFile << "\" to \"" << outFile << "\"\n";
 
-    RosegardenDocument doc(
-            nullptr,  // parent
-            {},  // audioPluginManager
-            true,  // skipAutoload
-            true,  // clearCommandHistory
-            false);  // m_useSequencer
-
-    // cppcheck-suppress danglingLifetime
-    RosegardenDocument::currentDocument = &doc;
-
-    bool ok;
-
-    ok = doc.openDocument(
-            inFile,
-            false,  // permanent
-            true,  // squelchProgressDialog
-            false);  // enableLock
-    if (!ok) {
-        std::cerr << "Error opening rg file: " << inFile << "\n";
-        exit(1);
-    }
-
-    MidiFile midiFile;
-    ok = midiFile.convertToMidi(&doc, outFile);
-    if (!ok) {
-        std::cerr << "Error writing MIDI file: " << outFile << "\n";
+    QString error;
+    if (!BatchConverter::convert(inFile, outFile, error)) {
+        std::cerr << error << "\n";
         exit(1);
     }
 
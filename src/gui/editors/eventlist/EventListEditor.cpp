@@ -19,20 +19,14 @@
 
 #include "EventListEditor.h"
 
+#include "EventListModel.h"
 #include "TrivialVelocityDialog.h"
 
 #include "base/BaseProperties.h"
 #include "base/Clipboard.h"
 #include "base/Composition.h"
 #include "base/Event.h"
-#include "base/MidiTypes.h"
-#include "base/NotationTypes.h"
-#include "base/Pitch.h"
-#include "base/RealTime.h"
 #include "base/Segment.h"
-#include "base/SegmentPerformanceHelper.h"
-#include "base/figuration/GeneratedRegion.h"
-#include "base/figuration/SegmentID.h"
 #include "commands/edit/CopyCommand.h"
 #include "commands/edit/CutCommand.h"
 #include "commands/edit/EraseCommand.h"
@@ -72,12 +66,13 @@
 #include <QPushButton>
 #include <QSettings>
 #include <QStatusBar>
-#include <QTableWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <QDesktopServices>
 
+#include <algorithm>
+
 
 namespace Rosegarden
 {
@@ -149,10 +144,6 @@ namespace
             "timemode",
             int(Composition::TimeMode::MusicalTime));
 
-    constexpr int KeyRole = Qt::UserRole;
-    constexpr int SegmentPtrRole = Qt::UserRole + 1;
-    constexpr int EventPtrRole = Qt::UserRole + 2;
-
 }
 
 
@@ -275,6 +266,7 @@ EventListEditor::EventListEditor(const std::vector<Segment *> &segments) :
             this, &EventListEditor::slotAllOnOffClicked);
     filterGroupLayout->addWidget(allOnOff);
 
+    // Same order as EventListModel::Category.
     m_showStates = {
         &m_showNote, &m_showRest, &m_showProgramChange, &m_showController,
         &m_showPitchBend, &m_showChannelPressure, &m_showKeyPressure,
@@ -284,31 +276,38 @@ EventListEditor::EventListEditor(const std::vector<Segment *> &segments) :
     mainLayout->addWidget(m_filterGroup, 0, 0, Qt::AlignHCenter);
     mainLayout->setRowMinimumHeight(0, m_filterGroup->height());
 
-    // Table Widget
+    // Event table
+
+    // The model formats only the rows that are visible and follows the
+    // Segment through SegmentObserver.
+    m_model = new EventListModel(segments[0], this);
 
-    m_tableWidget = new QTableWidget(mainWidget);
-    m_tableWidget->setShowGrid(false);
+    m_tableView = new QTableView(mainWidget);
+    m_tableView->setModel(m_model);
+    m_tableView->setShowGrid(false);
     // Hide the vertical header
-    m_tableWidget->verticalHeader()->hide();
-    // Set the row size.  Note that this requires a call to
-    // QTableWidget::setRowHeight(row, whatever) for every row.
-    m_tableWidget->verticalHeader()->setMaximumSectionSize(20);
+    m_tableView->verticalHeader()->hide();
+    // Fixed row height.  Otherwise the view measures every row, which
+    // is very slow with large Segments.
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_tableView->verticalHeader()->setDefaultSectionSize(20);
 
     // Disable double-click editing of each field.
-    m_tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
     // Double-click handler.  This brings up our editor.
-    connect(m_tableWidget, &QTableWidget::cellDoubleClicked,
+    connect(m_tableView, &QAbstractItemView::doubleClicked,
             this, &EventListEditor::slotCellDoubleClicked);
-    connect(m_tableWidget, &QTableWidget::itemSelectionChanged,
+    connect(m_tableView->selectionModel(),
+                &QItemSelectionModel::selectionChanged,
             this, &EventListEditor::slotItemSelectionChanged);
 
-    m_tableWidget->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(m_tableWidget, &QWidget::customContextMenuRequested,
+    m_tableView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_tableView, &QWidget::customContextMenuRequested,
             this, &EventListEditor::slotContextMenu);
 
-    m_tableWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
-    m_tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_tableView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
 
     QStringList columnNames;
     // ??? The extra space at the end of each of these is probably an
@@ -322,16 +321,15 @@ EventListEditor::EventListEditor(const std::vector<Segment *> &segments) :
     columnNames << tr("Velocity  ");
     columnNames << tr("Data1");
     columnNames << tr("Data2");
-    m_tableWidget->setColumnCount(columnNames.size());
-    m_tableWidget->setHorizontalHeaderLabels(columnNames);
+    m_model->setHeaderLabels(columnNames);
 
     // Make sure time columns have the right amount of space.
     constexpr int timeWidth = 110;
-    m_tableWidget->setColumnWidth(0, timeWidth);
-    m_tableWidget->setColumnWidth(1, timeWidth);
-    m_tableWidget->setMinimumWidth(700);
+    m_tableView->setColumnWidth(0, timeWidth);
+    m_tableView->setColumnWidth(1, timeWidth);
+    m_tableView->setMinimumWidth(700);
 
-    mainLayout->addWidget(m_tableWidget, 0, 1, 3, 1);
+    mainLayout->addWidget(m_tableView, 0, 1, 3, 1);
 
     // Trigger Segment Group Box
 
@@ -433,14 +431,16 @@ EventListEditor::EventListEditor(const std::vector<Segment *> &segments) :
 
     // Make sure the last column fills the widget.
     // Note: Must do this AFTER loadOptions() or else it will not work.
-    m_tableWidget->horizontalHeader()->setStretchLastSection(true);
+    m_tableView->horizontalHeader()->setStretchLastSection(true);
 
     updateFilterCheckBoxes();
-    updateTableWidget();
+    updateModelFilter();
+    m_model->setTimeMode(
+            static_cast<Composition::TimeMode>(a_timeModeSetting.get()));
 
     makeInitialSelection(CompositionPosition::getInstance()->get());
 
-    m_tableWidget->setFocus();
+    m_tableView->setFocus();
 }
 
 EventListEditor::~EventListEditor()
@@ -448,475 +448,77 @@ EventListEditor::~EventListEditor()
     saveOptions();
 }
 
-bool
-EventListEditor::updateTableWidget()
+void
+EventListEditor::updateModelFilter()
 {
-    // ??? Performance.
-    //     This routine performs a complete clear and repopulate of the table.
-    //     That's really slow with large numbers of events.  Consider using
-    //     SegmentObserver to only make the changes that are needed.
-
-    // ??? This has scrolling issues.  It seems to not maintain at least the
-    //     time position when filtering is changed.  Also when time mode is
-    //     changed it jumps when there is a selection.  There are no
-    //     scrollToItem() calls, so it isn't
-    //     that.  It's odd since other lists seem to maintain scroll position
-    //     just fine, especially when nothing really changes (time mode).
-
-    // Store the selection.
-
-    std::set<QString /*key*/> selection;
-
-    // For each row...
-    for (int row = 0; row < m_tableWidget->rowCount(); ++row) {
-        const QTableWidgetItem *item = m_tableWidget->item(row, 0);
-        if (!item)
-            continue;
-        // If this item is selected, add its key to the list.
-        if (item->isSelected())
-            selection.insert(item->data(KeyRole).toString());
+    // m_showStates is in EventListModel::Category order.
+    std::vector<bool> show;
+    for (const bool *state : m_showStates) {
+        show.push_back(*state);
     }
 
-    // Store "current" item.
-
-    bool haveCurrentItem;
-    QString currentItemKey;
-    int currentItemColumn;
+    m_model->setFilter(show);
+}
 
-    // Scope to avoid accidentally reusing currentItem after it is gone.
-    {
-        // The "current item" has the focus outline which is only
-        // visible if it happens to be selected.
-        QTableWidgetItem *currentItem = m_tableWidget->currentItem();
-        haveCurrentItem = currentItem;
-        if (haveCurrentItem) {
-            const int row = m_tableWidget->row(currentItem);
-            currentItemColumn = m_tableWidget->column(currentItem);
+std::vector<Event *>
+EventListEditor::getSelectedEvents() const
+{
+    QModelIndexList rows = m_tableView->selectionModel()->selectedRows();
+    // selectedRows() is in the order the user selected them.
+    std::sort(rows.begin(), rows.end());
 
-            // We need the column 0 item since it is the only one with data.
-            QTableWidgetItem *item0 = m_tableWidget->item(row, 0);
+    std::vector<Event *> events;
+    events.reserve(rows.size());
 
-            currentItemKey = item0->data(KeyRole).toString();
-        }
+    for (const QModelIndex &index : rows) {
+        Event *event = m_model->getEvent(index);
+        if (event)
+            events.push_back(event);
     }
 
+    return events;
+}
 
-    // *** Create the event list.
-
-    // Clear the list completely.
-    m_tableWidget->setRowCount(0);
-
-    SegmentPerformanceHelper helper(*m_segments[0]);
-
-    const Composition::TimeMode timeMode =
-            static_cast<Composition::TimeMode>(a_timeModeSetting.get());
-
-    // For each Event in the Segment...
-    for (Segment::iterator eventIter = m_segments[0]->begin();
-         m_segments[0]->isBeforeEndMarker(eventIter);
-         ++eventIter) {
-        Event *event = *eventIter;
-
-        // Event filters
-
-        if (event->isa(Note::EventType)) {
-            if (!m_showNote)
-                continue;
-
-        } else if (event->isa(Note::EventRestType)) {
-            if (!m_showRest)
-                continue;
-
-        } else if (event->isa(ProgramChange::EventType)) {
-            if (!m_showProgramChange)
-                continue;
-
-        } else if (event->isa(Controller::EventType)) {
-            if (!m_showController)
-                continue;
-
-        } else if (event->isa(PitchBend::EventType)) {
-            if (!m_showPitchBend)
-                continue;
-
-        } else if (event->isa(ChannelPressure::EventType)) {
-            if (!m_showChannelPressure)
-                continue;
-
-        } else if (event->isa(KeyPressure::EventType)) {
-            if (!m_showKeyPressure)
-                continue;
-
-        } else if (event->isa(RPN::EventType)  ||
-                   event->isa(NRPN::EventType)) {
-            if (!m_showRPNNRPN)
-                continue;
-
-        } else if (event->isa(SystemExclusive::EventType)) {
-            if (!m_showSystemExclusive)
-                continue;
-
-        } else if (event->isa(Indication::EventType)) {
-            if (!m_showIndication)
-                continue;
-
-        } else if (event->isa(Text::EventType)) {
-            if (!m_showText)
-                continue;
-
-        } else if (event->isa(GeneratedRegion::EventType)) {
-            if (!m_showGeneratedRegion)
-                continue;
-
-        } else if (event->isa(SegmentID::EventType)) {
-            if (!m_showSegmentID)
-                continue;
-
-        } else {
-            if (!m_showOther)
-                continue;
-        }
-
-        // Format each column.
-
-        // Time
-
-        Composition &comp = RosegardenDocument::currentDocument->getComposition();
-
-        const timeT eventTime = helper.getSoundingAbsoluteTime(eventIter);
-
-        const QString timeStr = comp.makeTimeString(eventTime, timeMode);
-
-        // Duration
-
-        QString durationStr;
-        QString musicalDuration;
-
-        if (event->getDuration() > 0  ||
-            event->isa(Note::EventType)  ||
-            event->isa(Note::EventRestType)) {
-            durationStr = comp.makeDurationString(
-                    eventTime,
-                    event->getDuration(),
-                    timeMode);
-            // For the key.
-            musicalDuration = comp.makeDurationString(
-                    eventTime,
-                    event->getDuration(),
-                    Composition::TimeMode::MusicalTime);
-        }
-
-        // Pitch
-
-        QString pitchStr;
-
-        if (event->has(BaseProperties::PITCH)) {
-            const int pitch = event->get<Int>(BaseProperties::PITCH);
-            pitchStr = QString("%1 %2  ")
-                       .arg(pitch).arg(Pitch::toStringOctave(pitch));
-        } else if (event->isa(Note::EventType)) {
-            pitchStr = tr("<not set>");
-        }
-
-        // Velocity
-
-        QString velocityStr;
-
-        if (event->has(BaseProperties::VELOCITY)) {
-            velocityStr = QString("%1  ").
-                      arg(event->get<Int>(BaseProperties::VELOCITY));
-        } else if (event->isa(Note::EventType)) {
-            velocityStr = tr("<not set>");
-        }
-
-        // Data 1
-
-        QString data1Str;
-
-        if (event->getType() == Controller::EventType  &&
-            event->has(Controller::NUMBER)) {
-            int number = event->get<Int>(Controller::NUMBER);
-            data1Str = QString("%1  %2").
-                    arg(number).arg(Controller::getName(number));
-        } else if (event->has(Controller::NUMBER)) {
-            // This handles RPN and NRPN.  We should probably be more
-            // specific here.
-            data1Str = QString("%1").
-                       arg(event->get<Int>(Controller::NUMBER));
-        } else if (event->has(Text::TextTypePropertyName)) {
-            data1Str = QString("%1").
-                       arg(strtoqstr(event->get<String>(
-                               Text::TextTypePropertyName)));
-        } else if (event->has(Indication::IndicationTypePropertyName)) {
-            data1Str = QString("%1").
-                       arg(strtoqstr(event->get<String>(
-                               Indication::IndicationTypePropertyName)));
-        } else if (event->has(Key::KeyPropertyName)) {
-            data1Str = QString("%1").
-                       arg(strtoqstr(event->get<String>(
-                               Key::KeyPropertyName)));
-        } else if (event->has(Clef::ClefPropertyName)) {
-            data1Str = QString("%1").
-                       arg(strtoqstr(event->get<String>(
-                               Clef::ClefPropertyName)));
-        } else if (event->has(PitchBend::MSB)) {
-            const int msb = event->get<Int>(PitchBend::MSB);
-            int lsb{0};
-            if (event->has(PitchBend::LSB))
-                lsb = event->get<Int>(PitchBend::LSB);
-            const int value = (msb << 7) + lsb;
-            data1Str = QString("%1").arg(value);
-        } else if (event->has(BaseProperties::BEAMED_GROUP_TYPE)) {
-            data1Str = QString("%1").
-                       arg(strtoqstr(event->get<String>(
-                               BaseProperties::BEAMED_GROUP_TYPE)));
-        } else if (event->has(GeneratedRegion::FigurationPropertyName)) {
-            data1Str = QString("%1").
-                       arg(event->get<Int>(
-                               GeneratedRegion::FigurationPropertyName));
-        } else if (event->has(SegmentID::IDPropertyName)) {
-            data1Str = QString("%1").
-                       arg(event->get<Int>(SegmentID::IDPropertyName));
-        }
-
-        if (event->has(ProgramChange::PROGRAM)) {
-            data1Str = QString("%1").
-                       arg(event->get<Int>(ProgramChange::PROGRAM) + 1);
-        }
-
-        if (event->getType() == ChannelPressure::EventType  &&
-            event->has(ChannelPressure::PRESSURE)) {
-            data1Str = QString("%1").
-                       arg(event->get<Int>(ChannelPressure::PRESSURE));
-        }
-        if (event->getType() == KeyPressure::EventType  &&
-            event->has(KeyPressure::PRESSURE)) {
-            data1Str = QString("%1").
-                       arg(event->get<Int>(KeyPressure::PRESSURE));
-        }
-
-
-        // Data 2
-
-        QString data2Str;
-
-        if (event->has(Controller::VALUE)) {
-            data2Str = QString("%1  ").
-                       arg(event->get<Int>(Controller::VALUE));
-        } else if (event->has(Text::TextPropertyName)) {
-            data2Str = QString("%1  ").
-                       arg(strtoqstr(event->get<String>(
-                               Text::TextPropertyName)));
-#if 0
-        } else if (event->has(Indication::IndicationTypePropertyName)) {
-            data2Str = QString("%1  ").
-                       arg(event->get<Int>(
-                               Indication::IndicationDurationPropertyName));
-#endif
-        } else if (event->has(BaseProperties::BEAMED_GROUP_ID)) {
-            data2Str = tr("(group %1)  ").
-                       arg(event->get<Int>(BaseProperties::BEAMED_GROUP_ID));
-        } else if (event->has(GeneratedRegion::ChordPropertyName)) {
-            data2Str = QString("%1  ").
-                       arg(event->get<Int>(GeneratedRegion::ChordPropertyName));
-        } else if (event->has(SegmentID::SubtypePropertyName)) {
-            data2Str = QString("%1  ").
-                       arg(strtoqstr(event->get<String>(
-                               SegmentID::SubtypePropertyName)));
-        }
-
-        if (event->has(BaseProperties::TRIGGER_SEGMENT_ID))
-            data2Str = "TRIGGER";
-
-        QStringList values;
-        values << timeStr <<
-                  durationStr <<
-                  strtoqstr(event->getType()) <<
-                  pitchStr <<
-                  velocityStr <<
-                  data1Str <<
-                  data2Str;
-
-        // Add a row to the table
-        const int row = m_tableWidget->rowCount();
-        m_tableWidget->insertRow(row);
-        // In order for setMaximumSectionSize() to work, setRowHeight() must
-        // be called.  The height here is irrelevant.  1 works.  50 works.
-        // Going with 20 to match the setMaximumSectionSize() call.
-        m_tableWidget->setRowHeight(row, 20);
-
-        int col1{0};
-
-        // Time
-        QTableWidgetItem *timeItem = new QTableWidgetItem(timeStr);
-        timeItem->setData(SegmentPtrRole, QVariant::fromValue((void *)(m_segments[0])));
-        timeItem->setData(EventPtrRole, QVariant::fromValue((void *)event));
-        m_tableWidget->setItem(row, col1++, timeItem);
-
-        // Duration
-        QTableWidgetItem *item1 = new QTableWidgetItem(durationStr);
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Type
-        item1 = new QTableWidgetItem(strtoqstr(event->getType()));
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Pitch
-        item1 = new QTableWidgetItem(pitchStr);
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Velocity
-        item1 = new QTableWidgetItem(velocityStr);
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Type (Data1)
-        item1 = new QTableWidgetItem(data1Str);
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Value (Data2)
-        item1 = new QTableWidgetItem(data2Str);
-        m_tableWidget->setItem(row, col1++, item1);
-
-        // Assemble a key so we can uniquely identify each row for selection
-        // persistence across updates.
-        // ??? Why not just use the Event pointer address?  It's dangerous,
-        //     but it should work well enough.  And it will be faster than a
-        //     string comparison.  It will also avoid needing to keep
-        //     musicalTime and musicalDuration.
-        // Always use musical time in case the time mode changes.
-        const QString musicalTime = comp.makeTimeString(
-                                eventTime,
-                                Composition::TimeMode::MusicalTime);
-        const QString key = musicalTime + musicalDuration +
-                strtoqstr(event->getType()) + pitchStr + velocityStr +
-                data1Str + data2Str;
-        timeItem->setData(KeyRole, key);
-
-        // Set current if it is the right one.
-        if (haveCurrentItem  &&  key == currentItemKey) {
-            item1 = m_tableWidget->item(row, currentItemColumn);
-            if (item1)
-                m_tableWidget->setCurrentItem(item1, QItemSelectionModel::NoUpdate);
-        }
-
-        // Restore selection.
-        if (selection.find(key) != selection.end()) {
-            // Select the entire row.
-            // For each column...
-            for (int col2 = 0; col2 < m_tableWidget->columnCount(); ++col2) {
-                QTableWidgetItem *item2 = m_tableWidget->item(row, col2);
-                if (!item2)
-                    continue;
-                item2->setSelected(true);
-            }
-        }
-    }
-
-    return true;
+Event *
+EventListEditor::getCurrentEvent() const
+{
+    return m_model->getEvent(m_tableView->currentIndex());
 }
 
 void
 EventListEditor::makeInitialSelection(timeT time)
 {
-    const int itemCount = m_tableWidget->rowCount();
-
-    QTableWidgetItem *foundItem{nullptr};
-
-    // For each row in the event list.
-    for (int row = 0; row < itemCount; ++row) {
-        QTableWidgetItem *item = m_tableWidget->item(row, 0);
-        if (!item)
-            continue;
-
-        const Event *event = static_cast<const Event *>(
-                item->data(EventPtrRole).value<void *>());
-        if (!event)
-            continue;
-
-        // If this item is past the playback position pointer, we are
-        // finished searching.
-        if (event->getAbsoluteTime() > time)
-            break;
-
-        // Remember the last good item.
-        foundItem = item;
-    }
-
-    // Nothing found?  Bail.
-    if (!foundItem)
-        return;
-
-    // Make it current so the keyboard works correctly.
-    m_tableWidget->setCurrentItem(foundItem);
-
-    const int foundRow = foundItem->row();
-
-    // Select the entire row or else pressing "E" to edit will not work.
-    for (int col = 0; col < m_tableWidget->columnCount(); ++col) {
-        QTableWidgetItem *item = m_tableWidget->item(foundRow, col);
-        if (!item)
-            continue;
-        // Select it.
-        item->setSelected(true);
-    }
-
-    // Yield to the event loop so that the UI will be rendered before calling
-    // scrollToItem().
-    qApp->processEvents();
-
-    // Make sure the item is visible.
-    m_tableWidget->scrollToItem(foundItem, QAbstractItemView::PositionAtCenter);
+    // Select the last Event at or before the playback position pointer.
+    selectRow(m_model->findRowAtTime(time));
 }
 
 void
 EventListEditor::selectEvent(const Event &i_event)
 {
-    const int itemCount = m_tableWidget->rowCount();
-
-    QTableWidgetItem *foundItem{nullptr};
-
-    // For each row in the event list.
-    for (int row = 0; row < itemCount; ++row) {
-        QTableWidgetItem *item = m_tableWidget->item(row, 0);
-        if (!item)
-            continue;
-
-        const Event *tableEvent = static_cast<const Event *>(
-                item->data(EventPtrRole).value<void *>());
-        if (!tableEvent)
-            continue;
-
-        // Found it?
-        if (*tableEvent == i_event) {
-            foundItem = item;
-            break;
-        }
-    }
+    selectRow(m_model->findRow(i_event));
+}
 
+void
+EventListEditor::selectRow(int row)
+{
     // Nothing found?  Bail.
-    if (!foundItem)
+    if (row < 0)
         return;
 
-    // Make it current so the keyboard works correctly.
-    m_tableWidget->setCurrentItem(foundItem);
+    const QModelIndex index = m_model->index(row, 0);
 
-    const int foundRow = foundItem->row();
-
-    // Select the entire row or else pressing "E" to edit will not work.
-    for (int col = 0; col < m_tableWidget->columnCount(); ++col) {
-        QTableWidgetItem *item = m_tableWidget->item(foundRow, col);
-        if (!item)
-            continue;
-        // Select it.
-        item->setSelected(true);
-    }
+    // Make it current so the keyboard works correctly.  Select the
+    // entire row or else pressing "E" to edit will not work.
+    m_tableView->selectionModel()->setCurrentIndex(
+            index,
+            QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 
     // Yield to the event loop so that the UI will be rendered before calling
-    // scrollToItem().
+    // scrollTo().
     qApp->processEvents();
 
     // Make sure the item is visible.
-    m_tableWidget->scrollToItem(foundItem, QAbstractItemView::PositionAtCenter);
+    m_tableView->scrollTo(index, QAbstractItemView::PositionAtCenter);
 }
 
 void
@@ -1052,34 +654,20 @@ EventListEditor::slotTriggerRetuneChanged()
 void
 EventListEditor::slotEditCut()
 {
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
+    const std::vector<Event *> selection = getSelectedEvents();
 
     if (selection.empty())
         return;
 
-    RG_DEBUG << "slotEditCut() - cutting " << selection.count() << " items";
+    RG_DEBUG << "slotEditCut() - cutting " << selection.size() << " items";
 
     EventSelection cutSelection(*m_segments[0]);
 
-    // For each item in the selection...
-    for (QTableWidgetItem *listItem : selection) {
-        if (!listItem)
-            continue;
-        // Only interested in column 0.
-        if (listItem->column() != 0)
-            continue;
-
-        Event *event = static_cast<Event *>(
-                listItem->data(EventPtrRole).value<void *>());
-        if (!event)
-            continue;
-
+    // For each Event in the selection...
+    for (Event *event : selection) {
         cutSelection.addEvent(event);
     }
 
-    if (cutSelection.empty())
-        return;
-
     CommandHistory::getInstance()->addCommand(
             new CutCommand(&cutSelection, Clipboard::mainClipboard()));
 }
@@ -1087,34 +675,20 @@ EventListEditor::slotEditCut()
 void
 EventListEditor::slotEditCopy()
 {
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
+    const std::vector<Event *> selection = getSelectedEvents();
 
     if (selection.empty())
         return;
 
-    RG_DEBUG << "slotEditCopy() - copying " << selection.count() << " items";
+    RG_DEBUG << "slotEditCopy() - copying " << selection.size() << " items";
 
     EventSelection copySelection(*m_segments[0]);
 
-    // For each item in the selection...
-    for (QTableWidgetItem *listItem : selection) {
-        if (!listItem)
-            continue;
-        // Only interested in column 0.
-        if (listItem->column() != 0)
-            continue;
-
-        Event *event = static_cast<Event *>(
-                listItem->data(EventPtrRole).value<void *>());
-        if (!event)
-            continue;
-
+    // For each Event in the selection...
+    for (Event *event : selection) {
         copySelection.addEvent(event);
     }
 
-    if (copySelection.empty())
-        return;
-
     CommandHistory::getInstance()->addCommand(
             new CopyCommand(&copySelection, Clipboard::mainClipboard()));
 }
@@ -1133,19 +707,11 @@ EventListEditor::slotEditPaste()
 
     timeT insertionTime = 0;
 
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
-
-    if (!selection.empty()) {
-        // Go with the time of the first selected item.
-        QTableWidgetItem *item = selection.at(0);
-        if (item) {
-            const Event *event = static_cast<const Event *>(
-                    item->data(EventPtrRole).value<void *>());
+    const std::vector<Event *> selection = getSelectedEvents();
 
-            if (event)
-                insertionTime = event->getAbsoluteTime();
-        }
-    }
+    // Go with the time of the first selected item.
+    if (!selection.empty())
+        insertionTime = selection.front()->getAbsoluteTime();
 
     PasteEventsCommand *command = new PasteEventsCommand(
             *m_segments[0],  // segment
@@ -1162,7 +728,7 @@ EventListEditor::slotEditPaste()
 
     CommandHistory::getInstance()->addCommand(command);
 
-    RG_DEBUG << "slotEditPaste() - pasting " << selection.count() << " items";
+    RG_DEBUG << "slotEditPaste() - pasting at " << insertionTime;
 }
 
 void
@@ -1179,19 +745,11 @@ EventListEditor::slotEditPasteAt()
 
     timeT insertionTime = 0;
 
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
+    const std::vector<Event *> selection = getSelectedEvents();
 
-    if (!selection.empty()) {
-        // Go with the time of the first selected item.
-        QTableWidgetItem *item = selection.at(0);
-        if (item) {
-            const Event *event = static_cast<const Event *>(
-                    item->data(EventPtrRole).value<void *>());
-
-            if (event)
-                insertionTime = event->getAbsoluteTime();
-        }
-    }
+    // Go with the time of the first selected item.
+    if (!selection.empty())
+        insertionTime = selection.front()->getAbsoluteTime();
 
     // Get the time from the user.
     TimeDialog dialog(this, // parent
@@ -1222,33 +780,19 @@ EventListEditor::slotEditPasteAt()
 void
 EventListEditor::slotEditDelete()
 {
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
+    const std::vector<Event *> selection = getSelectedEvents();
     if (selection.empty())
         return;
 
-    RG_DEBUG << "slotEditDelete() - deleting " << selection.count() << " items";
+    RG_DEBUG << "slotEditDelete() - deleting " << selection.size() << " items";
 
     EventSelection deleteSelection(*m_segments[0]);
 
-    // For each item in the list...
-    for (QTableWidgetItem *listItem : selection) {
-        if (!listItem)
-            continue;
-        // Only interested in column 0.
-        if (listItem->column() != 0)
-            continue;
-
-        Event *event = static_cast<Event *>(
-                listItem->data(EventPtrRole).value<void *>());
-        if (!event)
-            continue;
-
+    // For each Event in the selection...
+    for (Event *event : selection) {
         deleteSelection.addEvent(event);
     }
 
-    if (deleteSelection.empty())
-        return;
-
     CommandHistory::getInstance()->addCommand(
             new EraseCommand(&deleteSelection));
 }
@@ -1268,19 +812,11 @@ EventListEditor::slotEditInsert()
 
     timeT time{0};
 
-    QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
+    const std::vector<Event *> selection = getSelectedEvents();
 
     // If something is selected...
-    if (!selection.empty()) {
-        // Get the first which should always be column 0.
-        QTableWidgetItem *item = selection.first();
-        if (item) {
-            const Event *selectedEvent = static_cast<const Event *>(
-                    item->data(EventPtrRole).value<void *>());
-            if (selectedEvent)
-                time = selectedEvent->getAbsoluteTime();
-        }
-    }
+    if (!selection.empty())
+        time = selection.front()->getAbsoluteTime();
 
     // Create the initial Event for editing.
     Event event(type, time);
@@ -1302,28 +838,14 @@ EventListEditor::slotEditInsert()
 }
 
 void
-EventListEditor::editItem(const QTableWidgetItem *item)
+EventListEditor::editEvent(Event *event)
 {
-    RG_DEBUG << "editItem" << item;
-    if (!item)
-        return;
-
-    // Get the Segment.  Have to do this before launching
-    // the dialog since item might become invalid.
-    Segment *segment = static_cast<Segment *>(
-            item->data(SegmentPtrRole).value<void *>());
-    RG_DEBUG << "editItem segment" << segment;
-    if (!segment)
-        return;
-
-    // Get the Event.  Have to do this before launching
-    // the dialog since item might become invalid.
-    Event *event = static_cast<Event *>(
-            item->data(EventPtrRole).value<void *>());
-    RG_DEBUG << "editItem event" << event;
+    RG_DEBUG << "editEvent" << event;
     if (!event)
         return;
 
+    Segment *segment = m_segments[0];
+
     EditEvent dialog(this, *event);
 
     // Launch dialog.  Bail if canceled.
@@ -1349,48 +871,23 @@ void
 EventListEditor::slotEditEvent()
 {
     RG_DEBUG << "slotEditEvent";
-    const QList<QTableWidgetItem *> selection = m_tableWidget->selectedItems();
-    if (selection.isEmpty())
-        return;
-
-    const QTableWidgetItem *item = selection.first();
-    RG_DEBUG << "slotEditEvent item" << item;
-    if (!item)
+    const std::vector<Event *> selection = getSelectedEvents();
+    if (selection.empty())
         return;
 
-    editItem(item);
+    editEvent(selection.front());
 }
 
 void
 EventListEditor::slotSelectAll()
 {
-    // For each row...
-    for (int row = 0; row < m_tableWidget->rowCount(); ++row) {
-        // For each column...
-        for (int col = 0; col < m_tableWidget->columnCount(); ++col) {
-            QTableWidgetItem *item = m_tableWidget->item(row, col);
-            if (!item)
-                continue;
-            // Select it.
-            item->setSelected(true);
-        }
-    }
+    m_tableView->selectAll();
 }
 
 void
 EventListEditor::slotClearSelection()
 {
-    // For each row...
-    for (int row = 0; row < m_tableWidget->rowCount(); ++row) {
-        // For each column...
-        for (int col = 0; col < m_tableWidget->columnCount(); ++col) {
-            QTableWidgetItem *item = m_tableWidget->item(row, col);
-            if (!item)
-                continue;
-            // Deselect it.
-            item->setSelected(false);
-        }
-    }
+    m_tableView->clearSelection();
 }
 
 void
@@ -1468,7 +965,7 @@ EventListEditor::loadOptions()
     settings.beginGroup(WindowGeometryConfigGroup);
     restoreGeometry(settings.value("Event_List_View_Geometry").toByteArray());
     restoreState(settings.value("Event_List_View_State").toByteArray());
-    m_tableWidget->horizontalHeader()->restoreState(
+    m_tableView->horizontalHeader()->restoreState(
             settings.value("Event_List_View_Header_State").toByteArray());
     settings.endGroup();
 }
@@ -1498,7 +995,7 @@ EventListEditor::saveOptions()
     settings.setValue("Event_List_View_Geometry", saveGeometry());
     settings.setValue("Event_List_View_State", saveState());
     settings.setValue("Event_List_View_Header_State",
-            m_tableWidget->horizontalHeader()->saveState());
+            m_tableView->horizontalHeader()->saveState());
 }
 
 Segment *
@@ -1529,7 +1026,7 @@ EventListEditor::slotFilterClicked(bool)
     m_showSegmentID = m_segmentIDCheckBox->isChecked();
     m_showOther = m_otherCheckBox->isChecked();
 
-    updateTableWidget();
+    updateModelFilter();
 }
 
 void
@@ -1559,7 +1056,7 @@ EventListEditor::slotAllOnOffClicked(bool)
     }
 
     updateFilterCheckBoxes();
-    updateTableWidget();
+    updateModelFilter();
 }
 
 void
@@ -1590,7 +1087,7 @@ EventListEditor::slotMusicalTime()
     findAction("time_real")->setChecked(false);
     findAction("time_raw")->setChecked(false);
 
-    updateTableWidget();
+    m_model->setTimeMode(Composition::TimeMode::MusicalTime);
 }
 
 void
@@ -1601,7 +1098,7 @@ EventListEditor::slotRealTime()
     findAction("time_real")->setChecked(true);
     findAction("time_raw")->setChecked(false);
 
-    updateTableWidget();
+    m_model->setTimeMode(Composition::TimeMode::RealTime);
 }
 
 void
@@ -1612,38 +1109,26 @@ EventListEditor::slotRawTime()
     findAction("time_real")->setChecked(false);
     findAction("time_raw")->setChecked(true);
 
-    updateTableWidget();
+    m_model->setTimeMode(Composition::TimeMode::RawTime);
 }
 
 void
-EventListEditor::slotCellDoubleClicked(int row, int /* column */)
+EventListEditor::slotCellDoubleClicked(const QModelIndex &index)
 {
-    QTableWidgetItem *item = m_tableWidget->item(row, 0);
-    if (!item) {
-        RG_WARNING << "slotItemDoubleClicked(): WARNING: No Item.";
+    Event *event = m_model->getEvent(index);
+    if (!event) {
+        RG_WARNING << "slotCellDoubleClicked(): WARNING: No Event.";
         return;
     }
 
-    editItem(item);
+    editEvent(event);
 }
 
 void
 EventListEditor::slotContextMenu(const QPoint &pos)
 {
-    // Use itemAt() which is more predictable than currentItem().
-    const QTableWidgetItem *item = m_tableWidget->itemAt(pos);
-    if (!item)
-        return;
-
-    // Not the 0 column?  Get it.
-    if (item->column() != 0) {
-        item = m_tableWidget->item(item->row(), 0);
-        if (!item)
-            return;
-    }
-
-    const Event *event = static_cast<const Event *>(
-            item->data(EventPtrRole).value<void *>());
+    // Use indexAt() which is more predictable than currentIndex().
+    const Event *event = m_model->getEvent(m_tableView->indexAt(pos));
     if (!event)
         return;
 
@@ -1673,42 +1158,19 @@ EventListEditor::slotContextMenu(const QPoint &pos)
     m_editTriggeredSegment->setEnabled(trigger);
 
     // Launch the context menu.
-    m_contextMenu->exec(m_tableWidget->mapToGlobal(pos));
+    m_contextMenu->exec(m_tableView->viewport()->mapToGlobal(pos));
 }
 
 void
 EventListEditor::slotOpenInEventEditor(bool /* checked */)
 {
-    QTableWidgetItem *item = m_tableWidget->currentItem();
-    if (!item)
-        return;
-
-    // Not the 0 column?  Get it.
-    if (item->column() != 0) {
-        item = m_tableWidget->item(item->row(), 0);
-        if (!item)
-            return;
-    }
-
-    editItem(item);
+    editEvent(getCurrentEvent());
 }
 
 void
 EventListEditor::slotEditTriggeredSegment(bool /*checked*/)
 {
-    QTableWidgetItem *item = m_tableWidget->currentItem();
-    if (!item)
-        return;
-
-    // Not the 0 column?  Get it.
-    if (item->column() != 0) {
-        item = m_tableWidget->item(item->row(), 0);
-        if (!item)
-            return;
-    }
-
-    const Event *event = static_cast<const Event *>(
-            item->data(EventPtrRole).value<void *>());
+    const Event *event = getCurrentEvent();
     if (!event)
         return;
 
@@ -1795,13 +1257,15 @@ EventListEditor::slotDocumentModified(bool modified)
 
     updateWindowTitle(modified);
 
-    updateTableWidget();
+    // Added and removed Events come in through the model's
+    // SegmentObserver.  This picks up changes made to Events in place.
+    m_model->refresh();
 }
 
 void
 EventListEditor::slotItemSelectionChanged()
 {
-    const bool haveSelection = !m_tableWidget->selectedItems().empty();
+    const bool haveSelection = m_tableView->selectionModel()->hasSelection();
 
     if (haveSelection)
         enterActionState("have_selection");
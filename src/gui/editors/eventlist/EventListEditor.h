@@ -30,8 +30,8 @@
 class QWidget;
 class QMenu;
 class QPoint;
-class QTableWidget;
-class QTableWidgetItem;
+class QTableView;
+class QModelIndex;
 class QLabel;
 class QCheckBox;
 class QGroupBox;
@@ -44,6 +44,7 @@ namespace Rosegarden
 
 
 class Event;
+class EventListModel;
 
 
 /// The Event List Editor
@@ -103,7 +104,7 @@ private slots:
     void slotAllOnOffClicked(bool);
 
     /// Handle double-click on an event in the event list.
-    void slotCellDoubleClicked(int row, int column);
+    void slotCellDoubleClicked(const QModelIndex &index);
     void slotItemSelectionChanged();
 
     /// Right-click context menu.
@@ -167,8 +168,14 @@ private:
     std::vector<bool *> m_showStates;
 
     // The Event table.
-    QTableWidget *m_tableWidget;
-    bool updateTableWidget();
+    QTableView *m_tableView;
+    EventListModel *m_model;
+    /// Copy the filter check box states to the model.
+    void updateModelFilter();
+    /// Selected Events in row order.
+    std::vector<Event *> getSelectedEvents() const;
+    /// Event in the current row.
+    Event *getCurrentEvent() const;
 
     /// Pop-up menu for the event table.
     QMenu *m_contextMenu{nullptr};
@@ -176,6 +183,8 @@ private:
 
     void makeInitialSelection(timeT);
     void selectEvent(const Event &event);
+    /// Make row current and selected, and scroll to it.
+    void selectRow(int row);
 
     bool m_isTriggerSegment{false};
     QLabel *m_triggerName{nullptr};
@@ -186,7 +195,7 @@ private:
     void loadOptions();
     void saveOptions();
 
-    void editItem(const QTableWidgetItem *item);
+    void editEvent(Event *event);
 
 };
 
@@ -0,0 +1,596 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_NO_DEBUG_PRINT
+
+#include "EventListModel.h"
+
+#include "base/BaseProperties.h"
+#include "base/Event.h"
+#include "base/MidiTypes.h"
+#include "base/NotationTypes.h"
+#include "base/Pitch.h"
+#include "base/SegmentPerformanceHelper.h"
+#include "base/figuration/GeneratedRegion.h"
+#include "base/figuration/SegmentID.h"
+#include "document/RosegardenDocument.h"
+#include "misc/Debug.h"
+#include "misc/Strings.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace Rosegarden
+{
+
+
+namespace
+{
+
+    enum Column {
+        TimeColumn,
+        DurationColumn,
+        TypeColumn,
+        PitchColumn,
+        VelocityColumn,
+        Data1Column,
+        Data2Column,
+        ColumnCount
+    };
+
+    // The strings predate the model, so keep the EventListEditor
+    // translation context.
+    QString translate(const char *text)
+    {
+        return QCoreApplication::translate("Rosegarden::EventListEditor", text);
+    }
+
+    struct TimeLess
+    {
+        bool operator()(const Event *event, timeT time) const
+                { return event->getAbsoluteTime() < time; }
+        bool operator()(timeT time, const Event *event) const
+                { return time < event->getAbsoluteTime(); }
+    };
+
+}
+
+
+EventListModel::EventListModel(Segment *segment, QObject *parent) :
+    QAbstractTableModel(parent),
+    m_segment(segment),
+    m_show(CategoryCount, true)
+{
+    if (m_segment) {
+        for (Segment::iterator i = m_segment->begin();
+             m_segment->isBeforeEndMarker(i);
+             ++i) {
+            m_events.push_back(*i);
+        }
+
+        m_segment->addObserver(this);
+    }
+}
+
+EventListModel::~EventListModel()
+{
+    if (m_segment)
+        m_segment->removeObserver(this);
+}
+
+EventListModel::Category
+EventListModel::getCategory(const Event *event)
+{
+    if (event->isa(Note::EventType))
+        return NoteCategory;
+    if (event->isa(Note::EventRestType))
+        return RestCategory;
+    if (event->isa(ProgramChange::EventType))
+        return ProgramChangeCategory;
+    if (event->isa(Controller::EventType))
+        return ControllerCategory;
+    if (event->isa(PitchBend::EventType))
+        return PitchBendCategory;
+    if (event->isa(ChannelPressure::EventType))
+        return ChannelPressureCategory;
+    if (event->isa(KeyPressure::EventType))
+        return KeyPressureCategory;
+    if (event->isa(RPN::EventType)  ||  event->isa(NRPN::EventType))
+        return RPNNRPNCategory;
+    if (event->isa(SystemExclusive::EventType))
+        return SystemExclusiveCategory;
+    if (event->isa(Indication::EventType))
+        return IndicationCategory;
+    if (event->isa(Text::EventType))
+        return TextCategory;
+    if (event->isa(GeneratedRegion::EventType))
+        return GeneratedRegionCategory;
+    if (event->isa(SegmentID::EventType))
+        return SegmentIDCategory;
+
+    return OtherCategory;
+}
+
+bool
+EventListModel::isShown(const Event *event) const
+{
+    if (!m_show[getCategory(event)])
+        return false;
+
+    // Same as Segment::isBeforeEndMarker().
+    const timeT time = event->getAbsoluteTime();
+    const timeT endTime = m_segment->getEndMarkerTime();
+    return (time < endTime  ||
+            (time == endTime  &&  event->getDuration() == 0));
+}
+
+void
+EventListModel::setFilter(const std::vector<bool> &show)
+{
+    if (show.size() != CategoryCount) {
+        RG_WARNING << "setFilter(): Wrong category count: " << show.size();
+        return;
+    }
+
+    if (show == m_show)
+        return;
+
+    m_show = show;
+    refilter();
+}
+
+void
+EventListModel::setTimeMode(Composition::TimeMode timeMode)
+{
+    if (timeMode == m_timeMode)
+        return;
+
+    m_timeMode = timeMode;
+
+    if (m_events.empty())
+        return;
+
+    emit dataChanged(index(0, TimeColumn),
+                     index(rowCount() - 1, DurationColumn));
+}
+
+void
+EventListModel::refresh()
+{
+    if (m_events.empty())
+        return;
+
+    emit dataChanged(index(0, 0),
+                     index(rowCount() - 1, ColumnCount - 1));
+}
+
+void
+EventListModel::refilter()
+{
+    // endBatch() will pick up the new filter.
+    if (m_rebuildPending)
+        return;
+
+    emit layoutAboutToBeChanged();
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+
+    // New row for each Event that has a persistent index.  This is
+    // usually just the selection and the current index.
+    std::unordered_map<const Event *, int> newRows;
+    for (const QModelIndex &oldIndex : oldIndexes) {
+        const Event *event = getEvent(oldIndex.row());
+        if (event)
+            newRows[event] = -1;
+    }
+
+    EventVector events;
+
+    if (m_segment) {
+        for (Segment::iterator i = m_segment->begin();
+             m_segment->isBeforeEndMarker(i);
+             ++i) {
+            if (!m_show[getCategory(*i)])
+                continue;
+
+            if (!newRows.empty()) {
+                std::unordered_map<const Event *, int>::iterator found =
+                        newRows.find(*i);
+                if (found != newRows.end())
+                    found->second = int(events.size());
+            }
+
+            events.push_back(*i);
+        }
+    }
+
+    m_events.swap(events);
+    // events now holds the old rows.
+
+    QModelIndexList newIndexes;
+    for (const QModelIndex &oldIndex : oldIndexes) {
+        const int oldRow = oldIndex.row();
+        int newRow = -1;
+        if (oldRow >= 0  &&  oldRow < int(events.size()))
+            newRow = newRows[events[oldRow]];
+
+        if (newRow < 0)
+            newIndexes.append(QModelIndex());
+        else
+            newIndexes.append(index(newRow, oldIndex.column()));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged();
+}
+
+Event *
+EventListModel::getEvent(int row) const
+{
+    if (row < 0  ||  row >= int(m_events.size()))
+        return nullptr;
+
+    return m_events[row];
+}
+
+int
+EventListModel::findRow(const Event &event) const
+{
+    // Rows are in time order, so only the Events at the same time
+    // need to be compared.
+    EventVector::const_iterator i = std::lower_bound(
+            m_events.begin(), m_events.end(),
+            event.getAbsoluteTime(), TimeLess());
+
+    for (; i != m_events.end(); ++i) {
+        if ((*i)->getAbsoluteTime() != event.getAbsoluteTime())
+            break;
+        if (**i == event)
+            return int(i - m_events.begin());
+    }
+
+    return -1;
+}
+
+int
+EventListModel::findRowAtTime(timeT time) const
+{
+    EventVector::const_iterator i = std::upper_bound(
+            m_events.begin(), m_events.end(), time, TimeLess());
+
+    return int(i - m_events.begin()) - 1;
+}
+
+int
+EventListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return int(m_events.size());
+}
+
+int
+EventListModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return ColumnCount;
+}
+
+QVariant
+EventListModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    const Event *event = getEvent(index.row());
+    if (!event)
+        return QVariant();
+
+    return format(event, index.column());
+}
+
+QVariant
+EventListModel::headerData(int section,
+                           Qt::Orientation orientation,
+                           int role) const
+{
+    if (orientation != Qt::Horizontal  ||  role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    if (section < 0  ||  section >= m_headerLabels.size())
+        return QVariant();
+
+    return m_headerLabels.at(section);
+}
+
+QString
+EventListModel::format(const Event *event, int column) const
+{
+    switch (column) {
+
+    case TimeColumn:
+    case DurationColumn: {
+        const Composition &comp =
+                RosegardenDocument::currentDocument->getComposition();
+
+        timeT eventTime = event->getAbsoluteTime();
+
+        // Grace notes sound at a different time.  Only these need the
+        // (log time) iterator lookup.
+        if (event->has(BaseProperties::IS_GRACE_NOTE)  ||
+            event->has(BaseProperties::MAY_HAVE_GRACE_NOTES)) {
+            Segment::iterator eventIter =
+                    m_segment->findSingle(const_cast<Event *>(event));
+            if (eventIter != m_segment->end()) {
+                SegmentPerformanceHelper helper(*m_segment);
+                eventTime = helper.getSoundingAbsoluteTime(eventIter);
+            }
+        }
+
+        if (column == TimeColumn)
+            return comp.makeTimeString(eventTime, m_timeMode);
+
+        if (event->getDuration() > 0  ||
+            event->isa(Note::EventType)  ||
+            event->isa(Note::EventRestType)) {
+            return comp.makeDurationString(
+                    eventTime,
+                    event->getDuration(),
+                    m_timeMode);
+        }
+
+        return QString();
+    }
+
+    case TypeColumn:
+        return strtoqstr(event->getType());
+
+    case PitchColumn:
+        if (event->has(BaseProperties::PITCH)) {
+            const int pitch = event->get<Int>(BaseProperties::PITCH);
+            return QString("%1 %2  ")
+                       .arg(pitch).arg(Pitch::toStringOctave(pitch));
+        } else if (event->isa(Note::EventType)) {
+            return translate("<not set>");
+        }
+        return QString();
+
+    case VelocityColumn:
+        if (event->has(BaseProperties::VELOCITY)) {
+            return QString("%1  ").
+                      arg(event->get<Int>(BaseProperties::VELOCITY));
+        } else if (event->isa(Note::EventType)) {
+            return translate("<not set>");
+        }
+        return QString();
+
+    case Data1Column: {
+        if (event->isa(ChannelPressure::EventType)  &&
+            event->has(ChannelPressure::PRESSURE)) {
+            return QString("%1").
+                       arg(event->get<Int>(ChannelPressure::PRESSURE));
+        }
+        if (event->isa(KeyPressure::EventType)  &&
+            event->has(KeyPressure::PRESSURE)) {
+            return QString("%1").
+                       arg(event->get<Int>(KeyPressure::PRESSURE));
+        }
+
+        if (event->has(ProgramChange::PROGRAM)) {
+            return QString("%1").
+                       arg(event->get<Int>(ProgramChange::PROGRAM) + 1);
+        }
+
+        if (event->isa(Controller::EventType)  &&
+            event->has(Controller::NUMBER)) {
+            int number = event->get<Int>(Controller::NUMBER);
+            return QString("%1  %2").
+                    arg(number).arg(Controller::getName(number));
+        } else if (event->has(Controller::NUMBER)) {
+            // This handles RPN and NRPN.  We should probably be more
+            // specific here.
+            return QString("%1").
+                       arg(event->get<Int>(Controller::NUMBER));
+        } else if (event->has(Text::TextTypePropertyName)) {
+            return QString("%1").
+                       arg(strtoqstr(event->get<String>(
+                               Text::TextTypePropertyName)));
+        } else if (event->has(Indication::IndicationTypePropertyName)) {
+            return QString("%1").
+                       arg(strtoqstr(event->get<String>(
+                               Indication::IndicationTypePropertyName)));
+        } else if (event->has(Key::KeyPropertyName)) {
+            return QString("%1").
+                       arg(strtoqstr(event->get<String>(
+                               Key::KeyPropertyName)));
+        } else if (event->has(Clef::ClefPropertyName)) {
+            return QString("%1").
+                       arg(strtoqstr(event->get<String>(
+                               Clef::ClefPropertyName)));
+        } else if (event->has(PitchBend::MSB)) {
+            const int msb = event->get<Int>(PitchBend::MSB);
+            int lsb{0};
+            if (event->has(PitchBend::LSB))
+                lsb = event->get<Int>(PitchBend::LSB);
+            const int value = (msb << 7) + lsb;
+            return QString("%1").arg(value);
+        } else if (event->has(BaseProperties::BEAMED_GROUP_TYPE)) {
+            return QString("%1").
+                       arg(strtoqstr(event->get<String>(
+                               BaseProperties::BEAMED_GROUP_TYPE)));
+        } else if (event->has(GeneratedRegion::FigurationPropertyName)) {
+            return QString("%1").
+                       arg(event->get<Int>(
+                               GeneratedRegion::FigurationPropertyName));
+        } else if (event->has(SegmentID::IDPropertyName)) {
+            return QString("%1").
+                       arg(event->get<Int>(SegmentID::IDPropertyName));
+        }
+        return QString();
+    }
+
+    case Data2Column:
+        if (event->has(BaseProperties::TRIGGER_SEGMENT_ID))
+            return "TRIGGER";
+
+        if (event->has(Controller::VALUE)) {
+            return QString("%1  ").
+                       arg(event->get<Int>(Controller::VALUE));
+        } else if (event->has(Text::TextPropertyName)) {
+            return QString("%1  ").
+                       arg(strtoqstr(event->get<String>(
+                               Text::TextPropertyName)));
+        } else if (event->has(BaseProperties::BEAMED_GROUP_ID)) {
+            return translate("(group %1)  ").
+                       arg(event->get<Int>(BaseProperties::BEAMED_GROUP_ID));
+        } else if (event->has(GeneratedRegion::ChordPropertyName)) {
+            return QString("%1  ").
+                       arg(event->get<Int>(GeneratedRegion::ChordPropertyName));
+        } else if (event->has(SegmentID::SubtypePropertyName)) {
+            return QString("%1  ").
+                       arg(strtoqstr(event->get<String>(
+                               SegmentID::SubtypePropertyName)));
+        }
+        return QString();
+
+    default:
+        return QString();
+    }
+}
+
+bool
+EventListModel::batchChange()
+{
+    if (m_rebuildPending)
+        return true;
+
+    if (m_batchChanges++ == 0)
+        QTimer::singleShot(0, this, &EventListModel::endBatch);
+
+    if (m_batchChanges <= BatchThreshold)
+        return false;
+
+    RG_DEBUG << "batchChange(): Bulk edit, rebuilding the rows afterwards";
+
+    // The remaining changes would each cost a vector insert or erase.
+    // Drop the rows now so that none of them can go stale, and rebuild
+    // them once when the batch is over.
+    beginResetModel();
+    m_events.clear();
+    m_rebuildPending = true;
+    endResetModel();
+
+    return true;
+}
+
+void
+EventListModel::endBatch()
+{
+    m_batchChanges = 0;
+
+    if (!m_rebuildPending)
+        return;
+
+    beginResetModel();
+
+    m_rebuildPending = false;
+
+    if (m_segment) {
+        for (Segment::iterator i = m_segment->begin();
+             m_segment->isBeforeEndMarker(i);
+             ++i) {
+            if (m_show[getCategory(*i)])
+                m_events.push_back(*i);
+        }
+    }
+
+    endResetModel();
+}
+
+void
+EventListModel::eventAdded(const Segment *, Event *event)
+{
+    if (!isShown(event))
+        return;
+
+    if (batchChange())
+        return;
+
+    // Segment inserts after any equal Events, so do the same.
+    EventVector::iterator pos = std::upper_bound(
+            m_events.begin(), m_events.end(), event, Event::EventCmp());
+    const int row = int(pos - m_events.begin());
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_events.insert(pos, event);
+    endInsertRows();
+}
+
+void
+EventListModel::eventRemoved(const Segment *, Event *event)
+{
+    // The Event is still valid here, so we can search by time.
+    std::pair<EventVector::iterator, EventVector::iterator> range =
+            std::equal_range(m_events.begin(), m_events.end(),
+                             event, Event::EventCmp());
+    EventVector::iterator pos = std::find(range.first, range.second, event);
+
+    // Not in the filtered rows?
+    if (pos == range.second)
+        return;
+
+    if (batchChange())
+        return;
+
+    const int row = int(pos - m_events.begin());
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_events.erase(pos);
+    endRemoveRows();
+}
+
+void
+EventListModel::allEventsChanged(const Segment *)
+{
+    refilter();
+}
+
+void
+EventListModel::endMarkerTimeChanged(const Segment *, bool /*shorten*/)
+{
+    refilter();
+}
+
+void
+EventListModel::segmentDeleted(const Segment *)
+{
+    beginResetModel();
+    m_segment = nullptr;
+    m_events.clear();
+    m_rebuildPending = false;
+    endResetModel();
+}
+
+
+}
@@ -0,0 +1,164 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_EVENTLISTMODEL_H
+#define RG_EVENTLISTMODEL_H
+
+#include "base/Composition.h"  // Composition::TimeMode
+#include "base/Segment.h"  // SegmentObserver
+
+#include <QAbstractTableModel>
+#include <QStringList>
+
+#include <vector>
+
+
+namespace Rosegarden
+{
+
+
+class Event;
+
+
+/// Table model for the EventListEditor.
+/**
+ * One row per Event in the Segment that passes the filter, in Segment
+ * order.  The only per-row storage is the Event pointer; cell text is
+ * formatted in data() when the view asks for it, so only the visible
+ * rows are ever formatted.
+ *
+ * Changes to the Segment arrive through SegmentObserver and are applied
+ * as row insertions and removals, so the view keeps its selection,
+ * current index and scroll position.  Filter and time mode changes
+ * likewise do not reset the model.
+ *
+ * Bulk edits (quantize, paste, ...) would cost a vector insert or erase
+ * per Event that way.  Once more than BatchThreshold changes arrive
+ * before control gets back to the event loop, the model empties itself
+ * and rebuilds all of its rows once, when the batch is over.
+ */
+class EventListModel : public QAbstractTableModel, public SegmentObserver
+{
+    Q_OBJECT
+
+public:
+
+    EventListModel(Segment *segment, QObject *parent);
+    ~EventListModel() override;
+
+    /// Event filter categories.  Matches the EventListEditor check boxes.
+    enum Category {
+        NoteCategory,
+        RestCategory,
+        ProgramChangeCategory,
+        ControllerCategory,
+        PitchBendCategory,
+        ChannelPressureCategory,
+        KeyPressureCategory,
+        RPNNRPNCategory,
+        SystemExclusiveCategory,
+        IndicationCategory,
+        TextCategory,
+        GeneratedRegionCategory,
+        SegmentIDCategory,
+        OtherCategory,
+        CategoryCount
+    };
+    static Category getCategory(const Event *event);
+
+    /// Set which categories are shown.  Indexed by Category.
+    void setFilter(const std::vector<bool> &show);
+
+    /// Set the time mode for the time and duration columns.
+    void setTimeMode(Composition::TimeMode timeMode);
+
+    void setHeaderLabels(const QStringList &labels)  { m_headerLabels = labels; }
+
+    /// Re-format every cell.
+    /**
+     * For changes that are made to Events in place and so do not come
+     * through SegmentObserver.  Cheap since only the visible cells are
+     * formatted.
+     */
+    void refresh();
+
+    /// Event at row or nullptr.
+    Event *getEvent(int row) const;
+    Event *getEvent(const QModelIndex &index) const
+            { return getEvent(index.row()); }
+
+    /// Row of the Event that compares equal to event, or -1.
+    int findRow(const Event &event) const;
+    /// Last row at or before time, or -1.
+    int findRowAtTime(timeT time) const;
+
+    // QAbstractTableModel overrides.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index,
+                  int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    // SegmentObserver overrides.
+    void eventAdded(const Segment *, Event *) override;
+    void eventRemoved(const Segment *, Event *) override;
+    void allEventsChanged(const Segment *) override;
+    void endMarkerTimeChanged(const Segment *, bool shorten) override;
+    void segmentDeleted(const Segment *) override;
+
+private:
+
+    Segment *m_segment;
+
+    std::vector<bool> m_show;
+    bool isShown(const Event *event) const;
+
+    Composition::TimeMode m_timeMode{Composition::TimeMode::MusicalTime};
+
+    QStringList m_headerLabels;
+
+    /// The rows.  A subsequence of the Segment.
+    typedef std::vector<Event *> EventVector;
+    EventVector m_events;
+
+    /// Rebuild m_events from the Segment.
+    /**
+     * Emits layoutChanged() and maps the persistent indexes (selection
+     * and current index) over to the new rows.
+     */
+    void refilter();
+
+    /// Changes in one batch that are applied row by row.
+    static constexpr int BatchThreshold = 100;
+    /// Changes since control last got back to the event loop.
+    int m_batchChanges{0};
+    /// The rows are empty until endBatch() rebuilds them.
+    bool m_rebuildPending{false};
+    /// Count a change.  Returns true if it is left for endBatch().
+    bool batchChange();
+    /// Rebuild the rows if the batch was too big to follow.
+    void endBatch();
+
+    QString format(const Event *event, int column) const;
+};
+
+
+}
+
+#endif
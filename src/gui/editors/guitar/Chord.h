@@ -19,6 +19,7 @@
 #define RG_CHORD_H
 
 #include "Fingering.h"
+#include "base/EventTypeName.h"
 #include "base/TimeT.h"
 #include "misc/Debug.h"
 
@@ -42,7 +43,7 @@ class Chord
     friend bool operator<(const Chord&, const Chord&);
 
 public:
-    static const std::string EventType;
+    static const EventTypeName EventType;
     static const short EventSubOrdering;
 
     Chord();
@@ -19,6 +19,7 @@
 
 #include "MatrixElement.h"
 
+#include "MatrixNoteLayer.h"
 #include "MatrixScene.h"
 #include "misc/Debug.h"
 #include "base/RulerScale.h"
@@ -30,17 +31,32 @@
 #include "gui/rulers/DefaultVelocityColour.h"
 #include "misc/Preferences.h"
 
-#include <QGraphicsRectItem>
-#include <QGraphicsPolygonItem>
-#include <QBrush>
 #include <QColor>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QPainterPath>
 
 
 namespace Rosegarden
 {
 
 
-static const int MatrixElementData = 2;
+namespace
+{
+    const QFont &noteNameFont()
+    {
+        static QFont font;
+        static bool initialised = false;
+        if (!initialised) {
+            font.setPixelSize(8);
+            initialised = true;
+        }
+        return font;
+    }
+
+    unsigned a_nextSerial = 0;
+}
 
 MatrixElement::MatrixElement(MatrixScene *scene, Event *event,
                              bool drum, long pitchOffset,
@@ -50,11 +66,15 @@ MatrixElement::MatrixElement(MatrixScene *scene, Event *event,
     m_scene(scene),
     m_drum(drum),
     m_current(true),
-    m_item(nullptr),
-    m_textItem(nullptr),
+    m_width(0),
+    m_velocity(0),
     m_pitchOffset(pitchOffset),
     m_segment(segment),
-    m_isPreview(isPreview)
+    m_isPreview(isPreview),
+    m_serial(a_nextSerial++),
+    m_noteZ(NORMAL_SEGMENT_NOTE_Z),
+    m_tied(false),
+    m_textZ(NORMAL_SEGMENT_TEXT_Z)
 {
     RG_DEBUG << "MatrixElement()";
     if (segment && scene && segment != scene->getCurrentSegment()) {
@@ -65,20 +85,15 @@ MatrixElement::MatrixElement(MatrixScene *scene, Event *event,
 
 MatrixElement::~MatrixElement()
 {
-    RG_DEBUG << "deleting item:" << m_item << this;
-
-    // Remove the item from the scene.
-    // ??? Qt documentation indicates that it is faster to remove the
-    //     item and then delete it.  We should do that.
-    delete m_item;
-
-    if (m_textItem) {
-        RG_DEBUG << "deleting text item:" << m_textItem << this;
-        // Remove the item from the scene.
-        // ??? Qt documentation indicates that it is faster to remove the
-        //     item and then delete it.  We should do that.
-        delete m_textItem;
-    }
+    RG_DEBUG << "~MatrixElement()" << this;
+
+    m_scene->getNoteLayer()->removeElement(this);
+}
+
+void
+MatrixElement::changed()
+{
+    m_scene->getNoteLayer()->elementChanged(this);
 }
 
 void
@@ -134,9 +149,9 @@ MatrixElement::reconfigure(timeT time, timeT duration, int pitch, int velocity)
 
     // if the note has TIED_FORWARD or TIED_BACK properties, draw it with a
     // different fill pattern
-    bool tiedNote = (event()->has(BaseProperties::TIED_FORWARD) ||
-                     event()->has(BaseProperties::TIED_BACKWARD));
-    Qt::BrushStyle brushPattern = (tiedNote ? Qt::Dense2Pattern : Qt::SolidPattern);
+    m_tied = (event()->has(BaseProperties::TIED_FORWARD) ||
+              event()->has(BaseProperties::TIED_BACKWARD));
+    Qt::BrushStyle brushPattern = (m_tied ? Qt::Dense2Pattern : Qt::SolidPattern);
 
     QColor colour;
     if (event()->has(BaseProperties::TRIGGER_SEGMENT_ID)) {
@@ -163,122 +178,123 @@ MatrixElement::reconfigure(timeT time, timeT duration, int pitch, int velocity)
     // changes velocity color of notes.
     // colour.setAlpha(160);
 
+    m_pen = QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0);
+    m_brush = QBrush(colour, brushPattern);
+
+    // set the Y position taking m_pitchOffset into account, subtracting the
+    // opposite of whatever the originating segment transpose was
+
+//    std::cout << "TRANSPOSITION TEST: event pitch: "
+//              << (pitch ) << " m_pitchOffset: " << m_pitchOffset
+//              << std::endl;
+
+    double pitchy = (127 - pitch - m_pitchOffset) * (resolution + 1);
+
     double fres(resolution);
 
     if (m_drum) {
         fres = resolution + 1;
-        QGraphicsPolygonItem *item = dynamic_cast<QGraphicsPolygonItem *>(m_item);
-        if (!item) {
-            RG_DEBUG << "reconfigure drum deleting item:" << m_item << this;
-            // Remove the item from the scene.
-            // ??? Qt documentation indicates that it is faster to remove the
-            //     item and then delete it.  We should do that.
-            delete m_item;
-            item = new QGraphicsPolygonItem;
-            RG_DEBUG << "reconfigure drum created item:" << m_item << this;
-            m_item = item;
-            m_scene->addItem(m_item);
-        }
-        QPolygonF polygon;
-        polygon << QPointF(0, 0)
-                << QPointF(fres/2, fres/2)
-                << QPointF(0, fres)
-                << QPointF(-fres/2, fres/2)
-                << QPointF(0, 0);
-        item->setPolygon(polygon);
-        item->setPen
-            (QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0));
-        item->setBrush(QBrush(colour, brushPattern));
+        m_polygon.clear();
+        m_polygon << QPointF(x0, pitchy)
+                  << QPointF(x0 + fres/2, pitchy + fres/2)
+                  << QPointF(x0, pitchy + fres)
+                  << QPointF(x0 - fres/2, pitchy + fres/2)
+                  << QPointF(x0, pitchy);
+        m_rect = m_polygon.boundingRect();
+        m_noteName.clear();
     } else {
-        QGraphicsRectItem *item = dynamic_cast<QGraphicsRectItem *>(m_item);
-        if (!item) {
-            RG_DEBUG << "reconfigure deleting item:" << m_item << this;
-            // Remove the item from the scene.
-            // ??? Qt documentation indicates that it is faster to remove the
-            //     item and then delete it.  We should do that.
-            delete m_item;
-            item = new QGraphicsRectItem;
-            m_item = item;
-            RG_DEBUG << "reconfigure created item:" << m_item << this;
-            m_scene->addItem(m_item);
-        }
         float width = m_width;
         if (width < 1) {
             x0 = std::max(0.0, x1 - 1);
             width = 1;
         }
-        QRectF rect(0, 0, width, fres + 1);
-        item->setRect(rect);
-        item->setPen
-            (QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0));
-        item->setBrush(QBrush(colour, brushPattern));
-
-        const bool showName = Preferences::getShowNoteNames();
-
-        if (m_textItem) {
-            if (!showName) {
-                RG_DEBUG << "reconfigure deleting text item:" << m_textItem << this;
-                // Remove the item from the scene.
-                // ??? Qt documentation indicates that it is faster to remove the
-                //     item and then delete it.  We should do that.
-                delete m_textItem;
-                m_textItem = nullptr;
-            }
+        m_rect = QRectF(x0, pitchy, width, fres + 1);
+        m_polygon.clear();
+
+        if (Preferences::getShowNoteNames()) {
+            m_noteName = Pitch::toStringOctave(pitch);
+            const QFontMetricsF metrics(noteNameFont());
+            m_textRect = QRectF(QPointF(x0 + 1, pitchy - 1),
+                                metrics.size(0, m_noteName));
         } else {
-            if (showName) {
-                m_textItem = new QGraphicsSimpleTextItem;
-                RG_DEBUG << "reconfigure created text item:" << m_textItem << this;
-                m_scene->addItem(m_textItem);
-            }
-        }
-
-        if (m_textItem) {
-            // text above note, see constants in .h file
-            if (m_isPreview) {
-                m_textItem->setZValue(PREVIEW_NOTE_TEXT_Z);
-            } else {
-                m_textItem->setZValue(m_current ? ACTIVE_SEGMENT_TEXT_Z
-                                      : NORMAL_SEGMENT_TEXT_Z);
-                m_textItem->setBrush(GUIPalette::getColour(GUIPalette::MatrixElementBorder));
-            }
-            QString noteName = Pitch::toStringOctave(pitch);
-            m_textItem->setText(noteName);
-            QFont font;
-            font.setPixelSize(8);
-            m_textItem->setFont(font);
-            m_textItem->setData(MatrixElementData,
-                                QVariant::fromValue((void *)this));
+            m_noteName.clear();
         }
     }
 
     setLayoutX(x0);
 
-    m_item->setData(MatrixElementData, QVariant::fromValue((void *)this));
-
-    // set the Y position taking m_pitchOffset into account, subtracting the
-    // opposite of whatever the originating segment transpose was
-
-//    std::cout << "TRANSPOSITION TEST: event pitch: "
-//              << (pitch ) << " m_pitchOffset: " << m_pitchOffset
-//              << std::endl;
-
-    double pitchy = (127 - pitch - m_pitchOffset) * (resolution + 1);
-    m_item->setPos(x0, pitchy);
     // See constants in .h file
 
     if (m_isPreview) {
-        m_item->setZValue(PREVIEW_NOTE_Z);
+        m_noteZ = PREVIEW_NOTE_Z;
+        // text above note
+        m_textZ = PREVIEW_NOTE_TEXT_Z;
+        m_textBrush = QBrush(Qt::black);
     } else {
-        m_item->setZValue(m_current ? ACTIVE_SEGMENT_NOTE_Z
-                          : NORMAL_SEGMENT_NOTE_Z);
+        m_noteZ = m_current ? ACTIVE_SEGMENT_NOTE_Z : NORMAL_SEGMENT_NOTE_Z;
+        m_textZ = m_current ? ACTIVE_SEGMENT_TEXT_Z : NORMAL_SEGMENT_TEXT_Z;
+        m_textBrush = GUIPalette::getColour(GUIPalette::MatrixElementBorder);
     }
 
-    if (m_textItem) {
-            m_textItem->setPos(x0 + 1, pitchy - 1);
-        }
+    changed();
+}
+
+QRectF
+MatrixElement::getSceneBoundingRect() const
+{
+    QRectF rect = m_rect;
+
+    // Cosmetic pens are taken care of by MatrixNoteLayer.
+    if (!m_pen.isCosmetic()) {
+        const double halfPen = m_pen.widthF() / 2;
+        rect.adjust(-halfPen, -halfPen, halfPen, halfPen);
+    }
+
+    if (hasText())
+        rect = rect.united(m_textRect);
+
+    return rect;
+}
+
+bool
+MatrixElement::noteContains(const QPointF &pos) const
+{
+    if (m_drum)
+        return m_polygon.containsPoint(pos, Qt::OddEvenFill);
+
+    return m_rect.contains(pos);
+}
+
+bool
+MatrixElement::noteIntersects(const QRectF &rect) const
+{
+    if (m_drum) {
+        QPainterPath path;
+        path.addPolygon(m_polygon);
+        return path.intersects(rect);
+    }
 
-    // set a tooltip explaining why this event is drawn in a different pattern
-    if (tiedNote) m_item->setToolTip(QObject::tr("This event is tied to another event."));
+    return m_rect.intersects(rect);
+}
+
+void
+MatrixElement::paintNote(QPainter *painter) const
+{
+    painter->setPen(m_pen);
+    painter->setBrush(m_brush);
+
+    if (m_drum)
+        painter->drawPolygon(m_polygon);
+    else
+        painter->drawRect(m_rect);
+}
+
+void
+MatrixElement::paintText(QPainter *painter) const
+{
+    painter->setFont(noteNameFont());
+    painter->setPen(QPen(m_textBrush, 0));
+    painter->drawText(m_textRect, Qt::AlignLeft | Qt::AlignTop, m_noteName);
 }
 
 bool
@@ -291,19 +307,17 @@ void
 MatrixElement::setSelected(bool selected)
 {
     RG_DEBUG << "setSelected" << event()->getAbsoluteTime() << selected;
-    QAbstractGraphicsShapeItem *item =
-        dynamic_cast<QAbstractGraphicsShapeItem *>(m_item);
-    if (!item) return;
 
     if (selected) {
         QPen pen(GUIPalette::getColour(GUIPalette::SelectedElement), 2,
                  Qt::SolidLine, Qt::SquareCap, Qt::MiterJoin);
         pen.setCosmetic(!m_drum);
-        item->setPen(pen);
+        m_pen = pen;
     } else {
-        item->setPen
-            (QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0));
+        m_pen = QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0);
     }
+
+    changed();
 }
 
 void
@@ -314,10 +328,6 @@ MatrixElement::setCurrent(bool current)
         current << m_current;
     if (m_current == current) return;
 
-    QAbstractGraphicsShapeItem *item =
-        dynamic_cast<QAbstractGraphicsShapeItem *>(m_item);
-    if (!item) return;
-
     QColor colour;
 
     if (!current) {
@@ -332,32 +342,21 @@ MatrixElement::setCurrent(bool current)
         }
     }
 
-    item->setBrush(colour);
+    m_brush = QBrush(colour);
 
     // See constants in .h file
-    m_item->setZValue(current ? ACTIVE_SEGMENT_NOTE_Z : NORMAL_SEGMENT_NOTE_Z);
-    if (m_textItem) {
-        m_textItem->setZValue(current ? ACTIVE_SEGMENT_TEXT_Z
-                                      : NORMAL_SEGMENT_TEXT_Z);
-    }
+    m_noteZ = current ? ACTIVE_SEGMENT_NOTE_Z : NORMAL_SEGMENT_NOTE_Z;
+    m_textZ = current ? ACTIVE_SEGMENT_TEXT_Z : NORMAL_SEGMENT_TEXT_Z;
 
     if (current) {
-        item->setPen
-            (QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0));
+        m_pen = QPen(GUIPalette::getColour(GUIPalette::MatrixElementBorder), 0);
     } else {
-        item->setPen
-            (QPen(GUIPalette::getColour(GUIPalette::MatrixElementLightBorder), 0));
+        m_pen = QPen(GUIPalette::getColour(GUIPalette::MatrixElementLightBorder), 0);
     }
 
     m_current = current;
-}
 
-MatrixElement *
-MatrixElement::getMatrixElement(QGraphicsItem *item)
-{
-    QVariant v = item->data(MatrixElementData);
-    if (v.isNull()) return nullptr;
-    return static_cast<MatrixElement *>(v.value<void *>());
+    changed();
 }
 
 bool MatrixElement::isPreview() const
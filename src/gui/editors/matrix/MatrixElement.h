@@ -20,9 +20,13 @@
 
 #include "base/ViewElement.h"
 
-class QColor;
-class QGraphicsItem;
-class QGraphicsSimpleTextItem;
+#include <QBrush>
+#include <QPen>
+#include <QPolygonF>
+#include <QRectF>
+#include <QString>
+
+class QPainter;
 
 namespace Rosegarden
 {
@@ -36,9 +40,10 @@ class Segment;
  * This is more of a "MatrixNoteView" in pattern-speak or a "MatrixNoteItem"
  * in Qt-speak.
  *
- * m_item is the QGraphicsRectItem (or QGraphicsPolygonItem) that is
- * displayed for a note on the matrix.  reconfigure() creates m_item and
- * adds it to the scene.  m_item is owned by this class.
+ * MatrixElements are not scene items.  reconfigure() works out the
+ * note's shape and colours and hands the element to the scene's
+ * MatrixNoteLayer, which draws all of the notes and does the hit
+ * testing for the tools.  See MatrixNoteLayer.
  *
  * MatrixElements (and ViewElements in general) are stored in
  * ViewSegment::m_viewElementList.  They are created in
@@ -89,10 +94,29 @@ public:
 
     MatrixScene *getScene() { return m_scene; }
 
-    static MatrixElement *getMatrixElement(QGraphicsItem *);
-
     bool isPreview() const;
 
+    // For MatrixNoteLayer.  All in scene coordinates.
+
+    /// Note and note name, including the pen.
+    QRectF getSceneBoundingRect() const;
+    bool noteContains(const QPointF &pos) const;
+    bool noteIntersects(const QRectF &rect) const;
+    void paintNote(QPainter *painter) const;
+    double getNoteZ() const  { return m_noteZ; }
+
+    /// Whether the note name is shown.
+    bool hasText() const  { return !m_noteName.isEmpty(); }
+    const QRectF &getTextRect() const  { return m_textRect; }
+    void paintText(QPainter *painter) const;
+    double getTextZ() const  { return m_textZ; }
+
+    /// Creation order.  Breaks z ties.
+    unsigned getSerial() const  { return m_serial; }
+
+    /// Tied notes are drawn with a pattern and have a tooltip.
+    bool isTied() const  { return m_tied; }
+
     // Z values for occlusion/layering of object in graph display.
     // Difference between NORMAL_ and ACTIVE_  needed when notes from
     // different segments overlay each other at same pitch and time
@@ -115,8 +139,6 @@ protected:
     MatrixScene *m_scene;
     bool m_drum;
     bool m_current;
-    QGraphicsItem *m_item;
-    QGraphicsSimpleTextItem *m_textItem;
     double m_width;
     double m_velocity;
 
@@ -143,6 +165,28 @@ private:
     void reconfigure(timeT time, timeT duration, int pitch, int velocity);
 
     bool m_isPreview;
+
+    unsigned m_serial;
+
+    // What MatrixNoteLayer draws.
+
+    /// The note for the normal matrix.
+    QRectF m_rect;
+    /// The note for the percussion matrix (diamond).
+    QPolygonF m_polygon;
+    QPen m_pen;
+    QBrush m_brush;
+    double m_noteZ;
+    bool m_tied;
+
+    /// Empty if note names are not shown.
+    QString m_noteName;
+    QRectF m_textRect;
+    QBrush m_textBrush;
+    double m_textZ;
+
+    /// Let MatrixNoteLayer know we've changed.
+    void changed();
 };
 
 
@@ -0,0 +1,467 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_MODULE_STRING "[MatrixNoteLayer]"
+#define RG_NO_DEBUG_PRINT 1
+
+#include "MatrixNoteLayer.h"
+
+#include "MatrixElement.h"
+
+#include "misc/Debug.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QTransform>
+#include <QWidget>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace Rosegarden
+{
+
+
+namespace
+{
+    // Spatial index cell size in scene units.  A few bars by a few
+    // pitches at the default zoom.
+    constexpr double cellWidth = 256;
+    constexpr double cellHeight = 64;
+
+    // Tile size in device independent pixels.
+    constexpr int tileSize = 256;
+
+    // Room in device pixels for pens that extend past an element's rect.
+    constexpr double penMargin = 2;
+
+    // Per view, in KB.
+    constexpr int maxTileCacheCost = 64 * 1024;
+
+    quint64 makeKey(int column, int row)
+    {
+        return (quint64(quint32(column)) << 32) | quint32(row);
+    }
+
+    int keyColumn(quint64 key)  { return int(quint32(key >> 32)); }
+    int keyRow(quint64 key)  { return int(quint32(key)); }
+
+    int cellColumn(double x)  { return int(std::floor(x / cellWidth)); }
+    int cellRow(double y)  { return int(std::floor(y / cellHeight)); }
+
+    /// A note or note name in stacking order.
+    /**
+     * Equal z values stack in creation order, as scene items do.
+     */
+    struct StackEntry
+    {
+        double z;
+        unsigned serial;
+        MatrixElement *element;
+        bool text;
+
+        bool operator<(const StackEntry &rhs) const
+        {
+            if (z != rhs.z)
+                return z < rhs.z;
+            if (serial != rhs.serial)
+                return serial < rhs.serial;
+            // Note name above its own note.
+            return !text  &&  rhs.text;
+        }
+    };
+}
+
+
+MatrixNoteLayer::MatrixNoteLayer()
+{
+    // For option->exposedRect.
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setZValue(MatrixElement::NORMAL_SEGMENT_NOTE_Z);
+}
+
+MatrixNoteLayer::~MatrixNoteLayer()
+{
+    for (auto &pair : m_tileSets) {
+        QObject::disconnect(pair.second->destroyedConnection);
+    }
+}
+
+void
+MatrixNoteLayer::elementChanged(MatrixElement *element)
+{
+    const QRectF rect = element->getSceneBoundingRect();
+
+    auto elementRectIter = m_elementRects.find(element);
+    if (elementRectIter != m_elementRects.end()) {
+        const QRectF oldRect = elementRectIter->second;
+        unindex(element, oldRect);
+        invalidate(oldRect);
+        elementRectIter->second = rect;
+    } else {
+        m_elementRects[element] = rect;
+    }
+
+    index(element, rect);
+
+    if (!m_bounds.contains(rect)) {
+        prepareGeometryChange();
+        // Grow generously since notes tend to be added left to right.
+        m_bounds = m_bounds.united(
+                rect.adjusted(-cellWidth, -cellHeight,
+                              16 * cellWidth, cellHeight));
+    }
+
+    invalidate(rect);
+}
+
+void
+MatrixNoteLayer::removeElement(MatrixElement *element)
+{
+    auto elementRectIter = m_elementRects.find(element);
+    if (elementRectIter == m_elementRects.end())
+        return;
+
+    const QRectF rect = elementRectIter->second;
+    m_elementRects.erase(elementRectIter);
+
+    unindex(element, rect);
+    invalidate(rect);
+}
+
+void
+MatrixNoteLayer::index(MatrixElement *element, const QRectF &rect)
+{
+    const int lastColumn = cellColumn(rect.right());
+    const int lastRow = cellRow(rect.bottom());
+
+    for (int column = cellColumn(rect.left()); column <= lastColumn; ++column) {
+        for (int row = cellRow(rect.top()); row <= lastRow; ++row) {
+            m_cells[makeKey(column, row)].push_back(element);
+        }
+    }
+}
+
+void
+MatrixNoteLayer::unindex(MatrixElement *element, const QRectF &rect)
+{
+    const int lastColumn = cellColumn(rect.right());
+    const int lastRow = cellRow(rect.bottom());
+
+    for (int column = cellColumn(rect.left()); column <= lastColumn; ++column) {
+        for (int row = cellRow(rect.top()); row <= lastRow; ++row) {
+            auto cellIter = m_cells.find(makeKey(column, row));
+            if (cellIter == m_cells.end())
+                continue;
+
+            ElementVector &cell = cellIter->second;
+            auto elementIter = std::find(cell.begin(), cell.end(), element);
+            if (elementIter == cell.end())
+                continue;
+
+            // Order within a cell does not matter.
+            *elementIter = cell.back();
+            cell.pop_back();
+
+            if (cell.empty())
+                m_cells.erase(cellIter);
+        }
+    }
+}
+
+MatrixNoteLayer::ElementVector
+MatrixNoteLayer::candidates(const QRectF &rect) const
+{
+    ElementVector elements;
+
+    const QRectF searchRect = rect.intersected(m_bounds);
+    if (searchRect.isEmpty())
+        return elements;
+
+    const int lastColumn = cellColumn(searchRect.right());
+    const int lastRow = cellRow(searchRect.bottom());
+
+    for (int column = cellColumn(searchRect.left());
+         column <= lastColumn;
+         ++column) {
+        for (int row = cellRow(searchRect.top()); row <= lastRow; ++row) {
+            auto cellIter = m_cells.find(makeKey(column, row));
+            if (cellIter == m_cells.end())
+                continue;
+
+            for (MatrixElement *element : cellIter->second) {
+                if (element->getSceneBoundingRect().intersects(rect))
+                    elements.push_back(element);
+            }
+        }
+    }
+
+    // Elements that span cells were found more than once.
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()),
+                   elements.end());
+
+    return elements;
+}
+
+MatrixElement *
+MatrixNoteLayer::elementAt(const QPointF &pos) const
+{
+    auto cellIter = m_cells.find(makeKey(cellColumn(pos.x()),
+                                         cellRow(pos.y())));
+    if (cellIter == m_cells.end())
+        return nullptr;
+
+    bool found = false;
+    StackEntry top{};
+
+    // Every element that covers pos is in pos's cell.
+    for (MatrixElement *element : cellIter->second) {
+        if (element->isPreview())
+            continue;
+
+        StackEntry entry{};
+        entry.serial = element->getSerial();
+        entry.element = element;
+
+        if (element->hasText()  &&  element->getTextRect().contains(pos)) {
+            entry.z = element->getTextZ();
+            entry.text = true;
+        } else if (element->noteContains(pos)) {
+            entry.z = element->getNoteZ();
+            entry.text = false;
+        } else {
+            continue;
+        }
+
+        if (!found  ||  top < entry) {
+            top = entry;
+            found = true;
+        }
+    }
+
+    return found ? top.element : nullptr;
+}
+
+MatrixNoteLayer::ElementVector
+MatrixNoteLayer::elementsIn(const QRectF &rect) const
+{
+    std::vector<StackEntry> entries;
+
+    for (MatrixElement *element : candidates(rect)) {
+        if (element->noteIntersects(rect)  ||
+            (element->hasText()  &&
+             element->getTextRect().intersects(rect))) {
+            entries.push_back(StackEntry{element->getNoteZ(),
+                                         element->getSerial(),
+                                         element,
+                                         false});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    ElementVector elements;
+    elements.reserve(entries.size());
+    for (const StackEntry &entry : entries) {
+        elements.push_back(entry.element);
+    }
+
+    return elements;
+}
+
+void
+MatrixNoteLayer::invalidate(const QRectF &rect)
+{
+    for (auto &pair : m_tileSets) {
+        TileSet &tileSet = *pair.second;
+        if (tileSet.tiles.isEmpty())
+            continue;
+
+        const int firstColumn = int(std::floor(
+                (rect.left() * tileSet.scaleX - penMargin) / tileSize));
+        const int lastColumn = int(std::floor(
+                (rect.right() * tileSet.scaleX + penMargin) / tileSize));
+        const int firstRow = int(std::floor(
+                (rect.top() * tileSet.scaleY - penMargin) / tileSize));
+        const int lastRow = int(std::floor(
+                (rect.bottom() * tileSet.scaleY + penMargin) / tileSize));
+
+        const long tileCount = long(lastColumn - firstColumn + 1) *
+                               (lastRow - firstRow + 1);
+
+        if (tileCount > tileSet.tiles.size()) {
+            // Cheaper to go through the cache.
+            for (quint64 key : tileSet.tiles.keys()) {
+                const int column = keyColumn(key);
+                const int row = keyRow(key);
+                if (column >= firstColumn  &&  column <= lastColumn  &&
+                    row >= firstRow  &&  row <= lastRow)
+                    tileSet.tiles.remove(key);
+            }
+        } else {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                for (int row = firstRow; row <= lastRow; ++row) {
+                    tileSet.tiles.remove(makeKey(column, row));
+                }
+            }
+        }
+    }
+
+    // The views add a couple of pixels for pens and antialiasing.
+    update(rect);
+}
+
+void
+MatrixNoteLayer::paint(QPainter *painter,
+                       const QStyleOptionGraphicsItem *option,
+                       QWidget *widget)
+{
+    const QRectF exposed = option->exposedRect;
+    const QTransform transform = painter->worldTransform();
+
+    // Tiles only work for plain scaling and scrolling on screen.
+    if (!widget  ||  transform.type() > QTransform::TxScale  ||
+        transform.m11() <= 0  ||  transform.m22() <= 0) {
+        paintElements(painter, exposed);
+        return;
+    }
+
+    std::unique_ptr<TileSet> &tileSetPtr = m_tileSets[widget];
+    if (!tileSetPtr) {
+        tileSetPtr.reset(new TileSet);
+        tileSetPtr->tiles.setMaxCost(maxTileCacheCost);
+        tileSetPtr->destroyedConnection = QObject::connect(
+                widget, &QObject::destroyed,
+                [this, widget]() { m_tileSets.erase(widget); });
+    }
+    TileSet &tileSet = *tileSetPtr;
+
+    const double devicePixelRatio = painter->device()->devicePixelRatioF();
+
+    // Zoom changed?  Start over.
+    if (tileSet.scaleX != transform.m11()  ||
+        tileSet.scaleY != transform.m22()  ||
+        tileSet.devicePixelRatio != devicePixelRatio) {
+        tileSet.tiles.clear();
+        tileSet.scaleX = transform.m11();
+        tileSet.scaleY = transform.m22();
+        tileSet.devicePixelRatio = devicePixelRatio;
+    }
+
+    const int firstColumn =
+            int(std::floor(exposed.left() * tileSet.scaleX / tileSize));
+    const int lastColumn =
+            int(std::floor(exposed.right() * tileSet.scaleX / tileSize));
+    const int firstRow =
+            int(std::floor(exposed.top() * tileSet.scaleY / tileSize));
+    const int lastRow =
+            int(std::floor(exposed.bottom() * tileSet.scaleY / tileSize));
+
+    const int tileCost = int(tileSize * devicePixelRatio *
+                             tileSize * devicePixelRatio * 4 / 1024);
+
+    painter->save();
+
+    // Draw the tiles unscaled so they are not resampled.
+    painter->setWorldTransform(
+            QTransform::fromTranslate(transform.dx(), transform.dy()));
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const quint64 key = makeKey(column, row);
+
+            QPixmap *tile = tileSet.tiles.object(key);
+            if (!tile) {
+                tile = renderTile(column, row, tileSet, painter);
+                // The cache owns the tile.  It stays valid until the
+                // next insert.
+                tileSet.tiles.insert(key, tile, tileCost);
+            }
+
+            painter->drawPixmap(QPointF(column * tileSize, row * tileSize),
+                                *tile);
+        }
+    }
+
+    painter->restore();
+}
+
+QPixmap *
+MatrixNoteLayer::renderTile(int column, int row, const TileSet &tileSet,
+                            const QPainter *viewPainter) const
+{
+    RG_DEBUG << "renderTile()" << column << row;
+
+    QPixmap *tile = new QPixmap(
+            QSize(tileSize, tileSize) * tileSet.devicePixelRatio);
+    tile->setDevicePixelRatio(tileSet.devicePixelRatio);
+    tile->fill(Qt::transparent);
+
+    QPainter painter(tile);
+    painter.setRenderHints(viewPainter->renderHints());
+    // Scene to tile coordinates.
+    painter.setWorldTransform(QTransform(tileSet.scaleX, 0,
+                                         0, tileSet.scaleY,
+                                         -column * tileSize, -row * tileSize));
+
+    const double marginX = penMargin / tileSet.scaleX;
+    const double marginY = penMargin / tileSet.scaleY;
+
+    const QRectF rect(column * tileSize / tileSet.scaleX,
+                      row * tileSize / tileSet.scaleY,
+                      tileSize / tileSet.scaleX,
+                      tileSize / tileSet.scaleY);
+
+    paintElements(&painter,
+                  rect.adjusted(-marginX, -marginY, marginX, marginY));
+
+    return tile;
+}
+
+void
+MatrixNoteLayer::paintElements(QPainter *painter, const QRectF &rect) const
+{
+    std::vector<StackEntry> entries;
+
+    for (MatrixElement *element : candidates(rect)) {
+        entries.push_back(StackEntry{element->getNoteZ(),
+                                     element->getSerial(),
+                                     element,
+                                     false});
+        if (element->hasText()) {
+            entries.push_back(StackEntry{element->getTextZ(),
+                                         element->getSerial(),
+                                         element,
+                                         true});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    for (const StackEntry &entry : entries) {
+        if (entry.text)
+            entry.element->paintText(painter);
+        else
+            entry.element->paintNote(painter);
+    }
+}
+
+
+}
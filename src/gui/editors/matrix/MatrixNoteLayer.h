@@ -0,0 +1,146 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_MATRIXNOTELAYER_H
+#define RG_MATRIXNOTELAYER_H
+
+#include <QCache>
+#include <QGraphicsItem>
+#include <QObject>
+#include <QPixmap>
+#include <QRectF>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class QPainter;
+class QWidget;
+
+namespace Rosegarden
+{
+
+class MatrixElement;
+
+/// The single scene item that draws every MatrixElement.
+/**
+ * Owned by MatrixScene.  See MatrixScene::getNoteLayer().
+ *
+ * A dense performance can have hundreds of thousands of notes.  One
+ * QGraphicsItem per note makes scrolling, zooming and rubber-band
+ * selection slow, so the MatrixElements instead register themselves
+ * here and this item draws them all.
+ *
+ * The elements are kept in a uniform grid over the scene so that
+ * painting and hit testing only look at the notes near the area of
+ * interest.  Painting is done in fixed-size tiles which are cached per
+ * view (the matrix view and its panner) and reused until the notes in
+ * them change or the view's zoom changes.  Scrolling therefore only
+ * draws the tiles that have just come into view.
+ *
+ * Since the notes are no longer scene items, the editing tools must use
+ * elementAt() and elementsIn() rather than QGraphicsScene::items().
+ */
+class MatrixNoteLayer : public QGraphicsItem
+{
+public:
+    MatrixNoteLayer();
+    ~MatrixNoteLayer() override;
+
+    /// Add the element or update its position and appearance.
+    /**
+     * Called by MatrixElement whenever it changes.
+     */
+    void elementChanged(MatrixElement *element);
+    /// Called by ~MatrixElement().
+    void removeElement(MatrixElement *element);
+
+    /// Topmost non-preview element at scene position pos, or nullptr.
+    MatrixElement *elementAt(const QPointF &pos) const;
+
+    typedef std::vector<MatrixElement *> ElementVector;
+
+    /// All elements that intersect the scene rect.
+    /**
+     * In stacking order, bottom first.
+     */
+    ElementVector elementsIn(const QRectF &rect) const;
+
+    // QGraphicsItem overrides.
+    QRectF boundingRect() const override  { return m_bounds; }
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override;
+
+private:
+
+    // *** Spatial index
+
+    /// The rect each element was indexed with.
+    std::unordered_map<const MatrixElement *, QRectF> m_elementRects;
+
+    typedef quint64 CellKey;
+    std::unordered_map<CellKey, ElementVector> m_cells;
+
+    void index(MatrixElement *element, const QRectF &rect);
+    void unindex(MatrixElement *element, const QRectF &rect);
+
+    /// Elements whose indexed rects intersect rect.  Unsorted.
+    ElementVector candidates(const QRectF &rect) const;
+
+    /// Grows in large steps to avoid constant prepareGeometryChange().
+    QRectF m_bounds;
+
+    // *** Tile cache
+
+    /// The tiles for one view.
+    struct TileSet
+    {
+        /// Device pixels per scene unit.
+        double scaleX{0};
+        double scaleY{0};
+        double devicePixelRatio{0};
+
+        /// Key is the tile's column and row.  Cost is in KB.
+        QCache<quint64, QPixmap> tiles;
+
+        /// Removes the TileSet when its widget is destroyed.
+        QMetaObject::Connection destroyedConnection;
+    };
+
+    /// Key is the viewport widget.  Never dereferenced.
+    /**
+     * Entries are removed when their widget is destroyed, so that a new
+     * widget at the same address does not pick up stale tiles.
+     */
+    std::map<const QWidget *, std::unique_ptr<TileSet>> m_tileSets;
+
+    /// Drop the cached tiles that overlap rect and schedule a repaint.
+    void invalidate(const QRectF &rect);
+
+    QPixmap *renderTile(int column, int row, const TileSet &tileSet,
+                        const QPainter *viewPainter) const;
+
+    /// Paint the elements that intersect rect in stacking order.
+    void paintElements(QPainter *painter, const QRectF &rect) const;
+};
+
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "MatrixScene.h"
 
 #include "MatrixMouseEvent.h"
+#include "MatrixNoteLayer.h"
 #include "MatrixViewSegment.h"
 #include "MatrixWidget.h"
 #include "MatrixElement.h"
@@ -39,11 +40,13 @@
 #include "base/NotationRules.h"
 #include "gui/studio/StudioControl.h"
 
+#include <QGraphicsSceneHelpEvent>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsLineItem>
 #include <QSettings>
 #include <QPointF>
 #include <QRectF>
+#include <QToolTip>
 
 #include <algorithm>  // for std::sort
 
@@ -64,8 +67,11 @@ MatrixScene::MatrixScene() :
     m_snapGrid(nullptr),
     m_resolution(8),
     m_selection(nullptr),
+    m_noteLayer(new MatrixNoteLayer),
     m_highlightType(HT_BlackKeys)
 {
+    addItem(m_noteLayer);
+
     connect(CommandHistory::getInstance(), &CommandHistory::commandExecuted,
             this, &MatrixScene::slotCommandExecuted);
 }
@@ -667,16 +673,8 @@ MatrixScene::setupMouseEvent(QGraphicsSceneMouseEvent *e,
 
     mme.element = nullptr;
 
-    QList<QGraphicsItem *> l = items(e->scenePos());
-//   MATRIX_DEBUG << "Found " << l.size() << " items at " << e->scenePos();
-    for (int i = 0; i < l.size(); ++i) {
-        MatrixElement *element = MatrixElement::getMatrixElement(l[i]);
-        if (element && ! element->isPreview()) {
-            // items are in z-order from top, so this is most salient
-            mme.element = element;
-            break;
-        }
-    }
+    // Topmost non-preview note.
+    mme.element = m_noteLayer->elementAt(e->scenePos());
 
     mme.viewSegment = m_viewSegments[m_currentSegmentIndex];
 
@@ -759,6 +757,23 @@ MatrixScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *e)
     emit mouseDoubleClicked(&nme);
 }
 
+void
+MatrixScene::helpEvent(QGraphicsSceneHelpEvent *e)
+{
+    const MatrixElement *element = m_noteLayer->elementAt(e->scenePos());
+
+    // Explain why this event is drawn in a different pattern.
+    if (element  &&  element->isTied()) {
+        QToolTip::showText(e->screenPos(),
+                           QObject::tr("This event is tied to another event."),
+                           e->widget());
+        e->accept();
+        return;
+    }
+
+    QGraphicsScene::helpEvent(e);
+}
+
 void
 MatrixScene::slotCommandExecuted()
 {
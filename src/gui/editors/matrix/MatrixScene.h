@@ -24,6 +24,7 @@
 #include "gui/general/SelectionManager.h"
 
 class QGraphicsLineItem;
+class QGraphicsSceneHelpEvent;
 
 namespace Rosegarden
 {
@@ -35,6 +36,7 @@ class Event;
 class EventSelection;
 class MatrixElement;
 class MatrixMouseEvent;
+class MatrixNoteLayer;
 class MatrixViewSegment;
 class ViewSegment;
 class RulerScale;
@@ -45,10 +47,12 @@ class SnapGrid;
  * An instance of this is created and owned by MatrixWidget.  See
  * MatrixWidget::m_scene.
  *
- * Specialised graphics scene for matrix elements.  The note blocks and
- * horizontal and vertical grid lines are all represented by graphics items
- * owned by this scene.  This scene also owns the MatrixViewSegment classes
- * which track segment contents in view objects.
+ * Specialised graphics scene for matrix elements.  The horizontal and
+ * vertical grid lines are represented by graphics items owned by this
+ * scene.  The note blocks are all drawn by a single MatrixNoteLayer item
+ * which also does the hit testing for the tools.  This scene also owns
+ * the MatrixViewSegment classes which track segment contents in view
+ * objects.
  *
  * The scene works with MatrixViewSegment, MatrixViewElement, MatrixPainter,
  * and MatrixMover to support the new "concert pitch matrix" concept.  All
@@ -121,6 +125,9 @@ public:
     ZoomableRulerScale *getReferenceScale() { return m_referenceScale; }
     const SnapGrid *getSnapGrid() const { return m_snapGrid; }
 
+    /// Draws and hit tests the MatrixElements.
+    MatrixNoteLayer *getNoteLayer() { return m_noteLayer; }
+
     void setSnap(timeT);
 
     // unused bool constrainToSegmentArea(QPointF &scenePos);
@@ -173,6 +180,8 @@ protected:
     void mouseMoveEvent(QGraphicsSceneMouseEvent *) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *) override;
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *) override;
+    /// Tooltips for the notes.
+    void helpEvent(QGraphicsSceneHelpEvent *) override;
 
     void segmentRemoved(const Composition *, Segment *) override; // CompositionObserver
 
@@ -203,6 +212,8 @@ private:
 
     EventSelection *m_selection; // I own this
 
+    MatrixNoteLayer *m_noteLayer; // the scene owns this
+
     HighlightType m_highlightType;
 
     // These are the background items -- the grid lines and the shadings
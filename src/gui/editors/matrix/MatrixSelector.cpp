@@ -20,6 +20,7 @@
 #include "MatrixSelector.h"
 
 #include "MatrixElement.h"
+#include "MatrixNoteLayer.h"
 #include "MatrixMover.h"
 #include "MatrixPainter.h"
 #include "MatrixResizer.h"
@@ -516,50 +517,30 @@ MatrixSelector::getSelection(EventSelection *&selection,
 
     // get the selections
     //
-    QList<QGraphicsItem *> l = m_selectionRect->collidingItems
-        (Qt::IntersectsItemShape);
-
-    // This is a nasty optimisation, just to avoid re-creating the
-    // selection if the items we span are unchanged.  It's not very
-    // effective, either, because the colliding items returned
-    // includes things like the horizontal and vertical background
-    // lines -- and so it changes often: every time we cross a line.
-    // More thought needed.
-
-    // It might be better to use the event properties (i.e. time and
-    // pitch) to calculate this "from first principles" rather than
-    // doing it graphically.  That might also be helpful to avoid us
-    // dragging off the logical edges of the scene.
-
-    // (Come to think of it, though, that would be troublesome just
-    // because of the requirement to use all events that have any part
-    // inside the selection.  Quickly finding all events that start
-    // within a time range is trivial, finding all events that
-    // intersect one is more of a pain.)
+    const std::vector<MatrixElement *> l =
+            m_scene->getNoteLayer()->elementsIn(
+                    m_selectionRect->sceneBoundingRect());
+
+    // Avoid re-creating the selection if the notes we span are
+    // unchanged.
     if (l == m_previousCollisions) return false;
     m_previousCollisions = l;
 
-    if (!l.empty()) {
-        for (int i = 0; i < l.size(); ++i) {
-            QGraphicsItem *item = l[i];
-            MatrixElement *element = MatrixElement::getMatrixElement(item);
-            if (element) {
-                // The selection should only contain elements from the
-                // current segment however for preview play we should
-                // have all the elements
-                if (element->getSegment() ==
-                    element->getScene()->getCurrentSegment()) {
-                    selection->addEvent(element->event());
-                } else {
-                    // previewEvents contains events from other
-                    // segments which should also be preview played
-                    if (previewEvents) {
-                        if (previewEvents->find(element->event()) ==
-                            previewEvents->end()) {
-                            (*previewEvents)[element->event()] =
-                                element->getSegment();
-                        }
-                    }
+    for (MatrixElement *element : l) {
+        // The selection should only contain elements from the
+        // current segment however for preview play we should
+        // have all the elements
+        if (element->getSegment() ==
+            element->getScene()->getCurrentSegment()) {
+            selection->addEvent(element->event());
+        } else {
+            // previewEvents contains events from other
+            // segments which should also be preview played
+            if (previewEvents) {
+                if (previewEvents->find(element->event()) ==
+                    previewEvents->end()) {
+                    (*previewEvents)[element->event()] =
+                        element->getSegment();
                 }
             }
         }
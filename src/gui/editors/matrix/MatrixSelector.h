@@ -22,9 +22,10 @@
 #include "MatrixScene.h"
 
 #include <QGraphicsRectItem>
-#include <QList>
 #include <QString>
 
+#include <vector>
+
 
 namespace Rosegarden
 {
@@ -127,7 +128,7 @@ private:
 
     EventSelection *m_selectionToMerge{nullptr};
 
-    QList<QGraphicsItem *> m_previousCollisions;
+    std::vector<MatrixElement *> m_previousCollisions;
 };
 
 
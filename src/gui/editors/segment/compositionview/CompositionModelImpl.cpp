@@ -55,7 +55,7 @@
 #include <QTimer>
 
 #include <math.h>
-#include <algorithm>  // std::lower_bound() and std::min()
+#include <algorithm>  // std::lower_bound(), std::min() and std::sort()
 
 
 namespace Rosegarden
@@ -102,6 +102,8 @@ CompositionModelImpl::CompositionModelImpl(
 
         // Subscribe
         (*i)->addObserver(this);
+
+        indexSegment(*i);
     }
 
     connect(RosegardenMainWindow::self(),
@@ -158,10 +160,10 @@ void CompositionModelImpl::getSegmentRects(
     CompositionColourCache *colourCache =
             CompositionColourCache::getInstance();
 
-    const SegmentMultiSet &segments = m_composition.getSegments();
+    const SegmentVector segments = getSegmentsNear(clipRect);
 
-    // For each segment in the composition
-    for (SegmentMultiSet::const_iterator i = segments.begin();
+    // For each segment that might be in the clip rect
+    for (SegmentVector::const_iterator i = segments.begin();
          i != segments.end();
          ++i) {
 
@@ -268,10 +270,10 @@ void CompositionModelImpl::getSegmentRects(
 
 ChangingSegmentPtr CompositionModelImpl::getSegmentAt(const QPoint &pos)
 {
-    const SegmentMultiSet &segments = m_composition.getSegments();
+    const SegmentVector segments = getSegmentsNear(QRect(pos, QSize(1, 1)));
 
-    // For each segment in the composition
-    for (SegmentMultiSet::iterator i = segments.begin();
+    // For each segment that might be at pos
+    for (SegmentVector::const_iterator i = segments.begin();
          i != segments.end();
          ++i) {
 
@@ -430,11 +432,150 @@ void CompositionModelImpl::computeRepeatMarks(
     }
 }
 
+// --- Segment Index ------------------------------------------------
+
+void CompositionModelImpl::TrackSegments::sort()
+{
+    for (Entry &entry : entries) {
+        const Segment *segment = entry.segment;
+        entry.startTime = segment->getStartTime();
+        entry.endTime = segment->isRepeating() ?
+                            segment->getRepeatEndTime() :
+                            segment->getEndMarkerTime();
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b)
+              { return a.startTime < b.startTime; });
+
+    maxEndTime.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        maxEndTime[i] = entries[i].endTime;
+        if (i > 0  &&  maxEndTime[i - 1] > maxEndTime[i])
+            maxEndTime[i] = maxEndTime[i - 1];
+    }
+
+    dirty = false;
+}
+
+void CompositionModelImpl::indexSegment(Segment *segment)
+{
+    const TrackId trackId = segment->getTrack();
+    m_indexedSegmentTracks[segment] = trackId;
+
+    TrackSegments &trackSegments = m_segmentIndex[trackId];
+    trackSegments.entries.push_back(TrackSegments::Entry{0, 0, segment});
+    trackSegments.dirty = true;
+}
+
+void CompositionModelImpl::unindexSegment(const Segment *segment)
+{
+    std::map<const Segment *, TrackId>::iterator trackIter =
+            m_indexedSegmentTracks.find(segment);
+    if (trackIter == m_indexedSegmentTracks.end())
+        return;
+
+    TrackSegments &trackSegments = m_segmentIndex[trackIter->second];
+    std::vector<TrackSegments::Entry> &entries = trackSegments.entries;
+
+    for (std::vector<TrackSegments::Entry>::iterator i = entries.begin();
+         i != entries.end();
+         ++i) {
+        if (i->segment == segment) {
+            entries.erase(i);
+            break;
+        }
+    }
+    trackSegments.dirty = true;
+
+    m_indexedSegmentTracks.erase(trackIter);
+}
+
+void CompositionModelImpl::segmentIndexChanged(const Segment *segment)
+{
+    std::map<const Segment *, TrackId>::const_iterator trackIter =
+            m_indexedSegmentTracks.find(segment);
+    if (trackIter == m_indexedSegmentTracks.end())
+        return;
+
+    // The repeats of the other segments on the track may change too.
+    m_segmentIndex[trackIter->second].dirty = true;
+}
+
+void CompositionModelImpl::invalidateSegmentIndex()
+{
+    for (SegmentIndex::iterator i = m_segmentIndex.begin();
+         i != m_segmentIndex.end();
+         ++i) {
+        i->second.dirty = true;
+    }
+}
+
+CompositionModelImpl::SegmentVector
+CompositionModelImpl::getSegmentsNear(const QRect &rect)
+{
+    SegmentVector segments;
+
+    // Allow for the rounding of the segment rects' edges.
+    const RulerScale *rulerScale = m_grid.getRulerScale();
+    const timeT startTime = rulerScale->getTimeForX(rect.left() - 2);
+    const timeT endTime = rulerScale->getTimeForX(rect.right() + 2);
+
+    // Make sure each segment's rect lies within its track's bin.
+    updateAllTrackHeights();
+
+    const int firstPosition = m_grid.getYBin(rect.top());
+    const int lastPosition = m_grid.getYBin(rect.bottom());
+
+    for (int position = firstPosition; position <= lastPosition; ++position) {
+
+        const Track *track = m_composition.getTrackByPosition(position);
+        if (!track)
+            continue;
+
+        SegmentIndex::iterator indexIter = m_segmentIndex.find(track->getId());
+        if (indexIter == m_segmentIndex.end())
+            continue;
+
+        TrackSegments &trackSegments = indexIter->second;
+        if (trackSegments.dirty)
+            trackSegments.sort();
+
+        // Skip the segments that all end before the range.
+        size_t i = std::lower_bound(trackSegments.maxEndTime.begin(),
+                                    trackSegments.maxEndTime.end(),
+                                    startTime) -
+                       trackSegments.maxEndTime.begin();
+
+        for ( ; i < trackSegments.entries.size(); ++i) {
+            const TrackSegments::Entry &entry = trackSegments.entries[i];
+            if (entry.startTime > endTime)
+                break;
+            if (entry.endTime >= startTime)
+                segments.push_back(entry.segment);
+        }
+    }
+
+    // Recording segments grow with the pointer rather than with their
+    // end marker.
+    for (Segment *segment : m_recordingSegments) {
+        if (std::find(segments.begin(), segments.end(), segment) ==
+                segments.end())
+            segments.push_back(segment);
+    }
+
+    std::sort(segments.begin(), segments.end(), Segment::SegmentCmp());
+
+    return segments;
+}
+
 void CompositionModelImpl::segmentAdded(const Composition *, Segment *s)
 {
     // Keep tabs on it.
     s->addObserver(this);
 
+    indexSegment(s);
+
     // TrackEditor::commandExecuted() already updates us.  However, it
     // shouldn't.  This is the right thing to do.
     emit needUpdate();
@@ -445,6 +586,8 @@ void CompositionModelImpl::segmentRemoved(const Composition *, Segment *s)
     // Be tidy or else Segment's dtor will complain.
     s->removeObserver(this);
 
+    unindexSegment(s);
+
     deleteCachedPreview(s);
     m_selectedSegments.erase(s);
     m_recordingSegments.erase(s);
@@ -455,16 +598,21 @@ void CompositionModelImpl::segmentRemoved(const Composition *, Segment *s)
 }
 
 void CompositionModelImpl::segmentTrackChanged(
-        const Composition *, Segment *, TrackId /*tid*/)
+        const Composition *, Segment *s, TrackId /*tid*/)
 {
+    unindexSegment(s);
+    indexSegment(s);
+
     // TrackEditor::commandExecuted() already updates us.  However, it
     // shouldn't.  This is the right thing to do.
     emit needUpdate();
 }
 
 void CompositionModelImpl::segmentStartChanged(
-        const Composition *, Segment *, timeT)
+        const Composition *, Segment *s, timeT)
 {
+    segmentIndexChanged(s);
+
     // Ignore high-frequency updates during record.
     // This routine gets hit really hard when recording and
     // notes are coming in.
@@ -477,8 +625,10 @@ void CompositionModelImpl::segmentStartChanged(
 }
 
 void CompositionModelImpl::segmentEndMarkerChanged(
-        const Composition *, Segment *, bool)
+        const Composition *, Segment *s, bool)
 {
+    segmentIndexChanged(s);
+
     // Ignore high-frequency updates during record.
     // This routine gets hit really hard when recording.
     // Just holding down a single note results in 50 calls
@@ -492,8 +642,10 @@ void CompositionModelImpl::segmentEndMarkerChanged(
 }
 
 void CompositionModelImpl::segmentRepeatChanged(
-        const Composition *, Segment *, bool)
+        const Composition *, Segment *s, bool)
 {
+    segmentIndexChanged(s);
+
     // TrackEditor::commandExecuted() already updates us.  However, it
     // shouldn't.  This is the right thing to do.
     emit needUpdate();
@@ -503,6 +655,9 @@ void CompositionModelImpl::endMarkerTimeChanged(const Composition *, bool)
 {
     // The size of the composition has changed.
 
+    // Repeating segments may repeat up to the end.
+    invalidateSegmentIndex();
+
     // TrackEditor::commandExecuted() already updates us.  However, it
     // shouldn't.  This is the right thing to do.
     emit needSizeUpdate();
@@ -591,6 +746,10 @@ void CompositionModelImpl::slotDocumentAboutToChange()
         // Unsubscribe
         (*i)->removeObserver(this);
     }
+
+    // We won't hear about these segments going away.
+    m_segmentIndex.clear();
+    m_indexedSegmentTracks.clear();
 }
 
 // --- Changing -----------------------------------------------------
@@ -1135,6 +1294,7 @@ CompositionModelImpl::slotDocumentModified(bool)
     //     This results in duplicate updates.  The other updates
     //     need to be removed and only this one should remain.
     deleteCachedPreviews();
+    invalidateSegmentIndex();
     emit needUpdate();
 }
 
@@ -1236,12 +1396,12 @@ void CompositionModelImpl::setSelectionRect(const QRect &rect)
     m_previousTmpSelectedSegments = m_tmpSelectedSegments;
     m_tmpSelectedSegments.clear();
 
-    const SegmentMultiSet &segments = m_composition.getSegments();
+    const SegmentVector segments = getSegmentsNear(m_selectionRect);
 
     QRect updateRect = m_selectionRect;
 
-    // For each segment in the composition
-    for (SegmentMultiSet::iterator i = segments.begin();
+    // For each segment that might be in the rubber band
+    for (SegmentVector::const_iterator i = segments.begin();
          i != segments.end();
          ++i) {
 
@@ -1271,10 +1431,10 @@ void CompositionModelImpl::setSelectionRect(const QRect &rect)
 
 void CompositionModelImpl::finalizeSelectionRect()
 {
-    const SegmentMultiSet &segments = m_composition.getSegments();
+    const SegmentVector segments = getSegmentsNear(m_selectionRect);
 
-    // For each segment in the composition
-    for (SegmentMultiSet::const_iterator i = segments.begin();
+    // For each segment that might be in the rubber band
+    for (SegmentVector::const_iterator i = segments.begin();
          i != segments.end();
          ++i) {
 
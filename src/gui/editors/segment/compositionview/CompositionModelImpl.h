@@ -479,6 +479,61 @@ private:
      */
     void computeRepeatMarks(const Segment &, SegmentRect &) const;
 
+    // --- Segment Index ----------------------------------
+
+    /// The segments on one track, for finding those in a time range.
+    /**
+     * Painting and hit testing only need the segments in a small area
+     * of the view.  Rather than computing the SegmentRect of every
+     * segment in the composition, the segments are indexed by track and
+     * time, which, unlike the rects, do not change with zoom.  The index
+     * is maintained from the CompositionObserver notifications.
+     */
+    struct TrackSegments
+    {
+        TrackSegments() : dirty(true)  { }
+
+        struct Entry
+        {
+            timeT startTime;
+            /// Including repeats.
+            timeT endTime;
+            Segment *segment;
+        };
+        /// In start time order unless dirty.
+        std::vector<Entry> entries;
+        /// maxEndTime[n] is the latest endTime in entries[0..n].
+        std::vector<timeT> maxEndTime;
+
+        /// The times need reading and sorting before a search.
+        bool dirty;
+
+        /// Re-read the times and sort.
+        void sort();
+    };
+
+    typedef std::map<TrackId, TrackSegments> SegmentIndex;
+    SegmentIndex m_segmentIndex;
+
+    /// The track each segment was indexed under.
+    std::map<const Segment *, TrackId> m_indexedSegmentTracks;
+
+    void indexSegment(Segment *);
+    void unindexSegment(const Segment *);
+    /// Mark the track the segment was indexed under for re-sorting.
+    void segmentIndexChanged(const Segment *);
+    /// Mark every track for re-sorting.
+    void invalidateSegmentIndex();
+
+    typedef std::vector<Segment *> SegmentVector;
+
+    /// The segments whose rects might intersect rect.
+    /**
+     * In composition order.  The caller still needs to check the
+     * actual rects.
+     */
+    SegmentVector getSegmentsNear(const QRect &rect);
+
     // --- Selection --------------------------------------
 
     SegmentSelection m_selectedSegments;
@@ -47,6 +47,7 @@
 #include <QColor>
 #include <QEvent>
 #include <QFont>
+#include <QFontDatabase>
 #include <QFontMetrics>
 #include <QMessageBox>
 #include <QMouseEvent>
@@ -58,12 +59,15 @@
 //#include <QScrollBar>
 #include <QSettings>
 #include <QSize>
+#include <QRunnable>
 #include <QString>
+#include <QThread>
 #include <QTimer>
 #include <QVector>
 #include <QWidget>
 
-#include <algorithm>  // std::min, std::max, std::find
+#include <algorithm>  // std::min, std::max, std::find, std::sort
+#include <vector>
 
 
 namespace Rosegarden
@@ -84,14 +88,12 @@ CompositionView::CompositionView(RosegardenDocument *doc,
                                  QWidget *parent) :
     RosegardenScrollView(parent),
     m_model(model),
-    m_lastContentsX(0),
-    m_lastContentsY(0),
-    m_segmentsRefresh(0, 0, viewport()->width(), viewport()->height()),
-    //m_backgroundPixmap(),
+    //m_segmentsTiles(),
+    //m_segmentsTilePool(),
+    //m_backgroundImage(),
     //m_trackDividerColor(),
     m_showPreviews(false),
     m_showSegmentLabels(true),
-    m_segmentsLayer(viewport()->width(), viewport()->height()),
     //m_audioPreview(),
     //m_notationPreview(),
     //m_updateTimer(),
@@ -141,11 +143,15 @@ CompositionView::CompositionView(RosegardenDocument *doc,
             "true").toBool()) {
 
         if (Preferences::getTheme() == Preferences::DarkTheme)
-            m_backgroundPixmap = IconLoader::loadPixmap("bg-paper-black");
+            m_backgroundImage =
+                    IconLoader::loadPixmap("bg-paper-black").toImage();
         else
-            m_backgroundPixmap = IconLoader::loadPixmap("bg-segmentcanvas");
+            m_backgroundImage =
+                    IconLoader::loadPixmap("bg-segmentcanvas").toImage();
     }
 
+    m_segmentsTilePool.setMaxThreadCount(QThread::idealThreadCount());
+
     slotUpdateSize();
 
     // *** Connections
@@ -490,14 +496,6 @@ void CompositionView::resizeEvent(QResizeEvent *e)
     // Resize the contents if needed.
     slotUpdateSize();
 
-    // If the viewport has grown larger than the segments layer
-    if (e->size().width() > m_segmentsLayer.width()  ||
-        e->size().height() > m_segmentsLayer.height()) {
-
-        // Reallocate the segments layer
-        m_segmentsLayer = QPixmap(e->size().width(), e->size().height());
-    }
-
     updateAll();
 }
 
@@ -516,25 +514,40 @@ void CompositionView::drawAll()
 {
     //Profiler profiler("CompositionView::drawAll()");
 
-    // Scroll and refresh the segments layer.
-    scrollSegmentsLayer();
+    // Render any tiles of the segments layer that we don't have yet.
+    updateSegmentsTiles();
 
-    // ??? Try putting the artifacts on their own layer pixmap.  This might
-    //     simplify the code a bit.  Should also allow us to avoid
-    //     redrawing the artifacts just because the segments need to
-    //     be updated.  This might help the recording use case a little.
     // ??? There are two key use cases that need to be optimized.
     //     The first is recording.  This is the most important as it uses
     //     a lot of CPU (and shouldn't).  The second is auto-scrolling.
     //     It's not quite as important since it is relatively rare.
 
-    // Copy the entire segments layer to the viewport
+    // Copy the segments layer tiles to the viewport.
+
+    const int cx = contentsX();
+    const int cy = contentsY();
 
-    QRect viewportRect = viewport()->rect();
-    // Copy the segments to the viewport.
     QPainter viewportPainter(viewport());
-    viewportPainter.drawPixmap(
-            viewportRect, m_segmentsLayer, viewportRect);
+    // Switch to contents coords.
+    viewportPainter.translate(-cx, -cy);
+
+    const int firstColumn = cx / segmentsTileSize;
+    const int lastColumn = (cx + viewport()->width() - 1) / segmentsTileSize;
+    const int firstRow = cy / segmentsTileSize;
+    const int lastRow = (cy + viewport()->height() - 1) / segmentsTileSize;
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const SegmentsTileKey key(column, row);
+            SegmentsTileMap::const_iterator tileIter =
+                    m_segmentsTiles.find(key);
+            if (tileIter == m_segmentsTiles.end())
+                continue;
+            viewportPainter.drawImage(segmentsTileRect(key).topLeft(),
+                                      tileIter->second);
+        }
+    }
+
     viewportPainter.end();
 
     // Redraw all of the artifacts on the viewport.
@@ -542,156 +555,240 @@ void CompositionView::drawAll()
     drawArtifacts();
 }
 
-void CompositionView::scrollSegmentsLayer()
+void CompositionView::segmentsNeedRefresh()
 {
-    //Profiler profiler("CompositionView::scrollSegmentsLayer()");
+    m_segmentsTiles.clear();
+}
 
-    // Portion of the segments layer that needs to be redrawn.
-    QRect refreshRect = m_segmentsRefresh;
+void CompositionView::segmentsNeedRefresh(const QRect &r)
+{
+    const QRect rect = r.normalized();
 
-    const int w = viewport()->width();
-    const int h = viewport()->height();
-    const int cx = contentsX();
-    const int cy = contentsY();
-    // The entire viewport in contents coords.
-    const QRect viewportContentsRect(cx, cy, w, h);
+    // For each tile, drop it if it overlaps.
+    for (SegmentsTileMap::iterator tileIter = m_segmentsTiles.begin();
+         tileIter != m_segmentsTiles.end(); ) {
+        if (segmentsTileRect(tileIter->first).intersects(rect))
+            tileIter = m_segmentsTiles.erase(tileIter);
+        else
+            ++tileIter;
+    }
+}
 
-    bool scroll = (cx != m_lastContentsX || cy != m_lastContentsY);
+/// Draws one tile of the segments layer.
+class CompositionView::SegmentsTileJob : public QRunnable
+{
+public:
+    SegmentsTileJob(const CompositionView *view,
+                    const SegmentsTileKey &key,
+                    QImage *image,
+                    const CompositionModelImpl::SegmentRects *segmentRects,
+                    const CompositionModelImpl::YCoordVector *trackYCoords) :
+        m_view(view),
+        m_tileRect(segmentsTileRect(key)),
+        m_image(image),
+        m_segmentRects(segmentRects),
+        m_trackYCoords(trackYCoords)
+    { }
+
+    void run() override
+    {
+        QPainter painter(m_image);
+        // Switch to contents coords.
+        painter.translate(-m_tileRect.topLeft());
+        m_view->drawSegments(
+                &painter, m_tileRect, *m_segmentRects, *m_trackYCoords);
+    }
 
-    if (scroll) {
+private:
+    const CompositionView *m_view;
+    QRect m_tileRect;
+    QImage *m_image;
+    const CompositionModelImpl::SegmentRects *m_segmentRects;
+    const CompositionModelImpl::YCoordVector *m_trackYCoords;
+};
 
-        // ??? All this scroll optimization saves about 7% cpu on my
-        //     machine when auto-scrolling the BWV1048 example.  Doesn't
-        //     seem worth the extra code.
+void CompositionView::updateSegmentsTiles()
+{
+    //Profiler profiler("CompositionView::updateSegmentsTiles()");
 
-        if (refreshRect.isValid()) {
+    const int cx = contentsX();
+    const int cy = contentsY();
 
-            // If we've scrolled and there was an existing refresh
-            // rect, we can't be sure whether the refresh rect
-            // predated or postdated the internal update of scroll
-            // location.  Cut our losses and refresh everything.
+    const int firstColumn = cx / segmentsTileSize;
+    const int lastColumn = (cx + viewport()->width() - 1) / segmentsTileSize;
+    const int firstRow = cy / segmentsTileSize;
+    const int lastRow = (cy + viewport()->height() - 1) / segmentsTileSize;
 
-            refreshRect = viewportContentsRect;
+    // Find the visible tiles we don't have.
 
-        } else {
+    std::vector<SegmentsTileKey> missingTiles;
+    QRect missingRect;
 
-            // No existing refresh rect: we only need to handle the
-            // scroll.
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const SegmentsTileKey key(column, row);
+            if (m_segmentsTiles.find(key) != m_segmentsTiles.end())
+                continue;
+            missingTiles.push_back(key);
+            missingRect |= segmentsTileRect(key);
+        }
+    }
 
-            // Horizontal scroll distance
-            int dx = m_lastContentsX - cx;
+    // Nothing to do?  Bail.
+    if (missingTiles.empty())
+        return;
 
-            // If we're scrolling horizontally
-            if (dx != 0) {
+    // *** Get Segment and Preview Rectangles
 
-                // If we're scrolling less than the entire viewport
-                if (abs(dx) < w) {
+    // The model's caches are only safe to use from this thread, so
+    // everything the tiles need is gathered up front.
 
-                    // Scroll the segments layer sideways
-                    m_segmentsLayer.scroll(dx, 0, m_segmentsLayer.rect());
+    // Assume we aren't going to show previews.
+    CompositionModelImpl::NotationPreviewRanges *notationPreview = nullptr;
+    CompositionModelImpl::AudioPreviews *audioPreview = nullptr;
 
-                    // Add the part that was exposed to the refreshRect
-                    if (dx < 0) {
-                        refreshRect |= QRect(cx + w + dx, cy, -dx, h);
-                    } else {
-                        refreshRect |= QRect(cx, cy, dx, h);
-                    }
+    if (m_showPreviews) {
+        // Indicate that we want previews.
+        notationPreview = &m_notationPreview;
+        audioPreview = &m_audioPreview;
+    }
 
-                } else {  // We've scrolled more than the entire viewport
+    // Clear the previews.
+    // ??? Move this clearing into CompositionModelImpl::getSegmentRects()?
+    m_notationPreview.clear();
+    m_audioPreview.clear();
 
-                    // Refresh everything
-                    refreshRect = viewportContentsRect;
-                }
-            }
-
-            // Vertical scroll distance
-            int dy = m_lastContentsY - cy;
+    CompositionModelImpl::SegmentRects segmentRects;
 
-            // If we're scrolling vertically and the sideways scroll didn't
-            // result in a need to refresh everything,
-            if (dy != 0  &&  refreshRect != viewportContentsRect) {
+    // Fetch segment rectangles and (optionally) previews
+    m_model->getSegmentRects(
+            missingRect, &segmentRects, notationPreview, audioPreview);
+
+    // Fetch track Y coordinates.  We expand the rectangle slightly
+    // because we are drawing a rather wide track divider, so we need
+    // enough divider coords to do the drawing even though the center of
+    // the divider might be slightly outside of the tile.
+    const CompositionModelImpl::YCoordVector trackYCoords =
+            m_model->getTrackYCoords(missingRect.adjusted(0, -1, 0, +1));
+
+    // *** Draw the tiles
+
+    std::vector<QImage *> images;
+    for (const SegmentsTileKey &key : missingTiles) {
+        QImage &image = m_segmentsTiles[key];
+        image = QImage(segmentsTileSize, segmentsTileSize,
+                       QImage::Format_RGB32);
+        images.push_back(&image);
+    }
 
-                // If we're scrolling less than the entire viewport
-                if (abs(dy) < h) {
+    // The tiles have labels, and some platforms can only draw text on
+    // the GUI thread.  A single tile isn't worth the trip anyway.
+    const bool threaded = missingTiles.size() > 1  &&
+            QFontDatabase::supportsThreadedFontRendering();
+
+    if (!threaded) {
+        for (size_t i = 0; i < missingTiles.size(); ++i) {
+            SegmentsTileJob job(
+                    this, missingTiles[i], images[i], &segmentRects,
+                    &trackYCoords);
+            job.run();
+        }
+    } else {
+        // The jobs only read from this object and the gathered data, so
+        // there's no need to process events while we wait.  Not that it
+        // would be safe to do so during a paint.
+        for (size_t i = 0; i < missingTiles.size(); ++i) {
+            m_segmentsTilePool.start(new SegmentsTileJob(
+                    this, missingTiles[i], images[i], &segmentRects,
+                    &trackYCoords));
+        }
+        m_segmentsTilePool.waitForDone();
+    }
 
-                    // Scroll the segments layer vertically
-                    m_segmentsLayer.scroll(0, dy, m_segmentsLayer.rect());
+    pruneSegmentsTiles();
+}
 
-                    // Add the part that was exposed to the refreshRect
-                    if (dy < 0) {
-                        refreshRect |= QRect(cx, cy + h + dy, w, -dy);
-                    } else {
-                        refreshRect |= QRect(cx, cy, w, dy);
-                    }
+void CompositionView::pruneSegmentsTiles()
+{
+    qint64 bytes = 0;
+    for (const SegmentsTileMap::value_type &tile : m_segmentsTiles) {
+        bytes += qint64(tile.second.bytesPerLine()) * tile.second.height();
+    }
 
-                } else {  // We've scrolled more than the entire viewport
+    if (bytes <= segmentsTilesMaxBytes)
+        return;
 
-                    // Refresh everything
-                    refreshRect = viewportContentsRect;
-                }
-            }
-        }
+    // The tiles that the viewport can overlap are always kept, however
+    // large the display.
+    const size_t columns = viewport()->width() / segmentsTileSize + 2;
+    const size_t rows = viewport()->height() / segmentsTileSize + 2;
+    const size_t visibleTiles = columns * rows;
+
+    const QPoint center(contentsX() + viewport()->width() / 2,
+                        contentsY() + viewport()->height() / 2);
+
+    // Distance from the center of the viewport and tile.
+    typedef std::pair<int, SegmentsTileKey> TileDistance;
+    std::vector<TileDistance> distances;
+    distances.reserve(m_segmentsTiles.size());
+
+    for (const SegmentsTileMap::value_type &tile : m_segmentsTiles) {
+        distances.push_back(TileDistance(
+                (segmentsTileRect(tile.first).center() - center).
+                        manhattanLength(),
+                tile.first));
     }
 
-    m_lastContentsX = cx;
-    m_lastContentsY = cy;
+    // Keep the nearest, drop the rest.
+    std::sort(distances.begin(), distances.end());
+    qint64 keptBytes = 0;
+    for (size_t i = 0; i < distances.size(); ++i) {
+        SegmentsTileMap::iterator tile =
+                m_segmentsTiles.find(distances[i].second);
+        const qint64 tileBytes =
+                qint64(tile->second.bytesPerLine()) * tile->second.height();
+
+        if (i < visibleTiles  ||
+            keptBytes + tileBytes <= segmentsTilesMaxBytes) {
+            keptBytes += tileBytes;
+            continue;
+        }
 
-    // If we need to redraw the segments layer, do so.
-    if (refreshRect.isValid()) {
-        // Refresh the segments layer
-        drawSegments(refreshRect);
-        m_segmentsRefresh = QRect();
+        m_segmentsTiles.erase(tile);
     }
 }
 
-void CompositionView::drawSegments(const QRect &clipRect)
+void CompositionView::drawSegments(
+        QPainter *painter, const QRect &clipRect,
+        const CompositionModelImpl::SegmentRects &allSegmentRects,
+        const CompositionModelImpl::YCoordVector &trackYCoords) const
 {
     //Profiler profiler("CompositionView::drawSegments(clipRect)");
 
-    QPainter segmentsLayerPainter(&m_segmentsLayer);
-    // Switch to contents coords.
-    segmentsLayerPainter.translate(-contentsX(), -contentsY());
-
     // *** Draw the background
 
-    if (!m_backgroundPixmap.isNull()) {
-        QPoint offset(
-                clipRect.x() % m_backgroundPixmap.height(),
-                clipRect.y() % m_backgroundPixmap.width());
-        segmentsLayerPainter.drawTiledPixmap(
-                clipRect, m_backgroundPixmap, offset);
+    if (!m_backgroundImage.isNull()) {
+        // The texture is anchored to the contents origin so that the
+        // tiles line up.
+        painter->fillRect(clipRect, QBrush(m_backgroundImage));
     } else {
         if (Preferences::getTheme() == Preferences::DarkTheme)
-            segmentsLayerPainter.fillRect(clipRect, Qt::black);
+            painter->fillRect(clipRect, Qt::black);
         else
-            segmentsLayerPainter.eraseRect(clipRect);
+            painter->eraseRect(clipRect);
     }
 
     // *** Draw the track dividers
 
-    drawTrackDividers(&segmentsLayerPainter, clipRect);
-
-    // *** Get Segment and Preview Rectangles
-
-    // Assume we aren't going to show previews.
-    CompositionModelImpl::NotationPreviewRanges *notationPreview = nullptr;
-    CompositionModelImpl::AudioPreviews *audioPreview = nullptr;
-
-    if (m_showPreviews) {
-        // Clear the previews.
-        // ??? Move this clearing into CompositionModelImpl::getSegmentRects()?
-        m_notationPreview.clear();
-        m_audioPreview.clear();
-
-        // Indicate that we want previews.
-        notationPreview = &m_notationPreview;
-        audioPreview = &m_audioPreview;
-    }
+    drawTrackDividers(painter, clipRect, trackYCoords);
 
+    // The segment rects were gathered for all of the tiles being drawn.
+    // Only look at the ones in this tile.
     CompositionModelImpl::SegmentRects segmentRects;
-
-    // Fetch segment rectangles and (optionally) previews
-    m_model->getSegmentRects(clipRect, &segmentRects, notationPreview, audioPreview);
+    for (const SegmentRect &segmentRect : allSegmentRects) {
+        if (segmentRect.rect.intersects(clipRect))
+            segmentRects.push_back(segmentRect);
+    }
 
     // *** Draw Segment Rectangles
 
@@ -699,20 +796,20 @@ void CompositionView::drawSegments(const QRect &clipRect)
     for (CompositionModelImpl::SegmentRects::const_iterator i = segmentRects.begin();
          i != segmentRects.end(); ++i) {
 
-        drawCompRect(&segmentsLayerPainter, clipRect, *i);
+        drawCompRect(painter, clipRect, *i);
     }
 
-    drawIntersections(&segmentsLayerPainter, clipRect, segmentRects);
+    drawIntersections(painter, clipRect, segmentRects);
 
     // *** Draw Segment Previews
 
     if (m_showPreviews) {
         // We'll be modifying the transform.  save()/restore() to be safe.
-        segmentsLayerPainter.save();
+        painter->save();
 
         // Audio Previews
 
-        drawAudioPreviews(&segmentsLayerPainter, clipRect);
+        drawAudioPreviews(painter, clipRect);
 
         // Notation Previews
 
@@ -727,17 +824,22 @@ void CompositionView::drawSegments(const QRect &clipRect)
             const CompositionModelImpl::NotationPreviewRange &notationPreviewRange =
                     *notationPreviewIter;
 
+            // The part of the tile this segment's preview could be in.
+            const QRect previewClipRect = clipRect.translated(
+                    -notationPreviewRange.moveXOffset,
+                    -notationPreviewRange.segmentTop);
+
             QColor color = notationPreviewRange.color.isValid() ?
                            notationPreviewRange.color : defaultColor;
 
             // translate() calls are cumulative, so we need to be able to get
             // back to where we were.  Note that resetTransform() would be
             // too extreme as it would reverse the contents translation that
-            // is present in segmentsLayerPainter at this point in time.
-            segmentsLayerPainter.save();
+            // is present in the painter at this point in time.
+            painter->save();
             // Adjust the coordinate system to account for any segment
             // move offset and the vertical position of the segment.
-            segmentsLayerPainter.translate(
+            painter->translate(
                     notationPreviewRange.moveXOffset,
                     notationPreviewRange.segmentTop);
 
@@ -755,15 +857,19 @@ void CompositionView::drawSegments(const QRect &clipRect)
                 // events.  This is in keeping with the old appearance.
                 eventRect.adjust(0,0,1,1);
 
+                // Belongs to another tile?  Try the next.
+                if (!eventRect.intersects(previewClipRect))
+                    continue;
+
                 // Per the Qt docs, fillRect() should be faster than
                 // drawRect().  In practice, a small improvement was noted.
-                segmentsLayerPainter.fillRect(eventRect, color);
+                painter->fillRect(eventRect, color);
             }
             // Restore the transformation.
-            segmentsLayerPainter.restore();
+            painter->restore();
         }
 
-        segmentsLayerPainter.restore();
+        painter->restore();
     }
 
     // *** Draw Segment Labels
@@ -773,7 +879,7 @@ void CompositionView::drawSegments(const QRect &clipRect)
         for (CompositionModelImpl::SegmentRects::const_iterator i = segmentRects.begin();
              i != segmentRects.end(); ++i) {
 
-            drawCompRectLabel(&segmentsLayerPainter, *i);
+            drawCompRectLabel(painter, *i);
         }
     }
 }
@@ -856,16 +962,9 @@ void CompositionView::drawArtifacts()
 }
 
 void CompositionView::drawTrackDividers(
-        QPainter *segmentsLayerPainter, const QRect &clipRect)
+        QPainter *segmentsLayerPainter, const QRect &clipRect,
+        const CompositionModelImpl::YCoordVector &trackYCoords) const
 {
-    // Fetch track Y coordinates within the clip rectangle.  We expand the
-    // clip rectangle slightly because we are drawing a rather wide track
-    // divider, so we need enough divider coords to do the drawing even
-    // though the center of the divider might be slightly outside of the
-    // viewport.
-    CompositionModelImpl::YCoordVector trackYCoords =
-            m_model->getTrackYCoords(clipRect.adjusted(0,-1,0,+1));
-
     // Nothing to do?  Bail.
     if (trackYCoords.empty())
         return;
@@ -904,7 +1003,7 @@ void CompositionView::drawTrackDividers(
 void CompositionView::drawImage(
         QPainter *painter,
         QPoint dest, const CompositionModelImpl::QImageVector &tileVector,
-        QRect source)
+        QRect source) const
 {
     // ??? This is an awful lot of complexity to accommodate the tiling
     //     of the audio previews.  Why are they tiled?  Can they be
@@ -979,7 +1078,7 @@ void CompositionView::drawImage(
 }
 
 void CompositionView::drawAudioPreviews(
-        QPainter *segmentsLayerPainter, const QRect &clipRect)
+        QPainter *segmentsLayerPainter, const QRect &clipRect) const
 {
     //Profiler profiler("CompositionView::drawAudioPreviews");
 
@@ -1015,7 +1114,7 @@ void CompositionView::drawCompRect(
         QPainter *painter,
         const QRect &clipRect,
         const SegmentRect &rect,
-        int intersectLvl)
+        int intersectLvl) const
 {
     // Non repeating case, just draw the segment rect.
     if (!rect.isRepeating()) {
@@ -1070,7 +1169,7 @@ void CompositionView::drawCompRect(
 }
 
 void CompositionView::drawCompRectLabel(
-        QPainter *painter, const SegmentRect &rect)
+        QPainter *painter, const SegmentRect &rect) const
 {
     // No label?  Bail.
     if (rect.label.isEmpty())
@@ -1114,7 +1213,7 @@ void CompositionView::drawCompRectLabel(
 }
 
 void CompositionView::drawRect(QPainter *painter, const QRect &clipRect,
-        const QRect &rect, bool isSelected, int intersectLvl)
+        const QRect &rect, bool isSelected, int intersectLvl) const
 {
     RG_DEBUG << "drawRect" << rect << clipRect;
     // If the rect isn't in the clip rect, bail.
@@ -1166,7 +1265,7 @@ private:
 
 void CompositionView::drawIntersections(
         QPainter *painter, const QRect &clipRect,
-        const CompositionModelImpl::SegmentRects &rects)
+        const CompositionModelImpl::SegmentRects &rects) const
 {
     // Intersections are most noticeable when recording over existing
     // segments.  They also play a part when moving a segment over top
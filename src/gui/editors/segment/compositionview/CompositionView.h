@@ -24,13 +24,18 @@
 #include "base/TimeT.h"  // timeT
 
 #include <QColor>
+#include <QImage>
 #include <QPen>
 #include <QPixmap>
 #include <QPoint>
 #include <QRect>
 #include <QString>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <map>
+#include <utility>
+
 
 class QWidget;
 class QWheelEvent;
@@ -426,52 +431,75 @@ private:
 
     /// Deferred update of the segments within the entire viewport.
     /**
-     * This will cause scrollSegmentsLayer() to refresh the entire
-     * segments layer (m_segmentsLayer) the next time it is called.
-     * This in turn will cause drawAll() to redraw the entire
-     * viewport the next time it is called.
+     * This throws away the whole segments layer (m_segmentsTiles) so
+     * that drawAll() redraws everything the next time it is called.
      */
-    void segmentsNeedRefresh() {
-        m_segmentsRefresh.setRect(contentsX(), contentsY(), viewport()->width(), viewport()->height());
-    }
+    void segmentsNeedRefresh();
 
     /// Deferred update of the segments within the specified rect.
     /**
-     * This will cause the given portion of the viewport to be refreshed
-     * the next time drawAll() is called.
+     * This throws away the tiles of the segments layer that overlap r
+     * so that drawAll() redraws them the next time it is called.
      */
-    void segmentsNeedRefresh(const QRect &r) {
-        m_segmentsRefresh |=
-            (QRect(contentsX(), contentsY(), viewport()->width(), viewport()->height())
-             & r);
-    }
+    void segmentsNeedRefresh(const QRect &r);
+
+    /// Width and height of a segments layer tile in pixels.
+    static constexpr int segmentsTileSize = 256;
 
-    /// Scroll and refresh the segment layer (m_segmentsLayer) if needed.
+    /// Column and row of a segments layer tile.
+    typedef std::pair<int, int> SegmentsTileKey;
+    /// Rendered tiles of the segments layer, in contents coords.
     /**
-     * Used by drawAll().
+     * Only tiles that are up to date are kept.  A tile that is scrolled
+     * away from is kept until the cache gets too large (see
+     * pruneSegmentsTiles()) so that scrolling back doesn't cost anything.
+     *
+     * @see drawAll() and updateSegmentsTiles()
      */
-    void scrollSegmentsLayer();
-    int m_lastContentsX;
-    int m_lastContentsY;
+    typedef std::map<SegmentsTileKey, QImage> SegmentsTileMap;
+    SegmentsTileMap m_segmentsTiles;
 
-    /// Portion of the viewport that needs segments refreshed.
+    static QRect segmentsTileRect(const SegmentsTileKey &key) {
+        return QRect(key.first * segmentsTileSize,
+                     key.second * segmentsTileSize,
+                     segmentsTileSize, segmentsTileSize);
+    }
+
+    /// Render the tiles of the viewport that aren't in m_segmentsTiles.
     /**
-     * Used only by scrollSegmentsLayer() to limit work done redrawing
-     * the segment rectangles.
+     * The segment rects, previews and track dividers are gathered from
+     * the model here, then the tiles are drawn on m_segmentsTilePool.
+     * Used by drawAll().
      */
-    QRect m_segmentsRefresh;
+    void updateSegmentsTiles();
+    class SegmentsTileJob;
+    QThreadPool m_segmentsTilePool;
+
+    /// Memory for m_segmentsTiles.  The tiles in view are kept regardless.
+    static constexpr qint64 segmentsTilesMaxBytes = 32 * 1024 * 1024;
+    /// Drop the tiles furthest from the viewport when they take too much
+    /// memory.
+    void pruneSegmentsTiles();
 
-    /// Draw the segments on the m_segmentsLayer.
+    /// Draw the segments within clipRect on painter.
     /**
-     * Draws the background then calls drawSegments() to draw the segments on the
-     * segments layer (m_segmentsLayer).  Used by
-     * scrollSegmentsLayer().
+     * Draws the background, the track dividers, the segments and their
+     * previews and labels.  Runs on the m_segmentsTilePool threads
+     * where the platform supports threaded font rendering, so
+     * everything it needs from the model is passed in or has been
+     * gathered into m_notationPreview and m_audioPreview beforehand.
      */
-    void drawSegments(const QRect &);
-    QPixmap m_backgroundPixmap;
+    void drawSegments(QPainter *painter, const QRect &clipRect,
+                      const CompositionModelImpl::SegmentRects &segmentRects,
+                      const CompositionModelImpl::YCoordVector &trackYCoords)
+            const;
+    /// Tiled by drawSegments().  A QImage since it is used off-thread.
+    QImage m_backgroundImage;
 
     /// Draw the track dividers.
-    void drawTrackDividers(QPainter *segmentsLayerPainter, const QRect &clipRect);
+    void drawTrackDividers(
+            QPainter *segmentsLayerPainter, const QRect &clipRect,
+            const CompositionModelImpl::YCoordVector &trackYCoords) const;
     QColor m_trackDividerColor;
 
     /// Draw a rectangle on the given painter.
@@ -482,30 +510,32 @@ private:
      * @see drawCompRect()
      */
     void drawRect(QPainter *painter, const QRect &clipRect, const QRect &rect,
-                  bool isSelected = false, int intersectLvl = 0);
+                  bool isSelected = false, int intersectLvl = 0) const;
 
     /// A version of drawRect() that handles segment repeats.
     void drawCompRect(QPainter *painter, const QRect &clipRect,
-                      const SegmentRect &rect, int intersectLvl = 0);
+                      const SegmentRect &rect, int intersectLvl = 0) const;
 
     /// Used by drawSegments() to draw the segment labels.
     /**
      * @see setShowSegmentLabels()
      */
     void drawCompRectLabel(QPainter *painter,
-                           const SegmentRect &rect);
+                           const SegmentRect &rect) const;
     /// Used by drawCompRectLabel() to draw a halo around a text label.
     std::vector<QPoint> m_haloOffsets;
 
     /// Used by drawSegments() to draw any intersections between rectangles.
     void drawIntersections(QPainter *painter, const QRect &clipRect,
-                           const CompositionModelImpl::SegmentRects &rects);
+                           const CompositionModelImpl::SegmentRects &rects)
+            const;
 
-    /// Draw the previews for audio segments on the m_segmentsLayer.
+    /// Draw the previews for audio segments on a segments layer tile.
     /**
      * Used by drawSegments().
      */
-    void drawAudioPreviews(QPainter *segmentsLayerPainter, const QRect &clipRect);
+    void drawAudioPreviews(QPainter *segmentsLayerPainter,
+                           const QRect &clipRect) const;
 
     /// drawImage() for tiled audio previews.
     /**
@@ -516,25 +546,19 @@ private:
     void drawImage(
             QPainter *painter,
             QPoint dest, const CompositionModelImpl::QImageVector &tileVector,
-            QRect source);
+            QRect source) const;
 
     bool m_showPreviews;
     bool m_showSegmentLabels;
 
-    /// Layer that contains the segment rectangles.
-    /**
-     * @see drawAll() and drawSegments()
-     */
-    QPixmap m_segmentsLayer;
-
-    /// Used by drawSegments().
+    /// Set by updateSegmentsTiles(), used by drawSegments().
     /**
      * This is a std::vector with one element per segment.  Each element
      * (a RectRange) contains a pair of iterators into a vector of
      * preview QRects.
      */
     CompositionModelImpl::NotationPreviewRanges m_notationPreview;
-    /// Set by drawSegments(), used by drawAudioPreviews()
+    /// Set by updateSegmentsTiles(), used by drawAudioPreviews()
     CompositionModelImpl::AudioPreviews m_audioPreview;
 
     /// Drives slotUpdateTimer().
@@ -23,8 +23,8 @@
 #include "misc/Debug.h"
 #include "misc/Strings.h"
 #include "base/AnalysisTypes.h"
+#include "base/ChordAnalysisIndex.h"
 #include "base/Composition.h"
-#include "base/CompositionTimeSliceAdapter.h"
 #include "base/Instrument.h"
 #include "base/NotationTypes.h"
 //#include "base/Profiler.h"
@@ -80,6 +80,7 @@ ChordNameRuler::ChordNameRuler(RulerScale *rulerScale,
         m_currentSegment(nullptr),
         m_studio(nullptr),
         m_chordSegment(nullptr),
+        m_index(nullptr),
         m_fontMetrics(m_boldFont),
         TEXT_FORMAL_X("TextFormalX"),
         TEXT_ACTUAL_X("TextActualX"),
@@ -118,6 +119,7 @@ ChordNameRuler::ChordNameRuler(RulerScale *rulerScale,
         m_currentSegment(nullptr),
         m_studio(nullptr),
         m_chordSegment(nullptr),
+        m_index(nullptr),
         m_fontMetrics(m_boldFont),
         TEXT_FORMAL_X("TextFormalX"),
         TEXT_ACTUAL_X("TextActualX"),
@@ -148,6 +150,7 @@ ChordNameRuler::ChordNameRuler(RulerScale *rulerScale,
 
 ChordNameRuler::~ChordNameRuler()
 {
+    delete m_index;
     delete m_chordSegment;
 }
 
@@ -291,6 +294,8 @@ ChordNameRuler::recalculate(timeT from, timeT to)
 
         for (std::vector<SegmentRefreshMap::iterator>::iterator ei = eraseThese.begin();
                 ei != eraseThese.end(); ++ei) {
+            if (m_index)
+                m_index->removeSegment((*ei)->first);
             m_segments.erase(*ei);
         }
 
@@ -318,6 +323,16 @@ ChordNameRuler::recalculate(timeT from, timeT to)
     if (m_segments.empty())
         return ;
 
+    // The index keeps itself up to date as the segments are edited, so
+    // it only needs to be told about new segments.
+    if (!m_index)
+        m_index = new ChordAnalysisIndex;
+    for (SegmentRefreshMap::iterator i = m_segments.begin();
+            i != m_segments.end(); ++i) {
+        if (!m_index->hasSegment(i->first))
+            m_index->addSegment(i->first);
+    }
+
     SegmentRefreshStatus overallStatus;
     overallStatus.setNeedsRefresh(false);
 
@@ -415,15 +430,9 @@ ChordNameRuler::recalculate(timeT from, timeT to)
         m_chordSegment->erase(i, j);
     }
 
-    SegmentSelection selection;
-    for (SegmentRefreshMap::iterator si = m_segments.begin(); si != m_segments.end();
-            ++si) {
-        selection.insert(si->first);
-    }
-
-    CompositionTimeSliceAdapter adapter(m_composition, &selection, from, to);
     AnalysisHelper helper;
-    helper.labelChords(adapter, *m_chordSegment, m_composition->getNotationQuantizer());
+    helper.labelChords(*m_index, from, to, *m_chordSegment,
+                       m_composition->getNotationQuantizer());
 }
 
 void
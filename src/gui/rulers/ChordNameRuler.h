@@ -39,6 +39,7 @@ namespace Rosegarden
 
 class Studio;
 class Segment;
+class ChordAnalysisIndex;
 class RulerScale;
 class RosegardenDocument;
 class Composition;
@@ -122,6 +123,9 @@ private:
 
     Segment *m_chordSegment;
 
+    /// The notes and keys of the segments in m_segments.
+    ChordAnalysisIndex *m_index;
+
     QFont m_font;
     QFont m_boldFont;
     QFontMetrics m_fontMetrics;
@@ -30,7 +30,9 @@ namespace Rosegarden
 {
 
 
-CompositionMapper::CompositionMapper()
+CompositionMapper::CompositionMapper(
+        const MappedEventBuffer::Window &window) :
+    m_window(window)
 {
     const Composition &composition =
             RosegardenDocument::currentDocument->getComposition();
@@ -108,7 +110,7 @@ CompositionMapper::mapSegment(Segment *segment)
 
     QSharedPointer<SegmentMapper> mapper =
         SegmentMapper::makeMapperForSegment(
-                RosegardenDocument::currentDocument, segment);
+                RosegardenDocument::currentDocument, segment, m_window);
 
     if (mapper)
         m_segmentMappers[segment] = mapper;
@@ -18,6 +18,8 @@
 #ifndef RG_COMPOSITIONMAPPER_H
 #define RG_COMPOSITIONMAPPER_H
 
+#include "gui/seqmanager/MappedEventBuffer.h"
+
 #include <QSharedPointer>
 
 #include <map>
@@ -26,7 +28,6 @@ namespace Rosegarden
 {
 
 class SegmentMapper;
-class MappedEventBuffer;
 class Segment;
 class RosegardenDocument;
 
@@ -46,7 +47,9 @@ public:
      * This takes a RosegardenDocument pointer so that we can use this without
      * having a UI.  This is in support of the command line "--convert" feature.
      */
-    CompositionMapper();
+    explicit CompositionMapper(
+            const MappedEventBuffer::Window &window =
+                    MappedEventBuffer::Window());
 
     /// Get the SegmentMapper for a Segment
     QSharedPointer<MappedEventBuffer> getMappedEventBuffer(Segment *);
@@ -55,6 +58,14 @@ public:
     void segmentAdded(Segment *);
     void segmentDeleted(Segment *);
 
+    /// The window new SegmentMapper objects are made with.
+    /**
+     * SequenceManager::setMappingWindow() moves the window of those
+     * already made.
+     */
+    void setWindow(const MappedEventBuffer::Window &window)
+            { m_window = window; }
+
     typedef std::map<Segment *, QSharedPointer<SegmentMapper> > SegmentMappers;
 
     /// The Container of SegmentMapper Pointers.
@@ -72,6 +83,8 @@ public:
 private:
     /// Creates a SegmentMapper and adds it to the container.
     void mapSegment(Segment *);
+
+    MappedEventBuffer::Window m_window;
 };
 
 
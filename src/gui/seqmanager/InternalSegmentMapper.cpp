@@ -46,8 +46,13 @@ InternalSegmentMapper::InternalSegmentMapper(RosegardenDocument *doc,
                                              Segment *segment)
     : SegmentMapper(doc, segment),
       m_channelManager(doc->getInstrument(segment)),
-      m_triggeredEvents(new Segment)
-{}
+      m_triggeredEvents(new Segment),
+      m_inWindow(false)
+{
+    // Chasing controllers searches both of these, so index them.
+    m_controllerCache.addIndex(m_segment);
+    m_controllerCache.addIndex(m_triggeredEvents);
+}
 
 InternalSegmentMapper::
 ~InternalSegmentMapper()
@@ -85,6 +90,22 @@ void InternalSegmentMapper::fillBuffer()
     if (repeatCount > 0)
         repeatEndTime = m_segment->getRepeatEndTime();
 
+    m_inWindow = meetsWindow();
+
+    // Until playback gets near, there is nothing to map.  Keep the
+    // sounding times so that MappedBufMetaIterator knows when that is.
+    if (!m_inWindow) {
+        freeBuffer();
+        m_triggeredEvents->clear();
+        m_noteOffs = NoteoffContainer();
+        m_channelManager.freeChannelInterval();
+        m_channelManager.setDirty();
+        setStartEnd(
+                toRealTime(comp, segmentStartTime + m_segment->getDelay()),
+                toRealTime(comp, repeatEndTime + m_segment->getDelay()));
+        return;
+    }
+
     resize(0);
 
 #ifdef DEBUG_INTERNAL_SEGMENT_MAPPER
@@ -400,9 +421,32 @@ int
 InternalSegmentMapper::calculateSize()
 {
     if (!m_segment) { return 0; }
+    if (!meetsWindow()) { return 0; }
     return addSize(0, m_segment);
 }
 
+bool
+InternalSegmentMapper::meetsWindow()
+{
+    if (!m_window.bounded)
+        return true;
+
+    Composition &comp = m_doc->getComposition();
+
+    timeT endTime = getSegmentRepeatCount() > 0 ?
+            m_segment->getRepeatEndTime() : m_segment->getEndMarkerTime();
+
+    return m_window.meets(
+            toRealTime(comp, m_segment->getStartTime() + m_segment->getDelay()),
+            toRealTime(comp, endTime + m_segment->getDelay()));
+}
+
+bool
+InternalSegmentMapper::windowChanged(const Window & /*oldWindow*/)
+{
+    return meetsWindow() != m_inWindow;
+}
+
 // Make the channel ready to be played on.
 void
 InternalSegmentMapper::
@@ -72,6 +72,9 @@ protected:
 
     int calculateSize() override;
 
+    // Whether the segment has come into or gone out of the window.
+    bool windowChanged(const Window &oldWindow) override;
+
     // Do channel-setup for Auto channel mode.
     void makeReady(MappedInserterBase &inserter, RealTime time) override;
 
@@ -122,6 +125,13 @@ private:
 
     bool haveEarlierNoteoff(timeT t);
     RealTime toRealTime(Composition &comp, timeT t);
+
+    /// Whether the segment sounds within m_window.
+    /**
+     * Segments are mapped whole or not at all, so this is decided from
+     * the times the segment starts and, with any repeats, ends.
+     */
+    bool meetsWindow();
     int getControllerValue(timeT searchTime,
                            const std::string& eventType,
                            int controllerId);
@@ -141,6 +151,9 @@ private:
 
     /// Queue of noteoffs.
     NoteoffContainer m_noteOffs;
+
+    /// Whether the segment met m_window when last mapped.
+    bool m_inWindow;
 };
 
 
@@ -82,6 +82,21 @@ MEBIterator::moveTo(const RealTime &time)
     m_ready = false;
 }
 
+void
+MEBIterator::skipTo(const RealTime &time)
+{
+    QReadLocker locker(getLock());
+
+    while (!atEnd()) {
+        const MappedEvent *event = peek();
+
+        if (!event  ||  event->getEventTime() >= time)
+            break;
+
+        operator++();
+    }
+}
+
 MappedEvent *
 MEBIterator::peek() const
 {
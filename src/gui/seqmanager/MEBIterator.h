@@ -46,6 +46,14 @@ public:
 
     void moveTo(const RealTime &time);
 
+    /// Move to the first event that starts at or after time.
+    /**
+     * Unlike moveTo(), this skips events in progress rather than
+     * re-firing them and leaves the iterator ready.  For picking up
+     * where playback was in a buffer whose window has moved.
+     */
+    void skipTo(const RealTime &time);
+
     /// Dereference function
     /**
      * Returns a pointer to the MappedEvent the iterator is currently
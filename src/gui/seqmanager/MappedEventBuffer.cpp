@@ -30,6 +30,44 @@
 namespace Rosegarden
 {
 
+QAtomicInt MappedEventBuffer::m_startEndChanges;
+
+MappedEventBuffer::Window::Window() :
+    bounded(false)
+{
+}
+
+MappedEventBuffer::Window::Window(const RealTime &i_start,
+                                  const RealTime &i_end) :
+    bounded(true),
+    start(i_start),
+    end(i_end)
+{
+}
+
+bool
+MappedEventBuffer::Window::meets(const RealTime &from,
+                                 const RealTime &to) const
+{
+    if (!bounded)
+        return true;
+
+    if (from < end  &&  to >= start)
+        return true;
+
+    return hasLoop()  &&  from < loopEnd  &&  to >= loopStart;
+}
+
+bool
+MappedEventBuffer::Window::operator==(const Window &other) const
+{
+    if (!bounded  ||  !other.bounded)
+        return bounded == other.bounded;
+
+    return start == other.start  &&  end == other.end  &&
+           loopStart == other.loopStart  &&  loopEnd == other.loopEnd;
+}
+
 MappedEventBuffer::MappedEventBuffer(RosegardenDocument *doc) :
     m_doc(doc),
     m_end(std::numeric_limits<int>::max(), 0),  // 68 years
@@ -90,6 +128,23 @@ MappedEventBuffer::refresh()
     return resized;
 }
 
+bool
+MappedEventBuffer::setWindow(const Window &window)
+{
+    if (window == m_window)
+        return false;
+
+    const Window oldWindow = m_window;
+    m_window = window;
+
+    if (!windowChanged(oldWindow))
+        return false;
+
+    refresh();
+
+    return true;
+}
+
 int
 MappedEventBuffer::capacity() const
 {
@@ -141,6 +196,21 @@ MappedEventBuffer::reserve(int newSize)
     delete[] oldBuffer;
 }
 
+void
+MappedEventBuffer::freeBuffer()
+{
+    MappedEvent *oldBuffer = m_buffer;
+
+    {
+        QWriteLocker locker(&m_lock);
+        resize(0);
+        m_buffer = nullptr;
+        m_capacity.storeRelease(0);
+    }
+
+    delete[] oldBuffer;
+}
+
 void
 MappedEventBuffer::resize(int newFill)
 {
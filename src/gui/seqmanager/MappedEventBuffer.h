@@ -55,9 +55,11 @@ class RosegardenDocument;
  * been released.  See comments on m_lock below and in iterator::peek().]
  *
  * MappedEventBuffer only concerns itself with the state of the
- * composition, as opposed to the state of performance.  No matter how
- * the user jumps around in time, it shouldn't change.  For the
+ * composition, as opposed to the state of performance.  For the
  * current state of performance, see MappedEventBuffer::iterator.
+ * The one exception is the Window: for playback, SequenceManager has
+ * the mappers map only what sounds around the playhead, so that long
+ * compositions don't have to be mapped all at once.  See setWindow().
  *
  * A MappedEventBuffer-derived object is jointly owned by one or more
  * metaiterators (MappedBufMetaIterator?) and by ChannelManager and deletes
@@ -70,6 +72,39 @@ public:
     explicit MappedEventBuffer(RosegardenDocument *);
     virtual ~MappedEventBuffer();
 
+    /// The span of playback time a buffer maps.
+    /**
+     * A stretch around the playhead plus, when looping, the start of the
+     * loop that playback wraps around to.  The default Window is
+     * unbounded and has everything mapped, which is what MIDI export
+     * needs.
+     *
+     * @see setWindow()
+     */
+    struct Window
+    {
+        /// Unbounded.
+        Window();
+        Window(const RealTime &start, const RealTime &end);
+
+        /// Whether anything sounding from from to to meets the window.
+        bool meets(const RealTime &from, const RealTime &to) const;
+
+        bool hasLoop() const  { return loopStart < loopEnd; }
+
+        bool operator==(const Window &other) const;
+        bool operator!=(const Window &other) const
+            { return !(*this == other); }
+
+        /// False for the default, everything, Window.
+        bool bounded;
+        RealTime start;
+        RealTime end;
+        /// The start of the loop.  Empty when not looping.
+        RealTime loopStart;
+        RealTime loopEnd;
+    };
+
     /// Two-phase initialization.
     /**
      * Actual setup, must be called after ctor, calls virtual methods.
@@ -134,6 +169,28 @@ public:
         end   = m_end;
     }
 
+    /// Number of times any buffer's sounding times have changed.
+    /**
+     * MappedBufMetaIterator keeps its buffers ordered by start time and
+     * checks this to find out when that order needs rebuilding.
+     *
+     * @see setStartEnd()
+     */
+    static int getStartEndChanges()  { return m_startEndChanges.loadAcquire(); }
+
+    /// Map only what sounds within window.
+    /**
+     * Mappers that support windows refill to match (see
+     * windowChanged()), the others carry on mapping everything.  Until
+     * this is called, everything is mapped.
+     *
+     * Returns true if the buffer was refilled, in which case playback
+     * needs to pick up from the new contents.  While playing, call this
+     * through RosegardenSequencer::setMappingWindow() which does that.
+     */
+    bool setWindow(const Window &window);
+    const Window &getWindow() const  { return m_window; }
+
     virtual TrackId getTrackID() const  { return NoTrack; }
     virtual void insertChannelSetup(MappedInserterBase &)  { }
 
@@ -203,6 +260,16 @@ protected:
      */
     virtual bool shouldPlay(MappedEvent *evt, RealTime startTime)=0;
 
+    /// Whether moving from oldWindow to m_window changes the contents.
+    /**
+     * InternalSegmentMapper and MetronomeMapper override this.  The
+     * others map so few events that they always map everything.
+     *
+     * @see setWindow()
+     */
+    virtual bool windowChanged(const Window & /*oldWindow*/)
+        { return false; }
+
 
     /// Not used here.  Convenience for derivers.
     /**
@@ -229,9 +296,18 @@ protected:
      */
     RealTime m_end;
 
+    /// What to map.  See setWindow().
+    Window m_window;
+
     /// Add an event to the buffer.
     void mapAnEvent(MappedEvent *e);
 
+    /// Empty the buffer and give back its memory.
+    /**
+     * For mappers whose events have moved out of m_window.
+     */
+    void freeBuffer();
+
     /// Set the sounding times (m_start, m_end).
     /**
      * InternalSegmentMapper::fillBuffer() keeps this updated.
@@ -239,8 +315,11 @@ protected:
      * @see getStartEnd()
      */
     void setStartEnd(const RealTime &start, const RealTime &end) {
+        if (start == m_start  &&  end == m_end)
+            return;
         m_start = start;
         m_end   = end;
+        m_startEndChanges.ref();
     }
 
 private:
@@ -278,6 +357,9 @@ private:
      */
     mutable QAtomicInt m_size;
 
+    /// See getStartEndChanges().
+    static QAtomicInt m_startEndChanges;
+
     /// Lock for reserve() and callers to iterator::peek()
     /**
      * Used by reserve() to lock the swapping of the old for the new
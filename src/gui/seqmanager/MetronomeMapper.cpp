@@ -34,20 +34,24 @@
 
 #include <QSettings>
 
-#include <algorithm>  // For std::sort().
+#include <algorithm>  // For std::sort(), std::unique().
 
 namespace Rosegarden
 {
 
 
-MetronomeMapper::MetronomeMapper(RosegardenDocument *doc) :
+MetronomeMapper::MetronomeMapper(RosegardenDocument *doc,
+                                 const Window &window) :
     MappedEventBuffer(doc),
+    m_midiClock(false),
     m_metronome(nullptr),
     m_channelManager(nullptr), // We will set this below after we find instrument.
     m_metronomeDuring(GeneralConfigurationPage::DuringBoth)
 {
     //RG_DEBUG << "ctor: " << this;
 
+    m_window = window;
+
     Studio &studio = m_doc->getStudio();
 
     const DeviceId metronomeDeviceId = studio.getMetronomeDevice();
@@ -69,91 +73,34 @@ MetronomeMapper::MetronomeMapper(RosegardenDocument *doc) :
     m_channelManager.setInstrument(m_instrument);
     m_channelManager.setEternalInterval();
 
-    Composition &composition = m_doc->getComposition();
-
-    int depth = m_metronome->getDepth();
-
-    // If the metronome has bars at the very least, generate the metronome
-    // ticks.
-    if (depth > 0) {
-
-        // Start at a somewhat arbitrary time (-20) prior to the beginning
-        // of the composition.
+    // If the metronome has bars at the very least, it ticks from a
+    // somewhat arbitrary time (-20) prior to the beginning of the
+    // composition.
+    if (m_metronome->getDepth() > 0) {
+        Composition &composition = m_doc->getComposition();
         timeT barStart = composition.getBarStart(-20);
-        m_start = composition.getElapsedRealTime(barStart);
-
-        // For each bar
-        for (timeT barTime = barStart;
-             barTime < composition.getEndMarker();
-             barTime = composition.getBarEndForTime(barTime)) {
-
-            // Add the bar tick
-            m_ticks.push_back(Tick(barTime, BarTick));
-
-            // If all they want is bars, move to the next bar.
-            if (depth == 1)
-                continue;
-
-            // Handle beats and subbeats.
-
-            TimeSignature timeSig = composition.getTimeSignatureAt(barTime);
-            timeT barDuration = timeSig.getBarDuration();
-
-            // Get the beat and subbeat divisions.
-            std::vector<int> divisions;
-            timeSig.getDivisions(depth - 1, divisions);
-
-            int ticks = 1;
-
-            // For each tick type (beat then subbeat)
-            for (int i = 0; i < (int)divisions.size(); ++i) {
-                ticks *= divisions[i];
-
-                // For each tick
-                for (int tick = 0; tick < ticks; ++tick) {
-                    // Drop the first tick.
-                    if (tick % divisions[i] == 0)
-                        continue;
-
-                    timeT tickTime = barTime + (tick * barDuration) / ticks;
-                    m_ticks.push_back(Tick(tickTime, static_cast<TickType>(i + 1)));
-                }
-            }
-        }
+        setStartEnd(composition.getElapsedRealTime(barStart), m_end);
     }
 
     QSettings settings;
     settings.beginGroup(SequencerOptionsConfigGroup);
-    int midiClock = settings.value("midiclock", 0).toInt();
+    m_midiClock = (settings.value("midiclock", 0).toInt() == 1);
     //int mtcMode = settings.value("mtcmode", 0).toInt() ;
     settings.endGroup();
 
-    // Send
-    if (midiClock == 1) {
-        // 24 MIDI timing clocks per quarter note
-        timeT midiClockTime = Note(Note::Crotchet).getDuration() / 24;
-
-        // For each MIDI timing clock
-        for (timeT t = composition.getStartMarker();
-             t < composition.getEndMarker();
-             t += midiClockTime) {
-            m_ticks.push_back(Tick(t, MidiTimingClockTick));
-        }
-    }
-
     //if (mtcMode > 0) {
     //    // do something
     //}
 
-    std::sort(m_ticks.begin(), m_ticks.end());
+    // This eventually calls calculateSize() to work out the ticks and
+    // fillBuffer() which will convert (map) the ticks in m_ticks to
+    // events in m_buffer.
+    init();
 
-    if (m_ticks.empty()) {
+    // A window can miss the composition, but everything should tick.
+    if (m_ticks.empty()  &&  !m_window.bounded) {
         RG_WARNING << "ctor: WARNING no ticks generated";
     }
-
-    // This eventually calls fillBuffer() which will convert (map) the
-    // ticks in m_ticks to events in m_buffer.
-    init();
 }
 
 MetronomeMapper::~MetronomeMapper()
@@ -244,12 +191,121 @@ void MetronomeMapper::fillBuffer()
     m_channelManager.setDirty();
 }
 
+void
+MetronomeMapper::addTicks(timeT startTime, timeT endTime)
+{
+    Composition &composition = m_doc->getComposition();
+
+    int depth = m_metronome->getDepth();
+
+    // If the metronome has bars at the very least, generate the metronome
+    // ticks.
+    if (depth > 0) {
+
+        // For each bar
+        for (timeT barTime = composition.getBarStartForTime(startTime);
+             barTime < endTime  &&  barTime < composition.getEndMarker();
+             barTime = composition.getBarEndForTime(barTime)) {
+
+            // Add the bar tick
+            if (barTime >= startTime)
+                m_ticks.push_back(Tick(barTime, BarTick));
+
+            // If all they want is bars, move to the next bar.
+            if (depth == 1)
+                continue;
+
+            // Handle beats and subbeats.
+
+            TimeSignature timeSig = composition.getTimeSignatureAt(barTime);
+            timeT barDuration = timeSig.getBarDuration();
+
+            // Get the beat and subbeat divisions.
+            std::vector<int> divisions;
+            timeSig.getDivisions(depth - 1, divisions);
+
+            int ticks = 1;
+
+            // For each tick type (beat then subbeat)
+            for (int i = 0; i < (int)divisions.size(); ++i) {
+                ticks *= divisions[i];
+
+                // For each tick
+                for (int tick = 0; tick < ticks; ++tick) {
+                    // Drop the first tick.
+                    if (tick % divisions[i] == 0)
+                        continue;
+
+                    timeT tickTime = barTime + (tick * barDuration) / ticks;
+                    if (tickTime < startTime  ||  tickTime >= endTime)
+                        continue;
+
+                    m_ticks.push_back(Tick(tickTime, static_cast<TickType>(i + 1)));
+                }
+            }
+        }
+    }
+
+    // Send
+    if (m_midiClock) {
+        // 24 MIDI timing clocks per quarter note
+        timeT midiClockTime = Note(Note::Crotchet).getDuration() / 24;
+
+        // The first clock at or after startTime.
+        timeT t = composition.getStartMarker();
+        if (t < startTime)
+            t += (startTime - t + midiClockTime - 1) /
+                    midiClockTime * midiClockTime;
+
+        // For each MIDI timing clock
+        for ( ; t < endTime  &&  t < composition.getEndMarker();
+             t += midiClockTime) {
+            m_ticks.push_back(Tick(t, MidiTimingClockTick));
+        }
+    }
+}
+
 int
 MetronomeMapper::calculateSize()
 {
+    Composition &composition = m_doc->getComposition();
+
+    const timeT barStart = composition.getBarStart(-20);
+
+    m_ticks.clear();
+
+    // The bars that start before the end marker tick.
+    if (!m_window.bounded) {
+        addTicks(barStart,
+                 composition.getBarEndForTime(composition.getEndMarker()));
+    } else {
+        addTicks(std::max(barStart,
+                          composition.getElapsedTimeForRealTime(
+                                  m_window.start)),
+                 composition.getElapsedTimeForRealTime(m_window.end));
+        if (m_window.hasLoop()) {
+            addTicks(std::max(barStart,
+                              composition.getElapsedTimeForRealTime(
+                                      m_window.loopStart)),
+                     composition.getElapsedTimeForRealTime(
+                             m_window.loopEnd));
+        }
+    }
+
+    std::sort(m_ticks.begin(), m_ticks.end());
+    // Where the loop overlaps the rest of the window.
+    m_ticks.erase(std::unique(m_ticks.begin(), m_ticks.end()),
+                  m_ticks.end());
+
     return static_cast<int>(m_ticks.size());
 }
 
+bool
+MetronomeMapper::windowChanged(const Window & /*oldWindow*/)
+{
+    return true;
+}
+
 void
 MetronomeMapper::doInsert(MappedInserterBase &inserter, MappedEvent &evt,
                           RealTime start, bool firstOutput)
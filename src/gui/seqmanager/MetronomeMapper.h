@@ -41,7 +41,9 @@ class MidiMetronome;
 class MetronomeMapper : public MappedEventBuffer
 {
 public:
-    explicit MetronomeMapper(RosegardenDocument *doc);
+    /// Map the ticks within window.  See MappedEventBuffer::setWindow().
+    explicit MetronomeMapper(RosegardenDocument *doc,
+                             const Window &window = Window());
     ~MetronomeMapper() override;
 
     InstrumentId getMetronomeInstrument() const;
@@ -55,9 +57,12 @@ public:
     void makeReady(MappedInserterBase &inserter, RealTime time) override;
     /// Should the event be played?
     bool shouldPlay(MappedEvent *evt, RealTime startTime) override;
+    /// Work out the ticks within m_window (m_ticks).
     int calculateSize() override;
     /// Convert m_ticks to events in m_buffer.
     void fillBuffer() override;
+    /// The ticks move with the window.
+    bool windowChanged(const Window &oldWindow) override;
 
 private:
     Instrument *m_instrument;
@@ -70,9 +75,15 @@ private:
     };
     typedef std::pair<timeT, TickType> Tick;
     typedef std::vector<Tick> TickContainer;
-    /// The ticks of the metronome.
+    /// The ticks of the metronome within m_window.
     TickContainer m_ticks;
 
+    /// Add the ticks from startTime up to endTime to m_ticks.
+    void addTicks(timeT startTime, timeT endTime);
+
+    /// Whether to send MIDI timing clocks.
+    bool m_midiClock;
+
     const MidiMetronome *m_metronome;
 
     ChannelManager m_channelManager;
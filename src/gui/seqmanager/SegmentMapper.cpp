@@ -40,7 +40,8 @@ SegmentMapper::SegmentMapper(RosegardenDocument *doc,
 
 QSharedPointer<SegmentMapper>
 SegmentMapper::makeMapperForSegment(RosegardenDocument *doc,
-                                    Segment *segment)
+                                    Segment *segment,
+                                    const Window &window)
 {
     QSharedPointer<SegmentMapper> mapper;
 
@@ -63,8 +64,10 @@ SegmentMapper::makeMapperForSegment(RosegardenDocument *doc,
 
     // ??? InternalSegmentMapper and AudioSegmentMapper's ctors should
     //     call init().
-    if (mapper)
+    if (mapper) {
+        mapper->m_window = window;
         mapper->init();
+    }
 
     return mapper;
 }
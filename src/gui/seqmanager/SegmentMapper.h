@@ -34,8 +34,13 @@ class SegmentMapper : public MappedEventBuffer
 
 public:
     /// Create the appropriate mapper for the segment type.  Factory function.
+    /**
+     * The mapper maps what sounds within window.  See
+     * MappedEventBuffer::setWindow().
+     */
     static QSharedPointer<SegmentMapper> makeMapperForSegment(
-            RosegardenDocument *, Segment *);
+            RosegardenDocument *, Segment *,
+            const Window &window = Window());
 
     // MappedEventBuffer override
     TrackId getTrackID() const override;
@@ -69,11 +69,27 @@
 #include <QTimer>
 #include <QElapsedTimer>
 
+#include <algorithm>  // For std::min().
 #include <utility>  // For std::pair.
 
 namespace Rosegarden
 {
 
+
+namespace
+{
+
+    // How far ahead of the playback position the mapping window goes,
+    // and how little of that is left when it moves on.
+    const RealTime mappingWindowAhead(30, 0);
+    const RealTime mappingWindowRefill(15, 0);
+
+    // And how far behind, for what is sent just ahead of time, like the
+    // channel setup before a segment.
+    const RealTime mappingWindowBehind(2, 0);
+
+}
+
 SequenceManager::SequenceManager() :
     m_doc(nullptr),
     m_soundDriverStatus(NO_DRIVER),
@@ -81,6 +97,8 @@ SequenceManager::SequenceManager() :
     m_metronomeMapper(nullptr),
     m_tempoSegmentMapper(nullptr),
     m_timeSigSegmentMapper(nullptr),
+    m_mappingWindowEnabled(false),
+    m_mappingWindow(),
     m_refreshRequested(true),
     m_segments(),
     m_triggerSegments(),
@@ -216,6 +234,9 @@ SequenceManager::play()
     if (comp.getLoopMode() == Composition::LoopOn)
         startPos = comp.getElapsedRealTime(comp.getLoopStart());
 
+    // Have what plays first mapped before starting.
+    moveMappingWindow(startPos);
+
     int result = RosegardenSequencer::getInstance()->play(startPos);
 
     // Failed?  Bail.
@@ -369,6 +390,8 @@ SequenceManager::fastforward()
 void
 SequenceManager::jumpTo(const RealTime &time, bool reset)
 {
+    moveMappingWindow(time);
+
     RosegardenSequencer::getInstance()->jumpTo(time, reset);
 }
 
@@ -1052,35 +1075,50 @@ void SequenceManager::slotLoopChanged()
 
     Composition &composition = m_doc->getComposition();
 
-    if (composition.getLoopMode() == Composition::LoopOff) {
+    RealTime loopStart;
+    RealTime loopEnd;
+
+    if (!getLoopRange(loopStart, loopEnd)) {
         // Turn off the loop.
         RosegardenSequencer::getInstance()->setLoop(
                 RealTime::zero(), RealTime::zero(),
                 false);
-        return;
+    } else {
+        RosegardenSequencer::getInstance()->setLoop(
+                loopStart, loopEnd,
+                composition.getLoopMode() == Composition::LoopOn  &&
+                        Preferences::getJumpToLoop());
+    }
+
+    // The mapping window covers the start of the loop.
+    if (m_mappingWindowEnabled  &&  m_mappingWindow.bounded) {
+        setMappingWindow(makeMappingWindow(
+                CompositionPosition::getInstance()->getElapsedTime()));
     }
+}
+
+bool
+SequenceManager::getLoopRange(RealTime &loopStart, RealTime &loopEnd) const
+{
+    const Composition &composition = m_doc->getComposition();
 
     if (composition.getLoopMode() == Composition::LoopOn) {
-        const RealTime loopStart = composition.getElapsedRealTime(
+        loopStart = composition.getElapsedRealTime(
                 composition.getLoopStart());
-        const RealTime loopEnd = composition.getElapsedRealTime(
+        loopEnd = composition.getElapsedRealTime(
                 composition.getLoopEnd());
-        RosegardenSequencer::getInstance()->setLoop(
-                loopStart, loopEnd,
-                Preferences::getJumpToLoop());
-        return;
+        return true;
     }
 
     if (composition.getLoopMode() == Composition::LoopAll) {
-        const RealTime loopStart = composition.getElapsedRealTime(
+        loopStart = composition.getElapsedRealTime(
                 composition.getStartMarker());
-        const RealTime loopEnd = composition.getElapsedRealTime(
+        loopEnd = composition.getElapsedRealTime(
                 composition.getDuration(true));
-        RosegardenSequencer::getInstance()->setLoop(
-                loopStart, loopEnd,
-                false);
-        return;
+        return true;
     }
+
+    return false;
 }
 
 void SequenceManager::slotExportUpdate()
@@ -1280,7 +1318,12 @@ void SequenceManager::resetCompositionMapper()
 
     RosegardenSequencer::getInstance()->compositionAboutToBeDeleted();
 
-    m_compositionMapper.reset(new CompositionMapper);
+    if (m_mappingWindowEnabled) {
+        m_mappingWindow = makeMappingWindow(
+                CompositionPosition::getInstance()->getElapsedTime());
+    }
+
+    m_compositionMapper.reset(new CompositionMapper(m_mappingWindow));
 
     resetMetronomeMapper();
     resetTempoSegmentMapper();
@@ -1318,7 +1361,8 @@ void SequenceManager::resetMetronomeMapper()
     }
 
     m_metronomeMapper =
-            QSharedPointer<MetronomeMapper>(new MetronomeMapper(m_doc));
+            QSharedPointer<MetronomeMapper>(
+                    new MetronomeMapper(m_doc, m_mappingWindow));
     RosegardenSequencer::getInstance()->segmentAdded
         (m_metronomeMapper);
 }
@@ -1353,6 +1397,76 @@ void SequenceManager::resetTimeSigSegmentMapper()
         (m_timeSigSegmentMapper);
 }
 
+void SequenceManager::enableMappingWindow()
+{
+    m_mappingWindowEnabled = true;
+
+    connect(CompositionPosition::getInstance(), &CompositionPosition::changed,
+            this, &SequenceManager::slotUpdateMappingWindow);
+}
+
+void SequenceManager::slotUpdateMappingWindow()
+{
+    moveMappingWindow(CompositionPosition::getInstance()->getElapsedTime());
+}
+
+MappedEventBuffer::Window
+SequenceManager::makeMappingWindow(const RealTime &position) const
+{
+    MappedEventBuffer::Window window(position - mappingWindowBehind,
+                                     position + mappingWindowAhead);
+
+    // Playback wraps around to the start of the loop without asking us,
+    // so that needs to be ready too.
+    RealTime loopStart;
+    RealTime loopEnd;
+    if (getLoopRange(loopStart, loopEnd)  &&  loopStart < loopEnd) {
+        window.loopStart = loopStart - mappingWindowBehind;
+        window.loopEnd = std::min(loopEnd, loopStart + mappingWindowAhead);
+    }
+
+    return window;
+}
+
+void SequenceManager::moveMappingWindow(const RealTime &position)
+{
+    if (!m_mappingWindowEnabled)
+        return;
+
+    // Still enough mapped ahead?
+    if (m_mappingWindow.bounded  &&
+        position >= m_mappingWindow.start  &&
+        position + mappingWindowRefill <= m_mappingWindow.end)
+        return;
+
+    setMappingWindow(makeMappingWindow(position));
+}
+
+void SequenceManager::setMappingWindow(
+        const MappedEventBuffer::Window &window)
+{
+    if (window == m_mappingWindow)
+        return;
+
+    m_mappingWindow = window;
+
+    if (!m_compositionMapper)
+        return;
+
+    m_compositionMapper->setWindow(window);
+
+    RosegardenSequencer *sequencer = RosegardenSequencer::getInstance();
+
+    // Segments coming into the window are mapped whole and those going
+    // out of it are emptied.  The others are left as they are.
+    for (const CompositionMapper::SegmentMappers::value_type &pair :
+             m_compositionMapper->m_segmentMappers) {
+        sequencer->setMappingWindow(pair.second, window);
+    }
+
+    sequencer->setMappingWindow(m_metronomeMapper, window);
+}
+
 bool SequenceManager::event(QEvent *e)
 {
     if (e->type() == QEvent::User) {
@@ -1894,6 +2008,10 @@ MappedBufMetaIterator *
 SequenceManager::
 makeTempMetaiterator()
 {
+    // Export needs everything mapped.  The window comes back when the
+    // position next changes.
+    setMappingWindow(MappedEventBuffer::Window());
+
     MappedBufMetaIterator *metaiterator = new MappedBufMetaIterator;
     // Add the mappers we know of.  Not the metronome because we don't
     // export that.
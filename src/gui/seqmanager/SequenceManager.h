@@ -21,6 +21,7 @@
 #include "base/Composition.h"
 #include "base/RealTime.h"
 #include "gui/application/TransportStatus.h"
+#include "gui/seqmanager/MappedEventBuffer.h"
 #include "sound/MappedEventList.h"
 #include "sound/MappedEvent.h"
 #include "sound/SoundDriver.h"
@@ -101,6 +102,16 @@ public:
     /// Reset everything.
     void resetCompositionMapper();
 
+    /// Map for playback only what sounds around the playback position.
+    /**
+     * Otherwise the whole composition is mapped up front, which is what
+     * the command line conversion wants.  The window follows the
+     * playback position and also covers the start of the loop.
+     *
+     * @see MappedEventBuffer::setWindow()
+     */
+    void enableMappingWindow();
+
     /**
      * Update m_soundDriverStatus.
      *
@@ -366,6 +377,9 @@ private slots:
      */
     void slotScheduledCompositionMapperReset();
 
+    /// Keep the mapping window with the playback position.
+    void slotUpdateMappingWindow();
+
 private:
     /// Cache to avoid lock?
     /**
@@ -414,6 +428,22 @@ private:
     QSharedPointer<TimeSigSegmentMapper> m_timeSigSegmentMapper;
     void resetTimeSigSegmentMapper();
 
+    // *** Mapping window
+
+    /// See enableMappingWindow().
+    bool m_mappingWindowEnabled;
+    /// What the CompositionMapper and the MetronomeMapper map.
+    MappedEventBuffer::Window m_mappingWindow;
+    /// The window to map when playing from position.
+    MappedEventBuffer::Window makeMappingWindow(const RealTime &position) const;
+    /// Move the window if there is too little mapped ahead of position.
+    void moveMappingWindow(const RealTime &position);
+    /// Move the mappers to window.
+    void setMappingWindow(const MappedEventBuffer::Window &window);
+
+    /// The range the sequencer loops over, if it does.
+    bool getLoopRange(RealTime &loopStart, RealTime &loopEnd) const;
+
     // *** Refresh Mappers and RosegardenSequencer
 
     /// Let RosegardenSequencer know about any changes.
@@ -315,7 +315,7 @@ void AudioStrip::updateWidgets()
     // Get the appropriate buss based on the ID.
     Buss *buss = nullptr;
     if (!isInput()) {
-        BussVector busses = studio.getBusses();
+        const BussVector &busses = studio.getBussesRef();
         buss = busses[m_id];
     }
 
@@ -375,7 +375,7 @@ void AudioStrip::updateWidgets()
                 studio.getInstrumentById(m_id));
     }
     if (isSubmaster()) {
-        BussVector busses = studio.getBusses();
+        const BussVector &busses = studio.getBussesRef();
         if (m_id < busses.size()) {
             pluginContainer =
                     dynamic_cast<const PluginContainer *>(busses[m_id]);
@@ -553,7 +553,7 @@ AudioStrip::slotFaderLevelChanged(float dB)
     // If this is the master or a submaster Fader
     if (isSubmaster()  ||  isMaster()) {
 
-        BussVector busses = studio.getBusses();
+        const BussVector &busses = studio.getBussesRef();
 
         // If the buss ID is out of range, bail.
         if (m_id >= busses.size())
@@ -610,7 +610,7 @@ AudioStrip::slotPanChanged(float i_pan)
 
     if (isSubmaster()  ||  isMaster()) {
 
-        BussVector busses = studio.getBusses();
+        const BussVector &busses = studio.getBussesRef();
 
         if (m_id >= busses.size())
             return;
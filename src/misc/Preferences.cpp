@@ -230,6 +230,32 @@ bool Preferences::getJACKLoadCheck()
     return jackLoadCheck.get();
 }
 
+static PreferenceInt audioReadThreads(
+        SequencerOptionsConfigGroup, "audioReadThreads", 2);
+
+void Preferences::setAudioReadThreads(int value)
+{
+    audioReadThreads.set(value);
+}
+
+int Preferences::getAudioReadThreads()
+{
+    return audioReadThreads.get();
+}
+
+static PreferenceBool audioReadAheadHints(
+        SequencerOptionsConfigGroup, "audioReadAheadHints", true);
+
+void Preferences::setAudioReadAheadHints(bool value)
+{
+    audioReadAheadHints.set(value);
+}
+
+bool Preferences::getAudioReadAheadHints()
+{
+    return audioReadAheadHints.get();
+}
+
 static PreferenceBool bug1623(ExperimentalConfigGroup, "bug1623", false);
 
 bool Preferences::getBug1623()
@@ -368,6 +394,19 @@ bool Preferences::getShowGtk2Warning()
     return showGtk2Warning.get();
 }
 
+static PreferenceInt undoMemoryLimitMB(
+        GeneralOptionsConfigGroup, "undoMemoryLimitMB", 256);
+
+void Preferences::setUndoMemoryLimitMB(int value)
+{
+    undoMemoryLimitMB.set(value);
+}
+
+int Preferences::getUndoMemoryLimitMB()
+{
+    return undoMemoryLimitMB.get();
+}
+
 static PreferenceInt pdfViewer(
         ExternalApplicationsConfigGroup,
         "pdfviewer",
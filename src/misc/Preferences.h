@@ -101,6 +101,14 @@ namespace Preferences
     void setJACKLoadCheck(bool value);
     bool getJACKLoadCheck();
 
+    /// Number of threads reading audio files during playback.
+    void setAudioReadThreads(int value);
+    int getAudioReadThreads();
+
+    /// Ask the OS to prefetch audio files ahead of playback.
+    void setAudioReadAheadHints(bool value);
+    bool getAudioReadAheadHints();
+
     void setShowNoteNames(bool value);
     bool getShowNoteNames();
 
@@ -145,6 +153,10 @@ namespace Preferences
 
     void setShowGtk2Warning(bool value);
     bool getShowGtk2Warning();
+
+    /// Memory budget for the undo/redo history in MB.  0 means no limit.
+    void setUndoMemoryLimitMB(int value);
+    int getUndoMemoryLimitMB();
 }
 
 
@@ -40,6 +40,8 @@
 
 #include <QVector>
 
+#include <algorithm>
+
 //#define DEBUG_ROSEGARDEN_SEQUENCER
 
 //#define LOCKED QMutexLocker rgseq_locker(&m_mutex); SEQUENCER_DEBUG << "Locked in " << __PRETTY_FUNCTION__ << " at " << __LINE__
@@ -260,6 +262,10 @@ RosegardenSequencer::record(const RealTime &time,
         SEQUENCER_DEBUG << "RosegardenSequencer::record()"
                         << " - starting to record";
 #endif
+        // Anything left over from a previous recording is stale.
+        m_recordBacklog.clear();
+        SequencerDataBlock::getInstance()->resetRecordOverflowCount();
+
         // This function is (now) called synchronously from the GUI
         // thread, which is why we needed to obtain the sequencer lock
         // above.  This means we can safely call back into GUI
@@ -1075,6 +1081,22 @@ RosegardenSequencer::segmentModified(QSharedPointer<MappedEventBuffer> mapper)
    m_metaIterator.resetIteratorForBuffer(mapper, immediate);
 }
 
+void
+RosegardenSequencer::setMappingWindow(
+        QSharedPointer<MappedEventBuffer> mapper,
+        const MappedEventBuffer::Window &window)
+{
+    if (!mapper) return;
+
+    // Refill outside the lock, as for segmentModified(), so that the
+    // sequencer thread isn't held up while a whole segment is mapped.
+    if (!mapper->setWindow(window))
+        return;
+
+    LOCKED;
+    m_metaIterator.resumeIteratorForBuffer(mapper);
+}
+
 void
 RosegardenSequencer::segmentAdded(QSharedPointer<MappedEventBuffer> mapper)
 {
@@ -1272,18 +1294,19 @@ RosegardenSequencer::keepPlaying()
     if (isLooping()  &&  fetchEnd >= m_loopEnd)
         fetchEnd = m_loopEnd - RealTime(0, 1);
 
-    MappedEventList mappedEventList;
+    // Reuse the last slice's storage.
+    m_sliceEvents.clear();
 
     // If time has actually moved, get the events.
     if (fetchEnd > m_lastFetchSongPosition) {
         fetchEvents(
-                mappedEventList, m_lastFetchSongPosition, fetchEnd, false);
+                m_sliceEvents, m_lastFetchSongPosition, fetchEnd, false);
     }
 
     // Again, process whether we need to or not to keep
     // the Sequencer up-to-date with audio events
     m_driver->processEventsOut(
-            mappedEventList, m_lastFetchSongPosition, fetchEnd);
+            m_sliceEvents, m_lastFetchSongPosition, fetchEnd);
 
     if (fetchEnd > m_lastFetchSongPosition)
         m_lastFetchSongPosition = fetchEnd;
@@ -1373,7 +1396,13 @@ RosegardenSequencer::processRecordedMidi()
     // Get the MIDI events from the ALSA driver
     m_driver->getMappedEventList(recordList);
 
-    if (recordList.empty()) return;
+    if (recordList.empty()) {
+        // Pass on anything the GUI could not take last time.
+        if (!m_recordBacklog.empty())
+            SequencerDataBlock::getInstance()->addRecordedEvents(
+                    &m_recordBacklog);
+        return;
+    }
 
     // Handle "thru" first to reduce latency.
 
@@ -1394,8 +1423,32 @@ RosegardenSequencer::processRecordedMidi()
     // Remove events that match the record filter
     applyFiltering(&recordList, ControlBlock::getInstance()->getRecordFilter(), false);
 
-    // Store the events
-    SequencerDataBlock::getInstance()->addRecordedEvents(&recordList);
+    // Queue the new events behind anything that did not fit into the
+    // record ring buffer last time.  The backlog takes ownership.  If the
+    // GUI has stopped taking events altogether, the newest ones are
+    // dropped rather than letting the backlog grow without bound.
+    const size_t room = m_recordBacklog.size() < MaxRecordBacklog ?
+            MaxRecordBacklog - m_recordBacklog.size() : 0;
+    const MappedEventList::iterator keepEnd =
+            recordList.begin() + std::min(room, recordList.size());
+    m_recordBacklog.insert(recordList.begin(), keepEnd);
+    recordList.erase(recordList.begin(), keepEnd);
+
+    if (!recordList.empty()) {
+        RG_WARNING << "RosegardenSequencer::processRecordedMidi(): record backlog full, dropping" << recordList.size() << "events";
+        SequencerDataBlock::getInstance()->addRecordOverflow(
+                unsigned(recordList.size()));
+        recordList.clear();
+    }
+
+    // Store the events.  Whatever does not fit stays in the backlog, so
+    // nothing is dropped if the GUI falls behind for a while.
+    SequencerDataBlock::getInstance()->addRecordedEvents(&m_recordBacklog);
+
+#ifdef DEBUG_ROSEGARDEN_SEQUENCER
+    if (!m_recordBacklog.empty())
+        SEQUENCER_DEBUG << "RosegardenSequencer::processRecordedMidi: " << m_recordBacklog.size() << " events waiting for the GUI";
+#endif
 }
 
 void
@@ -1496,23 +1549,12 @@ RosegardenSequencer::applyFiltering(MappedEventList *mC,
                                        MidiFilter filter,
                                        bool filterControlDevice)
 {
-    // For each event in the list
-    for (MappedEventList::iterator i = mC->begin();
-         i != mC->end();
-         /* increment in loop */) {
-
-        // Hold on to the current event for processing.
-        MappedEventList::iterator j = i;
-        // Move to the next in case the current is erased.
-        ++i;
-
-        // If this event matches the filter, erase it from the list
-        if (((*j)->getType() & filter) ||
-                (filterControlDevice && ((*j)->getRecordedDevice() ==
-                                         EXTERNAL_CONTROLLER))) {
-            mC->erase(j);
-        }
-    }
+    // Drop the events that match the filter
+    mC->deleteIf([filter, filterControlDevice](const MappedEvent *event) {
+            return (event->getType() & filter) ||
+                   (filterControlDevice &&
+                    event->getRecordedDevice() == EXTERNAL_CONTROLLER);
+        });
 }
 
 // Initialise the virtual studio with a few audio faders and
@@ -322,6 +322,13 @@ public:
     void dumpFirstSegment();
 
     void segmentModified(QSharedPointer<MappedEventBuffer>);
+    /// Move a buffer's mapping window.  See MappedEventBuffer::setWindow().
+    /**
+     * The buffer is refilled on the calling thread, like any other
+     * refresh, and then playback carries on from the current time.
+     */
+    void setMappingWindow(QSharedPointer<MappedEventBuffer>,
+                          const MappedEventBuffer::Window &);
     void segmentAdded(QSharedPointer<MappedEventBuffer>);
     void segmentAboutToBeDeleted(QSharedPointer<MappedEventBuffer>);
     /// Close all mapped segments
@@ -540,6 +547,20 @@ private:
      */
     MappedEventList m_asyncInQueue;
 
+    /**
+     * Recorded events that did not fit into SequencerDataBlock's record
+     * ring buffer yet.  See processRecordedMidi().
+     */
+    MappedEventList m_recordBacklog;
+    /// Limit on m_recordBacklog.  Several minutes of dense MIDI input.
+    static constexpr size_t MaxRecordBacklog = 65536;
+
+    /**
+     * The events of each playback slice.  Kept between slices so that
+     * its storage is reused.  See keepPlaying().
+     */
+    MappedEventList m_sliceEvents;
+
     typedef std::pair<TransportRequest, RealTime> TransportPair;
     std::deque<TransportPair> m_transportRequests;
     /// Serial number used to detect completion of processing across threads.
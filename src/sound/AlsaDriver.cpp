@@ -3807,7 +3807,7 @@ AlsaDriver::processMidiOut(const MappedEventList &rgEventList,
     // hard to follow.
     std::string sysExData;
 
-    // NB the MappedEventList is implicitly ordered by time (std::multiset)
+    // NB the MappedEventList is implicitly ordered by time (sorted on iteration)
 
     // For each incoming MappedEvent...
     for (MappedEvent *rgEvent : rgEventList) {
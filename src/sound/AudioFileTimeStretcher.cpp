@@ -18,8 +18,8 @@
 
 #include "AudioFileTimeStretcher.h"
 
-#include "AudioTimeStretcher.h"
 #include "AudioFileManager.h"
+#include "ParallelTimeStretcher.h"
 #include "WAVAudioFile.h"
 #include "base/RealTime.h"
 #include "misc/Debug.h"
@@ -28,12 +28,7 @@
 #include <QProgressDialog>
 
 #include <fstream>
-
-#ifdef __FreeBSD__
-#include <stdlib.h>
-#else
-#include <alloca.h>
-#endif
+#include <vector>
 
 namespace Rosegarden {
 
@@ -98,162 +93,73 @@ AudioFileTimeStretcher::getStretchedAudioFile(AudioFileId source,
         return -1;
     }
 
-    int obs = 1024;
-    int ibs = obs / ratio;
-    int ch = sourceFile->getChannels();
-    int sr = sourceFile->getSampleRate();
-
-    AudioTimeStretcher stretcher(sr, ch, ratio, true, obs);
-
-    // We'll first prime the timestretcher with half its window size
-    // of silence, an amount which we then discard at the start of the
-    // output (as well as its own processing latency).  Really the
-    // timestretcher should handle this itself and report it in its
-    // own latency calculation
-
-    size_t padding = stretcher.getWindowSize()/2;
-
-    // cppcheck-suppress allocaCalled
-    char *ebf = (char *)alloca
-        (ch * ibs * sourceFile->getBytesPerFrame());
-
-    std::vector<float *> dbfs;
-    for (int c = 0; c < ch; ++c) {
-        // cppcheck-suppress allocaCalled
-        dbfs.push_back((float *)alloca((ibs > int(padding) ? size_t(ibs) : padding)
-                                       * sizeof(float)));
-    }
-
-    // cppcheck-suppress allocaCalled
-    float **ibfs = (float **)alloca(ch * sizeof(float *));
-    // cppcheck-suppress allocaCalled
-    float **obfs = (float **)alloca(ch * sizeof(float *));
-
-    for (int c = 0; c < ch; ++c) {
-        ibfs[c] = dbfs[c];
-    }
-
-    for (int c = 0; c < ch; ++c) {
-        // cppcheck-suppress allocaCalled
-        obfs[c] = (float *)alloca(obs * sizeof(float));
-    }
-
-    // cppcheck-suppress allocaCalled
-    char *oebf = (char *)alloca(ch * obs * sizeof(float));
-
-    int totalIn = 0, totalOut = 0;
-
-    for (int c = 0; c < ch; ++c) {
-        for (size_t i = 0; i < padding; ++i) {
-            ibfs[c][i] = 0.f;
-        }
-    }
-    stretcher.putInput(ibfs, padding);
+    const int ch = sourceFile->getChannels();
+    const int sr = sourceFile->getSampleRate();
+    const unsigned int bytesPerFrame = sourceFile->getBytesPerFrame();
 
     RealTime totalTime = sourceFile->getLength();
     long fileTotalIn = RealTime::realTime2Frame
         (totalTime, sourceFile->getSampleRate());
-    int progressCount = 0;
-
-    long expectedOut = ceil(fileTotalIn * ratio);
-
-    bool inputExhausted = false;
 
     sourceFile->scanTo(&streamIn, RealTime::zero());
 
-    while (1) {
+    // Reading, decoding and encoding happen here on the GUI thread.  The
+    // stretching itself is spread across a pool of worker threads.
 
-        if (m_progressDialog  &&  m_progressDialog->wasCanceled()) {
-            RG_DEBUG << "getStretchedAudioFile(): cancelled";
-            return -1;
-        }
+    std::vector<char> encoded;
+    std::vector<float *> decodeTargets(ch);
 
-        unsigned int thisRead = 0;
+    auto read = [&](float **buffers, size_t frames) -> size_t {
+        encoded.resize(frames * bytesPerFrame);
+        unsigned int thisRead = sourceFile->getSampleFrames
+            (&streamIn, encoded.data(), frames);
+        if (thisRead == 0)
+            return 0;
 
-        if (!inputExhausted) {
-            thisRead = sourceFile->getSampleFrames(&streamIn, ebf, ibs);
-            if (int(thisRead) < ibs) inputExhausted = true;
+        for (int c = 0; c < ch; ++c) {
+            decodeTargets[c] = buffers[c];
         }
 
-        if (thisRead == 0) {
-            if (totalOut >= expectedOut) break;
-            else {
-                // run out of input data, continue feeding zeroes until
-                // we have enough output data
-                for (int c = 0; c < ch; ++c) {
-                    for (int i = 0; i < ibs; ++i) {
-                        ibfs[c][i] = 0.f;
-                    }
-                }
-                thisRead = ibs;
-            }
-        }
-
-        if (!sourceFile->decode((unsigned char *)ebf,
-                                thisRead * sourceFile->getBytesPerFrame(),
+        if (!sourceFile->decode((unsigned char *)encoded.data(),
+                                thisRead * bytesPerFrame,
                                 sr, ch,
-                                thisRead, dbfs, false)) {
+                                thisRead, decodeTargets, false)) {
             RG_WARNING << "getStretchedAudioFile(): ERROR: AudioFile failed to decode its own output";
-            break;
+            return 0;
         }
 
-        stretcher.putInput(ibfs, thisRead);
-        totalIn += thisRead;
-
-        unsigned int available = stretcher.getAvailableOutputSamples();
+        return thisRead;
+    };
 
-        while (available > 0) {
+    std::vector<float> interleaved;
 
-            unsigned int count = available;
-            if (count > (unsigned int)obs) count = (unsigned int)obs;
-
-            if (padding > 0) {
-                if (count <= padding) {
-                    stretcher.getOutput(obfs, count);
-                    padding -= count;
-                    available -= count;
-                    continue;
-                } else {
-                    stretcher.getOutput(obfs, padding);
-                    count -= padding;
-                    available -= padding;
-                    padding = 0;
-                }
+    auto write = [&](float **buffers, size_t frames) {
+        interleaved.resize(frames * ch);
+        float *encodePointer = interleaved.data();
+        for (size_t i = 0; i < frames; ++i) {
+            for (int c = 0; c < ch; ++c) {
+                *encodePointer++ = buffers[c][i];
             }
-
-            stretcher.getOutput(obfs, count);
-
-            char *encodePointer = oebf;
-            for (unsigned int i = 0; i < count; ++i) {
-                for (int c = 0; c < ch; ++c) {
-                    float sample = obfs[c][i];
-                    // cppcheck-suppress invalidPointerCast
-                    *(float *)encodePointer = sample;
-                    encodePointer += sizeof(float);
-                }
-            }
-
-            if (totalOut < expectedOut &&
-                totalOut + int(count) > expectedOut) {
-                count = expectedOut - totalOut;
-            }
-
-            writeFile.appendSamples(oebf, count);
-            totalOut += count;
-            available -= count;
-
-            if (totalOut >= expectedOut) break;
         }
-
-        if (++progressCount == 100) {
-            int progress = static_cast<int>(100.0 * totalIn / fileTotalIn);
-            if (m_progressDialog)
-                m_progressDialog->setValue(progress);
-
-            progressCount = 0;
+        writeFile.appendSamples((const char *)interleaved.data(), frames);
+    };
+
+    auto poll = [this](int progress) -> bool {
+        if (m_progressDialog) {
+            if (m_progressDialog->wasCanceled())
+                return false;
+            m_progressDialog->setValue(progress);
         }
-
         qApp->processEvents();
+        return true;
+    };
+
+    ParallelTimeStretcher stretcher(sr, ch, ratio);
+
+    if (!stretcher.process(fileTotalIn > 0 ? size_t(fileTotalIn) : 0,
+                           read, write, poll)) {
+        RG_DEBUG << "getStretchedAudioFile(): cancelled";
+        return -1;
     }
 
     if (m_progressDialog)
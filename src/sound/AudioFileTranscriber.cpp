@@ -0,0 +1,176 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_MODULE_STRING "[AudioFileTranscriber]"
+
+#include "AudioFileTranscriber.h"
+
+#include "AudioFile.h"
+#include "AudioFileManager.h"
+#include "AudioTranscriber.h"
+#include "base/BaseProperties.h"
+#include "base/Composition.h"
+#include "base/Event.h"
+#include "base/NotationTypes.h"
+#include "base/RealTime.h"
+#include "base/Segment.h"
+#include "misc/Debug.h"
+
+#include <QApplication>
+#include <QProgressDialog>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace Rosegarden {
+
+
+AudioFileTranscriber::AudioFileTranscriber(AudioFileManager *afm) :
+        m_audioFileManager(afm),
+        m_method(PitchDetector::AUTOCORRELATION),
+        m_frameSize(PitchDetector::defaultFrameSize),
+        m_stepSize(PitchDetector::defaultStepSize)
+{
+}
+
+AudioFileTranscriber::~AudioFileTranscriber()
+{
+}
+
+Segment *
+AudioFileTranscriber::transcribe(const Segment *audioSegment,
+                                 const Composition &composition)
+{
+    AudioFile *sourceFile =
+            m_audioFileManager->getAudioFile(audioSegment->getAudioFileId());
+    if (!sourceFile) {
+        RG_WARNING << "transcribe(): WARNING: Source file not found for ID" << audioSegment->getAudioFileId();
+        return nullptr;
+    }
+
+    std::ifstream streamIn(sourceFile->getAbsoluteFilePath().toLocal8Bit(),
+                           std::ios::in | std::ios::binary);
+    if (!streamIn) {
+        RG_WARNING << "transcribe(): WARNING: Creation of ifstream failed for file " << sourceFile->getAbsoluteFilePath();
+        return nullptr;
+    }
+
+    if (m_progressDialog) {
+        m_progressDialog->setLabelText(tr("Transcribing audio..."));
+        m_progressDialog->setRange(0, 100);
+    }
+
+    const int sr = sourceFile->getSampleRate();
+    const unsigned int bytesPerFrame = sourceFile->getBytesPerFrame();
+
+    // Just the part of the file that the segment plays.
+    const RealTime audioStart = audioSegment->getAudioStartTime();
+    const RealTime audioEnd =
+            std::min(audioSegment->getAudioEndTime(), sourceFile->getLength());
+    const long totalFrames = RealTime::realTime2Frame(audioEnd - audioStart, sr);
+
+    sourceFile->scanTo(&streamIn, audioStart);
+
+    // Reading and decoding happen here on the GUI thread.  The pitch
+    // detection itself is spread across a pool of worker threads.
+
+    std::vector<char> encoded;
+    long framesLeft = totalFrames;
+
+    auto read = [&](float *buffer, size_t frames) -> size_t {
+        frames = std::min(frames, size_t(std::max(0L, framesLeft)));
+        if (frames == 0)
+            return 0;
+
+        encoded.resize(frames * bytesPerFrame);
+        unsigned int thisRead = sourceFile->getSampleFrames
+            (&streamIn, encoded.data(), frames);
+        if (thisRead == 0)
+            return 0;
+
+        // Stereo is mixed down to mono.
+        std::vector<float *> target(1, buffer);
+        if (!sourceFile->decode((unsigned char *)encoded.data(),
+                                thisRead * bytesPerFrame,
+                                sr, 1,
+                                thisRead, target, false)) {
+            RG_WARNING << "transcribe(): ERROR: AudioFile failed to decode its own output";
+            return 0;
+        }
+
+        framesLeft -= thisRead;
+        return thisRead;
+    };
+
+    auto poll = [this](int progress) -> bool {
+        if (m_progressDialog) {
+            if (m_progressDialog->wasCanceled())
+                return false;
+            m_progressDialog->setValue(progress);
+        }
+        qApp->processEvents();
+        return true;
+    };
+
+    AudioTranscriber transcriber(sr, m_frameSize, m_stepSize);
+    transcriber.setMethod(m_method);
+
+    if (!transcriber.process(totalFrames > 0 ? size_t(totalFrames) : 0,
+                             read, poll)) {
+        RG_DEBUG << "transcribe(): cancelled";
+        return nullptr;
+    }
+
+    // Place the notes in the composition's time, through its tempo
+    // changes.
+
+    const timeT startTime = audioSegment->getStartTime();
+    const RealTime startRealTime = composition.getElapsedRealTime(startTime);
+
+    Segment *segment = new Segment;
+    segment->setLabel(audioSegment->getLabel());
+    segment->setStartTime(startTime);
+
+    for (const AudioTranscriber::Note &found : transcriber.getNotes()) {
+        const timeT time = composition.getElapsedTimeForRealTime(
+                startRealTime + found.time);
+        const timeT endTime = composition.getElapsedTimeForRealTime(
+                startRealTime + found.time + found.duration);
+
+        Event *note = new Event(Note::EventType, time,
+                                std::max(timeT(1), endTime - time));
+        note->set<Int>(BaseProperties::PITCH, found.pitch);
+        note->set<Int>(BaseProperties::VELOCITY, found.velocity);
+        segment->insert(note);
+    }
+
+    const timeT endTime = std::max(audioSegment->getEndMarkerTime(),
+                                   segment->getEndTime());
+    segment->setEndMarkerTime(endTime);
+    segment->normalizeRests(startTime, endTime);
+
+    if (m_progressDialog)
+        m_progressDialog->setValue(100);
+
+    RG_DEBUG << "transcribe(): " << transcriber.getNotes().size() << " notes";
+
+    return segment;
+}
+
+
+}
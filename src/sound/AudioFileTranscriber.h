@@ -0,0 +1,75 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_AUDIO_FILE_TRANSCRIBER_H
+#define RG_AUDIO_FILE_TRANSCRIBER_H
+
+#include "PitchDetector.h"
+
+#include <QObject>
+#include <QPointer>
+
+class QProgressDialog;
+
+namespace Rosegarden {
+
+class AudioFileManager;
+class Composition;
+class Segment;
+
+/// Transcribe the audio under an audio Segment into a MIDI Segment.
+class AudioFileTranscriber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioFileTranscriber(AudioFileManager *afm);
+    ~AudioFileTranscriber() override;
+
+    /// One of PitchDetector::getMethods().
+    void setMethod(const PitchDetector::Method &method)
+            { m_method = method; }
+
+    /// Analysis frame and step sizes, in samples.
+    void setFrameSize(int frameSize, int stepSize)
+            { m_frameSize = frameSize;  m_stepSize = stepSize; }
+
+    /**
+     * Return a new Segment with the notes found in audioSegment,
+     * starting at the same time.  The caller owns it.
+     *
+     * Returns nullptr on error or if cancelled.
+     */
+    Segment *transcribe(const Segment *audioSegment,
+                        const Composition &composition);
+
+    void setProgressDialog(QPointer<QProgressDialog> progressDialog)
+            { m_progressDialog = progressDialog; }
+
+protected:
+    AudioFileManager *m_audioFileManager;
+
+    PitchDetector::Method m_method;
+    int m_frameSize;
+    int m_stepSize;
+
+    QPointer<QProgressDialog> m_progressDialog;
+};
+
+}
+
+#endif
@@ -24,12 +24,19 @@
 #include "base/AudioLevel.h"
 #include "AudioPlayQueue.h"
 
+#include "misc/Preferences.h"
 #include "misc/Strings.h"
 
+#include <QRunnable>
+#include <QThreadPool>
+
 #include <sys/time.h>
 #include <pthread.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <map>
 
 #ifdef __FreeBSD__
 #include <stdlib.h>
@@ -856,13 +863,120 @@ AudioBussMixer::threadRun()
 
 AudioFileReader::AudioFileReader(SoundDriver *driver,
                                  unsigned int sampleRate) :
-        AudioThread("AudioFileReader", driver, sampleRate)
+        AudioThread("AudioFileReader", driver, sampleRate),
+        m_ioPool(new QThreadPool),
+        m_ioThreads(std::max(1, Preferences::getAudioReadThreads()))
 {
-    // nothing else here
+    m_ioPool->setMaxThreadCount(m_ioThreads);
+    PlayableAudioFile::setReadAheadHints(Preferences::getAudioReadAheadHints());
 }
 
 AudioFileReader::~AudioFileReader()
-{}
+{
+    delete m_ioPool;
+}
+
+namespace
+{
+    struct ReadRequest
+    {
+        PlayableData *file;
+        /// fillBuffers() rather than updateBuffers().
+        bool fill;
+        /// How soon the file runs dry, in units of a quarter buffer.
+        size_t urgency;
+        AudioFileId audioFileId;
+        size_t position;
+    };
+
+    /// Do one thread's share of the reads, in order.
+    class ReadJob : public QRunnable
+    {
+    public:
+        ReadJob(const std::vector<const ReadRequest *> &requests,
+                const RealTime &fillTime,
+                std::atomic<bool> &someFilled) :
+            m_requests(requests),
+            m_fillTime(fillTime),
+            m_someFilled(someFilled)
+        { }
+
+        void run() override
+        {
+            for (const ReadRequest *request : m_requests) {
+                if (request->fill) {
+                    request->file->fillBuffers(m_fillTime);
+                    m_someFilled = true;
+                } else if (request->file->updateBuffers()) {
+                    m_someFilled = true;
+                }
+            }
+        }
+
+    private:
+        std::vector<const ReadRequest *> m_requests;
+        RealTime m_fillTime;
+        std::atomic<bool> &m_someFilled;
+    };
+
+    /// Carry out requests, most urgent first, on up to threads threads.
+    /**
+     * Returns true if any buffers were filled.
+     */
+    bool
+    readFiles(std::vector<ReadRequest> &requests,
+              const RealTime &fillTime,
+              QThreadPool *pool,
+              int threads)
+    {
+        if (requests.empty())
+            return false;
+
+        // Most urgent first.  Within the same urgency, keep reads from
+        // the same file together and in file order so the disk can
+        // stream them.
+        std::stable_sort(requests.begin(), requests.end(),
+                         [](const ReadRequest &a, const ReadRequest &b) {
+                             if (a.urgency != b.urgency)
+                                 return a.urgency < b.urgency;
+                             if (a.audioFileId != b.audioFileId)
+                                 return a.audioFileId < b.audioFileId;
+                             return a.position < b.position;
+                         });
+
+        // Each AudioFile goes to one thread, handed out in order of
+        // urgency so the most urgent files start first.
+        std::vector<std::vector<const ReadRequest *> > lanes(threads);
+        std::map<AudioFileId, size_t> laneForFile;
+        for (const ReadRequest &request : requests) {
+            auto inserted = laneForFile.insert(std::make_pair(
+                    request.audioFileId, laneForFile.size() % lanes.size()));
+            lanes[inserted.first->second].push_back(&request);
+        }
+
+        std::atomic<bool> someFilled(false);
+
+        if (laneForFile.size() == 1  ||  threads == 1) {
+            ReadJob(lanes[0], fillTime, someFilled).run();
+            return someFilled;
+        }
+
+        // The workers refer to requests on our stack, so we must not
+        // be cancelled until they are done.
+        int oldState;
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldState);
+
+        for (const std::vector<const ReadRequest *> &lane : lanes) {
+            if (!lane.empty())
+                pool->start(new ReadJob(lane, fillTime, someFilled));
+        }
+        pool->waitForDone();
+
+        pthread_setcancelstate(oldState, nullptr);
+
+        return someFilled;
+    }
+}
 
 void
 AudioFileReader::fillBuffers(const RealTime &currentTime)
@@ -891,16 +1005,25 @@ AudioFileReader::fillBuffers(const RealTime &currentTime)
         (*fi)->clearBuffers();
     }
 
+    std::vector<ReadRequest> requests;
+
     int allocated = 0;
     for (AudioPlayQueue::FileSet::const_iterator fi = files.begin();
             fi != files.end(); ++fi) {
-        (*fi)->fillBuffers(currentTime);
-        if ((*fi)->getEndTime() >= currentTime) {
+        PlayableData *file = *fi;
+        AudioFile *audioFile = file->getAudioFile();
+        requests.push_back(ReadRequest{
+                file, true, 0, audioFile ? audioFile->getId() : 0, 0 });
+        if (file->getEndTime() >= currentTime) {
             if (++allocated == poolSize)
                 break;
-        } // else the file's ring buffers will have been returned
+        } // else the file's ring buffers will be returned
     }
 
+    // All equally urgent.  The read positions aren't known until each
+    // file has scanned to currentTime, so these are only grouped by file.
+    readFiles(requests, currentTime, m_ioPool, m_ioThreads);
+
     releaseLock();
 }
 
@@ -913,8 +1036,6 @@ AudioFileReader::kick(bool wantLock)
     RealTime now = m_driver->getSequencerTime();
     const AudioPlayQueue *queue = m_driver->getAudioQueue();
 
-    bool someFilled = false;
-
     // Tell files that are playing or will be playing in the next few
     // seconds to update.
 
@@ -923,23 +1044,72 @@ AudioFileReader::kick(bool wantLock)
     queue->getPlayingFiles
     (now, RealTime(3, 0) + m_driver->getAudioReadBufferLength(), playing);
 
+    std::vector<ReadRequest> requests;
+    std::vector<BufferLevel> levels;
+    levels.reserve(playing.size());
+
     for (AudioPlayQueue::FileSet::iterator fi = playing.begin();
             fi != playing.end(); ++fi) {
 
-        if (!(*fi)->isBuffered()) {
+        PlayableData *file = *fi;
+        AudioFile *audioFile = file->getAudioFile();
+
+        const size_t bufferFrames = file->getBufferFrames();
+        const size_t available = file->getSampleFramesAvailable();
+
+        levels.push_back(BufferLevel{
+                file->getInstrument(), file->getRuntimeSegmentId(),
+                audioFile ? audioFile->getId() : 0,
+                available, bufferFrames });
+
+        ReadRequest request{
+                file, false, 0, audioFile ? audioFile->getId() : 0,
+                file->getReadPosition() };
+
+        if (!file->isBuffered()) {
             // fillBuffers has not been called on this file.  This
             // happens when a file is unmuted during playback.  The
             // results are unpredictable because we can no longer
             // synchronise with the correct JACK callback slice at
             // this point, but this is better than allowing the file
             // to update from its start as would otherwise happen.
-            (*fi)->fillBuffers(now);
-            someFilled = true;
-        } else {
-            if ((*fi)->updateBuffers())
-                someFilled = true;
+            request.fill = true;
+            requests.push_back(request);
+            continue;
         }
+
+        if (file->isFullyBuffered())
+            continue;
+
+        // Leave it until a quarter of the buffer is free so that the
+        // read is worth doing.
+        const size_t quarter = std::max(size_t(1), bufferFrames / 4);
+        if (bufferFrames > 0  &&  available + quarter > bufferFrames)
+            continue;
+
+        // Frames from now until this file runs dry.
+        size_t dry = available;
+        if (file->getStartTime() > now) {
+            dry += size_t(RealTime::realTime2Frame(
+                    file->getStartTime() - now, m_sampleRate));
+        }
+        request.urgency = dry / quarter;
+
+        requests.push_back(request);
+    }
+
+    {
+        QMutexLocker lock(&m_bufferLevelsMutex);
+        m_bufferLevels.swap(levels);
+    }
+
+#ifdef DEBUG_READER
+    if (!requests.empty()) {
+        std::cerr << "AudioFileReader::kick: " << requests.size() << " of " << playing.size() << " files need reading" << std::endl;
     }
+#endif
+
+    const bool someFilled = readFiles(requests, now, m_ioPool, m_ioThreads);
 
     if (wantLock)
         releaseLock();
@@ -947,6 +1117,13 @@ AudioFileReader::kick(bool wantLock)
     return someFilled;
 }
 
+std::vector<AudioFileReader::BufferLevel>
+AudioFileReader::getBufferLevels() const
+{
+    QMutexLocker lock(&m_bufferLevelsMutex);
+    return m_bufferLevels;
+}
+
 void
 AudioFileReader::threadRun()
 {
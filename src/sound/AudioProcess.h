@@ -21,6 +21,12 @@
 #include "RingBuffer.h"
 #include "RecordableAudioFile.h"
 
+#include <QMutex>
+
+#include <vector>
+
+class QThreadPool;
+
 
 namespace Rosegarden
 {
@@ -169,6 +175,15 @@ protected:
     BufferMap m_bufferMap;
 };
 
+/// Streams audio files from disk into their PlayableAudioFile buffers.
+/**
+ * Each pass works out how soon every playing file will run out of
+ * buffered audio and reads the most urgent first.  A file is only
+ * topped up once a fair part of its buffer is free, so reads are few
+ * and large rather than many and small.  Reads from the same AudioFile
+ * are kept together on one thread in file order, and different
+ * AudioFiles are spread over a few I/O threads.
+ */
 class AudioFileReader : public AudioThread
 {
 public:
@@ -185,8 +200,33 @@ public:
      */
     void fillBuffers(const RealTime &currentTime);
 
+    struct BufferLevel
+    {
+        InstrumentId instrumentId;
+        int runtimeSegmentId;
+        AudioFileId audioFileId;
+        /// Frames buffered and ready to play.
+        size_t framesAvailable;
+        /// Frames the buffer can hold.  0 if the file is not streamed.
+        size_t bufferFrames;
+    };
+
+    /// Buffer fill level of each playing file as of the last pass.
+    /**
+     * For diagnostics.  May be called from any thread.
+     */
+    std::vector<BufferLevel> getBufferLevels() const;
+
 protected:
     void threadRun() override;
+
+private:
+    /// Runs the reads on behalf of kick() and fillBuffers().
+    QThreadPool *m_ioPool;
+    int m_ioThreads;
+
+    mutable QMutex m_bufferLevelsMutex;
+    std::vector<BufferLevel> m_bufferLevels;
 };
 
 
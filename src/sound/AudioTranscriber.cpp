@@ -0,0 +1,328 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_NO_DEBUG_PRINT
+
+#include "AudioTranscriber.h"
+
+#include "misc/Debug.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Rosegarden
+{
+
+
+struct AudioTranscriber::Chunk
+{
+    /// First step of the pitch track this chunk fills in.
+    size_t firstStep{0};
+    size_t steps{0};
+
+    /// From the start of the first step's analysis frame.
+    std::vector<float> input;
+};
+
+class AudioTranscriber::ChunkJob : public QRunnable
+{
+public:
+    ChunkJob(AudioTranscriber *owner, Chunk *chunk, PitchDetector *detector) :
+        m_owner(owner),
+        m_chunk(chunk),
+        m_detector(detector)
+    { }
+
+    void run() override  { m_owner->analyseChunk(*m_chunk, *m_detector); }
+
+private:
+    AudioTranscriber *m_owner;
+    Chunk *m_chunk;
+    PitchDetector *m_detector;
+};
+
+AudioTranscriber::AudioTranscriber(int sampleRate,
+                                   int frameSize,
+                                   int stepSize,
+                                   int threadCount) :
+    m_sampleRate(sampleRate),
+    m_frameSize(frameSize),
+    m_stepSize(stepSize),
+    m_threadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount()),
+    // Ten seconds per chunk, as for ParallelTimeStretcher.
+    m_chunkFrames(size_t(sampleRate) * 10),
+    m_method(PitchDetector::AUTOCORRELATION),
+    m_threshold(-40),
+    m_minimumDuration(RealTime::fromMilliseconds(50)),
+    m_cancelled(false),
+    m_stepsDone(0)
+{
+    if (m_threadCount < 1)
+        m_threadCount = 1;
+}
+
+AudioTranscriber::~AudioTranscriber()
+{
+}
+
+bool
+AudioTranscriber::process(size_t inputFrames,
+                          ReadFunction read,
+                          PollFunction poll)
+{
+    m_cancelled = false;
+    m_stepsDone = 0;
+    m_notes.clear();
+
+    // Each step analyses a frame and the one a step after it, for the
+    // phase differences.
+    const size_t bufferFrames = size_t(m_frameSize + m_stepSize);
+    const size_t step = size_t(m_stepSize);
+
+    const size_t totalSteps = inputFrames >= bufferFrames ?
+            (inputFrames - bufferFrames) / step + 1 : 0;
+
+    m_pitches.assign(totalSteps, -1);
+    m_levels.assign(totalSteps, 0.f);
+
+    if (totalSteps == 0)
+        return true;
+
+    const size_t stepsPerChunk = std::max(size_t(1), m_chunkFrames / step);
+    const size_t chunkCount = (totalSteps + stepsPerChunk - 1) / stepsPerChunk;
+
+    RG_DEBUG << "process():" << inputFrames << "frames," << totalSteps <<
+                "steps in" << chunkCount << "chunks on" << m_threadCount <<
+                "threads";
+
+    auto percent = [&]() -> int {
+        return int(std::min(size_t(100), m_stepsDone * 100 / totalSteps));
+    };
+
+    // Input that has been read and is still needed, from pendingStart.
+    std::vector<float> pending;
+    size_t pendingStart = 0;
+    bool inputExhausted = false;
+
+    const size_t readBlockSize = 16384;
+    std::vector<float> readBuffer(readBlockSize);
+
+    for (size_t first = 0; first < chunkCount; first += m_threadCount) {
+
+        const size_t last =
+                std::min(chunkCount, first + size_t(m_threadCount));
+        std::vector<Chunk> chunks(last - first);
+
+        // Set up this wave's chunks.
+
+        for (size_t k = first; k < last; ++k) {
+            Chunk &chunk = chunks[k - first];
+
+            chunk.firstStep = k * stepsPerChunk;
+            const size_t steps =
+                    std::min(stepsPerChunk, totalSteps - chunk.firstStep);
+            const size_t inputStart = chunk.firstStep * step;
+            const size_t inputEnd = inputStart + (steps - 1) * step +
+                    bufferFrames;
+
+            while (!inputExhausted  &&
+                   pendingStart + pending.size() < inputEnd) {
+                const size_t got = read(readBuffer.data(), readBlockSize);
+                pending.insert(pending.end(),
+                               readBuffer.begin(), readBuffer.begin() + got);
+                if (got < readBlockSize)
+                    inputExhausted = true;
+            }
+
+            // The input may turn out to be shorter than promised.
+            const size_t available = pendingStart + pending.size();
+            if (available >= inputStart + bufferFrames) {
+                chunk.steps = std::min(
+                        steps,
+                        (available - inputStart - bufferFrames) / step + 1);
+                chunk.input.assign(
+                        pending.begin() + (inputStart - pendingStart),
+                        pending.begin() + (inputStart - pendingStart) +
+                                (chunk.steps - 1) * step + bufferFrames);
+            }
+
+            // Drop input that no later chunk needs.
+            const size_t keepFrom = std::min(
+                    available, (chunk.firstStep + stepsPerChunk) * step);
+            if (keepFrom > pendingStart) {
+                pending.erase(pending.begin(),
+                              pending.begin() + (keepFrom - pendingStart));
+                pendingStart = keepFrom;
+            }
+        }
+
+        // One detector per thread, kept for the later waves.
+        while (m_detectors.size() < chunks.size()) {
+            m_detectors.emplace_back(new PitchDetector(
+                    m_frameSize, m_stepSize, m_sampleRate));
+        }
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            m_detectors[i]->setMethod(m_method);
+        }
+
+        // Analyse them.
+
+        {
+            QThreadPool pool;
+            pool.setMaxThreadCount(m_threadCount);
+
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                pool.start(new ChunkJob(
+                        this, &chunks[i], m_detectors[i].get()));
+            }
+
+            while (!pool.waitForDone(20)) {
+                if (!poll(percent()))
+                    m_cancelled = true;
+            }
+        }
+
+        if (m_cancelled) {
+            RG_DEBUG << "process(): cancelled";
+            return false;
+        }
+    }
+
+    makeNotes();
+
+    poll(100);
+
+    return true;
+}
+
+void
+AudioTranscriber::analyseChunk(Chunk &chunk, PitchDetector &detector)
+{
+    const float threshold = powf(10.f, m_threshold / 20.f);
+    const size_t bufferFrames = size_t(m_frameSize + m_stepSize);
+    float *buffer = detector.getInBuffer();
+
+    for (size_t i = 0; i < chunk.steps; ++i) {
+
+        if (m_cancelled)
+            return;
+
+        const float *frame = chunk.input.data() + i * m_stepSize;
+        const size_t step = chunk.firstStep + i;
+
+        double sum = 0;
+        for (int c = 0; c < m_frameSize; ++c) {
+            sum += double(frame[c]) * frame[c];
+        }
+        const float level = float(sqrt(sum / m_frameSize));
+        m_levels[step] = level;
+
+        // Don't bother looking for a pitch in silence.
+        if (level >= threshold) {
+            std::copy(frame, frame + bufferFrames, buffer);
+            const double frequency = detector.getPitch();
+            if (frequency > 0) {
+                const long pitch = lrint(69 + 12 * log2(frequency / 440));
+                if (pitch >= 0  &&  pitch < 128)
+                    m_pitches[step] = int(pitch);
+            }
+        }
+
+        ++m_stepsDone;
+    }
+}
+
+void
+AudioTranscriber::makeNotes()
+{
+    const size_t steps = m_pitches.size();
+    const float threshold = powf(10.f, m_threshold / 20.f);
+
+    // A median over five steps gets rid of octave jumps and other short
+    // glitches in the pitch track.
+    std::vector<int> pitches(steps, -1);
+    for (size_t s = 0; s < steps; ++s) {
+        if (m_levels[s] < threshold)
+            continue;
+
+        int window[5];
+        int n = 0;
+        for (size_t w = (s < 2 ? 0 : s - 2);
+             w <= s + 2  &&  w < steps; ++w) {
+            window[n++] = m_pitches[w];
+        }
+        std::nth_element(window, window + n / 2, window + n);
+        pitches[s] = window[n / 2];
+    }
+
+    // Time at the middle of a step's analysis frame.
+    auto stepTime = [this](size_t s) -> RealTime {
+        return RealTime::frame2RealTime(
+                long(s) * m_stepSize + m_frameSize / 2, m_sampleRate);
+    };
+
+    auto velocity = [this](float level) -> int {
+        const float dB = 20.f * log10f(std::max(level, 1e-9f));
+        const float scaled = m_threshold < 0 ?
+                1.f + 126.f * (dB - m_threshold) / -m_threshold : 100.f;
+        return std::max(1, std::min(127, int(lrintf(scaled))));
+    };
+
+    const size_t minimumSteps = std::max(size_t(1), size_t(lrint(
+            m_minimumDuration.toSeconds() * m_sampleRate / m_stepSize)));
+
+    size_t start = 0;
+    int pitch = -1;
+    float peak = 0;
+
+    for (size_t s = 0; s <= steps; ++s) {
+        const int p = s < steps ? pitches[s] : -1;
+
+        // The level doubling from one step to the next is a new attack
+        // on the same pitch.
+        const bool onset = p >= 0  &&  p == pitch  &&
+                s - start >= minimumSteps  &&
+                m_levels[s] > m_levels[s - 1] * 2;
+
+        if (p != pitch  ||  onset) {
+            if (pitch >= 0  &&  s - start >= minimumSteps) {
+                Note note;
+                note.time = stepTime(start);
+                note.duration = stepTime(s) - note.time;
+                note.pitch = pitch;
+                note.velocity = velocity(peak);
+                m_notes.push_back(note);
+            }
+            start = s;
+            pitch = p;
+            peak = 0;
+        }
+
+        if (s < steps)
+            peak = std::max(peak, m_levels[s]);
+    }
+
+    RG_DEBUG << "makeNotes():" << m_notes.size() << "notes from" << steps <<
+                "steps";
+}
+
+
+}
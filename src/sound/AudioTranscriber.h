@@ -0,0 +1,153 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_AUDIO_TRANSCRIBER_H
+#define RG_AUDIO_TRANSCRIBER_H
+
+#include "PitchDetector.h"
+#include "base/RealTime.h"
+
+#include <rosegardenprivate_export.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <stddef.h>
+
+namespace Rosegarden
+{
+
+
+/// Transcribe a monophonic recording into notes, faster than real time.
+/**
+ * The input is cut into chunks of getChunkFrames() frames which are run
+ * through PitchDetector on a pool of worker threads.  Neighbouring
+ * chunks share one analysis frame of input so that every step of the
+ * pitch track is analysed exactly once.  There is one PitchDetector,
+ * and so one set of FFTW plans, per thread, reused for every chunk that
+ * thread is given.
+ *
+ * Chunks are processed in waves of getThreadCount() chunks, so memory
+ * use is bounded by the chunk size regardless of the length of the
+ * input.  All reading and polling happens on the calling thread.
+ *
+ * Once the pitch track is complete it is smoothed and cut into notes on
+ * the calling thread.  A note starts wherever the pitch changes or the
+ * level jumps, and ends at the next change or where the level drops
+ * below the threshold.
+ *
+ * Used by AudioFileTranscriber.
+ */
+class ROSEGARDENPRIVATE_EXPORT AudioTranscriber
+{
+public:
+    /**
+     * threadCount of 0 means one thread per core.
+     */
+    AudioTranscriber(int sampleRate,
+                     int frameSize = PitchDetector::defaultFrameSize,
+                     int stepSize = PitchDetector::defaultStepSize,
+                     int threadCount = 0);
+    ~AudioTranscriber();
+
+    /// One of PitchDetector::getMethods().
+    void setMethod(const PitchDetector::Method &method)
+            { m_method = method; }
+
+    /// Level in dB below which the input counts as silence.
+    void setThreshold(float dB)  { m_threshold = dB; }
+
+    /// Shorter notes are dropped as glitches.
+    void setMinimumDuration(const RealTime &duration)
+            { m_minimumDuration = duration; }
+
+    /// Read up to frames frames of mono input into buffer.
+    /**
+     * Returns the number of frames read.  Fewer than requested means
+     * the end of the input has been reached.
+     */
+    typedef std::function<size_t (float *buffer, size_t frames)>
+            ReadFunction;
+    /// Called regularly while the workers run.  Return false to cancel.
+    typedef std::function<bool (int percent)> PollFunction;
+
+    /// Transcribe inputFrames frames from read().
+    /**
+     * Returns false if cancelled.
+     */
+    bool process(size_t inputFrames, ReadFunction read, PollFunction poll);
+
+    struct Note
+    {
+        /// From the start of the input.
+        RealTime time;
+        RealTime duration;
+        int pitch;
+        int velocity;
+    };
+
+    /// The notes found by process(), in time order.
+    const std::vector<Note> &getNotes() const  { return m_notes; }
+
+    int getThreadCount() const  { return m_threadCount; }
+
+    size_t getChunkFrames() const  { return m_chunkFrames; }
+    /// Input frames per chunk.  Mainly for testing.
+    void setChunkFrames(size_t frames)  { m_chunkFrames = frames; }
+
+private:
+    struct Chunk;
+    class ChunkJob;
+
+    /// Fill chunk's part of the pitch track.  Called on a worker thread.
+    void analyseChunk(Chunk &chunk, PitchDetector &detector);
+
+    /// Cut the pitch track into m_notes.
+    void makeNotes();
+
+    int m_sampleRate;
+    int m_frameSize;
+    int m_stepSize;
+    int m_threadCount;
+    size_t m_chunkFrames;
+
+    PitchDetector::Method m_method;
+    float m_threshold;
+    RealTime m_minimumDuration;
+
+    /// One per thread.  Created on the calling thread, on first use,
+    /// since FFTW planning is not thread-safe.
+    std::vector<std::unique_ptr<PitchDetector> > m_detectors;
+
+    /// MIDI pitch at each step, or -1 where there is none.
+    std::vector<int> m_pitches;
+    /// RMS level at each step.
+    std::vector<float> m_levels;
+
+    std::vector<Note> m_notes;
+
+    std::atomic<bool> m_cancelled;
+    /// Steps analysed so far, for progress.
+    std::atomic<size_t> m_stepsDone;
+};
+
+
+}
+
+#endif
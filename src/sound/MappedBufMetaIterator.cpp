@@ -24,8 +24,7 @@
 #include "gui/seqmanager/MEBIterator.h"
 #include "sound/ControlBlock.h"
 
-#include <queue>  // std::priority_queue
-#include <functional>  // std::greater
+#include <algorithm>
 
 //#define DEBUG_META_ITERATOR 1
 //#define DEBUG_PLAYING_AUDIO_FILES 1
@@ -34,6 +33,13 @@ namespace Rosegarden
 {
 
 
+MappedBufMetaIterator::MappedBufMetaIterator() :
+    m_nextScheduled(0),
+    m_scheduleValid(false),
+    m_scheduleChanges(0)
+{
+}
+
 void
 MappedBufMetaIterator::addBuffer(
         QSharedPointer<MappedEventBuffer> mappedEventBuffer)
@@ -52,6 +58,8 @@ MappedBufMetaIterator::addBuffer(
     QSharedPointer<MEBIterator> iter(new MEBIterator(mappedEventBuffer));
     iter->moveTo(m_currentTime);
     m_iterators.push_back(iter);
+
+    m_scheduleValid = false;
 }
 
 void
@@ -71,6 +79,8 @@ MappedBufMetaIterator::removeBuffer(
 
     // Remove from m_segments
     m_buffers.erase(mappedEventBuffer);
+
+    m_scheduleValid = false;
 }
 
 void
@@ -78,6 +88,10 @@ MappedBufMetaIterator::clear()
 {
     m_iterators.clear();
     m_buffers.clear();
+
+    m_schedule.clear();
+    m_activeSet.clear();
+    m_scheduleValid = false;
 }
 
 void
@@ -107,6 +121,8 @@ MappedBufMetaIterator::jumpToTime(const RealTime &time)
          ++i) {
         (*i)->moveTo(time);
     }
+
+    m_scheduleValid = false;
 }
 
 void
@@ -160,23 +176,23 @@ MappedBufMetaIterator::fetchEvents(MappedInserterBase &inserter,
     // there will be anything interesting ever going on in this routine.
 
     // Make a set of all buffer starts that occur during the slice sorted
-    // from earliest to latest.
+    // from earliest to latest.  m_schedule is in start order, so only
+    // the buffers that start during the slice need to be looked at.
     typedef std::set<RealTime> TimeSet;
     TimeSet bufferStarts;
 
-    // For each buffer.
-    for (BufferSet::iterator i = m_buffers.begin();
-         i != m_buffers.end();
+    updateSchedule(startTime);
+
+    ScheduledVector::const_iterator first = std::lower_bound(
+            m_schedule.begin(), m_schedule.end(), startTime,
+            [](const Scheduled &scheduled, const RealTime &time)
+                { return scheduled.start < time; });
+
+    for (ScheduledVector::const_iterator i = first;
+         i != m_schedule.end()  &&  i->start < endTime;
          ++i) {
-        RealTime start;
-        RealTime end;
-        (*i)->getStartEnd(start, end);
-        // If this segment's start is within the timeslice, add it
-        // to bufferStarts.
-        if (start >= startTime  &&  start < endTime) {
-            bufferStarts.insert(start);
-            //RG_DEBUG << "sub-slice: " << start;
-        }
+        bufferStarts.insert(i->start);
+        //RG_DEBUG << "sub-slice: " << i->start;
     }
 
     //if (!bufferStarts.empty()) {
@@ -223,160 +239,189 @@ fetchEventsNoncompeting(MappedInserterBase &inserter,
     //Profiler profiler("MappedBufMetaIterator::fetchEventsNoncompeting", false);
 
     m_currentTime = endTime;
-    
-    // For each segment (MEBIterator), activate segments that have anything
-    // playing.
-    for (IteratorVector::iterator i = m_iterators.begin();
-         i != m_iterators.end();
-         ++i) { 
-        RealTime start;
-        RealTime end;
-        (*i)->getMappedEventBuffer()->getStartEnd(start, end);
-
-        // Activate MEBIterators for Segments that have something playing during
-        // this time slice.  We include Segments that end exactly when we start,
-        // but not Segments that start exactly when we end.
-        //
-        // Activation makes it easier to focus on relevant Segments later in
-        // this routine.
-        // Might want to consider assembling a vector of relevant MEBIterators
-        // and iterating through that instead of storing a flag in MEBIterator.
-        // We'll still need to set the current time.  Alternatively, we could
-        // do this check further down while we are going through the
-        // MEBIterators.  That would eliminate the need for a flag or a vector.
-        bool active = (start < endTime  &&  end >= startTime);
-        (*i)->setActive(active, startTime);
+
+    // Bring the active set up to date.  Only the Segments that have
+    // something playing during this time slice are in it.  We include
+    // Segments that end exactly when we start, but not Segments that
+    // start exactly when we end.
+    updateActiveSet(startTime, endTime);
+
+    // Merge the events of the active iterators in time order.  Each
+    // iterator is in the m_pending heap, keyed by the time of its next
+    // event, for as long as it has events due in this slice.  So the
+    // work per slice goes with the number of events fetched rather than
+    // the number of Segments.
+    //
+    // This replaces a round-robin that took one event from each Segment
+    // per pass until none had more.
+    m_pending.clear();
+
+    for (size_t order = 0; order < m_activeSet.size(); ++order) {
+        MEBIterator *iter = m_activeSet[order].iter;
+        iter->setActive(true, startTime);
+
+        QReadLocker locker(iter->getLock());
+        queueNext(inserter, iter, order, startTime, endTime);
     }
 
-    // State variable to allow the outer (round-robin) loop to run until
-    // the inner (segment) loop has nothing to do.
-    bool segmentsHaveMore = false;
-
-    // For each pass through the segments.
-    // On each pass, we only process one event in each segment.
-    // ??? Why not process all the events in each segment?
-    //     for each segment
-    //         for each event
-    //             process the event
-    //         rof
-    //     rof
-    //     Is this round-robin approach intended to spread the locks out?
-    //     Is it really necessary?
-    //     Prior to the auto-channels feature, this routine was called
-    //     MappedSegmentsMetaIterator::fillCompositionWithEventsUntil().
-    //     It has always used this round-robin approach.
-    do {
-        segmentsHaveMore = false;
-
-        // For each segment, process only the first event.
-        for (IteratorVector::iterator i = m_iterators.begin();
-             i != m_iterators.end();
-             ++i) {
-            QSharedPointer<MEBIterator> iter = (*i);
+    while (!m_pending.empty()) {
+        std::pop_heap(m_pending.begin(), m_pending.end());
+        const Pending next = m_pending.back();
+        m_pending.pop_back();
 
-#ifdef DEBUG_META_ITERATOR
-            RG_DEBUG << "fetchEventsNoncompeting() : checking segment #" << i;
-#endif
+        MEBIterator *iter = next.iter;
 
-            // Skip any segments that aren't active.
-            if (!iter->getActive()) {
-#ifdef DEBUG_META_ITERATOR
-                RG_DEBUG << "fetchEventsNoncompeting() : no more events to get for this slice in segment #" << i;
-#endif
+        // This locks the iterator's buffer against writes, lest
+        // writing cause reallocating the buffer while we are
+        // holding a pointer into it.  No function we call will
+        // hold the `event' pointer past its own scope, implying
+        // that nothing holds it past an iteration of this loop,
+        // which is this lock's scope.
+        QReadLocker locker(iter->getLock());
 
-                continue;
-            }
+        MappedEvent *event = iter->peek();
 
-            if (iter->atEnd()) {
-#ifdef DEBUG_META_ITERATOR
-                RG_DEBUG << "fetchEventsNoncompeting() : " << endTime << " reached end of segment #" << i;
-#endif
-                // Make this iterator abort early in future
-                // iterations, since we know it's all done.
-                iter->setInactive();
-                continue;
-            }
+        // The buffer may have been refilled since the event was
+        // queued.  If so, look again.
+        if (!event  ||  !event->isValid()  ||
+            event->getEventTime() != next.time) {
+            queueNext(inserter, iter, next.order, startTime, endTime);
+            continue;
+        }
 
-            // This locks the iterator's buffer against writes, lest
-            // writing cause reallocating the buffer while we are
-            // holding a pointer into it.  No function we call will
-            // hold the `event' pointer past its own scope, implying
-            // that nothing holds it past an iteration of this loop,
-            // which is this lock's scope.
-            QReadLocker locker(iter->getLock());
-
-            MappedEvent *event = iter->peek();
-
-            // We couldn't fetch an event or it failed a sanity check.
-            // So proceed to the next iterator but keep looking at
-            // this one - incrementing it does nothing useful, and it
-            // might get more events.  But don't set segmentsHaveMore,
-            // lest we loop forever waiting for a valid event.
-            if (!event  ||  !event->isValid())
-                continue;
+        // Increment the iterator, since we're taking this event.
+        ++(*iter);
 
-            // If we got this far, make the mapper ready.  Do this
-            // even if the note won't play during this slice, because
-            // sometimes/always we prepare channels slightly ahead of
-            // their first notes, to fix bug #1378
-            if (!iter->isReady())
-                iter->makeReady(inserter, startTime);
-
-            // If this event starts prior to the end of the slice, take it.
-            if (event->getEventTime() < endTime) {
-                // Increment the iterator, since we're taking this
-                // event.  NB, in the other branch it is not yet used
-                // so we leave `iter' where it is.
-                ++(*iter);
-
-                // If we got this far, we'll want to try the next
-                // iteration, so note it.
-                segmentsHaveMore = true;
-                
 #ifdef DEBUG_META_ITERATOR
-                RG_DEBUG << "  Event...";
-                QString trackId = QString::number(event->getTrackId());
-                if (event->getTrackId() == NoTrack)
-                    trackId += " (NoTrack)";
-                RG_DEBUG << "    Track ID:" << trackId <<
-                            " channel:" << (unsigned int) event->getRecordedChannel() <<
-                            " inst:" << event->getInstrument();
-                QString eventType = QString::number(event->getType());
-                if (event->getType() & MappedEvent::MidiNote)
-                    eventType += " (MidiNote)";
-                if (event->getType() & MappedEvent::MidiNoteOneShot)
-                    eventType += " (MidiNoteOneShot)";
-                RG_DEBUG << "    Event type:" << eventType <<
-                            " time:" << event->getEventTime() <<
-                            " duration:" << event->getDuration() <<
-                            " data1:" << (unsigned int)event->getData1() <<
-                            " data2:" << (unsigned int)event->getData2();
+        RG_DEBUG << "  Event...";
+        QString trackId = QString::number(event->getTrackId());
+        if (event->getTrackId() == NoTrack)
+            trackId += " (NoTrack)";
+        RG_DEBUG << "    Track ID:" << trackId <<
+                    " channel:" << (unsigned int) event->getRecordedChannel() <<
+                    " inst:" << event->getInstrument();
+        QString eventType = QString::number(event->getType());
+        if (event->getType() & MappedEvent::MidiNote)
+            eventType += " (MidiNote)";
+        if (event->getType() & MappedEvent::MidiNoteOneShot)
+            eventType += " (MidiNoteOneShot)";
+        RG_DEBUG << "    Event type:" << eventType <<
+                    " time:" << event->getEventTime() <<
+                    " duration:" << event->getDuration() <<
+                    " data1:" << (unsigned int)event->getData1() <<
+                    " data2:" << (unsigned int)event->getData2();
 #endif
 
-                if (iter->shouldPlay(event, startTime)) {
-                    iter->doInsert(inserter, *event);
+        if (iter->shouldPlay(event, startTime)) {
+            iter->doInsert(inserter, *event);
 #ifdef DEBUG_META_ITERATOR
-                    RG_DEBUG << "  Inserting event";
+            RG_DEBUG << "  Inserting event";
 #endif
 
-                } else {
+        } else {
 #ifdef DEBUG_META_ITERATOR
-                    RG_DEBUG << "  Skipping event";
+            RG_DEBUG << "  Skipping event";
 #endif
-                }
-            } else {
-                // This iterator has more events but they only sound
-                // after the end of this slice, so it's done.
-                iter->setInactive();
+        }
+
+        queueNext(inserter, iter, next.order, startTime, endTime);
+    }
+}
 
+void
+MappedBufMetaIterator::queueNext(MappedInserterBase &inserter,
+                                 MEBIterator *iter, size_t order,
+                                 const RealTime &startTime,
+                                 const RealTime &endTime)
+{
+    if (iter->atEnd()) {
 #ifdef DEBUG_META_ITERATOR
-                RG_DEBUG << "fetchEventsNoncompeting() : Event is past end for segment #" << i;
+        RG_DEBUG << "queueNext() : " << endTime << " reached end of segment";
 #endif
-            }
-        }
-    } while (segmentsHaveMore);
+        iter->setInactive();
+        return;
+    }
+
+    MappedEvent *event = iter->peek();
+
+    // We couldn't fetch an event or it failed a sanity check.  Leave
+    // this iterator where it is, it might get more events, but don't
+    // queue it lest we loop forever waiting for a valid event.
+    if (!event  ||  !event->isValid())
+        return;
+
+    // If we got this far, make the mapper ready.  Do this even if the
+    // note won't play during this slice, because sometimes/always we
+    // prepare channels slightly ahead of their first notes, to fix bug
+    // #1378
+    if (!iter->isReady())
+        iter->makeReady(inserter, startTime);
+
+    // This iterator has more events but they only sound after the end
+    // of this slice, so it's done.
+    if (event->getEventTime() >= endTime) {
+        iter->setInactive();
+        return;
+    }
+
+    m_pending.push_back({ event->getEventTime(), order, iter });
+    std::push_heap(m_pending.begin(), m_pending.end());
+}
+
+void
+MappedBufMetaIterator::updateSchedule(const RealTime &startTime)
+{
+    // Rebuild if the buffers have changed, if any buffer's sounding
+    // times have changed, or if time has gone backwards.
+    const int changes = MappedEventBuffer::getStartEndChanges();
+    if (m_scheduleValid  &&  changes == m_scheduleChanges  &&
+        startTime >= m_scheduleTime)
+        return;
+
+    m_schedule.clear();
+    m_schedule.reserve(m_iterators.size());
+
+    for (const QSharedPointer<MEBIterator> &iter : m_iterators) {
+        Scheduled scheduled;
+        iter->getMappedEventBuffer()->getStartEnd(
+                scheduled.start, scheduled.end);
+        scheduled.iter = iter.data();
+        m_schedule.push_back(scheduled);
+    }
+
+    std::stable_sort(m_schedule.begin(), m_schedule.end(),
+                     [](const Scheduled &a, const Scheduled &b)
+                         { return a.start < b.start; });
 
-    return;
+    m_nextScheduled = 0;
+    m_activeSet.clear();
+    m_scheduleValid = true;
+    m_scheduleChanges = changes;
+    m_scheduleTime = startTime;
+}
+
+void
+MappedBufMetaIterator::updateActiveSet(const RealTime &startTime,
+                                       const RealTime &endTime)
+{
+    updateSchedule(startTime);
+    m_scheduleTime = startTime;
+
+    // Admit the buffers that start before this slice ends.
+    while (m_nextScheduled < m_schedule.size()  &&
+           m_schedule[m_nextScheduled].start < endTime) {
+        m_activeSet.push_back(m_schedule[m_nextScheduled]);
+        ++m_nextScheduled;
+    }
+
+    // Drop the ones that ended before it starts.  Slices only move
+    // forward, so they won't be wanted again until updateSchedule()
+    // starts over.
+    m_activeSet.erase(
+            std::remove_if(m_activeSet.begin(), m_activeSet.end(),
+                           [&startTime](const Scheduled &scheduled)
+                               { return scheduled.end < startTime; }),
+            m_activeSet.end());
 }
 
 void
@@ -409,6 +454,19 @@ MappedBufMetaIterator::resetIteratorForBuffer(
     }
 }
 
+void
+MappedBufMetaIterator::resumeIteratorForBuffer(
+        QSharedPointer<MappedEventBuffer> mappedEventBuffer)
+{
+    for (QSharedPointer<MEBIterator> iter : m_iterators) {
+        if (iter->getMappedEventBuffer() == mappedEventBuffer) {
+            iter->reset();
+            iter->skipTo(m_currentTime);
+            break;
+        }
+    }
+}
+
 void
 MappedBufMetaIterator::getAudioEvents(std::vector<MappedEvent> &audioEvents)
 {
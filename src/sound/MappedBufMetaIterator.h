@@ -60,6 +60,8 @@ class MEBIterator;
 class MappedBufMetaIterator
 {
 public:
+    MappedBufMetaIterator();
+
     void addBuffer(QSharedPointer<MappedEventBuffer>);
     void removeBuffer(QSharedPointer<MappedEventBuffer>);
 
@@ -92,6 +94,15 @@ public:
             QSharedPointer<MappedEventBuffer> mappedEventBuffer,
             bool immediate);
 
+    /// Pick up at the current time after the buffer's window moved.
+    /**
+     * What has been played already is skipped rather than re-fired.
+     *
+     * @see MappedEventBuffer::setWindow()
+     */
+    void resumeIteratorForBuffer(
+            QSharedPointer<MappedEventBuffer> mappedEventBuffer);
+
     void getAudioEvents(std::vector<MappedEvent> &);
 
     // For debugging.
@@ -112,6 +123,68 @@ private:
     /// Reset all iterators to beginning
     void reset();
 
+    /// An iterator and its buffer's sounding times.
+    struct Scheduled
+    {
+        RealTime start;
+        RealTime end;
+        MEBIterator *iter;
+    };
+    typedef std::vector<Scheduled> ScheduledVector;
+
+    /// All the iterators, ordered by when their buffers start sounding.
+    /**
+     * Slices are fetched in time order, so the iterators that become
+     * active can be taken from the front of this as they are reached,
+     * without looking at the ones that are idle.
+     *
+     * @see updateActiveSet()
+     */
+    ScheduledVector m_schedule;
+    /// The first iterator in m_schedule that has not started yet.
+    size_t m_nextScheduled;
+    /// Set to rebuild m_schedule, e.g. when the buffers change.
+    bool m_scheduleValid;
+    /// MappedEventBuffer::getStartEndChanges() when m_schedule was built.
+    int m_scheduleChanges;
+    /// Start of the last slice m_activeSet was updated for.
+    RealTime m_scheduleTime;
+
+    /// Iterators whose buffers sound during the current slice.
+    ScheduledVector m_activeSet;
+
+    /// Make sure m_schedule is up to date for a slice starting at startTime.
+    void updateSchedule(const RealTime &startTime);
+    /// Bring m_activeSet up to date for a new slice.
+    void updateActiveSet(const RealTime &startTime, const RealTime &endTime);
+
+    /// An iterator waiting in the merge of fetchEventsNoncompeting().
+    struct Pending
+    {
+        /// Time of the iterator's next event.
+        RealTime time;
+        /// Position in m_activeSet, to break ties the same way every time.
+        size_t order;
+        MEBIterator *iter;
+
+        /// Order for a min-heap: earliest first.
+        bool operator<(const Pending &other) const {
+            if (time != other.time)
+                return time > other.time;
+            return order > other.order;
+        }
+    };
+    /// Heap of the iterators with events due in the current slice.
+    std::vector<Pending> m_pending;
+
+    /// Queue iter's next event if it is due before endTime.
+    /**
+     * Caller must hold iter's read lock.
+     */
+    void queueNext(MappedInserterBase &inserter, MEBIterator *iter,
+                   size_t order,
+                   const RealTime &startTime, const RealTime &endTime);
+
     /// Fetch events during an interval, with non-competing buffers.
     /**
      * Caller guarantees that the buffers are non-competing, meaning
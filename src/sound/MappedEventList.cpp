@@ -16,22 +16,29 @@
 
 #include "MappedEvent.h"
 
+#include <algorithm>
+
 
 namespace Rosegarden
 {
 
 
+MappedEventList::MappedEventList() :
+    m_owned(0),
+    m_poolUsed(0)
+{
+}
+
 MappedEventList::~MappedEventList()
 {
     clear();
 }
 
 // copy constructor
-MappedEventList::MappedEventList(const MappedEventList &mC):
-    std::multiset<MappedEvent *, MappedEvent::MappedEventCmp>()
+MappedEventList::MappedEventList(const MappedEventList &mC) :
+    m_owned(0),
+    m_poolUsed(0)
 {
-    clear();
-
     // deep copy
     for (MappedEventList::const_iterator it = mC.begin(); it != mC.end(); ++it)
         insert(new MappedEvent(**it));
@@ -59,12 +66,74 @@ MappedEventList::merge(const MappedEventList &mC)
 }
 
 void
-MappedEventList::clear()
+MappedEventList::insert(MappedEvent *event)
 {
-    for (MappedEventListIterator it = begin(); it != end(); ++it)
-        delete (*it);
+    append(event);
+    ++m_owned;
+}
+
+void
+MappedEventList::append(MappedEvent *event)
+{
+    // They mostly come in time order.
+    if (m_events.empty()  ||  !(*event < *m_events.back())) {
+        m_events.push_back(event);
+        return;
+    }
+
+    // After any events at the same time.
+    m_events.insert(std::upper_bound(m_events.begin(), m_events.end(),
+                                     event, MappedEvent::MappedEventCmp()),
+                    event);
+}
 
-    erase(begin(), end());
+MappedEvent *
+MappedEventList::insertCopy(const MappedEvent &event)
+{
+    const size_t block = m_poolUsed / PoolBlockSize;
+    if (block == m_poolBlocks.size())
+        m_poolBlocks.emplace_back(new MappedEvent[PoolBlockSize]);
+
+    MappedEvent *copy = &m_poolBlocks[block][m_poolUsed % PoolBlockSize];
+    *copy = event;
+    ++m_poolUsed;
+
+    append(copy);
+    return copy;
+}
+
+bool
+MappedEventList::fromPool(const MappedEvent *event) const
+{
+    std::less<const MappedEvent *> less;
+
+    for (const std::unique_ptr<MappedEvent[]> &block : m_poolBlocks) {
+        if (!less(event, block.get())  &&
+            less(event, block.get() + PoolBlockSize))
+            return true;
+    }
+
+    return false;
+}
+
+void
+MappedEventList::clear()
+{
+    // The pool's events are recycled rather than deleted, all at once.
+    if (!m_poolUsed) {
+        for (MappedEvent *event : m_events) {
+            delete event;
+        }
+    } else if (m_owned) {
+        for (MappedEvent *event : m_events) {
+            if (!fromPool(event))
+                delete event;
+        }
+    }
+
+    m_events.clear();
+    m_owned = 0;
+    m_poolUsed = 0;
 }
 
 
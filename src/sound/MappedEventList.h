@@ -19,8 +19,10 @@
 
 #include "base/Composition.h"
 #include "MappedEvent.h"
-#include <set>
-#include <QDataStream>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 namespace Rosegarden
 {
@@ -36,12 +38,25 @@ namespace Rosegarden
  * MappedEventList is a normal container with nothing fixed about it;
  * it's just the container that happens to be used in sequencer
  * threads when a set of MappedEvents is called for.
+ *
+ * The events are kept in a flat vector, in time order.  An event goes
+ * after any others at the same time.  Since they mostly come in time
+ * order, adding one is usually just an append.
+ *
+ * A list that is filled and cleared over and over, like the one the
+ * sequencer fetches each playback slice into, can use insertCopy().
+ * The copies come from a pool that clear() recycles, so once the pool
+ * and the vector have grown to fit a slice, filling the list again
+ * doesn't allocate.
  */
-class MappedEventList : public std::multiset<MappedEvent *,
-                                             MappedEvent::MappedEventCmp>
+class MappedEventList
 {
 public:
-    MappedEventList() { }
+    typedef std::vector<MappedEvent *> EventVector;
+    typedef EventVector::iterator iterator;
+    typedef EventVector::const_iterator const_iterator;
+
+    MappedEventList();
     MappedEventList(const MappedEventList &mC);
 
     void merge(const MappedEventList &mC);
@@ -50,12 +65,100 @@ public:
 
     ~MappedEventList();
 
-    // Clear out
+    /// Add an event allocated with new.  The list owns it until erased.
+    void insert(MappedEvent *event);
+    /// Add the events in [first, last).  The list takes ownership.
+    template <class Iterator>
+    void insert(Iterator first, Iterator last)
+    {
+        for ( ; first != last; ++first)
+            insert(*first);
+    }
+
+    /// Add a copy of event from the list's pool.
+    /**
+     * The copy belongs to the pool.  It lives until clear() and must not
+     * be handed to another list.
+     */
+    MappedEvent *insertCopy(const MappedEvent &event);
+
+    iterator begin()  { return m_events.begin(); }
+    iterator end()  { return m_events.end(); }
+    const_iterator begin() const  { return m_events.begin(); }
+    const_iterator end() const  { return m_events.end(); }
+
+    size_t size() const  { return m_events.size(); }
+    bool empty() const  { return m_events.empty(); }
+
+    /// Remove an event without deleting it.  The caller owns it then.
+    /**
+     * Unless it is a pool copy, which stays with the pool.
+     */
+    iterator erase(iterator i)
+    {
+        if (!fromPool(*i))
+            --m_owned;
+        return m_events.erase(i);
+    }
+    iterator erase(iterator first, iterator last)
+    {
+        if (m_poolBlocks.empty()) {
+            m_owned -= last - first;
+        } else {
+            for (const_iterator i = first; i != last; ++i) {
+                if (!fromPool(*i))
+                    --m_owned;
+            }
+        }
+        return m_events.erase(first, last);
+    }
+
+    /// Delete the events that predicate(event) is true for, in one pass.
+    /**
+     * Pool copies are only removed from the list.
+     */
+    template <class Predicate>
+    void deleteIf(Predicate predicate)
+    {
+        m_events.erase(
+                std::remove_if(m_events.begin(), m_events.end(),
+                               [this, &predicate](MappedEvent *event) {
+                                   if (!predicate(event))
+                                       return false;
+                                   if (!fromPool(event)) {
+                                       delete event;
+                                       --m_owned;
+                                   }
+                                   return true;
+                               }),
+                m_events.end());
+    }
+
+    /// Delete the events and empty the list, keeping its storage.
     void clear();
+
+private:
+    /// Add an event in time order, without taking ownership of it.
+    void append(MappedEvent *event);
+
+    bool fromPool(const MappedEvent *event) const;
+
+    EventVector m_events;
+    /// Number of events in m_events that were added by insert().
+    /**
+     * So that clear() only has to look for them in a list that has
+     * both kinds, which the sequencer's lists never do.
+     */
+    size_t m_owned;
+
+    /// Storage for insertCopy(), in blocks so that it never moves.
+    static constexpr size_t PoolBlockSize = 256;
+    std::vector<std::unique_ptr<MappedEvent[]> > m_poolBlocks;
+    /// Number of pool slots in use.
+    size_t m_poolUsed;
 };
 
-typedef std::multiset<MappedEvent *, MappedEvent::MappedEventCmp>::iterator
-    MappedEventListIterator;
+typedef MappedEventList::iterator MappedEventListIterator;
 
 }
 
@@ -38,8 +38,13 @@
 #include "sound/SortingInserter.h"
 
 #include <QProgressDialog>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
+#include <atomic>
 #include <fstream>
+#include <limits>
 #include <string>
 #include <sstream>
 
@@ -136,10 +141,6 @@ MidiFile::read(std::ifstream *midiFile, unsigned long numberOfBytes)
     while (stringRet.length() < numberOfBytes  &&
            midiFile->read(&fileMidiByte, 1)) {
         stringRet += fileMidiByte;
-
-        // Kick the event loop to make sure the UI doesn't become
-        // unresponsive during a long load.
-        qApp->processEvents();
     }
 
     // Unexpected EOF
@@ -158,6 +159,10 @@ MidiFile::read(std::ifstream *midiFile, unsigned long numberOfBytes)
     if (m_bytesRead >= 2000) {
         m_bytesRead = 0;
 
+        // Kick the event loop to make sure the UI doesn't become
+        // unresponsive during a long load.
+        qApp->processEvents();
+
         // Update the progress dialog if one is connected.
         if (m_progressDialog) {
             if (m_progressDialog->wasCanceled())
@@ -752,6 +757,7 @@ MidiFile::convertToRosegarden(const QString &filename, RosegardenDocument *doc)
         timeT endOfLastNote = 0;
 
         // Statistics.
+        int eventCount = 0;
         int noteCount = 0;
         int keySigCount = 0;
 
@@ -763,8 +769,9 @@ MidiFile::convertToRosegarden(const QString &filename, RosegardenDocument *doc)
              ++midiEventIter) {
             const MidiEvent &midiEvent = **midiEventIter;
 
-            // Kick the event loop.
-            qApp->processEvents();
+            // Kick the event loop every so often.
+            if (++eventCount % 1000 == 0)
+                qApp->processEvents();
 
             const timeT midiAbsoluteTime = midiEvent.getTime();
             const timeT midiDuration = midiEvent.getDuration();
@@ -1351,7 +1358,7 @@ MidiFile::convertToMidi(RosegardenDocument *doc, const QString &filename)
     MidiInserter inserter(composition, Preferences::getSMFExportPPQN(), end);
     // Copy the events from sorter to inserter.
     sorter.insertSorted(inserter);
-    // Finally, copy the events from inserter to m_midiComposition.
+    // Finally, move the events from inserter to m_midiComposition.
     inserter.assignToMidiFile(*this);
 
     // Write m_midiComposition to the file.
@@ -1365,19 +1372,19 @@ MidiFile::convertToMidi(RosegardenDocument *doc, const QString &filename)
 }
 
 void
-MidiFile::writeInt(std::ofstream *midiFile, int number)
+MidiFile::appendInt(std::string &buffer, int number)
 {
-    *midiFile << static_cast<MidiByte>((number & 0xFF00) >> 8);
-    *midiFile << static_cast<MidiByte>(number & 0x00FF);
+    buffer += static_cast<MidiByte>((number & 0xFF00) >> 8);
+    buffer += static_cast<MidiByte>(number & 0x00FF);
 }
 
 void
-MidiFile::writeLong(std::ofstream *midiFile, unsigned long number)
+MidiFile::appendLong(std::string &buffer, unsigned long number)
 {
-    *midiFile << static_cast<MidiByte>((number & 0xFF000000) >> 24);
-    *midiFile << static_cast<MidiByte>((number & 0x00FF0000) >> 16);
-    *midiFile << static_cast<MidiByte>((number & 0x0000FF00) >> 8);
-    *midiFile << static_cast<MidiByte>(number & 0x000000FF);
+    buffer += static_cast<MidiByte>((number & 0xFF000000) >> 24);
+    buffer += static_cast<MidiByte>((number & 0x00FF0000) >> 16);
+    buffer += static_cast<MidiByte>((number & 0x0000FF00) >> 8);
+    buffer += static_cast<MidiByte>(number & 0x000000FF);
 }
 
 std::string
@@ -1411,42 +1418,43 @@ MidiFile::longToVarBuffer(unsigned long value)
     return returnString;
 }
 
-void
-MidiFile::writeHeader(std::ofstream *midiFile)
+std::string
+MidiFile::encodeHeader() const
 {
     // Our identifying Header string
-    *midiFile << MIDI_FILE_HEADER;
+    std::string header = MIDI_FILE_HEADER;
 
-    // Write number of Bytes to follow
-    *midiFile << static_cast<MidiByte>(0x00);
-    *midiFile << static_cast<MidiByte>(0x00);
-    *midiFile << static_cast<MidiByte>(0x00);
-    *midiFile << static_cast<MidiByte>(0x06);
+    // Number of Bytes to follow
+    appendLong(header, 6);
 
-    writeInt(midiFile, static_cast<int>(m_format));
-    writeInt(midiFile, m_numberOfTracks);
-    writeInt(midiFile, m_timingDivision);
+    appendInt(header, static_cast<int>(m_format));
+    appendInt(header, m_numberOfTracks);
+    appendInt(header, m_timingDivision);
+
+    return header;
 }
 
-void
-MidiFile::writeTrack(std::ofstream *midiFile, TrackId trackNumber)
+std::string
+MidiFile::encodeTrack(const MidiTrack &track)
 {
     // For running status.
     MidiByte previousEventCode = 0;
 
-    // First we write into trackBuffer, then we write trackBuffer
-    // out to the file with its accompanying length.
+    // The chunk header goes first.  The length is filled in once we
+    // know it.
+    std::string trackBuffer = MIDI_TRACK_HEADER;
+    appendLong(trackBuffer, 0);
+    const size_t headerSize = trackBuffer.size();
 
-    std::string trackBuffer;
+    // Most events are four bytes or less.
+    trackBuffer.reserve(headerSize + track.size() * 4);
 
     // Used to accumulate time deltas for skipped events.
     timeT skippedTime = 0;
 
     // For each event in the Track
-    for (MidiTrack::iterator i = m_midiComposition[trackNumber].begin();
-         i != m_midiComposition[trackNumber].end();
-         ++i) {
-        const MidiEvent &midiEvent = **i;
+    for (const MidiEvent *event : track) {
+        const MidiEvent &midiEvent = *event;
 
         // Do not write controller reset events to the buffer/file.
         // HACK for #1404.  I gave up trying to find where the events
@@ -1466,7 +1474,7 @@ MidiFile::writeTrack(std::ofstream *midiFile, TrackId trackNumber)
                 midiEvent.getEventCode() == MIDI_CTRL_CHANGE &&
                 midiEvent.getData1() == MIDI_CONTROLLER_RESET
             ) {
-            RG_WARNING << "writeTrack(): Found controller 121.  Skipping.  This is a HACK to address BUG #1404.";
+            RG_WARNING << "encodeTrack(): Found controller 121.  Skipping.  This is a HACK to address BUG #1404.";
 
             // Keep track of the timestamps from skipped events so we can
             // add them to the next event that makes it through.
@@ -1482,7 +1490,6 @@ MidiFile::writeTrack(std::ofstream *midiFile, TrackId trackNumber)
 
         RG_DEBUG << "MIDI event for channel "
                   << static_cast<int>(midiEvent.getChannelNumber())
-                  << " (track " << trackNumber << ") "
                   << " time" << midiEvent.getTime();
         RG_DEBUG << midiEvent;
 
@@ -1534,22 +1541,42 @@ MidiFile::writeTrack(std::ofstream *midiFile, TrackId trackNumber)
                 break;
 
             default:
-                RG_WARNING << "writeTrack() - cannot write unsupported MIDI event: " << QString("0x%1").arg(midiEvent.getMessageType(), 0, 16);
+                RG_WARNING << "encodeTrack() - cannot write unsupported MIDI event: " << QString("0x%1").arg(midiEvent.getMessageType(), 0, 16);
                 break;
             }
         }
-
-        // Kick the event loop to keep the UI responsive.
-        qApp->processEvents();
     }
 
-    // Now we write the track to the file.
+    // Now fill in the length.
+    std::string length;
+    appendLong(length, trackBuffer.size() - headerSize);
+    trackBuffer.replace(headerSize - length.size(), length.size(), length);
 
-    *midiFile << MIDI_TRACK_HEADER;
-    writeLong(midiFile, trackBuffer.length());
-    *midiFile << trackBuffer;
+    return trackBuffer;
 }
 
+class MidiFile::EncodeTrackJob : public QRunnable
+{
+public:
+    EncodeTrackJob(const MidiTrack *track, std::string *chunk,
+                   std::atomic<int> *tracksDone) :
+        m_track(track),
+        m_chunk(chunk),
+        m_tracksDone(tracksDone)
+    { }
+
+    void run() override
+    {
+        *m_chunk = encodeTrack(*m_track);
+        ++*m_tracksDone;
+    }
+
+private:
+    const MidiTrack *m_track;
+    std::string *m_chunk;
+    std::atomic<int> *m_tracksDone;
+};
+
 bool
 MidiFile::write(const QString &filename)
 {
@@ -1562,21 +1589,53 @@ MidiFile::write(const QString &filename)
         return false;
     }
 
-    writeHeader(&midiFile);
+    // Each track is encoded into its own chunk by a worker thread.
+    std::vector<std::string> chunks(m_numberOfTracks);
+    std::atomic<int> tracksDone(0);
+    bool canceled = false;
+
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
 
-    // For each track, write it out.
-    for (TrackId i = 0; i < m_numberOfTracks; ++i) {
-        writeTrack(&midiFile, i);
+        for (TrackId i = 0; i < m_numberOfTracks; ++i) {
+            pool.start(new EncodeTrackJob(
+                    &m_midiComposition[i], &chunks[i], &tracksDone));
+        }
+
+        // Keep the UI responsive and let the user cancel.
+        while (!pool.waitForDone(20)) {
+            if (m_progressDialog  &&  m_progressDialog->wasCanceled()) {
+                // Drop the jobs that haven't started.
+                pool.clear();
+                canceled = true;
+            }
+
+            if (m_progressDialog)
+                m_progressDialog->setValue(
+                        tracksDone * 100 / m_numberOfTracks);
+
+            qApp->processEvents();
+        }
+    }
 
-        if (m_progressDialog  &&  m_progressDialog->wasCanceled())
-            return false;
+    if (canceled)
+        return false;
 
-        if (m_progressDialog)
-            m_progressDialog->setValue(i * 100 / m_numberOfTracks);
+    // Then the whole file goes out in order.
+    const std::string header = encodeHeader();
+    midiFile.write(header.data(), header.size());
+    for (const std::string &chunk : chunks) {
+        midiFile.write(chunk.data(), chunk.size());
     }
 
     midiFile.close();
 
+    if (!midiFile.good()) {
+        RG_WARNING << "write() - error writing file";
+        return false;
+    }
+
     return true;
 }
 
@@ -1585,80 +1644,104 @@ MidiFile::consolidateNoteEvents(TrackId trackId)
 {
     MidiTrack &track = m_midiComposition[trackId];
 
+    const size_t none = std::numeric_limits<size_t>::max();
+
+    // The note-ons still waiting for their note-off, for each channel
+    // and pitch, oldest first.  A note-off ends the oldest one, which
+    // pairs overlapping notes of the same pitch first on, first off.
+    const size_t keys = 16 * 256;
+    std::vector<size_t> oldestOpen(keys, none);
+    std::vector<size_t> newestOpen(keys, none);
+    std::vector<size_t> nextOpen(track.size(), none);
+
+    // For each note-off, the note-on it ends.
+    std::vector<size_t> noteOnFor(track.size(), none);
+    // For each note-on, whether it has been ended.
+    std::vector<bool> ended(track.size(), false);
+
     // For each MIDI event on the track.
-    for (MidiTrack::iterator firstEventIter = track.begin();
-         firstEventIter != track.end();
-         ++firstEventIter) {
-        MidiEvent &firstEvent = **firstEventIter;
+    for (size_t i = 0; i < track.size(); ++i) {
+        MidiEvent &event = *track[i];
 
-        // Not a note-on?  Try the next event.
-        if (firstEvent.getMessageType() != MIDI_NOTE_ON)
-            continue;
+        const MidiByte type = event.getMessageType();
 
-        // Note-on with velocity 0 is a note-off.  Try the next event.
-        if (firstEvent.getVelocity() == 0)
+        // Note-on with velocity 0 is a note-off.
+        const bool noteOn = (type == MIDI_NOTE_ON  &&  event.getVelocity() != 0);
+        const bool noteOff = (type == MIDI_NOTE_OFF  ||
+                (type == MIDI_NOTE_ON  &&  event.getVelocity() == 0));
+
+        if (!noteOn  &&  !noteOff)
             continue;
 
-        // At this point, firstEvent is a note-on event.
-        // Search for the matching note-off event.
+        const size_t key = event.getChannelNumber() * 256 + event.getPitch();
 
-        bool noteOffFound = false;
+        if (noteOn) {
+            // Wait at the back for a note-off.
+            if (newestOpen[key] == none)
+                oldestOpen[key] = i;
+            else
+                nextOpen[newestOpen[key]] = i;
+            newestOpen[key] = i;
 
-        MidiTrack::iterator secondEventIter;
+            continue;
+        }
 
-        // For each following MIDI event
-        for (secondEventIter = firstEventIter + 1;
-             secondEventIter != track.end();
-             ++secondEventIter) {
-            const MidiEvent &secondEvent = **secondEventIter;
+        // A note-off with nothing to end is left alone.
+        if (oldestOpen[key] == none)
+            continue;
 
-            bool noteOff = (secondEvent.getMessageType() == MIDI_NOTE_OFF  ||
-                    (secondEvent.getMessageType() == MIDI_NOTE_ON  &&
-                     secondEvent.getVelocity() == 0x00));
+        const size_t on = oldestOpen[key];
+        oldestOpen[key] = nextOpen[on];
+        if (oldestOpen[key] == none)
+            newestOpen[key] = none;
 
-            // Not a note-off?  Try the next event.
-            if (!noteOff)
-                continue;
+        MidiEvent &noteOnEvent = *track[on];
 
-            // Wrong pitch?  Try the next event.
-            if (secondEvent.getPitch() != firstEvent.getPitch())
-                continue;
+        timeT noteDuration = event.getTime() - noteOnEvent.getTime();
 
-            // Wrong channel?  Try the next event.
-            // Note: Since all the events in a track are for a single channel,
-            //       this will never be true.
-            if (secondEvent.getChannelNumber() != firstEvent.getChannelNumber())
-                continue;
+        // Some MIDI files floating around in the real world
+        // apparently have note-on followed immediately by note-off
+        // on percussion tracks.  Instead of setting the duration to
+        // 0 in this case, which has no meaning, set it to 1.
+        if (noteDuration == 0) {
+            RG_WARNING << "consolidateNoteEvents() - detected MIDI note duration of 0.  Using duration of 1.  Touch wood.";
+            noteDuration = 1;
+        }
 
-            timeT noteDuration = secondEvent.getTime() - firstEvent.getTime();
+        noteOnEvent.setDuration(noteDuration);
 
-            // Some MIDI files floating around in the real world
-            // apparently have note-on followed immediately by note-off
-            // on percussion tracks.  Instead of setting the duration to
-            // 0 in this case, which has no meaning, set it to 1.
-            if (noteDuration == 0) {
-                RG_WARNING << "consolidateNoteEvents() - detected MIDI note duration of 0.  Using duration of 1.  Touch wood.";
-                noteDuration = 1;
-            }
+        noteOnFor[i] = on;
+        ended[on] = true;
+    }
 
-            firstEvent.setDuration(noteDuration);
+    // Notes that never end last until the last event on the track.
+    for (size_t i = 0; i < track.size(); ++i) {
+        MidiEvent &event = *track[i];
 
-            // Remove the note-off.
-            delete *secondEventIter;
-            track.erase(secondEventIter);
+        if (event.getMessageType() != MIDI_NOTE_ON  ||
+            event.getVelocity() == 0  ||  ended[i])
+            continue;
 
-            noteOffFound = true;
-            break;
-        }
+        // Leave out the note-offs of notes that started earlier.  They
+        // are gone by now as far as this note is concerned.
+        size_t last = track.size() - 1;
+        while (noteOnFor[last] != none  &&  noteOnFor[last] < i)
+            --last;
 
-        if (!noteOffFound) {
-            // avoid crash due to secondEventIter == track.end()
-            --secondEventIter;
-            // Set Event duration to length of Segment.
-            firstEvent.setDuration(
-                    (*secondEventIter)->getTime() - firstEvent.getTime());
+        // Set Event duration to length of Segment.
+        event.setDuration(track[last]->getTime() - event.getTime());
+    }
+
+    // Remove the note-offs that have been consolidated.
+    size_t kept = 0;
+    for (size_t i = 0; i < track.size(); ++i) {
+        if (noteOnFor[i] != none) {
+            delete track[i];
+            continue;
         }
+        track[kept++] = track[i];
     }
+    track.resize(kept);
 }
 
 void
@@ -173,23 +173,35 @@ private:
     // *** Rosegarden to Standard MIDI File
 
     /// Write m_midiComposition to a MIDI file.
+    /**
+     * The tracks are encoded in parallel, each into its own buffer, and
+     * the whole file is then written out in one go.
+     */
     bool write(const QString &filename);
-    void writeHeader(std::ofstream *midiFile);
-    void writeTrack(std::ofstream *midiFile, TrackId trackNumber);
+    /// The MThd chunk.
+    std::string encodeHeader() const;
+    /// A complete MTrk chunk for track.
+    /**
+     * Only reads track, so it is safe to call for different tracks from
+     * different threads.
+     */
+    static std::string encodeTrack(const MidiTrack &track);
 
     // Write
-    /// Write an int as 2 bytes.
-    void writeInt(std::ofstream *midiFile, int number);
-    /// Write a long as 4 bytes.
-    void writeLong(std::ofstream *midiFile, unsigned long number);
+    /// Append an int as 2 bytes.
+    static void appendInt(std::string &buffer, int number);
+    /// Append a long as 4 bytes.
+    static void appendLong(std::string &buffer, unsigned long number);
 
     // Conversion
     /// Convert a value to a "variable-length quantity" in a std::string.
-    std::string longToVarBuffer(unsigned long value);
+    static std::string longToVarBuffer(unsigned long value);
 
     // *** Misc
 
     QPointer<QProgressDialog> m_progressDialog;
+
+    class EncodeTrackJob;
 };
 
 
@@ -585,12 +585,13 @@ MidiInserter::assignToMidiFile(MidiFile &midifile)
     midifile.m_timingDivision = m_timingDivision;
     midifile.m_format = MidiFile::MIDI_SIMULTANEOUS_TRACK_FILE;
 
-    midifile.m_midiComposition[0] = m_conductorTrack.m_midiTrack;
+    // The MidiFile takes over the events.
+    midifile.m_midiComposition[0].swap(m_conductorTrack.m_midiTrack);
     unsigned int index = 0;
     for (TrackMap::iterator i = m_trackPosMap.begin();
          i != m_trackPosMap.end();
          ++i, ++index) {
-        midifile.m_midiComposition[index + 1] = i->second.m_midiTrack;
+        midifile.m_midiComposition[index + 1].swap(i->second.m_midiTrack);
     }
 }
 
@@ -0,0 +1,381 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#define RG_NO_DEBUG_PRINT
+
+#include "ParallelTimeStretcher.h"
+
+#include "AudioTimeStretcher.h"
+#include "misc/Debug.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace Rosegarden
+{
+
+
+struct ParallelTimeStretcher::Chunk
+{
+    /// First input frame fed to the stretcher.
+    size_t inputStart{0};
+    std::vector<std::vector<float> > input;
+
+    /// Output frames to throw away before the wanted output begins.
+    size_t skip{0};
+    /// Output frames wanted.
+    size_t outputFrames{0};
+    std::vector<std::vector<float> > output;
+
+    /// Created and destroyed on the calling thread since FFTW planning
+    /// is not thread-safe.  Only fftwf_execute() runs on the workers.
+    std::unique_ptr<AudioTimeStretcher> stretcher;
+};
+
+class ParallelTimeStretcher::ChunkJob : public QRunnable
+{
+public:
+    ChunkJob(ParallelTimeStretcher *owner, Chunk *chunk) :
+        m_owner(owner),
+        m_chunk(chunk)
+    { }
+
+    void run() override  { m_owner->stretchChunk(*m_chunk); }
+
+private:
+    ParallelTimeStretcher *m_owner;
+    Chunk *m_chunk;
+};
+
+ParallelTimeStretcher::ParallelTimeStretcher(size_t sampleRate,
+                                             size_t channels,
+                                             float ratio,
+                                             int threadCount) :
+    m_sampleRate(sampleRate),
+    m_channels(channels),
+    m_ratio(ratio),
+    m_threadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount()),
+    // Ten seconds per chunk keeps the crossfades rare and the memory
+    // per wave small.
+    m_chunkFrames(sampleRate * 10),
+    m_outputBlockSize(1024),
+    m_cancelled(false),
+    m_framesDone(0)
+{
+    if (m_threadCount < 1)
+        m_threadCount = 1;
+}
+
+bool
+ParallelTimeStretcher::process(size_t inputFrames,
+                               ReadFunction read,
+                               WriteFunction write,
+                               PollFunction poll)
+{
+    m_cancelled = false;
+    m_framesDone = 0;
+
+    const size_t expectedOut = size_t(ceil(double(inputFrames) * m_ratio));
+    if (expectedOut == 0  ||  m_channels == 0)
+        return true;
+
+    // The window size depends only on the sample rate and ratio, so a
+    // throwaway stretcher tells us what every chunk will use.
+    size_t windowSize;
+    {
+        AudioTimeStretcher probe(m_sampleRate, m_channels, m_ratio, true,
+                                 m_outputBlockSize);
+        windowSize = probe.getWindowSize();
+    }
+
+    // Output frames over which neighbouring chunks are crossfaded, and
+    // extra input each chunk gets so that the phase vocoder has settled
+    // before its output is used.
+    const size_t crossfade = windowSize * 2;
+    const size_t warmUp = windowSize * 2;
+
+    // Each chunk must be comfortably longer than the crossfade.
+    const size_t chunkFrames = std::max(
+            m_chunkFrames, size_t(ceil(double(crossfade * 4) / m_ratio)));
+    const size_t chunkCount =
+            std::max(size_t(1), (inputFrames + chunkFrames - 1) / chunkFrames);
+
+    RG_DEBUG << "process():" << inputFrames << "frames in" << chunkCount <<
+                "chunks on" << m_threadCount << "threads";
+
+    // Output frame at which chunk k takes over from chunk k-1.
+    auto boundary = [&](size_t k) -> size_t {
+        if (k >= chunkCount)
+            return expectedOut;
+        return std::min(expectedOut,
+                        size_t(lrint(double(k * chunkFrames) * m_ratio)));
+    };
+    // First output frame of chunk k, including the crossfade.
+    auto outputStart = [&](size_t k) -> size_t {
+        return k == 0 ? 0 : boundary(k) - crossfade;
+    };
+    auto inputStart = [&](size_t k) -> size_t {
+        const size_t start = size_t(double(outputStart(k)) / m_ratio);
+        return start > warmUp ? start - warmUp : 0;
+    };
+    auto inputEnd = [&](size_t k) -> size_t {
+        return std::min(inputFrames,
+                        size_t(ceil(double(boundary(k + 1)) / m_ratio)) +
+                                warmUp);
+    };
+
+    // Progress is measured against everything the chunks are fed,
+    // overlaps included.
+    size_t totalWork = 0;
+    for (size_t k = 0; k < chunkCount; ++k) {
+        totalWork += inputEnd(k) - inputStart(k);
+    }
+    auto percent = [&]() -> int {
+        if (totalWork == 0)
+            return 100;
+        return int(std::min(size_t(100), m_framesDone * 100 / totalWork));
+    };
+
+    // Input that has been read and is still needed, from pendingStart.
+    std::vector<std::vector<float> > pending(m_channels);
+    size_t pendingStart = 0;
+    size_t pendingFrames = 0;
+    bool inputExhausted = false;
+
+    const size_t readBlockSize = 16384;
+    std::vector<std::vector<float> > readBuffers(
+            m_channels, std::vector<float>(readBlockSize));
+    std::vector<float *> readPointers(m_channels);
+    for (size_t c = 0; c < m_channels; ++c) {
+        readPointers[c] = readBuffers[c].data();
+    }
+
+    // The end of the previous chunk's output, waiting to be crossfaded
+    // with the start of the next one.
+    std::vector<std::vector<float> > tail(m_channels);
+    size_t tailFrames = 0;
+    std::vector<float *> writePointers(m_channels);
+
+    for (size_t first = 0; first < chunkCount; first += m_threadCount) {
+
+        const size_t last =
+                std::min(chunkCount, first + size_t(m_threadCount));
+        std::vector<Chunk> chunks(last - first);
+
+        // Set up this wave's chunks.
+
+        for (size_t k = first; k < last; ++k) {
+            Chunk &chunk = chunks[k - first];
+
+            const size_t end = inputEnd(k);
+            while (!inputExhausted  &&  pendingStart + pendingFrames < end) {
+                const size_t got = read(readPointers.data(), readBlockSize);
+                for (size_t c = 0; c < m_channels; ++c) {
+                    pending[c].insert(pending[c].end(),
+                                      readBuffers[c].begin(),
+                                      readBuffers[c].begin() + got);
+                }
+                pendingFrames += got;
+                if (got < readBlockSize)
+                    inputExhausted = true;
+            }
+
+            // The input may turn out to be shorter than promised.
+            const size_t available = pendingStart + pendingFrames;
+            chunk.inputStart = std::min(inputStart(k), available);
+            const size_t inputStop = std::min(end, available);
+
+            chunk.input.resize(m_channels);
+            for (size_t c = 0; c < m_channels; ++c) {
+                chunk.input[c].assign(
+                        pending[c].begin() + (chunk.inputStart - pendingStart),
+                        pending[c].begin() + (inputStop - pendingStart));
+            }
+
+            const long skip = long(outputStart(k)) -
+                    lrint(double(chunk.inputStart) * m_ratio);
+            chunk.skip = skip > 0 ? size_t(skip) : 0;
+            chunk.outputFrames = boundary(k + 1) - outputStart(k);
+            chunk.output.assign(m_channels,
+                                std::vector<float>(chunk.outputFrames, 0.f));
+
+            chunk.stretcher.reset(new AudioTimeStretcher(
+                    m_sampleRate, m_channels, m_ratio, true,
+                    m_outputBlockSize));
+
+            // Drop input that no later chunk needs.
+            const size_t keepFrom = (k + 1 < chunkCount) ?
+                    inputStart(k + 1) : available;
+            if (keepFrom > pendingStart) {
+                const size_t drop = std::min(keepFrom - pendingStart,
+                                             pendingFrames);
+                for (size_t c = 0; c < m_channels; ++c) {
+                    pending[c].erase(pending[c].begin(),
+                                     pending[c].begin() + drop);
+                }
+                pendingStart += drop;
+                pendingFrames -= drop;
+            }
+        }
+
+        // Stretch them.
+
+        {
+            QThreadPool pool;
+            pool.setMaxThreadCount(m_threadCount);
+
+            for (Chunk &chunk : chunks) {
+                pool.start(new ChunkJob(this, &chunk));
+            }
+
+            while (!pool.waitForDone(20)) {
+                if (!poll(percent()))
+                    m_cancelled = true;
+            }
+        }
+
+        if (m_cancelled) {
+            RG_DEBUG << "process(): cancelled";
+            return false;
+        }
+
+        // Stitch them onto the output in order.
+
+        for (size_t k = first; k < last; ++k) {
+            Chunk &chunk = chunks[k - first];
+
+            // Linear crossfade from the previous chunk.
+            const size_t fade = std::min(tailFrames, chunk.outputFrames);
+            for (size_t c = 0; c < m_channels; ++c) {
+                float *out = chunk.output[c].data();
+                for (size_t i = 0; i < fade; ++i) {
+                    const float gain = (float(i) + 0.5f) / float(fade);
+                    out[i] = tail[c][i] * (1.f - gain) + out[i] * gain;
+                }
+            }
+
+            // Hold back the end for the next chunk's crossfade.
+            const bool lastChunk = (k + 1 == chunkCount);
+            const size_t hold =
+                    lastChunk ? 0 : std::min(crossfade, chunk.outputFrames);
+            const size_t writeFrames = chunk.outputFrames - hold;
+
+            if (writeFrames > 0) {
+                for (size_t c = 0; c < m_channels; ++c) {
+                    writePointers[c] = chunk.output[c].data();
+                }
+                write(writePointers.data(), writeFrames);
+            }
+
+            for (size_t c = 0; c < m_channels; ++c) {
+                tail[c].assign(chunk.output[c].begin() + writeFrames,
+                               chunk.output[c].end());
+            }
+            tailFrames = hold;
+        }
+    }
+
+    poll(100);
+
+    return true;
+}
+
+void
+ParallelTimeStretcher::stretchChunk(Chunk &chunk)
+{
+    AudioTimeStretcher &stretcher = *chunk.stretcher;
+
+    const size_t inputBlockSize =
+            std::max(size_t(1), size_t(m_outputBlockSize / m_ratio));
+
+    // Prime the stretcher with half its window size of silence, an
+    // amount which we then discard at the start of the output (as well
+    // as its own processing latency).  Same as the single-threaded
+    // AudioFileTimeStretcher always did.
+    const size_t padding = stretcher.getWindowSize() / 2;
+    std::vector<float> silence(std::max(padding, inputBlockSize), 0.f);
+    std::vector<float *> silencePointers(m_channels, silence.data());
+    stretcher.putInput(silencePointers.data(), padding);
+
+    size_t discard = padding + chunk.skip;
+
+    const size_t inputFrames = chunk.input[0].size();
+    size_t fed = 0;
+    size_t produced = 0;
+
+    std::vector<std::vector<float> > outputBlock(
+            m_channels, std::vector<float>(m_outputBlockSize));
+    std::vector<float *> inputPointers(m_channels);
+    std::vector<float *> outputPointers(m_channels);
+    for (size_t c = 0; c < m_channels; ++c) {
+        outputPointers[c] = outputBlock[c].data();
+    }
+
+    while (produced < chunk.outputFrames) {
+
+        if (m_cancelled)
+            return;
+
+        size_t count = inputBlockSize;
+
+        if (fed < inputFrames) {
+            count = std::min(inputBlockSize, inputFrames - fed);
+            for (size_t c = 0; c < m_channels; ++c) {
+                inputPointers[c] = chunk.input[c].data() + fed;
+            }
+            m_framesDone += count;
+        } else {
+            // Out of input.  Keep feeding silence until there is enough
+            // output.
+            for (size_t c = 0; c < m_channels; ++c) {
+                inputPointers[c] = silence.data();
+            }
+        }
+
+        stretcher.putInput(inputPointers.data(), count);
+        fed += count;
+
+        size_t available = stretcher.getAvailableOutputSamples();
+
+        while (available > 0  &&  produced < chunk.outputFrames) {
+
+            const size_t got = std::min(available, m_outputBlockSize);
+            stretcher.getOutput(outputPointers.data(), got);
+            available -= got;
+
+            const size_t from = std::min(discard, got);
+            discard -= from;
+
+            const size_t keep =
+                    std::min(got - from, chunk.outputFrames - produced);
+            for (size_t c = 0; c < m_channels; ++c) {
+                std::copy(outputBlock[c].begin() + from,
+                          outputBlock[c].begin() + from + keep,
+                          chunk.output[c].begin() + produced);
+            }
+            produced += keep;
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,112 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A MIDI and audio sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+
+    Other copyrights also apply to some parts of this work.  Please
+    see the AUTHORS file and individual file headers for details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_PARALLEL_TIME_STRETCHER_H
+#define RG_PARALLEL_TIME_STRETCHER_H
+
+#include <rosegardenprivate_export.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <stddef.h>
+
+namespace Rosegarden
+{
+
+
+/// Time-stretch a stream of audio on a pool of worker threads.
+/**
+ * The input is cut into chunks of getChunkFrames() frames.  Each chunk
+ * is run through its own AudioTimeStretcher along with some extra input
+ * on either side so that the phase vocoder has settled by the time it
+ * reaches the chunk proper.  The outputs of neighbouring chunks overlap
+ * by a few analysis windows and are crossfaded together.
+ *
+ * Chunks are processed in waves of getThreadCount() chunks, so memory
+ * use is bounded by the chunk size regardless of the length of the
+ * input.  All reading, writing and polling happens on the calling
+ * thread.
+ *
+ * Used by AudioFileTimeStretcher.
+ */
+class ROSEGARDENPRIVATE_EXPORT ParallelTimeStretcher
+{
+public:
+    /**
+     * threadCount of 0 means one thread per core.
+     */
+    ParallelTimeStretcher(size_t sampleRate,
+                          size_t channels,
+                          float ratio,
+                          int threadCount = 0);
+
+    /// Read up to frames frames of de-interleaved input into buffers.
+    /**
+     * Returns the number of frames read.  Fewer than requested means
+     * the end of the input has been reached.
+     */
+    typedef std::function<size_t (float **buffers, size_t frames)>
+            ReadFunction;
+    /// Write frames frames of de-interleaved output.
+    typedef std::function<void (float **buffers, size_t frames)>
+            WriteFunction;
+    /// Called regularly while the workers run.  Return false to cancel.
+    typedef std::function<bool (int percent)> PollFunction;
+
+    /// Stretch inputFrames frames from read() to write().
+    /**
+     * Produces ceil(inputFrames * ratio) frames of output.  Returns
+     * false if cancelled.
+     */
+    bool process(size_t inputFrames,
+                 ReadFunction read,
+                 WriteFunction write,
+                 PollFunction poll);
+
+    int getThreadCount() const  { return m_threadCount; }
+
+    size_t getChunkFrames() const  { return m_chunkFrames; }
+    /// Input frames per chunk.  Mainly for testing.
+    void setChunkFrames(size_t frames)  { m_chunkFrames = frames; }
+
+private:
+    struct Chunk;
+    class ChunkJob;
+
+    /// Run chunk's stretcher over its input.  Called on a worker thread.
+    void stretchChunk(Chunk &chunk);
+
+    size_t m_sampleRate;
+    size_t m_channels;
+    float m_ratio;
+    int m_threadCount;
+    size_t m_chunkFrames;
+
+    /// Output block size given to each AudioTimeStretcher.
+    size_t m_outputBlockSize;
+
+    std::atomic<bool> m_cancelled;
+    /// Input frames fed to the stretchers so far, for progress.
+    std::atomic<size_t> m_framesDone;
+};
+
+
+}
+
+#endif
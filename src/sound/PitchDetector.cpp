@@ -73,8 +73,14 @@ PitchDetector::PitchDetector( int frameSize, int stepSize, int sampleRate ) {
     //for autocorrelation
     m_pc= fftwf_plan_dft_r2c_1d( m_frameSize, m_cepstralIn, m_cepstralOut, FFTW_MEASURE );
 
+    m_window.resize(m_frameSize);
+    for ( int c=0; c<m_frameSize; c++ ) {
+        m_window[c] = 0.5 - 0.5*( cos(2*M_PI*c/m_frameSize) );
+    }
+
     //set default method
     m_method = AUTOCORRELATION;
+    m_algorithm = Autocorrelation;
 }
 
 const QVector<PitchDetector::Method>* PitchDetector::getMethods() {
@@ -86,14 +92,20 @@ void PitchDetector::setMethod( PitchDetector::Method method ) {
     std::cout << "PitchDetector::setMethod " << method << std::endl;
 #endif
 
-    if (m_methods.contains(method)) {
-        m_method = method;
-    }
-    else {
+    if (method == AUTOCORRELATION) {
+        m_algorithm = Autocorrelation;
+    } else if (method == HPS) {
+        m_algorithm = HarmonicProductSpectrum;
+    } else if (method == PARTIAL) {
+        m_algorithm = Partial;
+    } else {
 #if DEBUG_PT
         std::cout << "PitchDetector::setMethod Not a method!\n";
 #endif
+        return;
     }
+
+    m_method = method;
 }
 
 double PitchDetector::getPitch() {
@@ -102,22 +114,24 @@ double PitchDetector::getPitch() {
 //    double f2 = 0;   // not used?
 
     // Fill input buffers with data for two overlapping frames.
+    const double *window = m_window.constData();
     for ( int c=0; c<m_frameSize; c++ ) {
-        double window = 0.5 - 0.5*( cos(2*M_PI*c/m_frameSize) );
-        m_in1[c] = m_frame[c] * window;
-        m_in2[c] = m_frame[c+m_stepSize] *window ;
+        m_in1[c] = m_frame[c] * window[c];
+        m_in2[c] = m_frame[c+m_stepSize] * window[c];
     }
     // Perform DFT
     fftwf_execute( m_p1 );
     fftwf_execute( m_p2 );
-    if ( m_method == AUTOCORRELATION )
+    switch ( m_algorithm ) {
+    case Autocorrelation:
         freq = autocorrelation();
-    else if ( m_method == HPS )
+        break;
+    case HarmonicProductSpectrum:
         freq = hps();
-    else if ( m_method == PARTIAL )
+        break;
+    case Partial:
         freq = partial();
-    else {
-        return 0;
+        break;
     }
 
 #if DEBUG_PT
@@ -131,6 +145,7 @@ float *PitchDetector::getInBuffer() {
 }
 
 PitchDetector::~PitchDetector() {
+    free(m_frame);
     fftwf_free(m_in1);
     fftwf_free(m_in2);
     fftwf_free(m_ft1);
@@ -340,6 +355,7 @@ double PitchDetector::partial() {
         if (fMag < abs(value)) {
             fMag = abs(value);
             oldPhase = arg(value);
+            fBin = c;
         }
 
     }
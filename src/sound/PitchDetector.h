@@ -63,6 +63,10 @@ namespace Rosegarden
  * and not the more usual usage of the number of samples presented
  * simultaneously (1=mono, 2=stereo etc).
  *
+ * A detector may be used from any one thread at a time.  Construct and
+ * destroy them on a single thread, though, since FFTW's planner is not
+ * thread-safe.
+ *
  * \author Doug McGilvray (original author)
  * \author Graham Percival (slightly rewritten to match Rosegarden standards)
  * \author Nick Bailey (changed to use QSting, QVector instead of std::...)
@@ -119,6 +123,9 @@ public:
 
 private:
 
+    /// The method as an index, so that getPitch() needn't compare strings.
+    enum Algorithm { Autocorrelation, HarmonicProductSpectrum, Partial };
+
     float *m_frame;
     double partial();
     double amdf();
@@ -139,6 +146,11 @@ private:
     int m_sampleRate;
 
     Method m_method;
+    Algorithm m_algorithm;
+
+    /// Hann window over an analysis frame, worked out once.
+    QVector<double> m_window;
+
     fftwf_complex *m_ft1, *m_ft2, *m_cepstralOut;
     fftwf_plan m_p1, m_p2, m_pc;
 
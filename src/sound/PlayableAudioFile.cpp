@@ -19,7 +19,9 @@
 
 #include <utility>
 
+#include <fcntl.h>
 #include <pthread.h>
+#include <unistd.h>
 
 
 namespace Rosegarden
@@ -31,17 +33,34 @@ namespace Rosegarden
 
 AudioCache PlayableAudioFile::m_smallFileCache;
 
-std::vector<sample_t *> PlayableAudioFile::m_workBuffers;
-size_t PlayableAudioFile::m_workBufferSize = 0;
-QMutex PlayableAudioFile::m_workBuffersMutex;
-
-char *PlayableAudioFile::m_rawFileBuffer;
-size_t PlayableAudioFile::m_rawFileBufferSize = 0;
-
 RingBufferPool *PlayableAudioFile::m_ringBufferPool = nullptr;
 
+bool PlayableAudioFile::m_readAheadHints = false;
+
 static constexpr size_t a_xfadeFrames = 30;
 
+namespace
+{
+    // Scratch space for updateBuffers().  AudioFileReader may update
+    // several files at once on different threads, so each thread has
+    // its own.
+    struct ReadBuffers
+    {
+        ~ReadBuffers()
+        {
+            for (sample_t *buffer : work) {
+                delete[] buffer;
+            }
+        }
+
+        std::vector<char> raw;
+        std::vector<sample_t *> work;
+        size_t workSize = 0;
+    };
+
+    thread_local ReadBuffers readBuffers;
+}
+
 PlayableAudioFile::PlayableAudioFile(InstrumentId instrumentId,
                                      AudioFile *audioFile,
                                      const RealTime &startTime,
@@ -55,6 +74,7 @@ PlayableAudioFile::PlayableAudioFile(InstrumentId instrumentId,
     m_startIndex(startIndex),
     m_duration(duration),
     m_file(nullptr),
+    m_adviceFd(-1),
     m_audioFile(audioFile),
     m_instrumentId(instrumentId),
     m_targetChannels(targetChannels),
@@ -150,10 +170,7 @@ PlayableAudioFile::initialise(size_t bufferSize, size_t smallFileSize)
 
 PlayableAudioFile::~PlayableAudioFile()
 {
-    if (m_file) {
-        m_file->close();
-        delete m_file;
-    }
+    closeFile();
 
     returnRingBuffers();
     delete[] m_ringBuffers;
@@ -163,11 +180,6 @@ PlayableAudioFile::~PlayableAudioFile()
         m_smallFileCache.decrementReference(m_audioFile);
     }
 
-    {
-        QMutexLocker lock(&m_workBuffersMutex);
-        clearWorkBuffers();
-    }
-
 #ifdef DEBUG_PLAYABLE
     //    std::cerr << "PlayableAudioFile::~PlayableAudioFile - destroying - " << this << std::endl;
 #endif
@@ -184,6 +196,69 @@ PlayableAudioFile::returnRingBuffers()
     }
 }
 
+void
+PlayableAudioFile::closeFile()
+{
+    if (m_file) {
+        m_file->close();
+        delete m_file;
+        m_file = nullptr;
+    }
+
+    if (m_adviceFd >= 0) {
+        ::close(m_adviceFd);
+        m_adviceFd = -1;
+    }
+}
+
+void
+PlayableAudioFile::adviseReadAhead()
+{
+#ifdef POSIX_FADV_WILLNEED
+    if (!m_file  ||  m_fileEnded)
+        return;
+
+    if (m_adviceFd < 0) {
+        m_adviceFd = ::open(m_audioFile->getAbsoluteFilePath().toLocal8Bit(),
+                            O_RDONLY);
+        if (m_adviceFd < 0)
+            return;
+    }
+
+    // The next read will be about one buffer's worth.
+    const size_t frames = getBufferFrames();
+    const size_t sourceFrames = size_t(double(frames) *
+            double(getSourceSampleRate()) / double(m_targetSampleRate));
+
+    (void)posix_fadvise(m_adviceFd,
+                        off_t(getReadPosition()),
+                        off_t(sourceFrames * getBytesPerFrame()),
+                        POSIX_FADV_WILLNEED);
+#endif
+}
+
+size_t
+PlayableAudioFile::getBufferFrames() const
+{
+    if (m_isSmallFile)
+        return 0;
+
+    if (m_ringBuffers[0])
+        return m_ringBuffers[0]->getSize();
+
+    return m_ringBufferPool ? m_ringBufferPool->getBufferSize() : 0;
+}
+
+size_t
+PlayableAudioFile::getReadPosition() const
+{
+    if (!m_file)
+        return 0;
+
+    const std::streamoff position = m_file->tellg();
+    return position > 0 ? size_t(position) : 0;
+}
+
 bool
 PlayableAudioFile::scanTo(const RealTime &time)
 {
@@ -448,13 +523,8 @@ PlayableAudioFile::checkSmallFileCache(size_t smallFileSize)
         file.close();
     }
 
-    if (m_isSmallFile) {
-        if (m_file) {
-            m_file->close();
-            delete m_file;
-            m_file = nullptr;
-        }
-    }
+    if (m_isSmallFile)
+        closeFile();
 }
 
 #if 0
@@ -625,59 +695,53 @@ PlayableAudioFile::updateBuffers()
 #endif
 
     // !!! need to be doing this in initialise, want to avoid allocations here
-    if ((getBytesPerFrame() * fileFrames) > m_rawFileBufferSize) {
-        delete[] m_rawFileBuffer;
-        m_rawFileBufferSize = getBytesPerFrame() * fileFrames;
+    std::vector<char> &rawFileBuffer = readBuffers.raw;
+    if (getBytesPerFrame() * fileFrames > rawFileBuffer.size()) {
 #ifdef DEBUG_PLAYABLE_READ
-
-        std::cerr << "Expanding raw file buffer to " << m_rawFileBufferSize << " chars" << std::endl;
+        std::cerr << "Expanding raw file buffer to " << getBytesPerFrame() * fileFrames << " chars" << std::endl;
 #endif
 
-        m_rawFileBuffer = new char[m_rawFileBufferSize];
+        rawFileBuffer.resize(getBytesPerFrame() * fileFrames);
     }
 
     size_t obtained =
-        m_audioFile->getSampleFrames(m_file, m_rawFileBuffer, fileFrames);
+        m_audioFile->getSampleFrames(m_file, rawFileBuffer.data(), fileFrames);
 
     if (obtained < fileFrames || m_file->eof()) {
         m_fileEnded = true;
     }
 
     {
-        // We're about to hit the work buffers.
-        QMutexLocker lock(&m_workBuffersMutex);
+        std::vector<sample_t *> &workBuffers = readBuffers.work;
 
 #ifdef DEBUG_PLAYABLE
         std::cerr << "requested " << fileFrames << " frames from file for " << nframes << " frames, got " << obtained << " frames" << std::endl;
 #endif
 
-        if (nframes > m_workBufferSize) {
+        if (nframes > readBuffers.workSize) {
 
-            clearWorkBuffers();
+            for (sample_t *buffer : workBuffers) {
+                delete[] buffer;
+            }
+            workBuffers.clear();
 
-            m_workBufferSize = nframes;
+            readBuffers.workSize = nframes;
 
 #ifdef DEBUG_PLAYABLE_READ
-            std::cerr << "Expanding work buffer to " << m_workBufferSize << " frames" << std::endl;
+            std::cerr << "Expanding work buffer to " << readBuffers.workSize << " frames" << std::endl;
 #endif
+        }
 
-            for (int i = 0; i < m_targetChannels; ++i) {
-                m_workBuffers.push_back(new sample_t[m_workBufferSize]);
-            }
-
-        } else {
-
-            while (m_targetChannels > (int)m_workBuffers.size()) {
-                m_workBuffers.push_back(new sample_t[m_workBufferSize]);
-            }
+        while (m_targetChannels > (int)workBuffers.size()) {
+            workBuffers.push_back(new sample_t[readBuffers.workSize]);
         }
 
-        if (m_audioFile->decode((const unsigned char *)m_rawFileBuffer,
+        if (m_audioFile->decode((const unsigned char *)rawFileBuffer.data(),
                                 obtained * getBytesPerFrame(),
                                 m_targetSampleRate,
                                 m_targetChannels,
                                 nframes,
-                                m_workBuffers,
+                                workBuffers,
                                 false)) {
 
             /* !!! No -- GUI and notification side of things isn't up to this yet,
@@ -699,7 +763,7 @@ PlayableAudioFile::updateBuffers()
                         }
                         float gain = float(i + originSamples) / float(fadeSamples);
                         for (int ch = 0; ch < m_targetChannels; ++ch) {
-                            m_workBuffers[ch][i] *= gain;
+                            workBuffers[ch][i] *= gain;
                         }
                     }
                 }
@@ -724,7 +788,7 @@ PlayableAudioFile::updateBuffers()
                             }
                         }
                         for (int ch = 0; ch < m_targetChannels; ++ch) {
-                            m_workBuffers[ch][i] *= gain;
+                            workBuffers[ch][i] *= gain;
                         }
                     }
                 }
@@ -739,35 +803,33 @@ PlayableAudioFile::updateBuffers()
                     float xfade = std::min(a_xfadeFrames, nframes);
                     if (m_firstRead) {
                         for (size_t i = 0; i < xfade; ++i) {
-                            m_workBuffers[ch][i] *= float(i + 1) / xfade;
+                            workBuffers[ch][i] *= float(i + 1) / xfade;
                         }
                     }
                     if (m_fileEnded) {
                         for (size_t i = 0; i < xfade; ++i) {
-                            m_workBuffers[ch][nframes - i - 1] *=
+                            workBuffers[ch][nframes - i - 1] *=
                                 float(i + 1) / xfade;
                         }
                     }
                 }
 
                 if (m_ringBuffers[ch]) {
-                    m_ringBuffers[ch]->write(m_workBuffers[ch], nframes);
+                    m_ringBuffers[ch]->write(workBuffers[ch], nframes);
                 }
             }
         }
 
-        // Done.
-        //m_workBuffersMutex.unlock();
     }
 
     m_firstRead = false;
 
     if (obtained < fileFrames) {
-        if (m_file) {
-            m_file->close();
-            delete m_file;
-            m_file = nullptr;
-        }
+        closeFile();
+    } else if (m_readAheadHints) {
+        // Get the kernel started on the next buffer's worth while the
+        // other files are being read.
+        adviseReadAhead();
     }
 
     return true;
@@ -830,14 +892,4 @@ PlayableAudioFile::getBitsPerSample()
 }
 #endif
 
-void
-PlayableAudioFile::clearWorkBuffers()
-{
-    for (size_t i = 0; i < m_workBuffers.size(); ++i) {
-        delete[] m_workBuffers[i];
-    }
-    m_workBuffers.clear();
-}
-
-
 }
@@ -23,8 +23,6 @@
 #include "AudioCache.h"
 #include "PlayableData.h"
 
-#include <QMutex>
-
 #include <vector>
 #include <fstream>
 
@@ -59,6 +57,12 @@ public:
 
     static void setRingBufferPoolSizes(size_t n, size_t nframes);
 
+    /// Ask the OS to prefetch the region each file will read next.
+    /**
+     * Set by AudioFileReader.  Uses posix_fadvise() where available.
+     */
+    static void setReadAheadHints(bool hints) { m_readAheadHints = hints; }
+
     //void setStartTime(const RealTime &time) { m_startTime = time; }
     RealTime getStartTime() const override { return m_startTime; }
 
@@ -121,9 +125,9 @@ public:
     // Clear out and refill the ring buffer (in preparation for
     // playback) according to the proposed play time.
     //
-    // This call and updateBuffers are not thread-safe (for
-    // performance reasons).  They should be called for all files
-    // sequentially within a single thread.
+    // This call and updateBuffers may be called for different files
+    // on different threads at once, but must not be called for the
+    // same file on two threads at once.
     //
     bool fillBuffers(const RealTime &currentTime) override;
 
@@ -131,12 +135,14 @@ public:
 
     // Update the buffer during playback.
     //
-    // This call and fillBuffers are not thread-safe (for performance
-    // reasons).  They should be called for all files sequentially
-    // within a single thread.
+    // The same threading rules as fillBuffers apply.
     //
     bool updateBuffers() override;
 
+    size_t getBufferFrames() const override;
+
+    size_t getReadPosition() const override;
+
     // Has fillBuffers been called and completed yet?
     //
     bool isBuffered() const override
@@ -180,6 +186,8 @@ private:
     void checkSmallFileCache(size_t smallFileSize);
     bool scanTo(const RealTime &time);
     void returnRingBuffers();
+    void closeFile();
+    void adviseReadAhead();
 
     RealTime              m_startTime;
     RealTime              m_startIndex;
@@ -191,6 +199,12 @@ private:
     //
     std::ifstream        *m_file;
 
+    // Separate descriptor on the same file, used only for read-ahead
+    // hints since m_file doesn't expose its own.  Opened on first use.
+    //
+    int                   m_adviceFd;
+    static bool           m_readAheadHints;
+
     // AudioFile handle
     //
     AudioFile            *m_audioFile;
@@ -213,19 +227,6 @@ private:
     static AudioCache     m_smallFileCache;
     bool                  m_isSmallFile;
 
-    static std::vector<sample_t *> m_workBuffers;
-    static size_t m_workBufferSize;
-
-    /**
-     * m_workBuffers is used by the AudioThread and the SequencerThread,
-     * so it needs synchronization.
-     */
-    static QMutex m_workBuffersMutex;
-    static void clearWorkBuffers();
-
-    static char          *m_rawFileBuffer;
-    static size_t         m_rawFileBufferSize;
-
     RingBuffer<sample_t>  **m_ringBuffers;
     static RingBufferPool  *m_ringBufferPool;
 
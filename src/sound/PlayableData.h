@@ -45,6 +45,18 @@ public:
 
     virtual bool isBuffered() const = 0;
 
+    /// Frames the read-ahead buffer can hold.
+    /**
+     * 0 for data that is not streamed from disk.
+     */
+    virtual size_t getBufferFrames() const { return 0; }
+
+    /// Byte offset in the source file at which the next read will start.
+    /**
+     * AudioFileReader uses this to order reads within a file.
+     */
+    virtual size_t getReadPosition() const { return 0; }
+
     virtual RealTime getStartTime() const = 0;
 
     virtual RealTime getEndTime() const = 0;
@@ -21,6 +21,9 @@
 
 #include <QMutexLocker>
 
+#include <algorithm>
+#include <thread>
+
 #define LOCKED QMutexLocker rg_SequencerDataBlock_locker(&m_mutex)
 
 namespace Rosegarden
@@ -105,46 +108,87 @@ SequencerDataBlock::setVisual(const MappedEvent *ev)
 int
 SequencerDataBlock::getRecordedEvents(MappedEventList &mC)
 {
-    // Grab a copy of the stopping point in case the other thread
-    // changes it while we are working.
-    int stopIndex = m_recordEventIndex;
-
-    MappedEvent *recordBuffer = m_recordBuffer;
+    // Everything up to here has been completely written.
+    const int stopIndex = m_recordEventIndex.load(std::memory_order_acquire);
+    int readIndex = m_readIndex.load(std::memory_order_relaxed);
 
     // While there are events in the record buffer, copy each event to
     // the user's list.
-    while (m_readIndex != stopIndex) {
-        mC.insert(new MappedEvent(recordBuffer[m_readIndex]));
+    while (readIndex != stopIndex) {
+        mC.insert(new MappedEvent(m_recordBuffer[readIndex]));
 
         // Increment and wrap around to the beginning if needed.
-        if (++m_readIndex == SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE)
-            m_readIndex = 0;
+        if (++readIndex == SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE)
+            readIndex = 0;
     }
 
+    // Hand the slots back to the writers in one go.
+    m_readIndex.store(readIndex, std::memory_order_release);
+
     return mC.size();
 }
 
-void
+int
 SequencerDataBlock::addRecordedEvents(MappedEventList *mC)
 {
-    // Grab a copy of the record position so we don't update it
-    // while the other thread is using it.
-    int index = m_recordEventIndex;
+    const int wanted = int(mC->size());
+    if (wanted == 0)
+        return 0;
+
+    // Claim as many slots as we can, up to the number of events.
+
+    int start = m_recordReserveIndex.load(std::memory_order_relaxed);
+    int count;
+    int end = start;
 
-    MappedEvent *recordBuffer = m_recordBuffer;
+    do {
+        const int readIndex = m_readIndex.load(std::memory_order_acquire);
 
-    // Copy each incoming event into the ring buffer.
-    for (MappedEventList::iterator i = mC->begin(); i != mC->end(); ++i) {
-        recordBuffer[index] = **i;
+        // One slot is always left empty so that a full ring can be told
+        // apart from an empty one.
+        int used = start - readIndex;
+        if (used < 0)
+            used += SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE;
+        const int available = SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE - 1 - used;
+
+        count = std::min(wanted, available);
+        if (count <= 0)
+            break;
+
+        end = (start + count) % SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE;
+
+    } while (!m_recordReserveIndex.compare_exchange_weak(
+                     start, end, std::memory_order_acq_rel));
+
+    if (count <= 0)
+        return 0;
+
+    // Copy the earliest events into the slots we own.  The rest stay
+    // with the caller.
+    int index = start;
+    MappedEventList::iterator i = mC->begin();
+    for (int n = 0; n < count; ++n, ++i) {
+        m_recordBuffer[index] = **i;
+        delete *i;
 
         // Increment and wrap around to the beginning if needed.
         if (++index == SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE)
             index = 0;
     }
+    mC->erase(mC->begin(), i);
+
+    // Publish in claim order.  Wait for any writer that claimed the slots
+    // before ours.  Those writers are only copying events, so this is
+    // very short.
+    int expected = start;
+    while (!m_recordEventIndex.compare_exchange_weak(
+                   expected, end, std::memory_order_release,
+                   std::memory_order_relaxed)) {
+        expected = start;
+        std::this_thread::yield();
+    }
 
-    // Once the buffer is in a consistent state, move the record index
-    // so that the other thread will read the new events.
-    m_recordEventIndex = index;
+    return count;
 }
 
 int
@@ -399,8 +443,10 @@ SequencerDataBlock::clearTemporaries()
     m_haveVisualEvent = false;
     m_visualEvent = MappedEvent();
 
+    m_recordReserveIndex = 0;
     m_recordEventIndex = 0;
     m_readIndex = 0;
+    m_recordOverflowCount = 0;
     for (MappedEvent &e : m_recordBuffer) e = MappedEvent();
 
     memset(m_knownInstruments, 0, sizeof(m_knownInstruments));
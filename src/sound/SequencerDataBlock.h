@@ -21,6 +21,8 @@
 
 #include <QMutex>
 
+#include <atomic>
+
 namespace Rosegarden
 {
 
@@ -44,7 +46,7 @@ class MappedEventList;
 
 #define SEQUENCER_DATABLOCK_MAX_NB_INSTRUMENTS 512 // can't be a symbol
 #define SEQUENCER_DATABLOCK_MAX_NB_SUBMASTERS   64 // can't be a symbol
-#define SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE 1024 // MIDI events
+#define SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE 4096 // MIDI events
 
 
 /// Holds MIDI data going from RosegardenSequencer to RosegardenMainWindow
@@ -55,8 +57,15 @@ class MappedEventList;
  * link in the chain from AlsaDriver::getMappedEventList() to
  * RosegardenDocument::insertRecordedMidi().
  *
- * This class needs to be reviewed for thread safety.  See the comments
- * in addRecordedEvents().
+ * The record ring buffer (m_recordBuffer) takes no locks.  Any number of
+ * threads may call addRecordedEvents() while a single thread calls
+ * getRecordedEvents().  The reader never waits.  A writer may briefly
+ * wait for writers that claimed slots before it to finish copying, so
+ * the writers are not strictly lock-free.  The ring never overwrites
+ * events that have not been read yet.  Events that do not fit are left
+ * with the caller (see addRecordedEvents()).
+ *
+ * The rest of this class still needs to be reviewed for thread safety.
  *
  * This used to be mapped into a shared memory
  * backed file, which had to be of fixed size and layout.  The design
@@ -93,15 +102,40 @@ public:
 
     /// Add events to the record ring buffer (m_recordBuffer).
     /**
+     * Events that were stored are removed from the list and deleted.  If
+     * the ring buffer is full, the events that did not fit (always the
+     * latest ones) are left in the list so that the caller can try again
+     * later.  Returns the number of events stored.
+     *
+     * Safe to call from several threads at once.
+     *
      * Called by RosegardenSequencer::processRecordedMidi().
      */
-    void addRecordedEvents(MappedEventList *);
+    int addRecordedEvents(MappedEventList *);
     /// Get events from the record ring buffer (m_recordBuffer).
     /**
+     * Takes everything that is available in one batch.  Only one thread
+     * may call this.
+     *
      * Called by RosegardenMainWindow::processRecordedEvents().
      */
     int getRecordedEvents(MappedEventList &);
 
+    /// Number of recorded events that were lost since recording started.
+    /**
+     * Events are only lost if the GUI stops taking them for so long that
+     * RosegardenSequencer's backlog fills up.  See
+     * RosegardenSequencer::processRecordedMidi().
+     */
+    unsigned getRecordOverflowCount() const
+        { return m_recordOverflowCount.load(std::memory_order_relaxed); }
+    /// Count events that had to be dropped.
+    void addRecordOverflow(unsigned count)
+        { m_recordOverflowCount.fetch_add(count, std::memory_order_relaxed); }
+    /// Called when recording starts.
+    void resetRecordOverflowCount()
+        { m_recordOverflowCount.store(0, std::memory_order_relaxed); }
+
     // unused bool getTrackLevel(TrackId track, LevelInfo &) const;
     // unused void setTrackLevel(TrackId track, const LevelInfo &);
 
@@ -146,21 +180,23 @@ protected:
     /// MIDI OUT event for display on the transport during playback.
     MappedEvent m_visualEvent{};
 
-    /// Index of the next available position in m_recordBuffer.
+    /// Next position in m_recordBuffer to be claimed by a writer.
     /**
-     * volatile is needed here (and probably other places) since this is used
-     * across threads.  volatile prevents compiler optimizations (caching)
-     * that might render the data useless.  The chances that the compiler
-     * might optimize in this fashion are very slim given the code that uses
-     * this variable.  However, better safe than sorry.
+     * Writers claim a range of slots by advancing this with a
+     * compare-and-swap, then fill the slots in without any locking.
      */
-    volatile int m_recordEventIndex;
-    /// Read position in m_recordBuffer.
+    std::atomic<int> m_recordReserveIndex;
+    /// Index of the next position in m_recordBuffer that is not yet readable.
     /**
-     * It's iffy as to whether "volatile" is actually needed here.  The two
-     * functions that use this may or may not be on different threads.
+     * Writers publish their slots by advancing this, in the order in
+     * which the slots were claimed.  Everything between m_readIndex and
+     * this is ready to be read.
      */
-    int m_readIndex;
+    std::atomic<int> m_recordEventIndex;
+    /// Read position in m_recordBuffer.
+    std::atomic<int> m_readIndex;
+    /// See getRecordOverflowCount().
+    std::atomic<unsigned> m_recordOverflowCount;
     /// Ring buffer of recorded MIDI events.
     MappedEvent m_recordBuffer[SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE]{};
 
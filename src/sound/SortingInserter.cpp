@@ -17,6 +17,8 @@
 
 #include "SortingInserter.h"
 
+#include <algorithm>
+
 namespace Rosegarden
 {
 
@@ -24,23 +26,19 @@ void
 SortingInserter::
 insertSorted(MappedInserterBase &exporter)
 {
-    static MappedEventCmp merc;
-    // std::list sort is stable, so we get same-time events in the
-    // order we inserted them, important for NoteOffs.
-    m_list.sort(merc);
-    std::list<MappedEvent>::const_iterator i = m_list.begin();
-    if (i != m_list.end() && i->getEventTime() < RealTime::zero()) {
-        // Negative time if the composition starts before the bar 1
-        RealTime timeOffset = - i->getEventTime();
-        for(; i != m_list.end(); ++i) {
-            MappedEvent *mE = new MappedEvent(*i);
-            mE->setEventTime(mE->getEventTime() + timeOffset);
-            exporter.insertCopy(*mE);
-        }
-    } else {
-        for(; i != m_list.end(); ++i) {
-            exporter.insertCopy(*i);
-        }
+    // std::stable_sort keeps same-time events in the order we inserted
+    // them, important for NoteOffs.
+    std::stable_sort(m_events.begin(), m_events.end());
+
+    // Negative time if the composition starts before the bar 1
+    RealTime timeOffset = RealTime::zero();
+    if (!m_events.empty() && m_events.front().getEventTime() < RealTime::zero())
+        timeOffset = - m_events.front().getEventTime();
+
+    for (MappedEvent &event : m_events) {
+        if (timeOffset != RealTime::zero())
+            event.setEventTime(event.getEventTime() + timeOffset);
+        exporter.insertCopy(event);
     }
 }
 
@@ -48,9 +46,8 @@ void
 SortingInserter::
 insertCopy(const MappedEvent &evt)
 {
-    m_list.push_back(evt);
-}
-  
+    m_events.push_back(evt);
 }
 
 
+}
@@ -20,7 +20,7 @@
 
 #include "sound/MappedInserterBase.h"
 #include "sound/MappedEvent.h"
-#include <list>
+#include <vector>
 
 namespace Rosegarden
 {
@@ -38,17 +38,6 @@ namespace Rosegarden
  */
 class SortingInserter : public MappedInserterBase
 {
-    /// Comparison functor for std::list::sort()
-    struct MappedEventCmp
-    {
-        bool operator()(const MappedEvent &a, const MappedEvent &b) const {
-            // ??? This functor may not be needed given that operator<
-            //     is defined for MappedEvent.  std::list::sort() without
-            //     arguments will use MappedEvent::operator<().
-            return a < b;
-        }
-    };
-    
 public:
     /// Sorts the events and copies them to an inserter.
     /**
@@ -61,16 +50,16 @@ public:
     void insertSorted(MappedInserterBase &exporter);
 
 private:
-    /// Inserts an event into a list in preparation for sorting.
+    /// Inserts an event into a vector in preparation for sorting.
     /**
-     * See insertSorted() which sorts the list and extracts the events
-     * from the list in sorted order.
+     * See insertSorted() which sorts the vector and extracts the events
+     * from it in sorted order.
      */
     void insertCopy(const MappedEvent &evt) override;
 
-    // NB, this is not the same as MappedEventList which is actually a
-    // std::multiset.
-    std::list<MappedEvent> m_list;
+    // NB, this is not the same as MappedEventList which keeps its
+    // events sorted as they come in.
+    std::vector<MappedEvent> m_events;
 };
 
 }
@@ -0,0 +1,82 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_TEST_NOTEBUFFER_H
+#define RG_TEST_NOTEBUFFER_H
+
+#include "gui/seqmanager/MappedEventBuffer.h"
+#include "base/RealTime.h"
+#include "base/Track.h"
+#include "sound/MappedEvent.h"
+
+/// A buffer of evenly spaced notes, like a short segment.
+/**
+ * For the tests of the sequencer's playback path.
+ */
+class NoteBuffer : public Rosegarden::MappedEventBuffer
+{
+public:
+    NoteBuffer(Rosegarden::TrackId trackId,
+               const Rosegarden::RealTime &start,
+               int notes) :
+        Rosegarden::MappedEventBuffer(nullptr),
+        m_trackId(trackId),
+        m_start(start),
+        m_notes(notes)
+    {
+    }
+
+    /// Move the notes, as editing the segment would.
+    void moveTo(const Rosegarden::RealTime &start)
+    {
+        m_start = start;
+        refresh();
+    }
+
+    static Rosegarden::RealTime spacing()
+            { return Rosegarden::RealTime::fromMilliseconds(50); }
+
+protected:
+    int calculateSize() override  { return m_notes; }
+
+    void fillBuffer() override
+    {
+        resize(0);
+
+        for (int i = 0; i < m_notes; ++i) {
+            Rosegarden::MappedEvent event;
+            event.setType(Rosegarden::MappedEvent::MidiNote);
+            event.setTrackId(m_trackId);
+            event.setPitch(60 + (m_trackId + i) % 12);
+            event.setVelocity(100);
+            event.setEventTime(m_start + spacing() * i);
+            event.setDuration(spacing());
+            mapAnEvent(&event);
+        }
+
+        setStartEnd(m_start, m_start + spacing() * m_notes);
+    }
+
+    bool shouldPlay(Rosegarden::MappedEvent *event,
+                    Rosegarden::RealTime startTime) override
+        { return !event->EndedBefore(startTime); }
+
+private:
+    Rosegarden::TrackId m_trackId;
+    Rosegarden::RealTime m_start;
+    int m_notes;
+};
+
+#endif
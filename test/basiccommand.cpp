@@ -0,0 +1,285 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/BaseProperties.h"
+#include "base/Event.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "base/SegmentLinker.h"
+#include "document/BasicCommand.h"
+#include "document/CommandHistory.h"
+
+#include <QTest>
+
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test for BasicCommand undo/redo and linked segment updates
+/**
+ * Both only swap the Events that actually changed.  See
+ * BasicCommand::copyFrom() and SegmentLinker::linkedSegmentChanged().
+ */
+class TestBasicCommand : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testUndoRedo_data();
+    void testUndoRedo();
+    void testLinkedSegment();
+};
+
+namespace
+{
+    const int noteCount = 2000;
+    const timeT spacing = 120;
+
+    // The command touches the first and last notes in this range.
+    const timeT editStart = 1000 * spacing;
+    const timeT editEnd = 1010 * spacing;
+
+    Segment *makeSegment()
+    {
+        Segment *segment = new Segment;
+
+        for (int i = 0; i < noteCount; ++i) {
+            Event *note = new Event(Note::EventType, i * spacing, spacing);
+            note->set<Int>(BaseProperties::PITCH, 48 + i % 24);
+            segment->insert(note);
+        }
+
+        return segment;
+    }
+
+    /// A plain copy.  Unlike Segment::clone(), not linked to anything.
+    Segment *copyOf(const Segment &segment)
+    {
+        Segment *copy = new Segment;
+        for (const Event *event : segment) {
+            copy->insert(new Event(*event));
+        }
+        return copy;
+    }
+
+    /// Same Events, in the same order.
+    bool sameEvents(const Segment &a, const Segment &b)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        Segment::const_iterator j = b.begin();
+        for (Segment::const_iterator i = a.begin(); i != a.end(); ++i, ++j) {
+            if (!(**i == **j))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// The Events themselves (not copies) in [start, end).
+    std::vector<const Event *> eventsIn(const Segment &segment,
+                                        timeT start, timeT end)
+    {
+        std::vector<const Event *> events;
+        for (Segment::const_iterator i = segment.findTime(start);
+             i != segment.findTime(end); ++i) {
+            events.push_back(*i);
+        }
+        return events;
+    }
+}
+
+/// Replaces the first and last notes in [start, end) with ones a
+/// semitone up.
+class BumpCommand : public BasicCommand
+{
+public:
+    BumpCommand(Segment &segment, timeT start, timeT end,
+                bool bruteForceRedo) :
+        BasicCommand("Bump", segment, start, end, bruteForceRedo),
+        m_start(start),
+        m_end(end)
+    { }
+
+protected:
+    void modifySegment() override
+    {
+        Segment &segment = getSegment();
+
+        Segment::iterator last = segment.findTime(m_end);
+        --last;
+        bump(segment, last);
+        bump(segment, segment.findTime(m_start));
+    }
+
+private:
+    static void bump(Segment &segment, Segment::iterator i)
+    {
+        Event *note = new Event(**i);
+        note->set<Int>(BaseProperties::PITCH,
+                       note->get<Int>(BaseProperties::PITCH) + 1);
+        segment.erase(i);
+        segment.insert(note);
+    }
+
+    timeT m_start;
+    timeT m_end;
+};
+
+/// Counts the Events added to and removed from a Segment.
+class ChangeCounter : public SegmentObserver
+{
+public:
+    void eventAdded(const Segment *, Event *) override  { ++added; }
+    void eventRemoved(const Segment *, Event *) override  { ++removed; }
+    void segmentDeleted(const Segment *) override  { }
+
+    void reset()  { added = 0; removed = 0; }
+
+    int added{0};
+    int removed{0};
+};
+
+void TestBasicCommand::init()
+{
+    CommandHistory::getInstance()->clear();
+}
+
+void TestBasicCommand::cleanup()
+{
+    CommandHistory::getInstance()->clear();
+}
+
+void TestBasicCommand::testUndoRedo_data()
+{
+    QTest::addColumn<bool>("bruteForceRedo");
+
+    QTest::newRow("modifySegment redo") << false;
+    QTest::newRow("brute force redo") << true;
+}
+
+void TestBasicCommand::testUndoRedo()
+{
+    QFETCH(bool, bruteForceRedo);
+
+    CommandHistory *history = CommandHistory::getInstance();
+
+    Segment *segment = makeSegment();
+    Segment *original = copyOf(*segment);
+
+    ChangeCounter counter;
+    segment->addObserver(&counter);
+
+    history->addCommand(
+            new BumpCommand(*segment, editStart, editEnd, bruteForceRedo));
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(!sameEvents(*segment, *original));
+
+    Segment *edited = copyOf(*segment);
+
+    // The notes between the two that changed are in the range that undo
+    // restores, but are the same Events before and after.
+    const std::vector<const Event *> middle =
+            eventsIn(*segment, editStart + 1, editEnd - spacing);
+    QCOMPARE(middle.size(), size_t(8));
+
+    counter.reset();
+    history->undo();
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*segment, *original));
+    QVERIFY(eventsIn(*segment, editStart + 1, editEnd - spacing) == middle);
+
+    counter.reset();
+    history->redo();
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*segment, *edited));
+    QVERIFY(eventsIn(*segment, editStart + 1, editEnd - spacing) == middle);
+
+    counter.reset();
+    history->undo();
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*segment, *original));
+
+    history->clear();
+    segment->removeObserver(&counter);
+    delete edited;
+    delete original;
+    delete segment;
+}
+
+void TestBasicCommand::testLinkedSegment()
+{
+    CommandHistory *history = CommandHistory::getInstance();
+
+    Segment *segment = makeSegment();
+    Segment *linked = SegmentLinker::createLinkedSegment(segment);
+    QVERIFY(linked->isLinkedTo(segment));
+
+    // After createLinkedSegment(), which adds a key at the start.
+    Segment *original = copyOf(*segment);
+    QVERIFY(sameEvents(*linked, *original));
+
+    ChangeCounter counter;
+    linked->addObserver(&counter);
+
+    history->addCommand(new BumpCommand(*segment, editStart, editEnd, false));
+
+    // Only the two notes that changed are passed on to the linked
+    // Segment.  Its other notes in the range stay put.
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*linked, *segment));
+
+    Segment *edited = copyOf(*segment);
+
+    counter.reset();
+    history->undo();
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*segment, *original));
+    QVERIFY(sameEvents(*linked, *original));
+
+    counter.reset();
+    history->redo();
+
+    QCOMPARE(counter.removed, 2);
+    QCOMPARE(counter.added, 2);
+    QVERIFY(sameEvents(*linked, *edited));
+
+    history->clear();
+    linked->removeObserver(&counter);
+    SegmentLinker::unlinkSegment(linked);
+    SegmentLinker::unlinkSegment(segment);
+    delete edited;
+    delete original;
+    delete linked;
+    delete segment;
+}
+
+QTEST_MAIN(TestBasicCommand)
+
+#include "basiccommand.moc"
@@ -0,0 +1,213 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "Workload.h"
+
+#include "base/BaseProperties.h"
+#include "base/Composition.h"
+#include "base/MidiTypes.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "base/SegmentLinker.h"
+#include "base/Studio.h"
+#include "base/Track.h"
+#include "base/TriggerSegment.h"
+#include "document/RosegardenDocument.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace Rosegarden;
+
+namespace
+{
+
+    // Bars per segment.
+    const int segmentBars = 8;
+
+    /// A random number in [0, n).
+    /**
+     * Only the raw output of the engine is used.  The standard
+     * distributions are free to differ between libraries.
+     */
+    int pick(std::minstd_rand &random, int n)
+    {
+        return int(random() % unsigned(n));
+    }
+
+}
+
+Workload::Workload(double scale) :
+    m_tracks(16),
+    m_bars(std::max(segmentBars, int(std::lround(128 * scale))))
+{
+    // Whole segments only.
+    m_bars -= m_bars % segmentBars;
+}
+
+void
+Workload::fill(RosegardenDocument *doc) const
+{
+    Composition &composition = doc->getComposition();
+    Studio &studio = doc->getStudio();
+
+    std::minstd_rand random(1);
+
+    InstrumentId baseInstrumentId;
+    const DeviceId deviceId = studio.getSpareDeviceId(baseInstrumentId);
+    studio.addDevice("Benchmark", deviceId, baseInstrumentId, Device::Midi);
+
+    const timeT barDuration = Note(Note::Semibreve).getDuration();
+    const timeT sixteenth = Note(Note::Semiquaver).getDuration();
+
+    // Ramps up and back down every segment's length.
+    for (int bar = 0; bar < m_bars; bar += segmentBars) {
+        const bool up = (bar / segmentBars) % 2 == 0;
+        composition.addTempoAtTime(
+                bar * barDuration,
+                Composition::getTempoForQpm(up ? 100 : 140),
+                Composition::getTempoForQpm(up ? 140 : 100));
+    }
+
+    // A three note turn that the notes of some tracks trigger.
+    Segment *ornament = new Segment;
+    for (int i = 0; i < 3; ++i) {
+        ornament->insert(Note(Note::Demisemiquaver).getAsNoteEvent(
+                i * Note(Note::Demisemiquaver).getDuration(),
+                60 + (i == 1 ? 2 : 0)));
+    }
+    TriggerSegmentRec *trigger =
+        composition.addTriggerSegment(ornament, 60, 100);
+
+    for (int t = 0; t < m_tracks; ++t) {
+        const TrackId trackId = composition.getNewTrackId();
+        composition.addTrack(new Track(
+                trackId, baseInstrumentId + t, t,
+                QString("Track %1").arg(t + 1).toStdString()));
+
+        const bool chords = t % 4 == 1;
+        const bool bends = t % 4 == 0;
+        const bool triggers = t % 4 == 3;
+
+        Segment *previous = nullptr;
+
+        for (int bar = 0; bar < m_bars; bar += segmentBars) {
+            const timeT start = bar * barDuration;
+
+            // Every fourth segment repeats the one before as a link.
+            if (previous  &&  (bar / segmentBars) % 4 == 3) {
+                Segment *linked = SegmentLinker::createLinkedSegment(previous);
+                linked->setStartTime(start);
+                linked->setTrack(trackId);
+                composition.addSegment(linked);
+                previous = linked;
+                continue;
+            }
+
+            Segment *segment = new Segment;
+            segment->setTrack(trackId);
+            segment->setStartTime(start);
+            segment->setLabel(QString("Segment %1").arg(bar / segmentBars + 1).
+                              toStdString());
+
+            const timeT end = start + segmentBars * barDuration;
+
+            for (timeT time = start; time < end; time += sixteenth) {
+                const int step = int((time - start) / sixteenth);
+
+                // Controllers: volume on the beat, expression twice as
+                // often and pitch bend on every sixteenth.
+                if (step % 4 == 0) {
+                    segment->insert(Controller::makeEvent(
+                            time, 7, 64 + pick(random, 64)));
+                }
+                if (step % 2 == 0) {
+                    segment->insert(Controller::makeEvent(
+                            time, 11, pick(random, 128)));
+                }
+                if (bends) {
+                    const int bend = 8192 + int(4096 * std::sin(step * 0.2));
+                    segment->insert(PitchBend::makeEvent(
+                            time, bend >> 7, bend & 0x7f));
+                }
+
+                // Three notes out of four, played a little off the grid
+                // so the quantizers have something to do.
+                if (pick(random, 4) == 0)
+                    continue;
+
+                const timeT played = std::max(
+                        start, time + pick(random, 21) - 10);
+                const Note::Type types[] =
+                    { Note::Semiquaver, Note::Quaver, Note::Crotchet };
+                const timeT duration =
+                    Note(types[pick(random, 3)]).getDuration() -
+                    pick(random, 10);
+                const int pitch = 36 + pick(random, 60);
+                const int voices = (chords && step % 4 == 0) ? 3 : 1;
+
+                for (int voice = 0; voice < voices; ++voice) {
+                    Event *note = new Event(
+                            Note::EventType, played, duration);
+                    note->set<Int>(BaseProperties::PITCH,
+                                   std::min(127, pitch + voice * 4));
+                    note->set<Int>(BaseProperties::VELOCITY,
+                                   40 + pick(random, 88));
+                    if (triggers && step % 16 == 0) {
+                        note->set<Int>(BaseProperties::TRIGGER_SEGMENT_ID,
+                                       trigger->getId());
+                        note->set<Bool>(BaseProperties::TRIGGER_SEGMENT_RETUNE,
+                                        true);
+                        note->set<String>(
+                                BaseProperties::TRIGGER_SEGMENT_ADJUST_TIMES,
+                                BaseProperties::TRIGGER_SEGMENT_ADJUST_SQUISH);
+                    }
+                    segment->insert(note);
+                }
+            }
+
+            segment->setEndMarkerTime(end);
+            composition.addSegment(segment);
+            previous = segment;
+        }
+    }
+
+    trigger->updateReferences();
+
+    composition.setEndMarker(m_bars * barDuration);
+}
+
+std::vector<Event *>
+Workload::makeNotes(int count) const
+{
+    std::minstd_rand random(2);
+
+    const timeT sixteenth = Note(Note::Semiquaver).getDuration();
+
+    std::vector<Event *> notes;
+    notes.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        notes.push_back(Note(Note::Semiquaver).getAsNoteEvent(
+                i * sixteenth, 36 + pick(random, 60)));
+    }
+
+    // Fisher-Yates, on the raw engine like everything else here.
+    for (int i = count - 1; i > 0; --i) {
+        std::swap(notes[i], notes[pick(random, i + 1)]);
+    }
+
+    return notes;
+}
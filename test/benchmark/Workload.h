@@ -0,0 +1,57 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#ifndef RG_BENCHMARK_WORKLOAD_H
+#define RG_BENCHMARK_WORKLOAD_H
+
+#include "base/Event.h"
+
+#include <vector>
+
+namespace Rosegarden
+{
+    class RosegardenDocument;
+}
+
+/// Builds the compositions the benchmarks work on.
+/**
+ * Everything is generated from a fixed seed, so the same scale gives
+ * the same composition, event for event, on every run and machine.
+ * Scale 1 is a large piece: 16 tracks of 128 bars with dense notes and
+ * controllers, tempo ramps, linked segments and triggered ornaments.
+ */
+class Workload
+{
+public:
+    explicit Workload(double scale);
+
+    int tracks() const  { return m_tracks; }
+    int bars() const  { return m_bars; }
+
+    /// Fill doc's studio and composition.
+    void fill(Rosegarden::RosegardenDocument *doc) const;
+
+    /// count notes on sixteenths, in a shuffled but repeatable order.
+    /**
+     * The caller owns the events.
+     */
+    std::vector<Rosegarden::Event *> makeNotes(int count) const;
+
+private:
+    int m_tracks;
+    int m_bars;
+};
+
+#endif
@@ -0,0 +1,556 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "Workload.h"
+
+#include "base/BasicQuantizer.h"
+#include "base/Composition.h"
+#include "base/Event.h"
+#include "base/NotationQuantizer.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "base/Track.h"
+#include "document/RosegardenDocument.h"
+#include "gui/editors/notation/NotationWidget.h"
+#include "gui/seqmanager/SegmentMapper.h"
+#include "sound/MappedBufMetaIterator.h"
+#include "sound/MappedEvent.h"
+#include "sound/MappedInserterBase.h"
+#include "sound/MidiFile.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace Rosegarden;
+
+namespace
+{
+
+    // Everything allocated since the start.
+    std::atomic<long> allocations(0);
+    std::atomic<long> allocatedBytes(0);
+
+}
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(long(size), std::memory_order_relaxed);
+
+    void *p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+    /// Start the peak resident set size over from the current size.
+    /**
+     * Linux 4.0 and later.  Elsewhere the peak is that of the whole run.
+     */
+    void resetPeakRss()
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+    }
+
+    /// The peak resident set size, in kB.
+    long peakRssKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0)
+                return std::atol(line.c_str() + 6);
+        }
+
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    /// Time, allocations and memory of the part of a benchmark that counts.
+    class Measurement
+    {
+    public:
+        void start()
+        {
+            resetPeakRss();
+            m_allocations = allocations;
+            m_allocatedBytes = allocatedBytes;
+            m_timer.start();
+        }
+
+        /// operations is how many things were done, for rates.
+        void stop(long operations)
+        {
+            m_nsecs = m_timer.nsecsElapsed();
+            m_allocations = allocations - m_allocations;
+            m_allocatedBytes = allocatedBytes - m_allocatedBytes;
+            m_peakRssKb = peakRssKb();
+            m_operations = operations;
+        }
+
+        /// One line of JSON.
+        void print(const char *name, double scale) const
+        {
+            std::printf("{\"benchmark\":\"%s\",\"scale\":%g,"
+                        "\"operations\":%ld,\"ms\":%.3f,"
+                        "\"allocations\":%ld,\"allocatedBytes\":%ld,"
+                        "\"peakRssKb\":%ld}\n",
+                        name, scale, m_operations, m_nsecs / 1e6,
+                        m_allocations, m_allocatedBytes, m_peakRssKb);
+            std::fflush(stdout);
+        }
+
+    private:
+        QElapsedTimer m_timer;
+        qint64 m_nsecs{0};
+        long m_operations{0};
+        long m_allocations{0};
+        long m_allocatedBytes{0};
+        long m_peakRssKb{0};
+    };
+
+    /// Counts what the metaiterator fetches.
+    class CountingInserter : public MappedInserterBase
+    {
+    public:
+        void insertCopy(const MappedEvent &) override  { ++count; }
+
+        long count{0};
+    };
+
+    typedef std::unique_ptr<RosegardenDocument> DocumentPtr;
+
+    DocumentPtr makeDocument()
+    {
+        DocumentPtr doc(new RosegardenDocument(nullptr, {}, true, true, false));
+        RosegardenDocument::currentDocument = doc.get();
+        return doc;
+    }
+
+    DocumentPtr makeDocument(const Workload &workload)
+    {
+        DocumentPtr doc = makeDocument();
+        workload.fill(doc.get());
+        return doc;
+    }
+
+    long countEvents(const Composition &composition)
+    {
+        long events = 0;
+        for (const Segment *segment : composition.getSegments()) {
+            events += long(segment->size());
+        }
+        return events;
+    }
+
+    // The notes the Segment benchmarks insert.
+    int noteCount(const Workload &workload)
+    {
+        return workload.tracks() * workload.bars() * 64;
+    }
+
+    bool segmentInsert(const Workload &workload, const QDir &,
+                       Measurement &measurement)
+    {
+        const std::vector<Event *> notes =
+            workload.makeNotes(noteCount(workload));
+        Segment segment;
+
+        measurement.start();
+        for (Event *note : notes) {
+            segment.insert(note);
+        }
+        measurement.stop(long(notes.size()));
+
+        return segment.size() == notes.size();
+    }
+
+    bool segmentFind(const Workload &workload, const QDir &,
+                     Measurement &measurement)
+    {
+        const std::vector<Event *> notes =
+            workload.makeNotes(noteCount(workload));
+        Segment segment;
+        for (Event *note : notes) {
+            segment.insert(note);
+        }
+
+        measurement.start();
+        size_t found = 0;
+        for (const Event *note : notes) {
+            if (segment.findTime(note->getAbsoluteTime()) != segment.end())
+                ++found;
+            if (segment.findSingle(note) != segment.end())
+                ++found;
+        }
+        measurement.stop(long(notes.size() * 2));
+
+        return found == notes.size() * 2;
+    }
+
+    bool segmentErase(const Workload &workload, const QDir &,
+                      Measurement &measurement)
+    {
+        const std::vector<Event *> notes =
+            workload.makeNotes(noteCount(workload));
+        Segment segment;
+        for (Event *note : notes) {
+            segment.insert(note);
+        }
+
+        // In the reverse of the order they went in.
+        measurement.start();
+        for (size_t i = 0; i < notes.size(); ++i) {
+            segment.erase(segment.findSingle(notes[notes.size() - 1 - i]));
+        }
+        measurement.stop(long(notes.size()));
+
+        return segment.empty();
+    }
+
+    std::vector<QSharedPointer<SegmentMapper> >
+    makeMappers(RosegardenDocument *doc)
+    {
+        std::vector<QSharedPointer<SegmentMapper> > mappers;
+        for (Segment *segment : doc->getComposition().getSegments()) {
+            mappers.push_back(
+                    SegmentMapper::makeMapperForSegment(doc, segment));
+        }
+        return mappers;
+    }
+
+    bool mapperFill(const Workload &workload, const QDir &,
+                    Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+
+        measurement.start();
+        std::vector<QSharedPointer<SegmentMapper> > mappers =
+            makeMappers(doc.get());
+        long mapped = 0;
+        for (const QSharedPointer<SegmentMapper> &mapper : mappers) {
+            mapped += mapper->size();
+        }
+        measurement.stop(mapped);
+
+        return mapped > 0;
+    }
+
+    bool metaIteratorFetch(const Workload &workload, const QDir &,
+                           Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+        const Composition &composition = doc->getComposition();
+
+        MappedBufMetaIterator metaIterator;
+        long mapped = 0;
+        for (const QSharedPointer<SegmentMapper> &mapper :
+                 makeMappers(doc.get())) {
+            metaIterator.addBuffer(mapper);
+            mapped += mapper->size();
+        }
+
+        const RealTime end =
+            composition.getElapsedRealTime(composition.getEndMarker());
+        // The sequencer's slice.
+        const RealTime slice = RealTime::fromMilliseconds(160);
+
+        CountingInserter inserter;
+
+        measurement.start();
+        metaIterator.jumpToTime(RealTime::zero());
+        for (RealTime t = RealTime::zero(); t < end; t = t + slice) {
+            metaIterator.fetchEvents(inserter, t, t + slice);
+        }
+        measurement.stop(inserter.count);
+
+        return inserter.count > 0  &&  inserter.count <= mapped;
+    }
+
+    bool notationLayout(const Workload &workload, const QDir &,
+                        Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+        const Composition &composition = doc->getComposition();
+
+        // A quarter of the tracks, as when opening a section of the
+        // score.
+        std::vector<Segment *> segments;
+        long events = 0;
+        for (Segment *segment : composition.getSegments()) {
+            const Track *track = composition.getTrackById(segment->getTrack());
+            if (track  &&  track->getPosition() < workload.tracks() / 4) {
+                segments.push_back(segment);
+                events += long(segment->size());
+            }
+        }
+
+        NotationWidget widget;
+
+        measurement.start();
+        widget.setSegments(doc.get(), segments);
+        measurement.stop(events);
+
+        return widget.getScene() != nullptr;
+    }
+
+    bool rgSave(const Workload &workload, const QDir &directory,
+                Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+        const QString filename = directory.filePath("benchmark.rg");
+        QString errMsg;
+
+        measurement.start();
+        const bool ok = doc->saveDocument(filename, errMsg);
+        measurement.stop(countEvents(doc->getComposition()));
+
+        if (!ok)
+            std::fprintf(stderr, "%s\n", qPrintable(errMsg));
+        return ok;
+    }
+
+    bool rgLoad(const Workload &workload, const QDir &directory,
+                Measurement &measurement)
+    {
+        const QString filename = directory.filePath("benchmark.rg");
+        long saved = 0;
+        {
+            DocumentPtr doc = makeDocument(workload);
+            QString errMsg;
+            if (!doc->saveDocument(filename, errMsg)) {
+                std::fprintf(stderr, "%s\n", qPrintable(errMsg));
+                return false;
+            }
+            saved = countEvents(doc->getComposition());
+        }
+
+        DocumentPtr loaded = makeDocument();
+
+        measurement.start();
+        const bool ok = loaded->openDocument(filename, false, true, false);
+        measurement.stop(countEvents(loaded->getComposition()));
+
+        return ok  &&  countEvents(loaded->getComposition()) == saved;
+    }
+
+    bool midiExport(const Workload &workload, const QDir &directory,
+                    Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+        const QString filename = directory.filePath("benchmark.mid");
+
+        measurement.start();
+        MidiFile midiFile;
+        const bool ok = midiFile.convertToMidi(doc.get(), filename);
+        measurement.stop(countEvents(doc->getComposition()));
+
+        return ok;
+    }
+
+    bool midiImport(const Workload &workload, const QDir &directory,
+                    Measurement &measurement)
+    {
+        const QString filename = directory.filePath("benchmark.mid");
+        {
+            DocumentPtr doc = makeDocument(workload);
+            MidiFile midiFile;
+            if (!midiFile.convertToMidi(doc.get(), filename))
+                return false;
+        }
+
+        DocumentPtr imported = makeDocument();
+
+        measurement.start();
+        MidiFile midiFile;
+        const bool ok = midiFile.convertToRosegarden(filename, imported.get());
+        measurement.stop(countEvents(imported->getComposition()));
+
+        if (!ok)
+            std::fprintf(stderr, "%s\n", midiFile.getError().c_str());
+        return ok;
+    }
+
+    bool quantize(const Workload &workload, const Quantizer &quantizer,
+                  Measurement &measurement)
+    {
+        DocumentPtr doc = makeDocument(workload);
+        const Composition &composition = doc->getComposition();
+
+        measurement.start();
+        for (Segment *segment : composition.getSegments()) {
+            quantizer.quantize(segment);
+        }
+        measurement.stop(countEvents(composition));
+
+        return true;
+    }
+
+    bool quantizeBasic(const Workload &workload, const QDir &,
+                       Measurement &measurement)
+    {
+        const BasicQuantizer quantizer(
+                Note(Note::Semiquaver).getDuration(), true);
+        return quantize(workload, quantizer, measurement);
+    }
+
+    bool quantizeNotation(const Workload &workload, const QDir &,
+                          Measurement &measurement)
+    {
+        const NotationQuantizer quantizer;
+        return quantize(workload, quantizer, measurement);
+    }
+
+    struct Benchmark
+    {
+        const char *name;
+        bool (*run)(const Workload &, const QDir &, Measurement &);
+    };
+
+    const Benchmark benchmarks[] = {
+        { "segment.insert", segmentInsert },
+        { "segment.find", segmentFind },
+        { "segment.erase", segmentErase },
+        { "mapper.fill", mapperFill },
+        { "metaiterator.fetch", metaIteratorFetch },
+        { "notation.layout", notationLayout },
+        { "rg.save", rgSave },
+        { "rg.load", rgLoad },
+        { "midi.export", midiExport },
+        { "midi.import", midiImport },
+        { "quantize.basic", quantizeBasic },
+        { "quantize.notation", quantizeNotation }
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr,
+                "Usage: rgbenchmark [--scale factor] [--filter text] [--list]\n"
+                "\n"
+                "Runs each benchmark whose name contains text on a generated\n"
+                "composition (scale 1 is 16 tracks of 128 bars) and prints one\n"
+                "line of JSON per benchmark.\n");
+    }
+
+}
+
+int main(int argc, char *argv[])
+{
+    // No display needed.
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    // Make sure settings end up in the right place, away from the
+    // user's own Rosegarden settings.
+    QCoreApplication::setOrganizationName("rosegardenmusic");
+    QCoreApplication::setApplicationName("rgbenchmark");
+
+    double scale = 1;
+    QString filter;
+    bool list = false;
+
+    const QStringList args = QCoreApplication::arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--scale"  &&  i + 1 < args.size()) {
+            bool ok = false;
+            scale = args[++i].toDouble(&ok);
+            if (!ok  ||  scale <= 0) {
+                usage();
+                return 2;
+            }
+        } else if (args[i] == "--filter"  &&  i + 1 < args.size()) {
+            filter = args[++i];
+        } else if (args[i] == "--list") {
+            list = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (list) {
+        for (const Benchmark &benchmark : benchmarks) {
+            std::printf("%s\n", benchmark.name);
+        }
+        return 0;
+    }
+
+    QSettings settings;
+    settings.beginGroup("Sequencer_Options");
+    // MidiFile: Don't start JACK.
+    settings.setValue("autostartjack", false);
+    settings.endGroup();
+
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        std::fprintf(stderr, "Can't create a temporary directory\n");
+        return 1;
+    }
+
+    const Workload workload(scale);
+
+    int failed = 0;
+    for (const Benchmark &benchmark : benchmarks) {
+        if (!QString(benchmark.name).contains(filter))
+            continue;
+
+        Measurement measurement;
+        const bool ok = benchmark.run(
+                workload, QDir(directory.path()), measurement);
+        RosegardenDocument::currentDocument = nullptr;
+
+        if (!ok) {
+            std::fprintf(stderr, "%s failed\n", benchmark.name);
+            ++failed;
+            continue;
+        }
+
+        measurement.print(benchmark.name, scale);
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "document/Command.h"
+#include "document/CommandHistory.h"
+#include "misc/Preferences.h"
+
+#include <QTest>
+
+#include <set>
+
+using namespace Rosegarden;
+
+/// Unit test for the CommandHistory memory budget
+class TestCommandHistory : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void testUndoLimit();
+    void testRedoKept();
+    void testUnlimited();
+    void testMemoryReport();
+};
+
+static const size_t KB = 1024;
+
+/// Holds a fixed amount of memory, or more once it has been redone.
+class FakeCommand : public NamedCommand
+{
+public:
+    FakeCommand(const QString &name, size_t memory,
+                size_t redoneMemory = 0) :
+        NamedCommand(name),
+        m_memory(memory),
+        m_redoneMemory(redoneMemory ? redoneMemory : memory),
+        m_executions(0)
+    {
+        live.insert(name);
+    }
+
+    ~FakeCommand() override  { live.erase(getName()); }
+
+    void execute() override  { ++m_executions; }
+    void unexecute() override  { }
+
+    size_t getMemoryUsage() const override
+            { return m_executions > 1 ? m_redoneMemory : m_memory; }
+
+    /// Names of the commands that have not been deleted yet.
+    static std::set<QString> live;
+
+private:
+    size_t m_memory;
+    size_t m_redoneMemory;
+    int m_executions;
+};
+
+std::set<QString> FakeCommand::live;
+
+void TestCommandHistory::initTestCase()
+{
+    Preferences::setUndoMemoryLimitMB(1);
+}
+
+void TestCommandHistory::init()
+{
+    CommandHistory::getInstance()->clear();
+    Preferences::setUndoMemoryLimitMB(1);
+    QVERIFY(FakeCommand::live.empty());
+}
+
+void TestCommandHistory::cleanupTestCase()
+{
+    CommandHistory::getInstance()->clear();
+}
+
+void TestCommandHistory::testUndoLimit()
+{
+    CommandHistory *history = CommandHistory::getInstance();
+
+    // Five 300KB commands in a 1MB budget: the oldest two go.
+    for (const char *name : { "A", "B", "C", "D", "E" }) {
+        history->addCommand(new FakeCommand(name, 300 * KB));
+    }
+
+    QCOMPARE(history->getMemoryUsage(), 900 * KB);
+    QCOMPARE(FakeCommand::live, std::set<QString>({ "C", "D", "E" }));
+
+    // Undo only moves entries to the redo history.
+    history->undo();
+    history->undo();
+
+    QCOMPARE(history->getMemoryUsage(), 900 * KB);
+    QCOMPARE(FakeCommand::live.size(), size_t(3));
+}
+
+void TestCommandHistory::testRedoKept()
+{
+    CommandHistory *history = CommandHistory::getInstance();
+
+    history->addCommand(new FakeCommand("A", 300 * KB));
+    history->addCommand(new FakeCommand("B", 300 * KB, 1100 * KB));
+    history->addCommand(new FakeCommand("C", 300 * KB));
+
+    history->undo();
+    history->undo();
+
+    // Redoing B takes the undo history over budget.  The oldest undo
+    // entry goes, but C can still be redone.
+    history->redo();
+
+    QCOMPARE(FakeCommand::live, std::set<QString>({ "B", "C" }));
+    QCOMPARE(history->getMemoryUsage(), 1400 * KB);
+
+    // Once there is nothing left to redo, B is the oldest undo entry.
+    history->redo();
+
+    QCOMPARE(FakeCommand::live, std::set<QString>({ "C" }));
+    QCOMPARE(history->getMemoryUsage(), 300 * KB);
+}
+
+void TestCommandHistory::testUnlimited()
+{
+    Preferences::setUndoMemoryLimitMB(0);
+
+    CommandHistory *history = CommandHistory::getInstance();
+
+    for (int i = 0; i < 10; ++i) {
+        history->addCommand(new FakeCommand(QString::number(i), 300 * KB));
+    }
+
+    QCOMPARE(history->getMemoryUsage(), 3000 * KB);
+    QCOMPARE(FakeCommand::live.size(), size_t(10));
+}
+
+void TestCommandHistory::testMemoryReport()
+{
+    CommandHistory *history = CommandHistory::getInstance();
+
+    history->addCommand(new FakeCommand("&Add", 300 * KB));
+    history->addCommand(new FakeCommand("Move", 100 * KB + 1));
+    history->addCommand(new FakeCommand("Erase", 0));
+
+    history->undo();
+
+    // Most recent first, names without accelerators, rounded up to KB.
+    QCOMPARE(history->getMemoryReport(), QStringList({
+            "Undo Move: 101 KB",
+            "Undo Add: 300 KB",
+            "Redo Erase: 0 KB" }));
+}
+
+QTEST_MAIN(TestCommandHistory)
+
+#include "commandhistory.moc"
@@ -0,0 +1,306 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/Composition.h"
+#include "base/NotationTypes.h"
+#include "base/RulerScale.h"
+#include "base/Segment.h"
+#include "base/Studio.h"
+#include "base/Track.h"
+#include "gui/editors/segment/compositionview/ChangingSegment.h"
+#include "gui/editors/segment/compositionview/CompositionModelImpl.h"
+
+#include <QTest>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Checks and benchmarks the arrange view's segment lookup.
+class TestCompositionModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSegmentRects();
+    void testSegmentAt();
+    void testEdits();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static const int trackCellHeight = 24;
+
+    /// Fill composition with tracks tracks of bars one bar segments.
+    static void makeComposition(Composition &composition,
+                                int tracks, int bars);
+
+    typedef std::tuple<int, int, int, int> RectKey;
+    typedef std::vector<RectKey> RectKeys;
+    static RectKey key(const QRect &rect)
+        { return RectKey(rect.x(), rect.y(), rect.width(), rect.height()); }
+
+    /// What getSegmentRects() finds in clipRect.
+    static RectKeys indexed(CompositionModelImpl &model,
+                            const QRect &clipRect);
+    /// What a search of every segment finds in clipRect.
+    static RectKeys bruteForce(CompositionModelImpl &model,
+                               Composition &composition,
+                               const QRect &clipRect);
+};
+
+void
+TestCompositionModel::makeComposition(Composition &composition,
+                                      int tracks, int bars)
+{
+    const timeT barDuration = composition.getBarEnd(0);
+
+    for (int t = 0; t < tracks; ++t) {
+        const TrackId trackId = composition.getNewTrackId();
+        composition.addTrack(new Track(trackId, MidiInstrumentBase, t));
+
+        for (int bar = 0; bar < bars; ++bar) {
+            Segment *segment = new Segment;
+            segment->setTrack(trackId);
+            segment->setStartTime(bar * barDuration);
+            // A few notes so the notation previews have something to do.
+            for (int beat = 0; beat < 4; ++beat) {
+                Note note(Note::Crotchet);
+                segment->insert(note.getAsNoteEvent(
+                        bar * barDuration + beat * note.getDuration(),
+                        60 + (t + bar + beat) % 24));
+            }
+            segment->setEndMarkerTime((bar + 1) * barDuration);
+            composition.addSegment(segment);
+        }
+    }
+
+    composition.setEndMarker(bars * barDuration);
+}
+
+TestCompositionModel::RectKeys
+TestCompositionModel::indexed(CompositionModelImpl &model,
+                              const QRect &clipRect)
+{
+    CompositionModelImpl::SegmentRects segmentRects;
+    CompositionModelImpl::NotationPreviewRanges notationPreviewRanges;
+    CompositionModelImpl::AudioPreviews audioPreviews;
+    model.getSegmentRects(clipRect, &segmentRects,
+                          &notationPreviewRanges, &audioPreviews);
+
+    RectKeys keys;
+    for (const SegmentRect &segmentRect : segmentRects) {
+        keys.push_back(key(segmentRect.rect));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+TestCompositionModel::RectKeys
+TestCompositionModel::bruteForce(CompositionModelImpl &model,
+                                 Composition &composition,
+                                 const QRect &clipRect)
+{
+    RectKeys keys;
+    for (const Segment *segment : composition.getSegments()) {
+        QRect rect;
+        model.getSegmentQRect(*segment, rect);
+        if (rect.intersects(clipRect))
+            keys.push_back(key(rect));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+void TestCompositionModel::testSegmentRects()
+{
+    Composition composition;
+    makeComposition(composition, 16, 40);
+    Studio studio;
+    SimpleRulerScale rulerScale(&composition, 0, 40);
+
+    CompositionModelImpl model(
+            nullptr, composition, studio, &rulerScale, trackCellHeight);
+
+    const int barWidth = int(rulerScale.getBarWidth(0));
+
+    // Clip rects landing on, between and beyond the segments.
+    const QRect clipRects[] = {
+        QRect(0, 0, 800, 200),
+        QRect(barWidth * 3 + 1, trackCellHeight * 2 + 3, 5, 5),
+        QRect(barWidth * 5, 0, 1, trackCellHeight * 16),
+        QRect(barWidth * 10 - 1, trackCellHeight * 4 - 1, 2, 2),
+        QRect(barWidth * 38, trackCellHeight * 14, 2000, 2000),
+        QRect(barWidth * 50, 0, 500, 500),
+        QRect(0, trackCellHeight * 20, 500, 500)
+    };
+
+    for (const QRect &clipRect : clipRects) {
+        QCOMPARE(indexed(model, clipRect),
+                 bruteForce(model, composition, clipRect));
+    }
+
+    QVERIFY(!indexed(model, QRect(0, 0, 800, 200)).empty());
+    QVERIFY(indexed(model, QRect(barWidth * 50, 0, 500, 500)).empty());
+}
+
+void TestCompositionModel::testSegmentAt()
+{
+    Composition composition;
+    makeComposition(composition, 8, 20);
+    Studio studio;
+    SimpleRulerScale rulerScale(&composition, 0, 40);
+
+    CompositionModelImpl model(
+            nullptr, composition, studio, &rulerScale, trackCellHeight);
+
+    for (const Segment *segment : composition.getSegments()) {
+        QRect rect;
+        model.getSegmentQRect(*segment, rect);
+
+        ChangingSegmentPtr changing = model.getSegmentAt(rect.center());
+        QVERIFY(changing);
+        QCOMPARE(changing->getSegment(), segment);
+    }
+
+    QVERIFY(!model.getSegmentAt(QPoint(-10, 5)));
+    QVERIFY(!model.getSegmentAt(QPoint(5, trackCellHeight * 8 + 5)));
+}
+
+void TestCompositionModel::testEdits()
+{
+    Composition composition;
+    makeComposition(composition, 8, 20);
+    Studio studio;
+    SimpleRulerScale rulerScale(&composition, 0, 40);
+
+    CompositionModelImpl model(
+            nullptr, composition, studio, &rulerScale, trackCellHeight);
+
+    const QRect all(0, 0, 100000, 100000);
+    const timeT barDuration = composition.getBarEnd(0);
+
+    // Moving segments reorders the composition, so pick them first.
+    const std::vector<Segment *> segments(composition.begin(),
+                                          composition.end());
+
+    // Move one segment to another track and later in time, lengthen
+    // another, and add and remove a few.
+    Segment *moved = segments[0];
+    moved->setTrack(composition.getTrackByPosition(5)->getId());
+    moved->setStartTime(18 * barDuration);
+
+    Segment *lengthened = segments.back();
+    lengthened->setEndMarkerTime(lengthened->getEndMarkerTime() +
+                                 10 * barDuration);
+
+    segments[1]->setRepeating(true);
+
+    Segment *added = new Segment;
+    added->setTrack(composition.getTrackByPosition(2)->getId());
+    added->setStartTime(15 * barDuration);
+    added->setEndMarkerTime(17 * barDuration);
+    composition.addSegment(added);
+
+    composition.deleteSegment(segments[2]);
+
+    const QRect clipRects[] = {
+        all,
+        QRect(int(rulerScale.getXForTime(18 * barDuration)) + 2,
+              trackCellHeight * 5 + 2, 4, 4),
+        QRect(int(rulerScale.getXForTime(19 * barDuration)), 0,
+              30, trackCellHeight * 8),
+        QRect(int(rulerScale.getXForTime(16 * barDuration)),
+              trackCellHeight * 2, 4, 4)
+    };
+
+    for (const QRect &clipRect : clipRects) {
+        QCOMPARE(indexed(model, clipRect),
+                 bruteForce(model, composition, clipRect));
+    }
+}
+
+void TestCompositionModel::benchmark_data()
+{
+    QTest::addColumn<bool>("hover");
+
+    QTest::newRow("paint") << false;
+    QTest::newRow("hover") << true;
+}
+
+void TestCompositionModel::benchmark()
+{
+    QFETCH(bool, hover);
+
+    // About 10000 segments.
+    const int tracks = 64;
+    const int bars = 160;
+
+    Composition composition;
+    makeComposition(composition, tracks, bars);
+    Studio studio;
+    SimpleRulerScale rulerScale(&composition, 0, 40);
+
+    CompositionModelImpl model(
+            nullptr, composition, studio, &rulerScale, trackCellHeight);
+
+    const QSize viewport(1200, 600);
+    const int width = int(rulerScale.getXForTime(composition.getEndMarker()));
+    const int height = tracks * trackCellHeight;
+
+    CompositionModelImpl::SegmentRects segmentRects;
+    CompositionModelImpl::NotationPreviewRanges notationPreviewRanges;
+    CompositionModelImpl::AudioPreviews audioPreviews;
+
+    // Fill the notation preview cache first so that it isn't timed.
+    model.getSegmentRects(QRect(0, 0, width, height), &segmentRects,
+                          &notationPreviewRanges, &audioPreviews);
+    QCOMPARE(int(segmentRects.size()), tracks * bars);
+
+    if (!hover) {
+        // Scroll right, then down, a viewport at a time.
+        QBENCHMARK {
+            for (int y = 0; y < height; y += viewport.height()) {
+                for (int x = 0; x < width; x += viewport.width() / 4) {
+                    notationPreviewRanges.clear();
+                    model.getSegmentRects(QRect(QPoint(x, y), viewport),
+                                          &segmentRects,
+                                          &notationPreviewRanges,
+                                          &audioPreviews);
+                }
+            }
+        }
+    } else {
+        // Hover over every track cell.
+        int hits = 0;
+        QBENCHMARK {
+            hits = 0;
+            for (int y = trackCellHeight / 2; y < height;
+                 y += trackCellHeight) {
+                for (int x = 5; x < width; x += 50) {
+                    if (model.getSegmentAt(QPoint(x, y)))
+                        ++hits;
+                }
+            }
+        }
+        QVERIFY(hits > 0);
+    }
+}
+
+QTEST_MAIN(TestCompositionModel)
+
+#include "compositionmodel.moc"
@@ -0,0 +1,231 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/ControllerContext.h"
+#include "base/MidiTypes.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+using namespace Rosegarden;
+
+/// Checks and benchmarks controller chasing through ControllerIndex
+class TestControllerContext : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSearch();
+    void testEdits();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    /// Fill segment with notes and with bars bars of controller changes.
+    static void makeSegment(Segment &segment, int bars);
+
+    /// Compare the indexed and the scanning searches of a and b.
+    static void compareSearches(const ControllerContextMap &indexes,
+                                const Segment *a, const Segment *b);
+};
+
+void
+TestControllerContext::makeSegment(Segment &segment, int bars)
+{
+    const timeT barDuration = Note(Note::Semibreve).getDuration();
+    const timeT step = barDuration / 16;
+
+    for (int bar = 0; bar < bars; ++bar) {
+        for (int i = 0; i < 16; ++i) {
+            const timeT time = bar * barDuration + i * step;
+            if (i % 4 == 0) {
+                segment.insert(Note(Note::Crotchet).getAsNoteEvent(
+                        time, 60 + (bar + i) % 12));
+            }
+            // Volume and expression often, pan now and then, and a
+            // pitch bend sweep.
+            segment.insert(Controller::makeEvent(time, 7, (bar + i) % 128));
+            if (i % 2 == 0)
+                segment.insert(Controller::makeEvent(time, 11, i * 8));
+            if (i == 0)
+                segment.insert(Controller::makeEvent(time, 10, bar % 128));
+            segment.insert(PitchBend::makeEvent(time, i * 8, 0));
+        }
+    }
+}
+
+void
+TestControllerContext::compareSearches(const ControllerContextMap &indexes,
+                                       const Segment *a, const Segment *b)
+{
+    const timeT end = std::max(a->getEndTime(), b ? b->getEndTime() : 0);
+    const timeT step = Note(Note::Semiquaver).getDuration() / 3;
+
+    for (int controllerId : { 7, 10, 11, 64 }) {
+        const ControllerSearch scan(Controller::EventType, controllerId);
+        const ControllerSearch indexed(
+                Controller::EventType, controllerId, &indexes);
+
+        for (timeT t = -step; t <= end + step; t += step) {
+            const ControllerSearch::Maybe expected =
+                scan.doubleSearch(a, b, t);
+            const ControllerSearch::Maybe actual =
+                indexed.doubleSearch(a, b, t);
+            QCOMPARE(actual.first, expected.first);
+            QCOMPARE(actual.second.value(), expected.second.value());
+            QCOMPARE(actual.second.time(), expected.second.time());
+        }
+    }
+
+    const ControllerSearch scan(PitchBend::EventType, 0);
+    const ControllerSearch indexed(PitchBend::EventType, 0, &indexes);
+    for (timeT t = -step; t <= end + step; t += step) {
+        const ControllerSearch::Maybe expected = scan.doubleSearch(a, b, t);
+        const ControllerSearch::Maybe actual = indexed.doubleSearch(a, b, t);
+        QCOMPARE(actual.first, expected.first);
+        QCOMPARE(actual.second.value(), expected.second.value());
+    }
+}
+
+void TestControllerContext::testSearch()
+{
+    Segment a;
+    makeSegment(a, 8);
+
+    // A second segment, like the triggered events, with changes of its
+    // own between a's.
+    Segment b;
+    const timeT offset = Note(Note::Semiquaver).getDuration() / 2;
+    for (int i = 0; i < 32; ++i) {
+        b.insert(Controller::makeEvent(i * 240 + offset, 7, 100 + i % 20));
+    }
+
+    ControllerContextMap indexes;
+    indexes.addIndex(&a);
+    indexes.addIndex(&b);
+    QVERIFY(indexes.getIndex(&a));
+    QVERIFY(indexes.getIndex(&b));
+
+    compareSearches(indexes, &a, &b);
+    compareSearches(indexes, &a, nullptr);
+
+    // Several changes at the same time.  The last one wins.
+    Segment c;
+    c.insert(Controller::makeEvent(960, 7, 10));
+    c.insert(Controller::makeEvent(960, 7, 20));
+    c.insert(Controller::makeEvent(960, 7, 30));
+    indexes.addIndex(&c);
+
+    const ControllerSearch search(Controller::EventType, 7, &indexes);
+    const ControllerSearch::Maybe found = search.doubleSearch(&c, nullptr, 961);
+    QVERIFY(found.first);
+    QCOMPARE(found.second.value(), 30);
+    QVERIFY(!search.doubleSearch(&c, nullptr, 960).first);
+    compareSearches(indexes, &c, nullptr);
+}
+
+void TestControllerContext::testEdits()
+{
+    Segment a;
+    makeSegment(a, 8);
+
+    ControllerContextMap indexes;
+    indexes.addIndex(&a);
+
+    // Remove every third event, add some more, and change a value in
+    // place.
+    int n = 0;
+    for (Segment::iterator i = a.begin(); i != a.end(); ) {
+        Segment::iterator j = i;
+        ++j;
+        if (++n % 3 == 0)
+            a.erase(i);
+        i = j;
+    }
+    for (int i = 0; i < 20; ++i) {
+        a.insert(Controller::makeEvent(i * 333, 64, i % 2 ? 127 : 0));
+        a.insert(Controller::makeEvent(i * 333, 7, i));
+    }
+    for (Segment::iterator i = a.begin(); i != a.end(); ++i) {
+        if ((*i)->isa(Controller::EventType)) {
+            (*i)->set<Int>(Controller::VALUE, 99);
+            break;
+        }
+    }
+
+    compareSearches(indexes, &a, nullptr);
+
+    // Moving the whole segment changes every event's time.
+    a.setStartTime(a.getStartTime() + 1000);
+    compareSearches(indexes, &a, nullptr);
+
+    a.clear();
+    compareSearches(indexes, &a, nullptr);
+    QVERIFY(!ControllerSearch(Controller::EventType, 7, &indexes).
+                doubleSearch(&a, nullptr, 100000).first);
+}
+
+void TestControllerContext::benchmark_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("scan") << false;
+    QTest::newRow("indexed") << true;
+}
+
+void TestControllerContext::benchmark()
+{
+    QFETCH(bool, indexed);
+
+    // A long segment with lots of controller changes.
+    const int bars = 2000;
+
+    Segment a;
+    makeSegment(a, bars);
+    Segment b;
+
+    ControllerContextMap indexes;
+    indexes.addIndex(&a);
+    indexes.addIndex(&b);
+
+    const timeT end = a.getEndTime();
+    // Like seeking about during playback: chase the controllers the
+    // controller-less parts of the segment would have to look back for.
+    const int seeks = 200;
+    const timeT step = end / seeks;
+
+    long total = 0;
+
+    QBENCHMARK {
+        total = 0;
+        for (int i = 0; i < seeks; ++i) {
+            for (int controllerId : { 7, 10, 11, 64 }) {
+                const ControllerSearch search(
+                        Controller::EventType, controllerId,
+                        indexed ? &indexes : nullptr);
+                total += search.doubleSearch(&a, &b, i * step).second.value();
+            }
+        }
+    }
+
+    QVERIFY(total > 0);
+}
+
+QTEST_MAIN(TestControllerContext)
+
+#include "controllercontext.moc"
@@ -2,8 +2,10 @@
 
 #include "sound/MidiFile.h"
 #include "document/RosegardenDocument.h"
+#include "document/io/BatchConverter.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QSettings>
 #include <QTest>
 
@@ -17,14 +19,27 @@ class TestConvert : public QObject
 
 private Q_SLOTS:
 
+    void initTestCase();
     void test1();
+    void testFormats();
+    void testClashingOutputs();
+
+private:
+    /// The number of bytes at pos in data, read as a big-endian number.
+    static int bigEndian(const QByteArray &data, int pos, int bytes);
 };
 
-void TestConvert::test1()
+int TestConvert::bigEndian(const QByteArray &data, int pos, int bytes)
 {
-    // For now, just do the conversion like main.cpp::convert() and
-    // let it crash.
+    int value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data.at(pos + i));
+    }
+    return value;
+}
 
+void TestConvert::initTestCase()
+{
     // Make sure settings end up in the right place.
     QCoreApplication::setOrganizationName("rosegardenmusic");
 
@@ -32,6 +47,12 @@ void TestConvert::test1()
     settings.beginGroup("Sequencer_Options");
     // MidiFile: Don't start JACK.
     settings.setValue("autostartjack", false);
+}
+
+void TestConvert::test1()
+{
+    // For now, just do the conversion like main.cpp::convert() and
+    // let it crash.
 
     RosegardenDocument doc(
             nullptr,  // parent
@@ -65,8 +86,75 @@ void TestConvert::test1()
     ok = midiFile.convertToMidi(&doc, outFilename);
     QVERIFY(ok);
 
+    // The tracks are encoded separately.  Check that the chunks they
+    // went out in add up.
+    QFile outFile(outFilename);
+    QVERIFY(outFile.open(QIODevice::ReadOnly));
+    const QByteArray data = outFile.readAll();
+    outFile.close();
+
+    QVERIFY(data.startsWith("MThd"));
+    const int tracks = bigEndian(data, 10, 2);
+    QVERIFY(tracks > 1);
+    int pos = 14;
+    for (int track = 0; track < tracks; ++track) {
+        QCOMPARE(data.mid(pos, 4), QByteArray("MTrk"));
+        pos += 8 + bigEndian(data, pos + 4, 4);
+    }
+    QCOMPARE(pos, data.size());
+
     // Clean up.
     QFile::remove(outFilename);
+
+    // The file must come out byte for byte as it did before the tracks
+    // were encoded in parallel.  The reference comes from the serial
+    // MidiFile::write().
+    const QString reference = QFINDTESTDATA("baseline/aylindaamiga.mid");
+    if (reference.isEmpty())
+        QSKIP("No reference file baseline/aylindaamiga.mid");
+
+    QFile referenceFile(reference);
+    QVERIFY(referenceFile.open(QIODevice::ReadOnly));
+    QVERIFY(data == referenceFile.readAll());
+}
+
+void TestConvert::testFormats()
+{
+    // Each format rosegarden-convert can write, as main.cpp::convert()
+    // does it.
+
+    const QString input =
+        QFINDTESTDATA("../data/examples/aylindaamiga.rg");
+
+    for (const QString extension : { "mid", "ly", "xml" }) {
+        const QString outFilename = "aylindaamiga." + extension;
+
+        QString error;
+        QVERIFY2(BatchConverter::convert(input, outFilename, error),
+                 qPrintable(error));
+        QVERIFY(QFile(outFilename).size() > 0);
+
+        QFile::remove(outFilename);
+    }
+
+    // Formats it can't write are an error.
+    QString error;
+    QVERIFY(!BatchConverter::convert(input, "aylindaamiga.wav", error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!QFile::exists("aylindaamiga.wav"));
+}
+
+void TestConvert::testClashingOutputs()
+{
+    // "true" stands in for rosegarden-convert.  It succeeds without
+    // writing anything.
+    const QStringList distinct = { "a/one.rg", "b/two.rg" };
+    QCOMPARE(BatchConverter::convertAll("true", distinct, ".", "mid", 2), 0);
+
+    // Two files with the same name would be converted to the same file.
+    // Nothing is converted.
+    const QStringList clashing = { "a/song.rg", "b/song.rg", "c/other.rg" };
+    QCOMPARE(BatchConverter::convertAll("true", clashing, ".", "mid", 2), 3);
 }
 
 QTEST_MAIN(TestConvert)
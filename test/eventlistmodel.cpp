@@ -0,0 +1,199 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "gui/editors/eventlist/EventListModel.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test for EventListModel
+class TestEventListModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSingleChanges();
+    void testBulkInsert();
+    void testBulkErase();
+    void testFilter();
+
+private:
+    /// Add count quarter notes, one every crotchet from time.
+    static std::vector<Event *> addNotes(Segment &segment,
+                                         timeT time, int count);
+
+    /// Check that the rows are the Segment's shown Events, in order.
+    static bool rowsMatch(const EventListModel &model,
+                          const Segment &segment,
+                          bool showNotes = true);
+};
+
+std::vector<Event *>
+TestEventListModel::addNotes(Segment &segment, timeT time, int count)
+{
+    std::vector<Event *> events;
+    const Note note(Note::Crotchet);
+
+    for (int i = 0; i < count; ++i) {
+        Event *event = note.getAsNoteEvent(
+                time + i * note.getDuration(), 60 + i % 12);
+        segment.insert(event);
+        events.push_back(event);
+    }
+
+    return events;
+}
+
+bool
+TestEventListModel::rowsMatch(const EventListModel &model,
+                              const Segment &segment,
+                              bool showNotes)
+{
+    int row = 0;
+
+    for (Segment::const_iterator i = segment.begin();
+         segment.isBeforeEndMarker(i);
+         ++i) {
+        if (!showNotes  &&  (*i)->isa(Note::EventType))
+            continue;
+        if (model.getEvent(row) != *i)
+            return false;
+        ++row;
+    }
+
+    return row == model.rowCount();
+}
+
+void TestEventListModel::testSingleChanges()
+{
+    Segment segment;
+    addNotes(segment, 0, 10);
+    segment.setEndMarkerTime(100000);
+
+    EventListModel model(&segment, nullptr);
+    QCOMPARE(model.rowCount(), 10);
+
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+
+    std::vector<Event *> added = addNotes(segment, 480, 3);
+    segment.eraseSingle(added[1]);
+
+    // A few changes go through as row insertions and removals.
+    QCOMPARE(inserted.count(), 3);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(model.rowCount(), 12);
+    QVERIFY(rowsMatch(model, segment));
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(reset.count(), 0);
+    QVERIFY(rowsMatch(model, segment));
+}
+
+void TestEventListModel::testBulkInsert()
+{
+    Segment segment;
+    addNotes(segment, 0, 100);
+    segment.setEndMarkerTime(10000000);
+
+    EventListModel model(&segment, nullptr);
+
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+
+    addNotes(segment, 240, 5000);
+
+    // Only the start of the batch is applied row by row.  The rest
+    // waits for the batch to end.
+    QVERIFY(inserted.count() < 1000);
+    QVERIFY(model.rowCount() < 1000);
+
+    QCoreApplication::processEvents();
+
+    QVERIFY(reset.count() > 0);
+    QCOMPARE(model.rowCount(), 5100);
+    QVERIFY(rowsMatch(model, segment));
+
+    // The next batch starts counting afresh.
+    inserted.clear();
+    addNotes(segment, 120, 1);
+
+    QCOMPARE(inserted.count(), 1);
+    QVERIFY(rowsMatch(model, segment));
+}
+
+void TestEventListModel::testBulkErase()
+{
+    Segment segment;
+    std::vector<Event *> events = addNotes(segment, 0, 3000);
+    segment.setEndMarkerTime(10000000);
+
+    EventListModel model(&segment, nullptr);
+    QCOMPARE(model.rowCount(), 3000);
+
+    for (size_t i = 0; i < events.size(); i += 2) {
+        segment.eraseSingle(events[i]);
+    }
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(model.rowCount(), 1500);
+    QVERIFY(rowsMatch(model, segment));
+}
+
+void TestEventListModel::testFilter()
+{
+    Segment segment;
+    addNotes(segment, 0, 10);
+    segment.insert(Clef(Clef::Bass).getAsEvent(0));
+    segment.insert(Key("G major").getAsEvent(960));
+    segment.setEndMarkerTime(10000000);
+
+    EventListModel model(&segment, nullptr);
+    QCOMPARE(model.rowCount(), 12);
+
+    std::vector<bool> show(EventListModel::CategoryCount, true);
+    show[EventListModel::NoteCategory] = false;
+    model.setFilter(show);
+
+    QCOMPARE(model.rowCount(), 2);
+    QVERIFY(rowsMatch(model, segment, false));
+
+    // A filter change in the middle of a bulk edit is picked up when
+    // the rows are rebuilt.
+    show[EventListModel::NoteCategory] = true;
+    model.setFilter(show);
+    addNotes(segment, 60, 500);
+    segment.insert(Clef(Clef::Treble).getAsEvent(1920));
+    show[EventListModel::NoteCategory] = false;
+    model.setFilter(show);
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(rowsMatch(model, segment, false));
+}
+
+QTEST_MAIN(TestEventListModel)
+
+#include "eventlistmodel.moc"
@@ -35,6 +35,11 @@ private Q_SLOTS:
     void testExamples_data();
     // Called for each row of test data.
     void testExamples();
+
+    // The bars come out the same whether they are written in order or
+    // on worker threads, and whether or not they come from the cache.
+    void testWriteBarsInOrder_data();
+    void testWriteBarsInOrder();
 };
 
 void TestLilypondExport::initTestCase()
@@ -281,6 +286,72 @@ void TestLilypondExport::testExamples()
     QFile::remove(fileName);
 }
 
+void TestLilypondExport::testWriteBarsInOrder_data()
+{
+    QTest::addColumn<QString>("baseDir");
+
+    QTest::newRow("Brandenburg_No3-BWV_1048") << "examples";
+    QTest::newRow("beaming") << "examples";
+    QTest::newRow("lilypond-alternative-endings") << "examples";
+    QTest::newRow("logical-segments-4") << "examples";
+    QTest::newRow("mozart-quartet") << "examples";
+}
+
+// Read an entire file.
+static QByteArray readAll(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Couldn't open" << fileName;
+        return QByteArray();
+    }
+
+    return file.readAll();
+}
+
+void TestLilypondExport::testWriteBarsInOrder()
+{
+    QString baseName{QTest::currentDataTag()};
+    QFETCH(QString, baseDir);
+
+    const QString input =
+            QFINDTESTDATA("../../data/" + baseDir + "/" + baseName + ".rg");
+    QVERIFY(!input.isEmpty()); // file not found
+
+    RosegardenDocument doc(
+            nullptr,  // parent
+            {},  // audioPluginManager
+            true,  // skipAutoload
+            true,  // clearCommandHistory
+            false);  // enableSound
+
+    doc.openDocument(
+            input,  // filename
+            false,  // permanent (false => no MIDI devices)
+            true);  // squelchProgressDialog
+
+    const QString fileName = baseName + "-bars.ly";
+
+    // In order, on this thread.
+    LilyPondExporter inOrder(&doc, SegmentSelection(), qstrtostr(fileName));
+    inOrder.setWriteBarsInOrder(true);
+    QVERIFY(inOrder.write());
+    const QByteArray expected = readAll(fileName);
+    QVERIFY(!expected.isEmpty());
+
+    // On worker threads, then from the cache.
+    for (int pass = 0; pass < 2; ++pass) {
+        LilyPondExporter exporter(
+                &doc, SegmentSelection(), qstrtostr(fileName));
+        QVERIFY(exporter.write());
+        QCOMPARE(exporter.getMessage(), inOrder.getMessage());
+        QVERIFY(readAll(fileName) == expected);
+    }
+
+    // Clean up.
+    QFile::remove(fileName);
+}
+
 QTEST_MAIN(TestLilypondExport)
 
 #include "lilypond_export_test.moc"
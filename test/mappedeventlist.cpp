@@ -0,0 +1,241 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "NoteBuffer.h"
+#include "gui/seqmanager/MappedEventBuffer.h"
+#include "sound/MappedBufMetaIterator.h"
+#include "sound/MappedEvent.h"
+#include "sound/MappedEventInserter.h"
+#include "sound/MappedEventList.h"
+
+#include <QTest>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Rosegarden;
+
+namespace
+{
+
+    // Count the allocations made while counting is on.
+    std::atomic<bool> counting(false);
+    std::atomic<int> allocations(0);
+
+}
+
+void *operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+
+    void *p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+    /// Count the allocations made in its lifetime.
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter()
+        {
+            allocations = 0;
+            counting = true;
+        }
+        ~AllocationCounter()  { counting = false; }
+
+        int count() const  { return allocations; }
+    };
+
+    MappedEvent makeEvent(int ms)
+    {
+        MappedEvent event;
+        event.setType(MappedEvent::MidiNote);
+        event.setEventTime(RealTime::fromMilliseconds(ms));
+        return event;
+    }
+
+}
+
+/// Checks MappedEventList ordering and that playback doesn't allocate.
+class TestMappedEventList : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testOrder();
+    void testOwnership();
+    void testSliceAllocations();
+    void testPlaybackAllocations();
+};
+
+void TestMappedEventList::testOrder()
+{
+    MappedEventList list;
+
+    // Out of order, with equal times that must keep their order.
+    const int times[] = { 30, 10, 20, 10, 40, 0, 20 };
+    int pitch = 0;
+    for (int ms : times) {
+        MappedEvent event = makeEvent(ms);
+        event.setPitch(pitch++);
+        list.insertCopy(event);
+    }
+
+    QCOMPARE(int(list.size()), 7);
+
+    const int sortedTimes[] = { 0, 10, 10, 20, 20, 30, 40 };
+    const int sortedPitches[] = { 5, 1, 3, 2, 6, 0, 4 };
+    int n = 0;
+    for (const MappedEvent *event : list) {
+        QCOMPARE(event->getEventTime(),
+                 RealTime::fromMilliseconds(sortedTimes[n]));
+        QCOMPARE(int(event->getPitch()), sortedPitches[n]);
+        ++n;
+    }
+
+    // Adding more sorts again.
+    list.insertCopy(makeEvent(5));
+    QCOMPARE((*(list.begin() + 1))->getEventTime(),
+             RealTime::fromMilliseconds(5));
+}
+
+void TestMappedEventList::testOwnership()
+{
+    MappedEventList list;
+
+    // A mix of heap and pool events.  clear() deletes one sort and
+    // recycles the other.
+    for (int i = 0; i < 600; ++i) {
+        if (i % 3 == 0)
+            list.insert(new MappedEvent(makeEvent(i)));
+        else
+            list.insertCopy(makeEvent(i));
+    }
+    QCOMPARE(int(list.size()), 600);
+
+    // Copies are independent of the pool.
+    MappedEventList copy(list);
+    list.clear();
+    QVERIFY(list.empty());
+    QCOMPARE(int(copy.size()), 600);
+    QCOMPARE((*copy.begin())->getEventTime(), RealTime::zero());
+
+    // Erasing hands the event back to the caller.
+    MappedEventList::iterator first = copy.begin();
+    MappedEvent *event = *first;
+    copy.erase(first);
+    QCOMPARE(int(copy.size()), 599);
+    delete event;
+}
+
+void TestMappedEventList::testSliceAllocations()
+{
+    MappedEventList list;
+    MappedEventInserter inserter(list);
+
+    const int events = 2000;
+
+    // The first slice grows the storage.
+    for (int i = 0; i < events; ++i) {
+        inserter.insertCopy(makeEvent(i));
+    }
+    list.clear();
+
+    // The rest reuse it.
+    AllocationCounter counter;
+
+    for (int slice = 0; slice < 20; ++slice) {
+        for (int i = 0; i < events; ++i) {
+            inserter.insertCopy(makeEvent(slice * events + i));
+        }
+        // Iterate as the driver would.
+        int count = 0;
+        for (const MappedEvent *event : list) {
+            if (event->isValid())
+                ++count;
+        }
+        QCOMPARE(count, events);
+        list.clear();
+    }
+
+    QCOMPARE(counter.count(), 0);
+}
+
+void TestMappedEventList::testPlaybackAllocations()
+{
+    // Fetch slices from a composition's worth of buffers into a reused
+    // list, as the sequencer does while playing.
+    const int buffers = 64;
+    const int notes = 2000;
+
+    MappedBufMetaIterator metaIterator;
+    for (int i = 0; i < buffers; ++i) {
+        QSharedPointer<MappedEventBuffer> buffer(
+                new NoteBuffer(i, RealTime::zero(), notes));
+        buffer->init();
+        metaIterator.addBuffer(buffer);
+    }
+
+    MappedEventList list;
+    const RealTime slice = NoteBuffer::spacing() * 16;
+
+    RealTime start = RealTime::zero();
+    metaIterator.jumpToTime(start);
+
+    // Warm up.
+    for (int i = 0; i < 4; ++i) {
+        list.clear();
+        MappedEventInserter inserter(list);
+        metaIterator.fetchEvents(inserter, start, start + slice);
+        start = start + slice;
+    }
+
+    AllocationCounter counter;
+
+    int fetched = 0;
+    for (int i = 0; i < 50; ++i) {
+        list.clear();
+        MappedEventInserter inserter(list);
+        metaIterator.fetchEvents(inserter, start, start + slice);
+        fetched += int(list.size());
+        start = start + slice;
+    }
+
+    const int allocated = counter.count();
+
+    QCOMPARE(fetched, 50 * buffers * 16);
+    QCOMPARE(allocated, 0);
+}
+
+QTEST_MAIN(TestMappedEventList)
+
+#include "mappedeventlist.moc"
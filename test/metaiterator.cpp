@@ -0,0 +1,407 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "NoteBuffer.h"
+#include "base/Composition.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "base/Studio.h"
+#include "base/Track.h"
+#include "document/RosegardenDocument.h"
+#include "gui/seqmanager/MappedEventBuffer.h"
+#include "gui/seqmanager/SegmentMapper.h"
+#include "sound/MappedBufMetaIterator.h"
+#include "sound/MappedEvent.h"
+#include "sound/MappedInserterBase.h"
+
+#include <QTest>
+
+#include <algorithm>
+#include <vector>
+
+using namespace Rosegarden;
+
+namespace
+{
+
+    /// A long run of notes that maps only those within its window.
+    class WindowedBuffer : public MappedEventBuffer
+    {
+    public:
+        explicit WindowedBuffer(int notes) :
+            MappedEventBuffer(nullptr),
+            m_notes(notes)
+        {
+        }
+
+        static RealTime spacing()  { return RealTime::fromMilliseconds(100); }
+
+    protected:
+        int calculateSize() override  { return 0; }
+
+        void fillBuffer() override
+        {
+            resize(0);
+
+            for (int i = 0; i < m_notes; ++i) {
+                const RealTime time = spacing() * i;
+                if (!m_window.meets(time, time + spacing()))
+                    continue;
+
+                MappedEvent event;
+                event.setType(MappedEvent::MidiNote);
+                event.setPitch(i % 128);
+                event.setVelocity(100);
+                event.setEventTime(time);
+                event.setDuration(spacing());
+                mapAnEvent(&event);
+            }
+
+            setStartEnd(RealTime::zero(), spacing() * m_notes);
+        }
+
+        bool shouldPlay(MappedEvent *event, RealTime startTime) override
+            { return !event->EndedBefore(startTime); }
+
+        bool windowChanged(const Window &) override  { return true; }
+
+    private:
+        int m_notes;
+    };
+
+    /// Keeps the track and time of what it is given.
+    class RecordingInserter : public MappedInserterBase
+    {
+    public:
+        void insertCopy(const MappedEvent &event) override
+        {
+            events.push_back(
+                    std::make_pair(event.getTrackId(), event.getEventTime()));
+        }
+
+        std::vector<std::pair<TrackId, RealTime> > events;
+    };
+
+}
+
+/// Checks and benchmarks the merge in MappedBufMetaIterator
+class TestMetaIterator : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFetch();
+    void testChanges();
+    void testWindow();
+    void testSegmentWindow();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    /// Add buffers buffers of notes notes each, one after the other
+    /// on tracks round robin.
+    static void addBuffers(MappedBufMetaIterator &metaIterator,
+                           int buffers, int tracks, int notes);
+
+    /// Fetch from start to end in slices of the sequencer's size.
+    static void play(MappedBufMetaIterator &metaIterator,
+                     RecordingInserter &inserter,
+                     const RealTime &start, const RealTime &end);
+};
+
+void
+TestMetaIterator::addBuffers(MappedBufMetaIterator &metaIterator,
+                             int buffers, int tracks, int notes)
+{
+    for (int i = 0; i < buffers; ++i) {
+        const RealTime start =
+            NoteBuffer::spacing() * (notes * (i / tracks));
+        QSharedPointer<MappedEventBuffer> buffer(
+                new NoteBuffer(i % tracks, start, notes));
+        buffer->init();
+        metaIterator.addBuffer(buffer);
+    }
+}
+
+void
+TestMetaIterator::play(MappedBufMetaIterator &metaIterator,
+                       RecordingInserter &inserter,
+                       const RealTime &start, const RealTime &end)
+{
+    const RealTime slice = RealTime::fromMilliseconds(160);
+
+    for (RealTime t = start; t < end; t = t + slice) {
+        metaIterator.fetchEvents(inserter, t, t + slice);
+    }
+}
+
+void TestMetaIterator::testFetch()
+{
+    const int tracks = 8;
+    const int buffers = 64;
+    const int notes = 16;
+
+    MappedBufMetaIterator metaIterator;
+    addBuffers(metaIterator, buffers, tracks, notes);
+
+    const RealTime end =
+        NoteBuffer::spacing() * (notes * (buffers / tracks));
+
+    RecordingInserter inserter;
+    play(metaIterator, inserter, RealTime::zero(), end);
+
+    // Every note, once, in time order.
+    QCOMPARE(int(inserter.events.size()), buffers * notes);
+    for (size_t i = 1; i < inserter.events.size(); ++i) {
+        QVERIFY(inserter.events[i - 1].second <= inserter.events[i].second);
+    }
+
+    // Each track gets all of its notes.
+    std::vector<int> perTrack(tracks, 0);
+    for (const std::pair<TrackId, RealTime> &event : inserter.events) {
+        ++perTrack[event.first];
+    }
+    for (int count : perTrack) {
+        QCOMPARE(count, buffers / tracks * notes);
+    }
+
+    // Jumping back plays the rest again.
+    metaIterator.jumpToTime(end / 2);
+    inserter.events.clear();
+    play(metaIterator, inserter, end / 2, end);
+    QCOMPARE(int(inserter.events.size()), buffers * notes / 2);
+}
+
+void TestMetaIterator::testChanges()
+{
+    const int notes = 16;
+    const RealTime length = NoteBuffer::spacing() * notes;
+
+    MappedBufMetaIterator metaIterator;
+    addBuffers(metaIterator, 4, 4, notes);
+
+    // Move one buffer later while playing.  The new times must be
+    // picked up without a jump.
+    QSharedPointer<MappedEventBuffer> later(
+            new NoteBuffer(7, length * 3, notes));
+    later->init();
+    metaIterator.addBuffer(later);
+
+    RecordingInserter inserter;
+    play(metaIterator, inserter, RealTime::zero(), length);
+    QCOMPARE(int(inserter.events.size()), 4 * notes);
+
+    later.staticCast<NoteBuffer>()->moveTo(length * 2);
+
+    inserter.events.clear();
+    play(metaIterator, inserter, length, length * 4);
+    QCOMPARE(int(inserter.events.size()), notes);
+    QCOMPARE(inserter.events.front().first, TrackId(7));
+    QVERIFY(inserter.events.front().second >= length * 2);
+    QVERIFY(inserter.events.back().second < length * 3);
+
+    // And removing a buffer forgets it.
+    metaIterator.removeBuffer(later);
+    metaIterator.jumpToTime(RealTime::zero());
+    inserter.events.clear();
+    play(metaIterator, inserter, RealTime::zero(), length * 4);
+    QCOMPARE(int(inserter.events.size()), 4 * notes);
+}
+
+void TestMetaIterator::testWindow()
+{
+    const int notes = 1000;
+    const RealTime end = WindowedBuffer::spacing() * notes;
+
+    // A window of a few seconds, with a loop back to the start.
+    const RealTime ahead = RealTime(4, 0);
+    const RealTime refill = RealTime(2, 0);
+    const RealTime loopEnd = RealTime(1, 0);
+
+    QSharedPointer<MappedEventBuffer> buffer(new WindowedBuffer(notes));
+    MappedEventBuffer::Window window(RealTime::zero(), ahead);
+    window.loopStart = RealTime::zero();
+    window.loopEnd = loopEnd;
+    // This fills it.
+    QVERIFY(buffer->setWindow(window));
+
+    MappedBufMetaIterator metaIterator;
+    metaIterator.addBuffer(buffer);
+    metaIterator.jumpToTime(RealTime::zero());
+
+    // Play it all, moving the window along as SequenceManager does.
+    const RealTime slice = RealTime::fromMilliseconds(160);
+    RecordingInserter inserter;
+    int largest = 0;
+    for (RealTime t = RealTime::zero(); t < end; t = t + slice) {
+        if (t + refill > window.end) {
+            window.start = t;
+            window.end = t + ahead;
+            if (buffer->setWindow(window))
+                metaIterator.resumeIteratorForBuffer(buffer);
+        }
+        largest = std::max(largest, buffer->size());
+        metaIterator.fetchEvents(inserter, t, t + slice);
+    }
+
+    // Every note, once, in order, without holding them all.
+    QCOMPARE(int(inserter.events.size()), notes);
+    for (int i = 0; i < notes; ++i) {
+        QCOMPARE(inserter.events[i].second, WindowedBuffer::spacing() * i);
+    }
+    QVERIFY(largest < notes / 10);
+
+    // The start of the loop is still there to wrap around to.
+    metaIterator.jumpToTime(RealTime::zero());
+    inserter.events.clear();
+    play(metaIterator, inserter, RealTime::zero(), loopEnd);
+    QCOMPARE(int(inserter.events.size()), 10);
+
+    // And the default window maps everything again.
+    QVERIFY(buffer->setWindow(MappedEventBuffer::Window()));
+    QCOMPARE(buffer->size(), notes);
+}
+
+void TestMetaIterator::testSegmentWindow()
+{
+    RosegardenDocument doc(
+            nullptr,  // parent
+            {},  // audioPluginManager
+            true,  // skipAutoload
+            true,  // clearCommandHistory
+            false);  // enableSound
+    Composition &composition = doc.getComposition();
+    Studio &studio = doc.getStudio();
+
+    InstrumentId baseInstrumentId;
+    const DeviceId deviceId = studio.getSpareDeviceId(baseInstrumentId);
+    studio.addDevice("Test", deviceId, baseInstrumentId, Device::Midi);
+
+    const TrackId trackId = composition.getNewTrackId();
+    composition.addTrack(new Track(trackId, baseInstrumentId, 0));
+
+    // Eight bars of crotchets from bar 16, 32 seconds in.  That's on a
+    // slice boundary, so that both plays below fetch the same slices.
+    const timeT barDuration = composition.getBarEnd(0);
+    const Note crotchet(Note::Crotchet);
+    Segment *segment = new Segment;
+    segment->setTrack(trackId);
+    for (int i = 0; i < 32; ++i) {
+        segment->insert(crotchet.getAsNoteEvent(
+                16 * barDuration + i * crotchet.getDuration(), 60 + i % 12));
+    }
+    composition.addSegment(segment);
+
+    const RealTime segmentStart =
+            composition.getElapsedRealTime(16 * barDuration);
+    const RealTime segmentEnd =
+            composition.getElapsedRealTime(24 * barDuration);
+    const RealTime second(1, 0);
+
+    // Everything, as for MIDI export.
+    QSharedPointer<MappedEventBuffer> whole(
+            SegmentMapper::makeMapperForSegment(&doc, segment));
+    QVERIFY(whole->size() > 0);
+
+    MappedBufMetaIterator wholeIterator;
+    wholeIterator.addBuffer(whole);
+    wholeIterator.jumpToTime(RealTime::zero());
+    RecordingInserter expected;
+    play(wholeIterator, expected, RealTime::zero(), segmentEnd + second);
+
+    // Outside the window, nothing is mapped, but the buffer still says
+    // when the segment sounds.
+    typedef MappedEventBuffer::Window Window;
+    QSharedPointer<MappedEventBuffer> mapper(
+            SegmentMapper::makeMapperForSegment(
+                    &doc, segment, Window(RealTime::zero(), second * 4)));
+    QCOMPARE(mapper->size(), 0);
+
+    RealTime start;
+    RealTime end;
+    mapper->getStartEnd(start, end);
+    QCOMPARE(start, segmentStart);
+    QCOMPARE(end, segmentEnd);
+
+    MappedBufMetaIterator metaIterator;
+    metaIterator.addBuffer(mapper);
+    metaIterator.jumpToTime(RealTime::zero());
+
+    RecordingInserter inserter;
+    play(metaIterator, inserter, RealTime::zero(), segmentStart);
+    QVERIFY(inserter.events.empty());
+
+    // Moving the window along short of the segment changes nothing.
+    QVERIFY(!mapper->setWindow(Window(second * 4, second * 8)));
+    QCOMPARE(mapper->size(), 0);
+
+    // Once the window meets the segment, the whole segment is mapped and
+    // playback picks it up.
+    QVERIFY(mapper->setWindow(
+            Window(segmentStart - second, segmentStart + second)));
+    QCOMPARE(mapper->size(), whole->size());
+    metaIterator.resumeIteratorForBuffer(mapper);
+
+    play(metaIterator, inserter, segmentStart, segmentEnd + second);
+    QVERIFY(inserter.events == expected.events);
+
+    // Past the end, it is emptied again.
+    QVERIFY(mapper->setWindow(
+            Window(segmentEnd + second, segmentEnd + second * 4)));
+    QCOMPARE(mapper->size(), 0);
+    mapper->getStartEnd(start, end);
+    QCOMPARE(start, segmentStart);
+    QCOMPARE(end, segmentEnd);
+}
+
+void TestMetaIterator::benchmark_data()
+{
+    QTest::addColumn<int>("buffers");
+
+    // The same number of events due per slice, with more and more
+    // segments waiting their turn.
+    QTest::newRow("60 segments") << 60;
+    QTest::newRow("600 segments") << 600;
+    QTest::newRow("3000 segments") << 3000;
+}
+
+void TestMetaIterator::benchmark()
+{
+    QFETCH(int, buffers);
+
+    const int tracks = 16;
+    const int notes = 40;
+
+    MappedBufMetaIterator metaIterator;
+    addBuffers(metaIterator, buffers, tracks, notes);
+
+    // Play the first 60 segments' worth.
+    const RealTime end = NoteBuffer::spacing() * (notes * (60 / tracks));
+
+    RecordingInserter inserter;
+    inserter.events.reserve(60 * notes);
+
+    QBENCHMARK {
+        inserter.events.clear();
+        metaIterator.jumpToTime(RealTime::zero());
+        play(metaIterator, inserter, RealTime::zero(), end);
+    }
+
+    QCOMPARE(int(inserter.events.size()), 60 / tracks * tracks * notes);
+}
+
+QTEST_MAIN(TestMetaIterator)
+
+#include "metaiterator.moc"
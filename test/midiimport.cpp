@@ -0,0 +1,239 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/BaseProperties.h"
+#include "base/Composition.h"
+#include "base/Event.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "document/RosegardenDocument.h"
+#include "sound/MidiFile.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QTest>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Checks and benchmarks note pairing on MIDI file import
+class TestMidiImport : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPairing();
+    void benchmark();
+
+private:
+    /// Append an event with a delta time and two or three bytes.
+    static void addEvent(std::string &track, unsigned long delta,
+                         int status, int data1, int data2 = -1);
+    /// Append the end of track meta event.
+    static void endTrack(std::string &track, unsigned long delta);
+
+    /// Write a format 1 file at 480 PPQ with the given track bodies.
+    static void writeFile(const QString &filename,
+                          const std::vector<std::string> &tracks);
+
+    /// Import filename into doc.
+    static bool import(const QString &filename, RosegardenDocument &doc);
+
+    /// Time, pitch and duration of each note, in order.
+    typedef std::tuple<timeT, int, timeT> NoteKey;
+    static std::vector<NoteKey> notes(const Composition &composition);
+};
+
+void
+TestMidiImport::addEvent(std::string &track, unsigned long delta,
+                         int status, int data1, int data2)
+{
+    // Variable-length delta time.
+    std::string bytes(1, char(delta & 0x7f));
+    while (delta >>= 7)
+        bytes.insert(bytes.begin(), char(0x80 | (delta & 0x7f)));
+    track += bytes;
+
+    track += char(status);
+    track += char(data1);
+    if (data2 >= 0)
+        track += char(data2);
+}
+
+void
+TestMidiImport::endTrack(std::string &track, unsigned long delta)
+{
+    addEvent(track, delta, 0xff, 0x2f, 0x00);
+}
+
+void
+TestMidiImport::writeFile(const QString &filename,
+                          const std::vector<std::string> &tracks)
+{
+    std::string data = "MThd";
+    data += std::string("\0\0\0\6\0\1", 6);
+    data += char(tracks.size() >> 8);
+    data += char(tracks.size() & 0xff);
+    data += char(480 >> 8);
+    data += char(480 & 0xff);
+
+    for (const std::string &track : tracks) {
+        data += "MTrk";
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            data += char((track.size() >> shift) & 0xff);
+        }
+        data += track;
+    }
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data.data(), data.size());
+}
+
+bool
+TestMidiImport::import(const QString &filename, RosegardenDocument &doc)
+{
+    MidiFile midiFile;
+    return midiFile.convertToRosegarden(filename, &doc);
+}
+
+std::vector<TestMidiImport::NoteKey>
+TestMidiImport::notes(const Composition &composition)
+{
+    std::vector<NoteKey> keys;
+
+    for (const Segment *segment : composition.getSegments()) {
+        for (const Event *event : *segment) {
+            if (!event->isa(Note::EventType))
+                continue;
+            keys.push_back(NoteKey(
+                    event->getAbsoluteTime(),
+                    int(event->get<Int>(BaseProperties::PITCH)),
+                    event->getDuration()));
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+void TestMidiImport::initTestCase()
+{
+    // Make sure settings end up in the right place.
+    QCoreApplication::setOrganizationName("rosegardenmusic");
+
+    QSettings settings;
+    settings.beginGroup("Sequencer_Options");
+    // MidiFile: Don't start JACK.
+    settings.setValue("autostartjack", false);
+}
+
+void TestMidiImport::testPairing()
+{
+    // Overlapping notes of the same pitch, a note-on with velocity 0 as
+    // the note-off, a stray note-off, a note that never ends and one
+    // that ends as soon as it starts.
+    std::string track;
+    addEvent(track, 0, 0x90, 60, 100);
+    addEvent(track, 100, 0x90, 60, 90);
+    addEvent(track, 100, 0x80, 60, 64);
+    addEvent(track, 100, 0x90, 60, 0);
+    addEvent(track, 0, 0x80, 62, 64);
+    addEvent(track, 100, 0x90, 64, 80);
+    addEvent(track, 80, 0x90, 67, 70);
+    addEvent(track, 0, 0x80, 67, 64);
+    // Another channel, with the same pitch, doesn't end the notes on
+    // the first.
+    addEvent(track, 0, 0x91, 60, 100);
+    addEvent(track, 120, 0x81, 60, 64);
+    endTrack(track, 360);
+
+    const QString filename = "midiimport-pairing.mid";
+    writeFile(filename, { track });
+
+    RosegardenDocument doc(nullptr, {}, true, true, false);
+    QVERIFY(import(filename, doc));
+    QFile::remove(filename);
+
+    // At 480 PPQ, MIDI times are half of Rosegarden's.
+    const std::vector<NoteKey> expected = {
+        NoteKey(0, 60, 400),
+        NoteKey(200, 60, 400),
+        // Until the end of the track.
+        NoteKey(800, 64, 1120),
+        NoteKey(960, 60, 240),
+        NoteKey(960, 67, 2)
+    };
+    QCOMPARE(notes(doc.getComposition()), expected);
+}
+
+void TestMidiImport::benchmark()
+{
+    // A long piano-roll performance: every track holds a pedal note
+    // through the whole piece under runs of overlapping notes.
+    const int tracks = 16;
+    const int notesPerTrack = 5000;
+
+    std::vector<std::string> trackData;
+    for (int t = 0; t < tracks; ++t) {
+        std::string track;
+        const int channel = t % 16;
+        addEvent(track, 0, 0x90 | channel, 36 + t, 100);
+        for (int i = 0; i < notesPerTrack; ++i) {
+            const int pitch = 48 + (i * 7 + t) % 36;
+            addEvent(track, 60, 0x90 | channel, pitch, 100);
+            // Each note lasts until three more have started.
+            if (i >= 3) {
+                const int offPitch = 48 + ((i - 3) * 7 + t) % 36;
+                addEvent(track, 0, 0x80 | channel, offPitch, 64);
+            }
+        }
+        for (int i = notesPerTrack - 3; i < notesPerTrack; ++i) {
+            addEvent(track, 60, 0x80 | channel, 48 + (i * 7 + t) % 36, 64);
+        }
+        addEvent(track, 0, 0x80 | channel, 36 + t, 64);
+        endTrack(track, 0);
+        trackData.push_back(track);
+    }
+
+    const QString filename = "midiimport-benchmark.mid";
+    writeFile(filename, trackData);
+
+    RosegardenDocument doc(nullptr, {}, true, true, false);
+    QVERIFY(import(filename, doc));
+
+    const std::vector<NoteKey> imported = notes(doc.getComposition());
+    QCOMPARE(int(imported.size()), tracks * (notesPerTrack + 1));
+
+    // The pedal notes last the whole piece.
+    QCOMPARE(std::get<2>(imported.front()),
+             timeT((notesPerTrack + 3) * 60 * 2));
+
+    QBENCHMARK {
+        RosegardenDocument benchmarkDoc(nullptr, {}, true, true, false);
+        import(filename, benchmarkDoc);
+    }
+
+    QFile::remove(filename);
+}
+
+QTEST_MAIN(TestMidiImport)
+
+#include "midiimport.moc"
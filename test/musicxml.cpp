@@ -0,0 +1,245 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/Composition.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+#include "base/Track.h"
+#include "document/RosegardenDocument.h"
+#include "document/io/MusicXMLLoader.h"
+#include "document/io/MusicXmlExporter.h"
+#include "misc/ConfigGroups.h"
+#include "misc/Strings.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QTest>
+
+#include <memory>
+
+using namespace Rosegarden;
+
+/// Round trip test and benchmark for MusicXML export and import
+class TestMusicXml : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testDeterministicExport_data();
+    void testDeterministicExport();
+    void testRoundTrip_data();
+    void testRoundTrip();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static std::unique_ptr<RosegardenDocument> newDocument();
+    /// Fill doc with a score of tracks staves of bars 4/4 bars.
+    static void makeScore(RosegardenDocument *doc, int tracks, int bars);
+    static QByteArray exportFile(RosegardenDocument *doc,
+                                 const QString &fileName);
+};
+
+void TestMusicXml::initTestCase()
+{
+    // Make sure settings end up in the right place.
+    QCoreApplication::setOrganizationName("rosegardenmusic");
+
+    QSettings settings;
+    settings.beginGroup(MusicXMLExportConfigGroup);
+    settings.setValue("mxmlexportselection", 0);  // all tracks
+    settings.setValue("mxmlmultistave", 0);  // none
+    settings.setValue("mxmlexportpercussion", 0);
+}
+
+std::unique_ptr<RosegardenDocument>
+TestMusicXml::newDocument()
+{
+    return std::unique_ptr<RosegardenDocument>(new RosegardenDocument(
+            nullptr,  // parent
+            {},  // audioPluginManager
+            true,  // skipAutoload
+            true,  // clearCommandHistory
+            false));  // enableSound
+}
+
+void
+TestMusicXml::makeScore(RosegardenDocument *doc, int tracks, int bars)
+{
+    Composition &composition = doc->getComposition();
+    const timeT barDuration = composition.getBarEnd(0);
+
+    for (int t = 0; t < tracks; ++t) {
+        const TrackId trackId = composition.getNewTrackId();
+        Track *track = new Track(trackId, MidiInstrumentBase, t);
+        track->setLabel(QString("Staff %1").arg(t + 1).toStdString());
+        composition.addTrack(track);
+
+        Segment *segment = new Segment;
+        segment->setTrack(trackId);
+        segment->insert(Clef(t % 2 ? Clef::Bass : Clef::Treble).getAsEvent(0));
+        segment->insert(Key("D major").getAsEvent(0));
+
+        // A mix of quavers, crotchets and a minim in every bar so that
+        // the beaming and the accidentals get some exercise.
+        static const Note::Type types[] =
+            { Note::Quaver, Note::Quaver, Note::Crotchet, Note::Minim };
+        for (int bar = 0; bar < bars; ++bar) {
+            timeT time = bar * barDuration;
+            for (Note::Type type : types) {
+                const int pitch = (t % 2 ? 48 : 60) + (bar * 5 + time) % 19;
+                Note note(type);
+                segment->insert(note.getAsNoteEvent(time, pitch));
+                time += note.getDuration();
+            }
+        }
+        composition.addSegment(segment);
+    }
+}
+
+QByteArray
+TestMusicXml::exportFile(RosegardenDocument *doc, const QString &fileName)
+{
+    MusicXmlExporter exporter(nullptr, doc, qstrtostr(fileName));
+    if (!exporter.write())
+        return QByteArray();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+void TestMusicXml::testDeterministicExport_data()
+{
+    QTest::addColumn<int>("dtdType");
+
+    QTest::newRow("partwise") << 0;
+    QTest::newRow("timewise") << 1;
+}
+
+void TestMusicXml::testDeterministicExport()
+{
+    QFETCH(int, dtdType);
+
+    QSettings settings;
+    settings.beginGroup(MusicXMLExportConfigGroup);
+    settings.setValue("mxmldtdtype", dtdType);
+    settings.endGroup();
+
+    std::unique_ptr<RosegardenDocument> doc = newDocument();
+    makeScore(doc.get(), 12, 64);
+
+    // The parts are written on several threads.  The result must not
+    // depend on which one finishes first.
+    const QByteArray first = exportFile(doc.get(), "deterministic.xml");
+    QVERIFY(!first.isEmpty());
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(exportFile(doc.get(), "deterministic.xml"), first);
+    }
+
+    QCOMPARE(first.count("<part id="), dtdType == 0 ? 12 : 12 * 64);
+    QCOMPARE(first.count("<note>"), 12 * 64 * 4);
+
+    QFile::remove("deterministic.xml");
+}
+
+void TestMusicXml::testRoundTrip_data()
+{
+    QTest::addColumn<int>("tracks");
+    QTest::addColumn<int>("bars");
+
+    QTest::newRow("quartet") << 4 << 100;
+    QTest::newRow("orchestra") << 32 << 50;
+}
+
+void TestMusicXml::testRoundTrip()
+{
+    QFETCH(int, tracks);
+    QFETCH(int, bars);
+
+    QSettings settings;
+    settings.beginGroup(MusicXMLExportConfigGroup);
+    settings.setValue("mxmldtdtype", 0);
+    settings.endGroup();
+
+    std::unique_ptr<RosegardenDocument> doc = newDocument();
+    makeScore(doc.get(), tracks, bars);
+
+    const QByteArray exported = exportFile(doc.get(), "roundtrip.xml");
+    QVERIFY(!exported.isEmpty());
+
+    std::unique_ptr<RosegardenDocument> imported = newDocument();
+    MusicXMLLoader loader;
+    QVERIFY2(loader.load("roundtrip.xml", imported.get()),
+             qPrintable(loader.errorMessage()));
+
+    QCOMPARE(int(imported->getComposition().getNbTracks()), tracks);
+
+    // The notes must survive the trip.  Writing the imported document
+    // out again must also be stable.
+    const QByteArray reexported = exportFile(imported.get(), "roundtrip2.xml");
+    QCOMPARE(reexported.count("<note>"), exported.count("<note>"));
+
+    std::unique_ptr<RosegardenDocument> imported2 = newDocument();
+    QVERIFY(loader.load("roundtrip2.xml", imported2.get()));
+    QCOMPARE(exportFile(imported2.get(), "roundtrip3.xml"), reexported);
+
+    QFile::remove("roundtrip.xml");
+    QFile::remove("roundtrip2.xml");
+    QFile::remove("roundtrip3.xml");
+}
+
+void TestMusicXml::benchmark_data()
+{
+    QTest::addColumn<bool>("import");
+
+    QTest::newRow("export") << false;
+    QTest::newRow("import") << true;
+}
+
+void TestMusicXml::benchmark()
+{
+    QFETCH(bool, import);
+
+    QSettings settings;
+    settings.beginGroup(MusicXMLExportConfigGroup);
+    settings.setValue("mxmldtdtype", 0);
+    settings.endGroup();
+
+    std::unique_ptr<RosegardenDocument> doc = newDocument();
+    makeScore(doc.get(), 32, 100);
+
+    if (!import) {
+        QBENCHMARK {
+            exportFile(doc.get(), "benchmark.xml");
+        }
+    } else {
+        QVERIFY(!exportFile(doc.get(), "benchmark.xml").isEmpty());
+
+        MusicXMLLoader loader;
+        QBENCHMARK {
+            std::unique_ptr<RosegardenDocument> imported = newDocument();
+            loader.load("benchmark.xml", imported.get());
+        }
+    }
+
+    QFile::remove("benchmark.xml");
+}
+
+QTEST_MAIN(TestMusicXml)
+
+#include "musicxml.moc"
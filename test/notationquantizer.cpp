@@ -0,0 +1,287 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/NotationQuantizer.h"
+#include "base/Composition.h"
+#include "base/Event.h"
+#include "base/NotationTypes.h"
+#include "base/Segment.h"
+
+#include <QFile>
+#include <QTest>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test for NotationQuantizer
+class TestNotationQuantizer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testThreads_data();
+    void testThreads();
+    void testBaseline_data();
+    void testBaseline();
+
+private:
+    /// A few thousand loosely played notes, with chords and overlaps.
+    static Segment *makePerformance();
+
+    /// A few hundred notes and the odd rest, some of them on the beat.
+    /**
+     * Uses the raw generator output so that it is the same with any
+     * standard library.
+     */
+    static Segment *makeShortPerformance();
+
+    /// One line with the Event's times and sorted properties.
+    static QString describe(const Event &);
+
+    /// Same times, persistent and non-persistent properties.
+    static bool sameEvent(const Event &a, const Event &b);
+};
+
+Segment *
+TestNotationQuantizer::makePerformance()
+{
+    Segment *segment = new Segment;
+
+    std::minstd_rand random(42);
+    std::uniform_int_distribution<int> jitter(-40, 40);
+    std::uniform_int_distribution<int> length(60, 900);
+    std::uniform_int_distribution<int> pitch(36, 84);
+    std::uniform_int_distribution<int> chord(0, 5);
+
+    timeT time = 0;
+
+    for (int i = 0; i < 6000; ++i) {
+        // Now and then a second note at (nearly) the same time.
+        if (chord(random) != 0)
+            time += 120;
+
+        Event *note = new Event(Note::EventType,
+                                std::max(timeT(0), time + jitter(random)),
+                                length(random));
+        note->set<Int>(BaseProperties::PITCH, pitch(random));
+        note->set<Int>(BaseProperties::VELOCITY, 100);
+        segment->insert(note);
+    }
+
+    return segment;
+}
+
+Segment *
+TestNotationQuantizer::makeShortPerformance()
+{
+    Segment *segment = new Segment;
+
+    std::minstd_rand random(7);
+
+    timeT time = 0;
+
+    for (int i = 0; i < 800; ++i) {
+        if (random() % 6 != 0)
+            time += 120;
+
+        if (random() % 50 == 0) {
+            segment->insert(new Event(Note::EventRestType, time, 120,
+                                      Note::EventRestSubOrdering));
+            continue;
+        }
+
+        timeT start = time;
+        if (random() % 3 != 0)
+            start = std::max(timeT(0),
+                             time + timeT(random() % 81) - 40);
+        const timeT duration = 60 + timeT(random() % 841);
+
+        Event *note = new Event(Note::EventType, start, duration);
+        note->set<Int>(BaseProperties::PITCH, 36 + long(random() % 49));
+        segment->insert(note);
+    }
+
+    return segment;
+}
+
+QString
+TestNotationQuantizer::describe(const Event &e)
+{
+    char times[200];
+    snprintf(times, sizeof times, "%s %ld %ld %d %ld %ld",
+             e.getType().c_str(),
+             long(e.getAbsoluteTime()),
+             long(e.getDuration()),
+             int(e.getSubOrdering()),
+             long(e.getNotationAbsoluteTime()),
+             long(e.getNotationDuration()));
+
+    // Sorted by name, as the PropertyName ids depend on the order in
+    // which the names were first seen.
+    std::vector<std::string> properties;
+    for (const PropertyName &name : e.getPersistentPropertyNames()) {
+        properties.push_back(name.getName() + "=" + e.getAsString(name));
+    }
+    for (const PropertyName &name : e.getNonPersistentPropertyNames()) {
+        properties.push_back(name.getName() + ":" + e.getAsString(name));
+    }
+    std::sort(properties.begin(), properties.end());
+
+    std::string line(times);
+    for (const std::string &property : properties) {
+        line += " " + property;
+    }
+
+    return QString::fromStdString(line);
+}
+
+bool
+TestNotationQuantizer::sameEvent(const Event &a, const Event &b)
+{
+    // Times and persistent properties.
+    if (!(a == b))
+        return false;
+
+    if (a.getNotationAbsoluteTime() != b.getNotationAbsoluteTime()  ||
+        a.getNotationDuration() != b.getNotationDuration())
+        return false;
+
+    const Event::PropertyNames names = a.getNonPersistentPropertyNames();
+    if (names != b.getNonPersistentPropertyNames())
+        return false;
+
+    for (const PropertyName &name : names) {
+        if (a.getAsString(name) != b.getAsString(name))
+            return false;
+    }
+
+    return true;
+}
+
+void TestNotationQuantizer::testThreads_data()
+{
+    QTest::addColumn<bool>("contrapuntal");
+
+    QTest::newRow("chords") << false;
+    QTest::newRow("contrapuntal") << true;
+}
+
+void TestNotationQuantizer::testThreads()
+{
+    QFETCH(bool, contrapuntal);
+
+    Composition composition;
+    composition.addTimeSignature(0, TimeSignature(3, 4));
+    composition.addTimeSignature(96000, TimeSignature(7, 8));
+
+    Segment *serialSegment = makePerformance();
+    Segment *parallelSegment = new Segment(*serialSegment);
+    composition.addSegment(serialSegment);
+    composition.addSegment(parallelSegment);
+
+    // Enough notes for the scoring to be spread over the workers.
+    NotationQuantizer serial;
+    serial.setContrapuntal(contrapuntal);
+    serial.setThreadCount(1);
+    serial.quantize(serialSegment);
+
+    NotationQuantizer parallel;
+    parallel.setContrapuntal(contrapuntal);
+    parallel.setThreadCount(4);
+    parallel.quantize(parallelSegment);
+
+    QCOMPARE(parallelSegment->size(), serialSegment->size());
+
+    Segment::const_iterator s = serialSegment->begin();
+    Segment::const_iterator p = parallelSegment->begin();
+    for (int n = 0; s != serialSegment->end(); ++s, ++p, ++n) {
+        QVERIFY2(sameEvent(**s, **p),
+                 qPrintable(QString("Event %1 at %2 differs").
+                            arg(n).arg((*s)->getAbsoluteTime())));
+    }
+}
+
+void TestNotationQuantizer::testBaseline_data()
+{
+    QTest::addColumn<bool>("contrapuntal");
+    QTest::addColumn<QString>("baseline");
+
+    QTest::newRow("chords") << false << "notationquantizer-chords.txt";
+    QTest::newRow("contrapuntal") << true <<
+            "notationquantizer-contrapuntal.txt";
+}
+
+void TestNotationQuantizer::testBaseline()
+{
+    QFETCH(bool, contrapuntal);
+    QFETCH(QString, baseline);
+
+    // The baselines were written by the quantizer as it was before the
+    // scoring was split up and the provisional values were moved off
+    // the Events.
+    QFile file(QFINDTESTDATA("baseline/" + baseline));
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QStringList expected;
+    while (!file.atEnd()) {
+        expected.append(QString::fromUtf8(file.readLine()).trimmed());
+    }
+
+    Composition composition;
+    composition.addTimeSignature(0, TimeSignature(3, 4));
+    composition.addTimeSignature(46080, TimeSignature(7, 8));
+
+    Segment *segment = makeShortPerformance();
+    composition.addSegment(segment);
+
+    NotationQuantizer quantizer;
+    quantizer.setContrapuntal(contrapuntal);
+
+    QStringList actual;
+
+    // Two ranges, each of which leaves a provisional duration on a
+    // chord note past its end, and then the whole Segment.
+    const timeT ranges[][2] = { { 9600, 27800 }, { 27800, 38840 } };
+    for (const auto &range : ranges) {
+        quantizer.quantize(segment,
+                           segment->findTime(range[0]),
+                           segment->findTime(range[1]));
+
+        actual.append(QString("# %1-%2").arg(range[0]).arg(range[1]));
+        for (const Event *event : *segment) {
+            actual.append(describe(*event));
+        }
+    }
+
+    quantizer.quantize(segment);
+
+    actual.append("# all");
+    for (const Event *event : *segment) {
+        actual.append(describe(*event));
+    }
+
+    for (int i = 0; i < expected.count() && i < actual.count(); ++i) {
+        QCOMPARE(actual.at(i), expected.at(i));
+    }
+    QCOMPARE(actual.count(), expected.count());
+}
+
+QTEST_MAIN(TestNotationQuantizer)
+
+#include "notationquantizer.moc"
@@ -27,6 +27,9 @@ class TestRealTime : public QObject
 private Q_SLOTS:
     void test();
     void testFrameConversion();
+    void testConstexpr();
+    void benchmark_data();
+    void benchmark();
 };
 
 void TestRealTime::test()
@@ -143,6 +146,116 @@ void TestRealTime::testFrameConversion()
     }
 }
 
+void TestRealTime::testConstexpr()
+{
+    static_assert(RealTime(1, 1500000000) == RealTime(2, 500000000),
+                  "constructor normalizes");
+    static_assert((RealTime(2, 12) / 4).nsec == 500000003,
+                  "division rounds to nearest");
+    static_assert(RealTime::realTime2Frame(
+                          RealTime::frame2RealTime(44099, 44100), 44100) ==
+                  44099, "frame conversion round trips");
+
+    QCOMPARE(RealTime(-3, 0) / 2, RealTime(-1, -500000000));
+    QCOMPARE(RealTime(1, 5).toNanoseconds(), Q_INT64_C(1000000005));
+    QCOMPARE(RealTime::fromNanoseconds(-1000000005), RealTime(-1, -5));
+}
+
+namespace
+{
+    /// RealTime as it was before the 64-bit fast path, for benchmark().
+    /**
+     * The constructor and realTime2Frame() used to live in RealTime.cpp,
+     * out of reach of the inliner, so they are kept out of line here too.
+     */
+    struct OldRealTime
+    {
+        __attribute__((noinline)) OldRealTime(int s, int n) :
+            sec(s),
+            nsec(n)
+        {
+            sec += nsec / nanoSecondsPerSecond;
+            nsec %= nanoSecondsPerSecond;
+
+            if (sec < 0  &&  nsec > 0) {
+                ++sec;
+                nsec -= nanoSecondsPerSecond;
+            }
+            if (sec > 0  &&  nsec < 0) {
+                --sec;
+                nsec += nanoSecondsPerSecond;
+            }
+        }
+
+        int sec;
+        int nsec;
+
+        OldRealTime operator+(const OldRealTime &r) const
+                { return OldRealTime(sec + r.sec, nsec + r.nsec); }
+        OldRealTime operator-(const OldRealTime &r) const
+                { return OldRealTime(sec - r.sec, nsec - r.nsec); }
+        bool operator<(const OldRealTime &r) const
+        {
+            if (sec == r.sec)
+                return (nsec < r.nsec);
+            else
+                return (sec < r.sec);
+        }
+
+        __attribute__((noinline))
+        static long realTime2Frame(const OldRealTime &time,
+                                   unsigned int sampleRate)
+        {
+            double s = time.sec + double(time.nsec + 1) / 1000000000.0;
+            return long(s * sampleRate);
+        }
+    };
+
+    // Keep the optimizer from throwing the benchmark loops away.
+    volatile long benchmarkSink;
+
+    /// What a mapper or the JACK callback does per event: step along,
+    /// compare with the end of the slice, and convert to frames.
+    template <typename T>
+    long eventLoop(int events)
+    {
+        const T step(0, 1234567);
+        const T sliceEnd(0, 20000000);
+        T time(0, 0);
+        T sliceStart(0, 0);
+        long frames = 0;
+
+        for (int i = 0; i < events; ++i) {
+            time = time + step;
+            if (sliceEnd < time - sliceStart)
+                sliceStart = time;
+            frames += T::realTime2Frame(time - sliceStart, 48000);
+        }
+
+        return frames;
+    }
+}
+
+void TestRealTime::benchmark_data()
+{
+    QTest::addColumn<bool>("old");
+
+    QTest::newRow("old") << true;
+    QTest::newRow("new") << false;
+}
+
+void TestRealTime::benchmark()
+{
+    QFETCH(bool, old);
+
+    const int events = 1000000;
+
+    QBENCHMARK {
+        benchmarkSink = old ? eventLoop<OldRealTime>(events) :
+                              eventLoop<RealTime>(events);
+    }
+}
+
 QTEST_MAIN(TestRealTime)
 
 #include "realtime.moc"
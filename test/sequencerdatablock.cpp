@@ -0,0 +1,193 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "sound/SequencerDataBlock.h"
+#include "sound/MappedEvent.h"
+#include "sound/MappedEventList.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test for the SequencerDataBlock record ring buffer
+class TestSequencerDataBlock : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void testWraparound();
+    void testFull();
+    void testConcurrentWriters();
+
+private:
+    /// Append count events from writer, numbered from first.
+    static void addEvents(MappedEventList &list,
+                          int writer, int first, int count);
+};
+
+static const int ringSize = SEQUENCER_DATABLOCK_RECORD_BUFFER_SIZE;
+
+void
+TestSequencerDataBlock::addEvents(MappedEventList &list,
+                                  int writer, int first, int count)
+{
+    for (int i = first; i < first + count; ++i) {
+        MappedEvent *event = new MappedEvent;
+        event->setType(MappedEvent::MidiNote);
+        event->setInstrumentId(writer);
+        event->setRuntimeSegmentId(i);
+        list.insert(event);
+    }
+}
+
+void TestSequencerDataBlock::init()
+{
+    SequencerDataBlock::getInstance()->clearTemporaries();
+}
+
+void TestSequencerDataBlock::testWraparound()
+{
+    SequencerDataBlock *dataBlock = SequencerDataBlock::getInstance();
+
+    // Several times round the ring, a batch that straddles the end of it
+    // on most passes.
+    const int batch = 1000;
+    int next = 0;
+
+    for (int pass = 0; pass < 10; ++pass) {
+        MappedEventList in;
+        addEvents(in, 0, next, batch);
+        QCOMPARE(dataBlock->addRecordedEvents(&in), batch);
+        QVERIFY(in.empty());
+
+        MappedEventList out;
+        QCOMPARE(dataBlock->getRecordedEvents(out), batch);
+        for (const MappedEvent *event : out) {
+            QCOMPARE(event->getRuntimeSegmentId(), next);
+            ++next;
+        }
+    }
+
+    QCOMPARE(dataBlock->getRecordOverflowCount(), 0u);
+}
+
+void TestSequencerDataBlock::testFull()
+{
+    SequencerDataBlock *dataBlock = SequencerDataBlock::getInstance();
+
+    const int total = ringSize + 1000;
+    MappedEventList in;
+    addEvents(in, 0, 0, total);
+
+    // One slot always stays empty.  The latest events are left over.
+    QCOMPARE(dataBlock->addRecordedEvents(&in), ringSize - 1);
+    QCOMPARE(int(in.size()), total - (ringSize - 1));
+    QCOMPARE((*in.begin())->getRuntimeSegmentId(), ringSize - 1);
+
+    // Retrying while the ring is full stores nothing and loses nothing.
+    for (int retry = 0; retry < 5; ++retry) {
+        QCOMPARE(dataBlock->addRecordedEvents(&in), 0);
+    }
+    QCOMPARE(int(in.size()), total - (ringSize - 1));
+    QCOMPARE(dataBlock->getRecordOverflowCount(), 0u);
+
+    int next = 0;
+
+    MappedEventList out;
+    QCOMPARE(dataBlock->getRecordedEvents(out), ringSize - 1);
+    for (const MappedEvent *event : out) {
+        QCOMPARE(event->getRuntimeSegmentId(), next);
+        ++next;
+    }
+
+    // Once the GUI catches up, the rest go through.
+    QCOMPARE(dataBlock->addRecordedEvents(&in), total - (ringSize - 1));
+    QVERIFY(in.empty());
+
+    MappedEventList rest;
+    dataBlock->getRecordedEvents(rest);
+    for (const MappedEvent *event : rest) {
+        QCOMPARE(event->getRuntimeSegmentId(), next);
+        ++next;
+    }
+    QCOMPARE(next, total);
+}
+
+void TestSequencerDataBlock::testConcurrentWriters()
+{
+    SequencerDataBlock *dataBlock = SequencerDataBlock::getInstance();
+
+    const int writers = 4;
+    const int eventsPerWriter = 20000;
+
+    // Small batches, retried until they fit, so that the writers keep
+    // running into each other and into a full ring.
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < writers; ++writer) {
+        threads.emplace_back([=]() {
+            MappedEventList pending;
+            for (int first = 0; first < eventsPerWriter; first += 7) {
+                addEvents(pending, writer, first,
+                          std::min(7, eventsPerWriter - first));
+                while (!pending.empty()) {
+                    if (dataBlock->addRecordedEvents(&pending) == 0)
+                        std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> next(writers, 0);
+    int received = 0;
+    bool inOrder = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (received < writers * eventsPerWriter  &&
+           timer.elapsed() < 30000) {
+        MappedEventList out;
+        received += dataBlock->getRecordedEvents(out);
+
+        // Each writer's events arrive complete and in order.
+        for (const MappedEvent *event : out) {
+            const int writer = int(event->getInstrumentId());
+            if (event->getRuntimeSegmentId() != next[writer])
+                inOrder = false;
+            ++next[writer];
+        }
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    QVERIFY(inOrder);
+    QCOMPARE(received, writers * eventsPerWriter);
+    for (int writer = 0; writer < writers; ++writer) {
+        QCOMPARE(next[writer], eventsPerWriter);
+    }
+    QCOMPARE(dataBlock->getRecordOverflowCount(), 0u);
+}
+
+QTEST_MAIN(TestSequencerDataBlock)
+
+#include "sequencerdatablock.moc"
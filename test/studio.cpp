@@ -0,0 +1,170 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "base/Studio.h"
+#include "base/Instrument.h"
+#include "base/MidiDevice.h"
+
+#include <QTest>
+
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test and benchmark for the Studio lookups
+class TestStudio : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLookups();
+    void testRemoveDevice();
+    void testBusses();
+    void benchmark();
+
+private:
+    /// Add devices MIDI devices of 16 instruments each.
+    static std::vector<DeviceId> addMidiDevices(Studio &studio, int devices);
+};
+
+std::vector<DeviceId>
+TestStudio::addMidiDevices(Studio &studio, int devices)
+{
+    std::vector<DeviceId> deviceIds;
+
+    for (int i = 0; i < devices; ++i) {
+        InstrumentId baseInstrumentId;
+        const DeviceId deviceId = studio.getSpareDeviceId(baseInstrumentId);
+        studio.addDevice(QString("Device %1").arg(i).toStdString(),
+                         deviceId, baseInstrumentId, Device::Midi);
+        deviceIds.push_back(deviceId);
+    }
+
+    return deviceIds;
+}
+
+void TestStudio::testLookups()
+{
+    Studio studio;
+    const std::vector<DeviceId> deviceIds = addMidiDevices(studio, 8);
+
+    for (DeviceId deviceId : deviceIds) {
+        Device *device = studio.getDevice(deviceId);
+        QVERIFY(device);
+        QCOMPARE(device->getId(), deviceId);
+
+        for (Instrument *instrument : device->getAllInstrumentsRef()) {
+            QCOMPARE(studio.getInstrumentById(instrument->getId()),
+                     instrument);
+            QCOMPARE(instrument->getDevice(), device);
+        }
+    }
+
+    // The audio and soft synth devices are always there.
+    QVERIFY(studio.getInstrumentById(AudioInstrumentBase));
+    QVERIFY(studio.getInstrumentById(SoftSynthInstrumentBase));
+
+    QCOMPARE(studio.getAllInstruments().size(),
+             studio.getAudioDevice()->getAllInstrumentsRef().size() +
+             studio.getSoftSynthDevice()->getAllInstrumentsRef().size() +
+             deviceIds.size() * 16);
+
+    QVERIFY(!studio.getInstrumentById(NoInstrument));
+    QVERIFY(!studio.getDevice(NO_DEVICE));
+}
+
+void TestStudio::testRemoveDevice()
+{
+    Studio studio;
+    const std::vector<DeviceId> deviceIds = addMidiDevices(studio, 4);
+
+    const Device *removed = studio.getDevice(deviceIds[1]);
+    QVERIFY(removed);
+    std::vector<InstrumentId> removedInstrumentIds;
+    for (const Instrument *instrument : removed->getAllInstrumentsRef()) {
+        removedInstrumentIds.push_back(instrument->getId());
+    }
+
+    studio.removeDevice(deviceIds[1]);
+
+    QVERIFY(!studio.getDevice(deviceIds[1]));
+    for (InstrumentId instrumentId : removedInstrumentIds) {
+        QVERIFY(!studio.getInstrumentById(instrumentId));
+    }
+
+    // The others must still be there.
+    for (DeviceId deviceId : { deviceIds[0], deviceIds[2], deviceIds[3] }) {
+        const Device *device = studio.getDevice(deviceId);
+        QVERIFY(device);
+        for (Instrument *instrument : device->getAllInstrumentsRef()) {
+            QCOMPARE(studio.getInstrumentById(instrument->getId()),
+                     instrument);
+        }
+    }
+
+    // A new device gets the spare ID and is found.
+    InstrumentId baseInstrumentId;
+    const DeviceId newDeviceId = studio.getSpareDeviceId(baseInstrumentId);
+    studio.addDevice("New", newDeviceId, baseInstrumentId, Device::Midi);
+    QVERIFY(studio.getDevice(newDeviceId));
+    QVERIFY(studio.getInstrumentById(baseInstrumentId));
+}
+
+void TestStudio::testBusses()
+{
+    Studio studio;
+    studio.setBussCount(8);
+
+    QCOMPARE(studio.getBussesRef().size(), size_t(8));
+    for (BussId bussId = 0; bussId < 8; ++bussId) {
+        QVERIFY(studio.getBussById(bussId));
+        QCOMPARE(studio.getBussById(bussId)->getId(), bussId);
+    }
+    QVERIFY(!studio.getBussById(8));
+}
+
+void TestStudio::benchmark()
+{
+    const int devices = 64;
+
+    Studio studio;
+    addMidiDevices(studio, devices);
+    studio.setBussCount(16);
+
+    const InstrumentVector instruments = studio.getAllInstruments();
+    QVERIFY(instruments.size() >= size_t(devices * 16));
+
+    size_t found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        for (const Instrument *instrument : instruments) {
+            if (studio.getInstrumentById(instrument->getId()) == instrument)
+                ++found;
+            if (studio.getDevice(instrument->getDevice()->getId()))
+                ++found;
+        }
+        for (BussId bussId = 0; bussId < 16; ++bussId) {
+            if (studio.getBussById(bussId))
+                ++found;
+        }
+    }
+
+    QCOMPARE(found, instruments.size() * 2 + 16);
+}
+
+QTEST_MAIN(TestStudio)
+
+#include "studio.moc"
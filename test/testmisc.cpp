@@ -3,6 +3,7 @@
 
 #include "base/Composition.h"
 #include "base/Event.h"
+#include "base/MidiTypes.h"
 #include "base/NotationTypes.h"
 #include "base/SegmentNotationHelper.h"
 #include "base/SegmentPerformanceHelper.h"
@@ -25,6 +26,9 @@ class TestMisc : public QObject
 private Q_SLOTS:
     void testEvent();
     void testEventPerformance();
+    void testEventType();
+    void testEventTypeScan_data();
+    void testEventTypeScan();
     void testNotationTypes();
 };
 
@@ -241,6 +245,103 @@ void TestMisc::testEventPerformance()
          << (et-st)*10 << "ms";
 }
 
+void TestMisc::testEventType()
+{
+    // Types read from a file are interned to the same atom as the
+    // EventType constants.
+    const std::string fromFile("note");
+    Event e(fromFile, 0, 10);
+    QVERIFY(e.isa(Note::EventType));
+    QVERIFY(e.isa(fromFile));
+    QVERIFY(!e.isa(Note::EventRestType));
+    QVERIFY(&e.getType() == &Note::EventType.getName());
+    QCOMPARE(e.getType().c_str(), "note");
+
+    // The sub-ordering is still looked up from the type.
+    Event clef(std::string("clefchange"), 0);
+    QCOMPARE(int(clef.getSubOrdering()), int(Clef::EventSubOrdering));
+
+    // Controller::EventType used to be a const char *.
+    Event cc(Controller::EventType, 0);
+    QVERIFY(cc.isa(Controller::EventType));
+    QVERIFY(cc.getType() == "controller");
+    QVERIFY(EventTypeName("controller") == Controller::EventType);
+    QVERIFY(EventTypeName("controllers") != Controller::EventType);
+
+    // Copies share the atom.
+    Event copy(e, 100);
+    QVERIFY(&copy.getType() == &e.getType());
+
+    QVERIFY(EventTypeName().getName().empty());
+}
+
+void TestMisc::testEventTypeScan_data()
+{
+    QTest::addColumn<bool>("strings");
+
+    QTest::newRow("isa(EventTypeName)") << false;
+    QTest::newRow("string compare") << true;
+}
+
+void TestMisc::testEventTypeScan()
+{
+    QFETCH(bool, strings);
+
+    // A segment with the usual mix of a recorded MIDI track.
+    Segment segment;
+    constexpr int EVENT_COUNT = 100000;
+    for (int i = 0; i < EVENT_COUNT; ++i) {
+        const timeT time = i * 60;
+        switch (i % 8) {
+        case 0:
+        case 1:
+        case 2:
+            segment.insert(new Event(Note::EventType, time, 60));
+            break;
+        case 3:
+            segment.insert(new Event(Note::EventRestType, time, 60));
+            break;
+        case 4:
+        case 5:
+            segment.insert(new Event(Controller::EventType, time));
+            break;
+        case 6:
+            segment.insert(new Event(PitchBend::EventType, time));
+            break;
+        default:
+            segment.insert(new Event(Text::EventType, time));
+            break;
+        }
+    }
+
+    // What the filters in the editors and exporters do.
+    const std::string noteType = Note::EventType;
+    const std::string controllerType = Controller::EventType;
+
+    int notes = 0;
+    int controllers = 0;
+    QBENCHMARK {
+        notes = 0;
+        controllers = 0;
+        for (const Event *event : segment) {
+            if (strings) {
+                if (event->getType() == noteType)
+                    ++notes;
+                else if (event->getType() == controllerType)
+                    ++controllers;
+            } else {
+                if (event->isa(Note::EventType))
+                    ++notes;
+                else if (event->isa(Controller::EventType))
+                    ++controllers;
+            }
+        }
+    }
+
+    QCOMPARE(notes, EVENT_COUNT / 8 * 3);
+    QCOMPARE(controllers, EVENT_COUNT / 8 * 2);
+}
+
 void TestMisc::testNotationTypes() {
     qDebug() << "Testing duration-list stuff";
 
@@ -0,0 +1,123 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "sound/ParallelTimeStretcher.h"
+
+#include <QTest>
+
+#include <cmath>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test and benchmark for ParallelTimeStretcher
+class TestTimeStretch : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLength();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    /// Stretch seconds of a stereo sine, return the output.
+    std::vector<float> stretch(int seconds, float ratio, int threads,
+                               size_t chunkFrames);
+};
+
+static const size_t sampleRate = 44100;
+
+std::vector<float>
+TestTimeStretch::stretch(int seconds, float ratio, int threads,
+                         size_t chunkFrames)
+{
+    const size_t inputFrames = sampleRate * seconds;
+    size_t position = 0;
+    std::vector<float> output;
+
+    ParallelTimeStretcher stretcher(sampleRate, 2, ratio, threads);
+    if (chunkFrames)
+        stretcher.setChunkFrames(chunkFrames);
+
+    auto read = [&](float **buffers, size_t frames) -> size_t {
+        size_t i = 0;
+        for (; i < frames  &&  position < inputFrames; ++i, ++position) {
+            const float sample =
+                    0.5f * sinf(2.f * float(M_PI) * 440.f * position /
+                                sampleRate);
+            buffers[0][i] = sample;
+            buffers[1][i] = sample;
+        }
+        return i;
+    };
+
+    auto write = [&](float **buffers, size_t frames) {
+        output.insert(output.end(), buffers[0], buffers[0] + frames);
+    };
+
+    auto poll = [](int) -> bool { return true; };
+
+    stretcher.process(inputFrames, read, write, poll);
+
+    return output;
+}
+
+void TestTimeStretch::testLength()
+{
+    // Several short chunks so that the crossfades get exercised.
+    const std::vector<float> output = stretch(5, 1.5f, 4, sampleRate / 2);
+
+    QCOMPARE(output.size(), size_t(ceil(5.0 * sampleRate * 1.5)));
+
+    // A steady sine should come out at a steady level, including
+    // across the chunk boundaries.
+    const size_t window = 2048;
+    for (size_t start = sampleRate / 2;
+         start + window < output.size() - sampleRate / 2;
+         start += window) {
+        double sum = 0;
+        for (size_t i = start; i < start + window; ++i) {
+            sum += output[i] * output[i];
+        }
+        const double rms = sqrt(sum / window);
+        // 0.5 amplitude sine has an RMS of about 0.354.
+        QVERIFY2(rms > 0.2  &&  rms < 0.5,
+                 qPrintable(QString("RMS %1 at frame %2").
+                            arg(rms).arg(start)));
+    }
+}
+
+void TestTimeStretch::benchmark_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all cores") << 0;
+}
+
+void TestTimeStretch::benchmark()
+{
+    QFETCH(int, threads);
+
+    // Short chunks so that the work is spread over the threads.
+    QBENCHMARK {
+        stretch(5, 1.25f, threads, sampleRate / 2);
+    }
+}
+
+QTEST_MAIN(TestTimeStretch)
+
+#include "timestretch.moc"
@@ -0,0 +1,213 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*- vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Rosegarden
+    A sequencer and musical notation editor.
+    Copyright 2000-2026 the Rosegarden development team.
+    See the AUTHORS file for more details.
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of the
+    License, or (at your option) any later version.  See the file
+    COPYING included with this distribution for more information.
+*/
+
+#include "sound/AudioTranscriber.h"
+#include "sound/PitchDetector.h"
+
+#include <QTest>
+
+#include <cmath>
+#include <vector>
+
+using namespace Rosegarden;
+
+/// Unit test and benchmark for AudioTranscriber
+class TestTranscribe : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMelody_data();
+    void testMelody();
+    void testChunks();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    /// A pitch, or -1 for a rest, and how long it lasts.
+    struct Step
+    {
+        int pitch;
+        int ms;
+    };
+
+    /// Render steps as a tone with a few harmonics.
+    static std::vector<float> render(const std::vector<Step> &steps);
+
+    /// Transcribe audio.
+    static std::vector<AudioTranscriber::Note> transcribe(
+            const std::vector<float> &audio, int method, int threads,
+            size_t chunkFrames);
+};
+
+static const int sampleRate = 44100;
+
+std::vector<float>
+TestTranscribe::render(const std::vector<Step> &steps)
+{
+    std::vector<float> audio;
+    double phase = 0;
+
+    for (const Step &step : steps) {
+        const int frames = sampleRate * step.ms / 1000;
+        const double frequency = step.pitch >= 0 ?
+                440 * pow(2, (step.pitch - 69) / 12.0) : 0;
+
+        for (int i = 0; i < frames; ++i) {
+            // Short fades in and out so that the notes don't click.
+            const double envelope = step.pitch >= 0 ?
+                    std::min(1.0, std::min(i, frames - i) / 200.0) : 0;
+            double sample = 0;
+            for (int harmonic = 1; harmonic <= 6; ++harmonic) {
+                sample += sin(phase * harmonic) / harmonic;
+            }
+            audio.push_back(float(0.3 * envelope * sample));
+            phase += 2 * M_PI * frequency / sampleRate;
+        }
+    }
+
+    return audio;
+}
+
+std::vector<AudioTranscriber::Note>
+TestTranscribe::transcribe(const std::vector<float> &audio, int method,
+                           int threads, size_t chunkFrames)
+{
+    AudioTranscriber transcriber(sampleRate,
+                                 PitchDetector::defaultFrameSize,
+                                 PitchDetector::defaultStepSize,
+                                 threads);
+    transcriber.setMethod(PitchDetector::getMethods()->at(method));
+    if (chunkFrames)
+        transcriber.setChunkFrames(chunkFrames);
+
+    size_t position = 0;
+
+    auto read = [&](float *buffer, size_t frames) -> size_t {
+        size_t i = 0;
+        for (; i < frames  &&  position < audio.size(); ++i, ++position) {
+            buffer[i] = audio[position];
+        }
+        return i;
+    };
+
+    auto poll = [](int) -> bool { return true; };
+
+    transcriber.process(audio.size(), read, poll);
+
+    return transcriber.getNotes();
+}
+
+void TestTranscribe::testMelody_data()
+{
+    QTest::addColumn<int>("method");
+
+    for (int method = 0; method < PitchDetector::getMethods()->size();
+         ++method) {
+        QTest::newRow(qPrintable(PitchDetector::getMethods()->at(method)))
+                << method;
+    }
+}
+
+void TestTranscribe::testMelody()
+{
+    QFETCH(int, method);
+
+    // A repeated note needs a rest to be heard as two.
+    const std::vector<Step> melody = {
+        { 57, 400 }, { 60, 300 }, { 64, 300 }, { -1, 200 },
+        { 64, 300 }, { 69, 500 }, { 72, 300 }
+    };
+
+    // Several short chunks so that the boundaries get exercised.
+    const std::vector<AudioTranscriber::Note> notes =
+            transcribe(render(melody), method, 4, sampleRate / 3);
+
+    QCOMPARE(int(notes.size()), 6);
+
+    int ms = 0;
+    size_t n = 0;
+    for (const Step &step : melody) {
+        if (step.pitch >= 0) {
+            QCOMPARE(notes[n].pitch, step.pitch);
+            QVERIFY2(fabs(notes[n].time.toSeconds() - ms / 1000.0) < 0.03,
+                     qPrintable(QString("Note %1 at %2s").
+                                arg(n).arg(notes[n].time.toSeconds())));
+            QVERIFY(fabs(notes[n].duration.toSeconds() - step.ms / 1000.0) <
+                    0.03);
+            QVERIFY(notes[n].velocity > 0  &&  notes[n].velocity < 128);
+            ++n;
+        }
+        ms += step.ms;
+    }
+}
+
+void TestTranscribe::testChunks()
+{
+    std::vector<Step> melody;
+    for (int i = 0; i < 20; ++i) {
+        melody.push_back({ 55 + (i * 5) % 19, 150 + (i % 3) * 50 });
+        if (i % 4 == 3)
+            melody.push_back({ -1, 100 });
+    }
+    const std::vector<float> audio = render(melody);
+
+    // However the work is cut up, the result is the same.
+    const std::vector<AudioTranscriber::Note> whole =
+            transcribe(audio, 0, 1, audio.size() * 2);
+    const std::vector<AudioTranscriber::Note> chunked =
+            transcribe(audio, 0, 3, sampleRate / 4 + 17);
+
+    QVERIFY(!whole.empty());
+    QCOMPARE(chunked.size(), whole.size());
+    for (size_t i = 0; i < whole.size(); ++i) {
+        QCOMPARE(chunked[i].time, whole[i].time);
+        QCOMPARE(chunked[i].duration, whole[i].duration);
+        QCOMPARE(chunked[i].pitch, whole[i].pitch);
+        QCOMPARE(chunked[i].velocity, whole[i].velocity);
+    }
+}
+
+void TestTranscribe::benchmark_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all cores") << 0;
+}
+
+void TestTranscribe::benchmark()
+{
+    QFETCH(int, threads);
+
+    // Five seconds of a busy vocal line.
+    std::vector<Step> melody;
+    for (int ms = 0; ms < 5000; ms += 250) {
+        melody.push_back({ 48 + (ms / 250 * 7) % 24, 250 });
+    }
+    const std::vector<float> audio = render(melody);
+
+    std::vector<AudioTranscriber::Note> notes;
+
+    QBENCHMARK {
+        notes = transcribe(audio, 0, threads, 0);
+    }
+
+    QVERIFY(!notes.empty());
+}
+
+QTEST_MAIN(TestTranscribe)
+
+#include "transcribe.moc"